@@ -0,0 +1,292 @@
+#include "base_diff.h"
+#include "json_reader.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace std::literals;
+
+namespace catalogue::diff {
+
+namespace {
+
+using Distances = std::vector<std::pair<std::string_view, int>>;
+
+/** Определение выгрузки по сравнению с каталогом */
+enum class Status : uint8_t {
+	ADDED,
+	CHANGED,
+	UNCHANGED,
+	DUPLICATE,   // повтор названия - учитывается первое определение
+};
+
+/** Остановка выгрузки и её расстояния до остановок выгрузки */
+struct NewStop {
+	const input::StopDescription *description = nullptr;
+	Distances distances;
+};
+
+journal::Mutation MakeMutation(journal::MutationType type, std::string_view name) {
+	journal::Mutation mutation;
+	mutation.type = type;
+	mutation.name = name;
+	return mutation;
+}
+
+journal::Mutation MakeDistance(journal::MutationType type, std::string_view from, std::string_view to, int distance = 0) {
+	journal::Mutation mutation = MakeMutation(type, from);
+	mutation.to = to;
+	mutation.distance = distance;
+	return mutation;
+}
+}
+
+/**
+ * СРАВНЕНИЕ ВЫГРУЗКИ С КАТАЛОГОМ
+ *
+ * АЛГОРИТМ:
+ * 1. Определения выгрузки разбираются; для каждого названия запоминается
+ *    первое определение, повторы отбрасываются
+ * 2. Параллельно (parallel.h) для каждого определения - поиск в каталоге
+ *    по названию: нет - новое; есть и хеш совпал с hashes по номеру - без
+ *    изменений; иначе изменилось. Каждое определение пишет только свою
+ *    ячейку результата
+ *    Маршрут, у номера которого в каталоге есть и другие маршруты
+ *    (TransportCatalogue::AddBus), считается изменившимся: он удаляется
+ *    вместе с ними и добавляется по первому определению
+ * 3. Номера, не встреченные в выгрузке, - исчезнувшие
+ * 4. Прежние расстояния нужны только для изменившихся остановок:
+ *    их собирает один проход по таблице расстояний
+ *
+ * Сложность: O(размер выгрузки + число расстояний каталога).
+ */
+std::vector<journal::Mutation> Diff(const json::Array &base_requests, const TransportCatalogue &catalogue,
+												const hashing::DefinitionHashes &hashes, DiffStats &stats) {
+	const std::deque<transport::Stop> &stops = catalogue.GetAllStops();
+	const std::deque<transport::Bus> &buses = catalogue.GetAllBuses();
+	if(hashes.stops.size() != stops.size() || hashes.buses.size() != buses.size()) {
+		throw std::logic_error("definition hashes do not match the catalogue");
+	}
+
+	std::vector<input::StopDescription> stop_requests;
+	std::vector<input::BusDescription> bus_requests;
+	for(const json::Node &request : base_requests) {
+		const json::Dict &content = request.AsDict();
+		if(content.at("type").AsString() == "Stop"s) {
+			stop_requests.emplace_back(content);
+		} else if(content.at("type").AsString() == "Bus"s) {
+			bus_requests.emplace_back(content);
+		}
+	}
+
+	std::unordered_map<std::string_view, size_t> first_stop;
+	first_stop.reserve(stop_requests.size());
+	for(size_t i = 0; i < stop_requests.size(); ++i) {
+		first_stop.emplace(stop_requests[i].name, i);
+	}
+	// Номера, под которыми в каталоге хранится больше одного маршрута
+	std::unordered_set<std::string_view> shared_numbers;
+	for(const transport::Bus &bus : buses) {
+		if(catalogue.FindBus(bus.number) != &bus) {
+			shared_numbers.insert(bus.number);
+		}
+	}
+
+	std::unordered_map<std::string_view, size_t> first_bus;
+	first_bus.reserve(bus_requests.size());
+	for(size_t i = 0; i < bus_requests.size(); ++i) {
+		first_bus.emplace(bus_requests[i].name, i);
+	}
+
+	auto stop_distances = [&first_stop](const input::StopDescription &request, Distances &distances) {
+		distances.clear();
+		for(const auto &[to, distance] : *request.distances) {
+			if(first_stop.count(to)) {
+				distances.emplace_back(to, distance.AsInt());
+			}
+		}
+	};
+	auto bus_stops = [&first_stop](const input::BusDescription &request, std::vector<std::string_view> &names) {
+		names.clear();
+		for(std::string_view name : request.stops) {
+			if(first_stop.count(name)) {
+				names.push_back(name);
+			}
+		}
+	};
+
+	std::vector<Status> stop_status(stop_requests.size());
+	std::vector<Status> bus_status(bus_requests.size());
+	std::vector<const transport::Stop *> old_stops(stop_requests.size(), nullptr);
+	std::vector<const transport::Bus *> old_buses(bus_requests.size(), nullptr);
+	const size_t count = std::max(stop_requests.size(), bus_requests.size());
+	parallel::ForEachRange(count, 0, [&](size_t, size_t begin, size_t end) {
+		Distances distances;
+		for(size_t i = begin; i < std::min(end, stop_requests.size()); ++i) {
+			const input::StopDescription &request = stop_requests[i];
+			if(first_stop.at(request.name) != i) {
+				stop_status[i] = Status::DUPLICATE;
+			} else if(old_stops[i] = catalogue.FindStop(request.name); !old_stops[i]) {
+				stop_status[i] = Status::ADDED;
+			} else {
+				stop_distances(request, distances);
+				stop_status[i] = hashing::HashStop(request.name, request.coordinates, distances) == hashes.stops[old_stops[i]->id]
+										  ? Status::UNCHANGED : Status::CHANGED;
+			}
+		}
+
+		std::vector<std::string_view> names;
+		for(size_t i = begin; i < std::min(end, bus_requests.size()); ++i) {
+			const input::BusDescription &request = bus_requests[i];
+			if(first_bus.at(request.name) != i) {
+				bus_status[i] = Status::DUPLICATE;
+			} else if(old_buses[i] = catalogue.FindBus(request.name); !old_buses[i]) {
+				bus_status[i] = Status::ADDED;
+			} else {
+				bus_stops(request, names);
+				bus_status[i] = hashing::HashBus(request.name, names, request.is_roundtrip) == hashes.buses[old_buses[i]->id]
+										 && !shared_numbers.count(request.name) ? Status::UNCHANGED : Status::CHANGED;
+			}
+		}
+	});
+
+	std::vector<NewStop> added_stops;
+	std::vector<std::pair<NewStop, const transport::Stop *>> changed_stops;
+	std::vector<bool> stop_seen(stops.size(), false);
+	for(size_t i = 0; i < stop_requests.size(); ++i) {
+		if(stop_status[i] == Status::DUPLICATE) {
+			continue;
+		}
+		const transport::Stop *old = old_stops[i];
+		if(old) {
+			stop_seen[old->id] = true;
+		}
+		if(stop_status[i] == Status::UNCHANGED) {
+			++stats.unchanged;
+			continue;
+		}
+		NewStop stop{&stop_requests[i], {}};
+		stop_distances(stop_requests[i], stop.distances);
+		if(old) {
+			changed_stops.emplace_back(std::move(stop), old);
+		} else {
+			added_stops.push_back(std::move(stop));
+		}
+	}
+
+	std::vector<std::pair<const input::BusDescription *, std::vector<std::string_view>>> new_buses;  // новые и изменившиеся
+	std::vector<bool> bus_seen(buses.size(), false);
+	std::vector<const transport::Bus *> changed_buses;
+	for(size_t i = 0; i < bus_requests.size(); ++i) {
+		if(bus_status[i] == Status::DUPLICATE) {
+			continue;
+		}
+		const transport::Bus *old = old_buses[i];
+		if(old) {
+			bus_seen[old->id] = true;
+		}
+		if(bus_status[i] == Status::UNCHANGED) {
+			++stats.unchanged;
+			continue;
+		}
+		if(old) {
+			changed_buses.push_back(old);
+			++stats.buses_changed;
+		} else {
+			++stats.buses_added;
+		}
+		std::vector<std::string_view> names;
+		bus_stops(bus_requests[i], names);
+		new_buses.emplace_back(&bus_requests[i], std::move(names));
+	}
+
+	std::vector<journal::Mutation> mutations;
+
+	// 1. Маршруты: исчезнувшие и изменившиеся
+	for(const transport::Bus &bus : buses) {
+		// Остальные маршруты номера RemoveBus удаляет вместе с первым
+		if(!bus_seen[bus.id] && catalogue.FindBus(bus.number) == &bus) {
+			mutations.push_back(MakeMutation(journal::MutationType::REMOVE_BUS, bus.number));
+			++stats.buses_removed;
+		}
+	}
+	for(const transport::Bus *bus : changed_buses) {
+		mutations.push_back(MakeMutation(journal::MutationType::REMOVE_BUS, bus->number));
+	}
+
+	// 2. Остановки: новые и новые координаты
+	for(const NewStop &stop : added_stops) {
+		journal::Mutation mutation = MakeMutation(journal::MutationType::ADD_STOP, stop.description->name);
+		mutation.coordinates = stop.description->coordinates;
+		mutations.push_back(std::move(mutation));
+	}
+	stats.stops_added = added_stops.size();
+	stats.stops_changed = changed_stops.size();
+	for(const auto &[stop, old] : changed_stops) {
+		if(!(stop.description->coordinates == old->coordinates)) {
+			journal::Mutation mutation = MakeMutation(journal::MutationType::UPDATE_STOP, old->name);
+			mutation.coordinates = stop.description->coordinates;
+			mutations.push_back(std::move(mutation));
+		}
+	}
+
+	// 3. Расстояния
+	const size_t distances_begin = mutations.size();
+	for(const NewStop &stop : added_stops) {
+		for(const auto &[to, distance] : stop.distances) {
+			mutations.push_back(MakeDistance(journal::MutationType::UPDATE_DISTANCE, stop.description->name, to, distance));
+		}
+	}
+	if(!changed_stops.empty()) {
+		std::unordered_map<const transport::Stop *, std::unordered_map<std::string_view, int>> old_distances;
+		old_distances.reserve(changed_stops.size());
+		for(const auto &[stop, old] : changed_stops) {
+			old_distances[old];
+		}
+		for(const auto &[stops_pair, distance] : catalogue.GetAllDistances()) {
+			if(auto it = old_distances.find(stops_pair.first); it != old_distances.end()) {
+				it->second.emplace(stops_pair.second->name, distance);
+			}
+		}
+
+		for(const auto &[stop, old] : changed_stops) {
+			std::unordered_map<std::string_view, int> &previous = old_distances.at(old);
+			for(const auto &[to, distance] : stop.distances) {
+				auto it = previous.find(to);
+				if(it == previous.end() || it->second != distance) {
+					mutations.push_back(MakeDistance(journal::MutationType::UPDATE_DISTANCE, old->name, to, distance));
+				}
+				if(it != previous.end()) {
+					previous.erase(it);
+				}
+			}
+			for(const auto &[to, distance] : previous) {
+				mutations.push_back(MakeDistance(journal::MutationType::REMOVE_DISTANCE, old->name, to));
+			}
+		}
+	}
+	stats.distances_changed = mutations.size() - distances_begin;
+
+	// 4. Маршруты: новые и изменившиеся
+	for(const auto &[request, stop_names] : new_buses) {
+		journal::Mutation mutation = MakeMutation(journal::MutationType::ADD_BUS, request->name);
+		mutation.stops.assign(stop_names.begin(), stop_names.end());
+		mutation.is_roundtrip = request->is_roundtrip;
+		mutations.push_back(std::move(mutation));
+	}
+
+	// 5. Исчезнувшие остановки
+	for(const transport::Stop &stop : stops) {
+		if(!stop_seen[stop.id]) {
+			mutations.push_back(MakeMutation(journal::MutationType::REMOVE_STOP, stop.name));
+			++stats.stops_removed;
+		}
+	}
+	return mutations;
+}
+}
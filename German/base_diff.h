@@ -0,0 +1,55 @@
+#pragma once
+
+/*
+ * ДИФФЕРЕНЦИАЛЬНАЯ ЗАГРУЗКА base_requests
+ *
+ * Ночная выгрузка base_requests почти совпадает с предыдущей, а полная
+ * пересборка каталога заново строит все индексы. Diff сравнивает новые
+ * определения с каталогом по хешам (definition_hash.h) и возвращает
+ * только изменения, которые переводят каталог в состояние новой выгрузки.
+ * Изменения применяются через journal::Store: они попадают в журнал,
+ * а индексы замороженного каталога обновляются только для затронутых
+ * маршрутов и остановок.
+ *
+ * ПОРЯДОК ИЗМЕНЕНИЙ:
+ * 1. Удаление исчезнувших и изменившихся маршрутов
+ * 2. Новые остановки; новые координаты изменившихся остановок
+ * 3. Расстояния новых и изменившихся остановок (задание, замена, удаление)
+ * 4. Новые и изменившиеся маршруты
+ * 5. Удаление исчезнувших остановок - маршрутов через них уже нет
+ *
+ * Как и при обычной загрузке, остановки маршрута и цели расстояний,
+ * которых нет среди остановок выгрузки, пропускаются; из повторяющихся
+ * определений учитывается первое. Всё, чего нет в выгрузке (в том числе
+ * данные GTFS), удаляется.
+ */
+
+#include "definition_hash.h"
+#include "journal.h"
+#include "json.h"
+#include "transport_catalogue.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace catalogue::diff {
+
+struct DiffStats {
+	size_t stops_added = 0;
+	size_t stops_changed = 0;
+	size_t stops_removed = 0;
+	size_t buses_added = 0;
+	size_t buses_changed = 0;
+	size_t buses_removed = 0;
+	size_t distances_changed = 0;   // заданных, заменённых и удалённых расстояний
+	size_t unchanged = 0;           // остановок и маршрутов с прежним хешем
+};
+
+/**
+ * Изменения, переводящие каталог в состояние base_requests.
+ * hashes - хеши текущего каталога по номерам (journal::Store::Hashes);
+ * не того размера - std::logic_error.
+ */
+std::vector<journal::Mutation> Diff(const json::Array &base_requests, const TransportCatalogue &catalogue,
+												const hashing::DefinitionHashes &hashes, DiffStats &stats);
+}
@@ -0,0 +1,410 @@
+#include "bitmap.h"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace catalogue::bitmap {
+
+namespace {
+
+constexpr size_t BITSET_WORDS = 65536 / 64;  // кратно ширине SIMD-регистра: хвоста нет
+
+// Во сколько раз массив должен быть больше другого, чтобы искать галопом
+constexpr size_t GALLOP_RATIO = 32;
+
+/** dst &= src по словам; возвращает число единичных битов результата */
+size_t AndWords(uint64_t *dst, const uint64_t *src) {
+	size_t i = 0;
+#if defined(__AVX2__)
+	for(; i + 4 <= BITSET_WORDS; i += 4) {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_and_si256(a, b));
+	}
+#elif defined(__SSE2__) || defined(_M_X64)
+	for(; i + 2 <= BITSET_WORDS; i += 2) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_and_si128(a, b));
+	}
+#else
+	for(; i < BITSET_WORDS; ++i) {
+		dst[i] &= src[i];
+	}
+#endif
+
+	size_t count = 0;
+	for(size_t w = 0; w < BITSET_WORDS; ++w) {
+		count += std::popcount(dst[w]);
+	}
+	return count;
+}
+
+/** dst |= src по словам; возвращает число единичных битов результата */
+size_t OrWords(uint64_t *dst, const uint64_t *src) {
+	size_t i = 0;
+#if defined(__AVX2__)
+	for(; i + 4 <= BITSET_WORDS; i += 4) {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_or_si256(a, b));
+	}
+#elif defined(__SSE2__) || defined(_M_X64)
+	for(; i + 2 <= BITSET_WORDS; i += 2) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_or_si128(a, b));
+	}
+#else
+	for(; i < BITSET_WORDS; ++i) {
+		dst[i] |= src[i];
+	}
+#endif
+
+	size_t count = 0;
+	for(size_t w = 0; w < BITSET_WORDS; ++w) {
+		count += std::popcount(dst[w]);
+	}
+	return count;
+}
+
+bool TestBit(const std::vector<uint64_t> &bits, uint16_t value) {
+	return (bits[value >> 6] >> (value & 63)) & 1;
+}
+
+/** Пересечение отсортированных массивов; small заметно меньше large - галопом */
+std::vector<uint16_t> IntersectArrays(const std::vector<uint16_t> &lhs, const std::vector<uint16_t> &rhs) {
+	const std::vector<uint16_t> &small = lhs.size() <= rhs.size() ? lhs : rhs;
+	const std::vector<uint16_t> &large = lhs.size() <= rhs.size() ? rhs : lhs;
+	std::vector<uint16_t> result;
+	result.reserve(small.size());
+
+	if(large.size() >= small.size() * GALLOP_RATIO) {
+		auto from = large.begin();
+		for(uint16_t value : small) {
+			// Экспоненциальный шаг, затем бинарный поиск в найденном окне
+			size_t step = 1;
+			auto to = from;
+			while(to != large.end() && *to < value) {
+				from = to;
+				to = static_cast<size_t>(large.end() - to) > step ? to + step : large.end();
+				step *= 2;
+			}
+			from = std::lower_bound(from, to, value);
+			if(from == large.end()) {
+				break;
+			}
+			if(*from == value) {
+				result.push_back(value);
+			}
+		}
+		return result;
+	}
+
+	std::set_intersection(small.begin(), small.end(), large.begin(), large.end(), std::back_inserter(result));
+	return result;
+}
+}
+
+// === ДОБАВЛЕНИЕ И УДАЛЕНИЕ ===
+
+void Bitmap::Add(uint32_t value) {
+	const uint16_t key = static_cast<uint16_t>(value >> 16);
+	const uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+
+	Container *container = nullptr;
+	if(containers_.empty() || containers_.back().key < key) {
+		containers_.push_back(Container{key, 0, {}, {}});
+		container = &containers_.back();
+	} else if(containers_.back().key == key) {
+		container = &containers_.back();
+	} else {
+		auto it = std::lower_bound(containers_.begin(), containers_.end(), key, [](const Container &c, uint16_t k) {
+			return c.key < k;
+		});
+		if(it == containers_.end() || it->key != key) {
+			it = containers_.insert(it, Container{key, 0, {}, {}});
+		}
+		container = &*it;
+	}
+
+	if(container->IsBitset()) {
+		uint64_t &word = container->bits[low >> 6];
+		const uint64_t mask = uint64_t{1} << (low & 63);
+		if(!(word & mask)) {
+			word |= mask;
+			++container->cardinality;
+		}
+		return;
+	}
+
+	std::vector<uint16_t> &array = container->array;
+	if(array.empty() || array.back() < low) {
+		array.push_back(low);  // построение по возрастанию номеров
+	} else {
+		auto it = std::lower_bound(array.begin(), array.end(), low);
+		if(it != array.end() && *it == low) {
+			return;
+		}
+		array.insert(it, low);
+	}
+	++container->cardinality;
+	if(container->cardinality > ARRAY_LIMIT) {
+		ToBitset(*container);
+	}
+}
+
+void Bitmap::Remove(uint32_t value) {
+	const uint16_t key = static_cast<uint16_t>(value >> 16);
+	const uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+	Container *container = Find(key);
+	if(!container) {
+		return;
+	}
+
+	if(container->IsBitset()) {
+		uint64_t &word = container->bits[low >> 6];
+		const uint64_t mask = uint64_t{1} << (low & 63);
+		if(!(word & mask)) {
+			return;
+		}
+		word &= ~mask;
+		--container->cardinality;
+		Normalize(*container);
+	} else {
+		auto it = std::lower_bound(container->array.begin(), container->array.end(), low);
+		if(it == container->array.end() || *it != low) {
+			return;
+		}
+		container->array.erase(it);
+		--container->cardinality;
+	}
+
+	if(container->cardinality == 0) {
+		containers_.erase(containers_.begin() + (container - containers_.data()));
+	}
+}
+
+// === ЧТЕНИЕ ===
+
+Bitmap::Container *Bitmap::Find(uint16_t key) {
+	return const_cast<Container *>(static_cast<const Bitmap *>(this)->Find(key));
+}
+
+const Bitmap::Container *Bitmap::Find(uint16_t key) const {
+	auto it = std::lower_bound(containers_.begin(), containers_.end(), key, [](const Container &c, uint16_t k) {
+		return c.key < k;
+	});
+	return it != containers_.end() && it->key == key ? &*it : nullptr;
+}
+
+bool Bitmap::Contains(uint32_t value) const {
+	const Container *container = Find(static_cast<uint16_t>(value >> 16));
+	if(!container) {
+		return false;
+	}
+	const uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+	if(container->IsBitset()) {
+		return TestBit(container->bits, low);
+	}
+	return std::binary_search(container->array.begin(), container->array.end(), low);
+}
+
+size_t Bitmap::Cardinality() const {
+	size_t count = 0;
+	for(const Container &container : containers_) {
+		count += container.cardinality;
+	}
+	return count;
+}
+
+std::vector<uint32_t> Bitmap::ToVector() const {
+	std::vector<uint32_t> result;
+	result.reserve(Cardinality());
+	for(const Container &container : containers_) {
+		const uint32_t high = static_cast<uint32_t>(container.key) << 16;
+		if(!container.IsBitset()) {
+			for(uint16_t low : container.array) {
+				result.push_back(high | low);
+			}
+			continue;
+		}
+		for(size_t w = 0; w < BITSET_WORDS; ++w) {
+			// Перебор единичных битов слова: младший бит, затем сброс его
+			for(uint64_t word = container.bits[w]; word != 0; word &= word - 1) {
+				result.push_back(high | static_cast<uint32_t>(w * 64 + std::countr_zero(word)));
+			}
+		}
+	}
+	return result;
+}
+
+size_t Bitmap::MemoryBytes() const {
+	size_t bytes = containers_.capacity() * sizeof(Container);
+	for(const Container &container : containers_) {
+		bytes += container.array.capacity() * sizeof(uint16_t) + container.bits.capacity() * sizeof(uint64_t);
+	}
+	return bytes;
+}
+
+void Bitmap::ShrinkToFit() {
+	containers_.shrink_to_fit();
+	for(Container &container : containers_) {
+		container.array.shrink_to_fit();
+	}
+}
+
+// === ПРЕОБРАЗОВАНИЕ КОНТЕЙНЕРОВ ===
+
+void Bitmap::ToBitset(Container &container) {
+	container.bits.assign(BITSET_WORDS, 0);
+	for(uint16_t low : container.array) {
+		container.bits[low >> 6] |= uint64_t{1} << (low & 63);
+	}
+	container.array.clear();
+	container.array.shrink_to_fit();
+}
+
+/** Приводит контейнер к виду, выгодному при его мощности */
+void Bitmap::Normalize(Container &container) {
+	if(container.IsBitset() && container.cardinality <= ARRAY_LIMIT) {
+		container.array.clear();
+		container.array.reserve(container.cardinality);
+		for(size_t w = 0; w < BITSET_WORDS; ++w) {
+			for(uint64_t word = container.bits[w]; word != 0; word &= word - 1) {
+				container.array.push_back(static_cast<uint16_t>(w * 64 + std::countr_zero(word)));
+			}
+		}
+		container.bits.clear();
+		container.bits.shrink_to_fit();
+	} else if(!container.IsBitset() && container.cardinality > ARRAY_LIMIT) {
+		ToBitset(container);
+	}
+}
+
+void Bitmap::AndContainer(Container &target, const Container &other) {
+	if(target.IsBitset() && other.IsBitset()) {
+		target.cardinality = static_cast<uint32_t>(AndWords(target.bits.data(), other.bits.data()));
+		Normalize(target);
+		return;
+	}
+
+	if(target.IsBitset()) {
+		// Результат не больше массива other - сразу массив
+		std::vector<uint16_t> result;
+		result.reserve(other.array.size());
+		for(uint16_t low : other.array) {
+			if(TestBit(target.bits, low)) {
+				result.push_back(low);
+			}
+		}
+		target.bits.clear();
+		target.bits.shrink_to_fit();
+		target.array = std::move(result);
+	} else if(other.IsBitset()) {
+		auto end = std::remove_if(target.array.begin(), target.array.end(), [&other](uint16_t low) {
+			return !TestBit(other.bits, low);
+		});
+		target.array.erase(end, target.array.end());
+	} else {
+		target.array = IntersectArrays(target.array, other.array);
+	}
+	target.cardinality = static_cast<uint32_t>(target.array.size());
+}
+
+void Bitmap::OrContainer(Container &target, const Container &other) {
+	if(!target.IsBitset() && !other.IsBitset() && target.array.size() + other.array.size() <= ARRAY_LIMIT) {
+		std::vector<uint16_t> result;
+		result.reserve(target.array.size() + other.array.size());
+		std::set_union(target.array.begin(), target.array.end(), other.array.begin(), other.array.end(),
+							std::back_inserter(result));
+		target.array = std::move(result);
+		target.cardinality = static_cast<uint32_t>(target.array.size());
+		return;
+	}
+
+	if(!target.IsBitset()) {
+		ToBitset(target);
+	}
+	if(other.IsBitset()) {
+		target.cardinality = static_cast<uint32_t>(OrWords(target.bits.data(), other.bits.data()));
+	} else {
+		for(uint16_t low : other.array) {
+			uint64_t &word = target.bits[low >> 6];
+			const uint64_t mask = uint64_t{1} << (low & 63);
+			target.cardinality += (word & mask) ? 0 : 1;
+			word |= mask;
+		}
+	}
+	Normalize(target);
+}
+
+// === ОПЕРАЦИИ НАД МНОЖЕСТВАМИ ===
+
+/**
+ * ПЕРЕСЕЧЕНИЕ
+ *
+ * Контейнеры сопоставляются по ключу слиянием; контейнеры без пары
+ * и опустевшие после пересечения удаляются.
+ */
+void Bitmap::AndWith(const Bitmap &other) {
+	size_t out = 0;
+	size_t j = 0;
+	for(size_t i = 0; i < containers_.size(); ++i) {
+		while(j < other.containers_.size() && other.containers_[j].key < containers_[i].key) {
+			++j;
+		}
+		if(j == other.containers_.size()) {
+			break;
+		}
+		if(other.containers_[j].key != containers_[i].key) {
+			continue;
+		}
+		AndContainer(containers_[i], other.containers_[j]);
+		if(containers_[i].cardinality > 0) {
+			if(out != i) {
+				containers_[out] = std::move(containers_[i]);
+			}
+			++out;
+		}
+	}
+	containers_.erase(containers_.begin() + out, containers_.end());
+}
+
+void Bitmap::OrWith(const Bitmap &other) {
+	std::vector<Container> result;
+	result.reserve(containers_.size() + other.containers_.size());
+	size_t i = 0;
+	size_t j = 0;
+	while(i < containers_.size() || j < other.containers_.size()) {
+		if(j == other.containers_.size() || (i < containers_.size() && containers_[i].key < other.containers_[j].key)) {
+			result.push_back(std::move(containers_[i++]));
+		} else if(i == containers_.size() || other.containers_[j].key < containers_[i].key) {
+			result.push_back(other.containers_[j++]);
+		} else {
+			OrContainer(containers_[i], other.containers_[j++]);
+			result.push_back(std::move(containers_[i++]));
+		}
+	}
+	containers_ = std::move(result);
+}
+
+Bitmap Bitmap::And(const Bitmap &lhs, const Bitmap &rhs) {
+	Bitmap result = lhs;
+	result.AndWith(rhs);
+	return result;
+}
+
+Bitmap Bitmap::Or(const Bitmap &lhs, const Bitmap &rhs) {
+	Bitmap result = lhs;
+	result.OrWith(rhs);
+	return result;
+}
+}
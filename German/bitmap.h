@@ -0,0 +1,87 @@
+#pragma once
+
+/*
+ * СЖАТОЕ БИТОВОЕ МНОЖЕСТВО (в стиле Roaring)
+ *
+ * Множество 32-битных номеров (номеров маршрутов) для быстрых пересечений
+ * и объединений. Номер делится на старшие 16 бит (ключ контейнера) и
+ * младшие 16 бит (значение внутри контейнера). Контейнер одного из двух видов:
+ * - массив: отсортированные uint16_t, пока значений не больше ARRAY_LIMIT
+ * - битовый: 1024 слова по 64 бита (8 КБ) на все 65536 значений
+ *
+ * Мелкие множества (остановка на паре маршрутов) занимают несколько байт,
+ * крупные (пересадочный узел) - не больше 8 КБ на 65536 маршрутов.
+ *
+ * ОПЕРАЦИИ:
+ * - битовый с битовым: пословное AND/OR (AVX2/SSE2, если доступны)
+ * - массив с битовым: проверка битов по значениям массива
+ * - массив с массивом: слияние, при большой разнице размеров - галоп
+ * После операции контейнер приводится к выгодному виду по мощности.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace catalogue::bitmap {
+
+class Bitmap {
+public:
+	/** Наибольшая мощность контейнера-массива; больше - битовый контейнер */
+	static constexpr size_t ARRAY_LIMIT = 4096;
+
+	/** Добавляет значение; добавление по возрастанию - O(1) */
+	void Add(uint32_t value);
+
+	/** Удаляет значение, если оно есть */
+	void Remove(uint32_t value);
+
+	bool Contains(uint32_t value) const;
+
+	bool Empty() const {
+		return containers_.empty();
+	}
+
+	size_t Cardinality() const;
+
+	/** Все значения по возрастанию */
+	std::vector<uint32_t> ToVector() const;
+
+	/** Пересечение с other на месте */
+	void AndWith(const Bitmap &other);
+
+	/** Объединение с other на месте */
+	void OrWith(const Bitmap &other);
+
+	static Bitmap And(const Bitmap &lhs, const Bitmap &rhs);
+	static Bitmap Or(const Bitmap &lhs, const Bitmap &rhs);
+
+	/** Приблизительный объём памяти (векторы контейнеров по capacity) */
+	size_t MemoryBytes() const;
+
+	/** Освобождает запас памяти векторов после построения */
+	void ShrinkToFit();
+
+private:
+	struct Container {
+		uint16_t key = 0;
+		uint32_t cardinality = 0;
+		std::vector<uint16_t> array;   // вид "массив": отсортированные значения
+		std::vector<uint64_t> bits;    // вид "битовый": 1024 слова; пуст для массива
+
+		bool IsBitset() const {
+			return !bits.empty();
+		}
+	};
+
+	Container *Find(uint16_t key);
+	const Container *Find(uint16_t key) const;
+
+	static void ToBitset(Container &container);
+	static void Normalize(Container &container);
+	static void AndContainer(Container &target, const Container &other);
+	static void OrContainer(Container &target, const Container &other);
+
+	std::vector<Container> containers_;  // по возрастанию key
+};
+}
@@ -0,0 +1,303 @@
+#include "catalogue_exporter.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+
+namespace catalogue::exporter {
+
+namespace {
+
+/**
+ * БУФЕРИЗОВАННАЯ ЗАПИСЬ В ФАЙЛ
+ *
+ * Накапливает вывод в буфере фиксированного размера и сбрасывает его
+ * в файл одним вызовом write. Числа форматируются std::to_chars -
+ * без локалей и без промежуточных строк.
+ */
+class Writer {
+public:
+	explicit Writer(const std::filesystem::path &path) : path_(path), out_(path, std::ios::binary) {
+		if(!out_) {
+			throw std::runtime_error("cannot create "s + path_.string());
+		}
+		buffer_.reserve(CAPACITY + 256);
+	}
+
+	Writer &operator<<(std::string_view text) {
+		buffer_.append(text);
+		MaybeFlush();
+		return *this;
+	}
+
+	Writer &operator<<(char c) {
+		buffer_.push_back(c);
+		MaybeFlush();
+		return *this;
+	}
+
+	Writer &operator<<(uint64_t value) {
+		char chars[24];
+		auto result = std::to_chars(chars, chars + sizeof(chars), value);
+		return *this << std::string_view(chars, result.ptr - chars);
+	}
+
+	/** Кратчайшая запись, которая читается обратно в то же самое число */
+	Writer &operator<<(double value) {
+		char chars[32];
+		auto result = std::to_chars(chars, chars + sizeof(chars), value);
+		return *this << std::string_view(chars, result.ptr - chars);
+	}
+
+	/** Поле CSV: в кавычках, только если содержит разделитель, кавычку или перевод строки */
+	Writer &Csv(std::string_view field) {
+		if(field.find_first_of(",\"\r\n"sv) == std::string_view::npos) {
+			return *this << field;
+		}
+		*this << '"';
+		for(char c : field) {
+			if(c == '"') {
+				*this << '"';
+			}
+			*this << c;
+		}
+		return *this << '"';
+	}
+
+	/** Строка JSON в кавычках */
+	Writer &JsonString(std::string_view text) {
+		*this << '"';
+		for(char c : text) {
+			switch(c) {
+				case '"':
+					*this << "\\\""sv;
+					break;
+				case '\\':
+					*this << "\\\\"sv;
+					break;
+				case '\n':
+					*this << "\\n"sv;
+					break;
+				case '\r':
+					*this << "\\r"sv;
+					break;
+				case '\t':
+					*this << "\\t"sv;
+					break;
+				default:
+					if(static_cast<unsigned char>(c) < 0x20) {
+						static constexpr char HEX[] = "0123456789abcdef";
+						*this << "\\u00"sv << HEX[(c >> 4) & 0xF] << HEX[c & 0xF];
+					} else {
+						*this << c;
+					}
+			}
+		}
+		return *this << '"';
+	}
+
+	/** Сбрасывает буфер и закрывает файл; ошибка записи - исключение */
+	void Close() {
+		Flush();
+		out_.close();
+		if(!out_) {
+			throw std::runtime_error("write failed: "s + path_.string());
+		}
+	}
+
+private:
+	static constexpr size_t CAPACITY = 1 << 20;
+
+	void MaybeFlush() {
+		if(buffer_.size() >= CAPACITY) {
+			Flush();
+		}
+	}
+
+	void Flush() {
+		out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+		buffer_.clear();
+		if(!out_) {
+			throw std::runtime_error("write failed: "s + path_.string());
+		}
+	}
+
+	std::filesystem::path path_;
+	std::ofstream out_;
+	std::string buffer_;
+};
+
+/**
+ * НОМЕРА ОСТАНОВОК
+ *
+ * stop_id остановки - её номер в порядке добавления в каталог.
+ * Указатель → номер ищется двоичным поиском по отсортированному массиву:
+ * это вдвое-втрое компактнее хеш-таблицы на миллионах остановок.
+ */
+class StopIndex {
+public:
+	explicit StopIndex(const std::deque<transport::Stop> &stops) {
+		index_.reserve(stops.size());
+		uint64_t number = 0;
+		for(const transport::Stop &stop : stops) {
+			index_.emplace_back(&stop, number++);
+		}
+		std::sort(index_.begin(), index_.end());
+	}
+
+	uint64_t Id(const transport::Stop *stop) const {
+		auto it = std::lower_bound(index_.begin(), index_.end(), std::make_pair(stop, uint64_t{0}));
+		return it->second;
+	}
+
+private:
+	std::vector<std::pair<const transport::Stop *, uint64_t>> index_;
+};
+
+/** Расстояние по дорогам с учётом обратного направления, как в TransportCatalogue::GetDistance */
+int RoadDistance(const detail::DistanceMap &distances, const transport::Stop *from, const transport::Stop *to) {
+	if(auto it = distances.find({from, to}); it != distances.end()) {
+		return it->second;
+	}
+	if(auto it = distances.find({to, from}); it != distances.end()) {
+		return it->second;
+	}
+	return 0;
+}
+
+/**
+ * Рейсы маршрута: [begin, end) в stops - остановках bus.stop_list.
+ * Некольцевой маршрут хранится как путь туда и обратно (A B C B A) -
+ * он делится на два рейса с общей конечной. Если вторая половина не является
+ * разворотом первой, маршрут выгружается одним рейсом как есть.
+ */
+std::vector<std::pair<size_t, size_t>> SplitTrips(const transport::Bus &bus, const std::vector<const transport::Stop *> &stops) {
+	if(!bus.is_roundtrip && stops.size() >= 3 && stops.size() % 2 == 1
+	   && std::equal(stops.begin(), stops.begin() + stops.size() / 2 + 1, stops.rbegin())) {
+		const size_t middle = stops.size() / 2;
+		return {{0, middle + 1}, {middle, stops.size()}};
+	}
+	return {{0, stops.size()}};
+}
+
+void WriteStops(const std::filesystem::path &directory, const TransportCatalogue &catalogue, ExportStats &stats) {
+	Writer out(directory / "stops.txt");
+	out << "stop_id,stop_name,stop_lat,stop_lon\n"sv;
+	uint64_t number = 0;
+	for(const transport::Stop &stop : catalogue.GetAllStops()) {
+		out << number++ << ',';
+		out.Csv(stop.name) << ',' << stop.coordinates.latitude << ',' << stop.coordinates.longitude << '\n';
+	}
+	out.Close();
+	stats.stops = number;
+}
+
+void WriteRoutes(const std::filesystem::path &directory, const TransportCatalogue &catalogue, ExportStats &stats) {
+	Writer out(directory / "routes.txt");
+	out << "route_id,route_short_name,route_type\n"sv;
+	uint64_t number = 0;
+	for(const transport::Bus &bus : catalogue.GetAllBuses()) {
+		out << number++ << ',';
+		out.Csv(bus.number) << ",3\n"sv;  // 3 - автобус
+	}
+	out.Close();
+	stats.buses = number;
+}
+
+/** trips.txt и stop_times.txt пишутся за один проход по маршрутам */
+void WriteTrips(const std::filesystem::path &directory, const TransportCatalogue &catalogue,
+					 const StopIndex &stop_index, ExportStats &stats) {
+	Writer trips(directory / "trips.txt");
+	Writer stop_times(directory / "stop_times.txt");
+	trips << "route_id,service_id,trip_id,direction_id\n"sv;
+	stop_times << "trip_id,arrival_time,departure_time,stop_id,stop_sequence,shape_dist_traveled\n"sv;
+
+	const detail::DistanceMap &distances = catalogue.GetAllDistances();
+	uint64_t route = 0;
+	for(const transport::Bus &bus : catalogue.GetAllBuses()) {
+		// Рейсам нужен доступ по индексу, а сжатый список читается только подряд
+		const std::vector<const transport::Stop *> stops = bus.stop_list.ToVector();
+		uint64_t direction = 0;
+		for(auto [begin, end] : SplitTrips(bus, stops)) {
+			trips << route << ",ALL,"sv << route << '_' << direction << ',' << direction << '\n';
+			++stats.trips;
+
+			uint64_t shape_dist = 0;
+			for(size_t i = begin; i < end; ++i) {
+				if(i > begin) {
+					shape_dist += static_cast<uint64_t>(RoadDistance(distances, stops[i - 1], stops[i]));
+				}
+				stop_times << route << '_' << direction << ",,,"sv << stop_index.Id(stops[i]) << ','
+							  << static_cast<uint64_t>(i - begin + 1) << ',' << shape_dist << '\n';
+			}
+			stats.stop_times += end - begin;
+			++direction;
+		}
+		++route;
+	}
+	trips.Close();
+	stop_times.Close();
+}
+
+void WriteDistances(const std::filesystem::path &directory, const TransportCatalogue &catalogue,
+						  const StopIndex &stop_index, ExportStats &stats) {
+	Writer out(directory / "road_distances.csv");
+	out << "from_stop_id,to_stop_id,distance\n"sv;
+	for(const auto &[stops, distance] : catalogue.GetAllDistances()) {
+		out << stop_index.Id(stops.first) << ',' << stop_index.Id(stops.second) << ','
+			 << static_cast<uint64_t>(std::max(distance, 0)) << '\n';
+	}
+	out.Close();
+	stats.distances = catalogue.GetAllDistances().size();
+}
+
+/** Маршруты как GeoJSON: координаты в порядке [долгота, широта] */
+void WriteGeoJson(const std::filesystem::path &directory, const TransportCatalogue &catalogue) {
+	Writer out(directory / "buses.geojson");
+	out << "{\"type\":\"FeatureCollection\",\"features\":["sv;
+	bool first = true;
+	for(const transport::Bus &bus : catalogue.GetAllBuses()) {
+		out << (first ? "\n"sv : ",\n"sv) << "{\"type\":\"Feature\",\"properties\":{\"name\":"sv;
+		first = false;
+		out.JsonString(bus.number) << ",\"is_roundtrip\":"sv << (bus.is_roundtrip ? "true"sv : "false"sv)
+		    << ",\"stops\":"sv << static_cast<uint64_t>(bus.stop_list.size())
+		    << "},\"geometry\":{\"type\":\"LineString\",\"coordinates\":["sv;
+		bool first_point = true;
+		for(const transport::Stop *stop : bus.stop_list) {
+			out << (first_point ? "["sv : ",["sv) << stop->coordinates.longitude << ',' << stop->coordinates.latitude << ']';
+			first_point = false;
+		}
+		out << "]}}"sv;
+	}
+	out << "\n]}\n"sv;
+	out.Close();
+}
+}
+
+ExportStats Export(const std::string &directory, const TransportCatalogue &catalogue) {
+	const std::filesystem::path path(directory);
+	std::error_code error;
+	std::filesystem::create_directories(path, error);
+	if(error) {
+		throw std::runtime_error("cannot create directory "s + directory + ": "s + error.message());
+	}
+
+	ExportStats stats;
+	const StopIndex stop_index(catalogue.GetAllStops());
+
+	WriteStops(path, catalogue, stats);
+	WriteRoutes(path, catalogue, stats);
+	WriteTrips(path, catalogue, stop_index, stats);
+	WriteDistances(path, catalogue, stop_index, stats);
+	WriteGeoJson(path, catalogue);
+	return stats;
+}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+/*
+ * ЭКСПОРТ ТРАНСПОРТНОГО КАТАЛОГА В CSV И GEOJSON
+ *
+ * Выгружает каталог в каталог файловой системы для внешних систем аналитики:
+ * - stops.txt          → остановки (stop_id, stop_name, stop_lat, stop_lon)
+ * - routes.txt         → маршруты (route_id, route_short_name, route_type)
+ * - trips.txt          → по одному рейсу на направление маршрута
+ * - stop_times.txt     → последовательности остановок рейсов; shape_dist_traveled -
+ *                        накопленная длина по дорогам в метрах
+ * - road_distances.csv → все заданные расстояния (from_stop_id, to_stop_id, distance)
+ * - buses.geojson      → FeatureCollection с линией (LineString) каждого маршрута
+ *
+ * СОВМЕСТИМОСТЬ:
+ * Файлы *.txt - подмножество GTFS, которое читает gtfs_reader.h: некольцевой
+ * маршрут выгружается двумя рейсами (туда и обратно) и при импорте снова
+ * собирается в один некольцевой автобус. Времена прибытия не выгружаются -
+ * в каталоге их нет.
+ *
+ * ПАМЯТЬ И СКОРОСТЬ:
+ * - Вывод идёт через буфер фиксированного размера, числа форматируются
+ *   std::to_chars - выгрузка не собирается в памяти целиком
+ * - Дополнительная память - только индекс остановка → номер (16 байт на остановку)
+ */
+
+#include "transport_catalogue.h"
+
+#include <cstddef>
+#include <string>
+
+namespace catalogue::exporter {
+
+/** Сводка экспорта */
+struct ExportStats {
+	size_t stops = 0;
+	size_t buses = 0;
+	size_t trips = 0;
+	size_t stop_times = 0;
+	size_t distances = 0;
+};
+
+/**
+ * Выгружает каталог в directory (создаётся, если его нет).
+ * @throws std::runtime_error при ошибке создания или записи файла
+ */
+ExportStats Export(const std::string &directory, const TransportCatalogue &catalogue);
+}
@@ -0,0 +1,260 @@
+#include "catalogue_reloader.h"
+#include "gtfs_reader.h"
+#include "json.h"
+#include "json_reader.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+using namespace std::literals;
+
+namespace catalogue::reload {
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+/** Шаг цикла наблюдения: с такой задержкой замечается остановка */
+constexpr std::chrono::milliseconds TICK{100};
+
+void LowerThreadPriority() {
+#if defined(__linux__)
+	// На Linux nice - свойство потока, а не процесса
+	setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#elif defined(_WIN32)
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#endif
+}
+
+/**
+ * Проверка до сборки: TransportCatalogue::SetDistance требует, чтобы обе
+ * остановки существовали, и не должен получить расстояние из битого файла
+ */
+void CheckDistances(const json::Dict &requests, const TransportCatalogue &catalogue) {
+	auto it = requests.find("base_requests"s);
+	if(it == requests.end()) {
+		return;
+	}
+	std::unordered_set<std::string_view> stops;
+	for(const json::Node &request : it->second.AsArray()) {
+		const json::Dict &content = request.AsDict();
+		if(content.at("type").AsString() == "Stop"s) {
+			stops.insert(content.at("name").AsString());
+		}
+	}
+	for(const json::Node &request : it->second.AsArray()) {
+		const json::Dict &content = request.AsDict();
+		if(content.at("type").AsString() != "Stop"s) {
+			continue;
+		}
+		for(const auto &[to, distance] : content.at("road_distances").AsDict()) {
+			if(!stops.count(to) && !catalogue.FindStop(to)) {
+				throw std::invalid_argument("distance to unknown stop: "s + to);
+			}
+		}
+	}
+}
+}
+
+/**
+ * Событие изменения файла. На Linux - inotify на каталог файла: запись
+ * через временный файл и rename меняет inode, и наблюдение за самим
+ * файлом после первой замены замолчало бы. На других системах - опрос
+ * времени изменения.
+ */
+class FileWatcher {
+public:
+	FileWatcher(const std::string &path, std::chrono::milliseconds poll_interval)
+		: path_(path), poll_interval_(poll_interval) {
+#if defined(__linux__)
+		name_ = path_.filename().string();
+		const std::filesystem::path directory = path_.has_parent_path() ? path_.parent_path() : ".";
+		fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if(fd_ < 0 || inotify_add_watch(fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+			if(fd_ >= 0) {
+				close(fd_);
+			}
+			throw std::runtime_error("cannot watch "s + path);
+		}
+#else
+		std::error_code error;
+		last_write_ = std::filesystem::last_write_time(path_, error);
+		last_check_ = Clock::now();
+#endif
+	}
+
+	~FileWatcher() {
+#if defined(__linux__)
+		close(fd_);
+#endif
+	}
+
+	FileWatcher(const FileWatcher &) = delete;
+	FileWatcher &operator=(const FileWatcher &) = delete;
+
+	/** Ждёт не дольше timeout; true - файл за это время менялся */
+	bool Wait(std::chrono::milliseconds timeout) {
+#if defined(__linux__)
+		pollfd descriptor{fd_, POLLIN, 0};
+		if(poll(&descriptor, 1, static_cast<int>(timeout.count())) <= 0) {
+			return false;
+		}
+		bool changed = false;
+		alignas(inotify_event) char buffer[4096];
+		ssize_t size;
+		while((size = read(fd_, buffer, sizeof(buffer))) > 0) {
+			for(const char *event_data = buffer; event_data < buffer + size;) {
+				const inotify_event *event = reinterpret_cast<const inotify_event *>(event_data);
+				if(event->len > 0 && name_ == event->name) {
+					changed = true;
+				}
+				event_data += sizeof(inotify_event) + event->len;
+			}
+		}
+		return changed;
+#else
+		std::this_thread::sleep_for(timeout);
+		if(Clock::now() - last_check_ < poll_interval_) {
+			return false;
+		}
+		last_check_ = Clock::now();
+		std::error_code error;
+		const std::filesystem::file_time_type write_time = std::filesystem::last_write_time(path_, error);
+		if(error || write_time == last_write_) {
+			return false;
+		}
+		last_write_ = write_time;
+		return true;
+#endif
+	}
+
+private:
+	std::filesystem::path path_;
+	std::chrono::milliseconds poll_interval_;
+#if defined(__linux__)
+	std::string name_;
+	int fd_ = -1;
+#else
+	std::filesystem::file_time_type last_write_;
+	Clock::time_point last_check_;
+#endif
+};
+
+void ApplyStorageSettings(TransportCatalogue &catalogue, const StorageSettings &settings) {
+	if(settings.stop_order) {
+		catalogue.ReorderStops(*settings.stop_order);
+	}
+	if(settings.compact_stop_lists) {
+		catalogue.CompactStopLists();
+	}
+}
+
+DatasetPtr LoadDataset(const std::string &base_path, const std::optional<std::string> &gtfs_path,
+							  const StorageSettings &storage, const gtfs::ImportSettings &gtfs) {
+	std::ifstream file(base_path);
+	if(!file) {
+		throw std::runtime_error("cannot open "s + base_path);
+	}
+	json::Document base = json::Load(file);
+	const json::Dict &requests = base.GetRoot().AsDict();
+
+	auto dataset = std::make_shared<Dataset>();
+	if(gtfs_path) {
+		gtfs::Import(*gtfs_path, dataset->catalogue, gtfs);
+	}
+	CheckDistances(requests, dataset->catalogue);
+	dataset->settings = input::LoadBase(requests, dataset->catalogue);
+	if(dataset->catalogue.GetAllStops().empty()) {
+		throw std::invalid_argument("catalogue has no stops");
+	}
+	ApplyStorageSettings(dataset->catalogue, storage);
+	return dataset;
+}
+
+CatalogueReloader::CatalogueReloader(std::string base_path, std::optional<std::string> gtfs_path, DatasetPtr initial,
+												 ReloaderSettings settings)
+	: base_path_(std::move(base_path)), gtfs_path_(std::move(gtfs_path)), settings_(settings),
+	  current_(std::move(initial)), watcher_(std::make_unique<FileWatcher>(base_path_, settings_.poll_interval)) {
+	worker_ = std::thread([this] {
+		Run();
+	});
+}
+
+CatalogueReloader::~CatalogueReloader() {
+	stopping_ = true;
+	worker_.join();
+}
+
+DatasetPtr CatalogueReloader::Current() const {
+	std::lock_guard lock(mutex_);
+	return current_;
+}
+
+size_t CatalogueReloader::Reloads() const {
+	return reloads_;
+}
+
+size_t CatalogueReloader::Failures() const {
+	return failures_;
+}
+
+/**
+ * ЦИКЛ НАБЛЮДЕНИЯ
+ *
+ * Каждое изменение файла сдвигает момент сборки на settle_delay вперёд:
+ * файл, который ещё дописывается, не собирается по частям
+ */
+void CatalogueReloader::Run() {
+	LowerThreadPriority();
+
+	std::optional<Clock::time_point> changed_at;
+	while(!stopping_) {
+		if(watcher_->Wait(TICK)) {
+			changed_at = Clock::now();
+		}
+		if(changed_at && Clock::now() - *changed_at >= settings_.settle_delay) {
+			changed_at.reset();
+			Rebuild();
+		}
+	}
+}
+
+/**
+ * Новая версия собирается целиком до замены; после замены в dataset
+ * остаётся прежняя. Если запросов на ней уже нет, она освобождается
+ * здесь же, в фоновом потоке, а не в потоке запросов
+ */
+void CatalogueReloader::Rebuild() {
+	const Clock::time_point start = Clock::now();
+	try {
+		DatasetPtr dataset = LoadDataset(base_path_, gtfs_path_, settings_.storage, settings_.gtfs);
+		const size_t stops = dataset->catalogue.GetAllStops().size();
+		const size_t buses = dataset->catalogue.GetAllBuses().size();
+		{
+			std::lock_guard lock(mutex_);
+			current_.swap(dataset);
+		}
+		++reloads_;
+		std::cerr << "reloaded "sv << base_path_ << ": "sv << stops << " stops, "sv << buses << " buses in "sv
+					 << std::chrono::duration<double>(Clock::now() - start).count() << " s"sv << std::endl;
+	} catch(const std::exception &e) {
+		++failures_;
+		std::cerr << "reload of "sv << base_path_ << " failed: "sv << e.what() << "; keeping the current catalogue"sv << std::endl;
+	}
+}
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+/*
+ * ГОРЯЧАЯ ПЕРЕЗАГРУЗКА КАТАЛОГА
+ *
+ * Сервер (request_server.h) с --watch следит за файлом base_requests и,
+ * когда файл меняется, собирает новый каталог в фоновом потоке, не
+ * останавливая обработку запросов.
+ *
+ * АРХИТЕКТУРНЫЕ РЕШЕНИЯ:
+ * 1. Каталог и настройки карты - неизменяемый Dataset под shared_ptr.
+ *    Запрос берёт указатель на текущую версию (Current) и держит его до
+ *    конца: замена не трогает запросы, которые уже выполняются, а старая
+ *    версия освобождается вместе с последним таким запросом
+ * 2. Замена - копирование shared_ptr под мьютексом: поток запросов ждёт
+ *    не дольше одного присваивания указателя
+ * 3. Сборка идёт с пониженным приоритетом (nice 19 на Linux,
+ *    THREAD_PRIORITY_LOWEST на Windows); потоки Freeze наследуют его
+ * 4. Файл, который не разбирается или не проходит проверку, в работу не
+ *    попадает: ошибка пишется в std::cerr, сервер остаётся на прежней версии
+ *
+ * ОТСЛЕЖИВАНИЕ:
+ * На Linux - inotify на каталог файла (IN_CLOSE_WRITE, IN_MOVED_TO), так что
+ * замена файла через rename тоже замечается. На других системах - опрос
+ * времени изменения раз в poll_interval. После события сборка ждёт, пока
+ * файл не перестанет меняться settle_delay; события во время сборки
+ * приводят к ещё одной сборке - в работу всегда попадает последняя версия.
+ *
+ * ПАМЯТЬ: во время сборки в памяти две версии каталога.
+ */
+
+#include "gtfs_reader.h"
+#include "map_renderer.h"
+#include "transport_catalogue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace catalogue::reload {
+
+/** Одна версия данных сервера */
+struct Dataset {
+	TransportCatalogue catalogue;
+	render::RenderSettings settings;
+};
+
+using DatasetPtr = std::shared_ptr<const Dataset>;
+
+/** Раскладка замороженного каталога в памяти */
+struct StorageSettings {
+	std::optional<detail::StopOrder> stop_order;  // порядок остановок (ReorderStops)
+	bool compact_stop_lists = false;              // сжатые списки остановок (CompactStopLists)
+};
+
+/** Применяет settings к замороженному каталогу: сначала порядок остановок, затем сжатие */
+void ApplyStorageSettings(TransportCatalogue &catalogue, const StorageSettings &settings);
+
+/**
+ * Собирает и замораживает каталог из base_path (и GTFS, если задан,
+ * с параметрами gtfs), затем применяет storage. Расстояния до неизвестных остановок и каталог
+ * без остановок отклоняются: std::invalid_argument; ошибка чтения - std::runtime_error.
+ */
+DatasetPtr LoadDataset(const std::string &base_path, const std::optional<std::string> &gtfs_path,
+							  const StorageSettings &storage = {}, const gtfs::ImportSettings &gtfs = {});
+
+class FileWatcher;
+
+struct ReloaderSettings {
+	std::chrono::milliseconds settle_delay{200};   // тишина после последнего события
+	std::chrono::milliseconds poll_interval{1000}; // опрос без inotify
+	StorageSettings storage;                       // раскладка новых версий
+	gtfs::ImportSettings gtfs;                     // импорт GTFS при каждой сборке
+};
+
+/**
+ * ФОНОВЫЙ ПЕРЕЗАГРУЗЧИК
+ *
+ * Поток наблюдения запускается в конструкторе и останавливается
+ * в деструкторе (дожидаясь текущей сборки).
+ */
+class CatalogueReloader {
+public:
+	CatalogueReloader(std::string base_path, std::optional<std::string> gtfs_path, DatasetPtr initial,
+							ReloaderSettings settings = {});
+	~CatalogueReloader();
+
+	CatalogueReloader(const CatalogueReloader &) = delete;
+	CatalogueReloader &operator=(const CatalogueReloader &) = delete;
+
+	/** Текущая версия; держать не дольше одного запроса */
+	DatasetPtr Current() const;
+
+	/** Число успешных и отклонённых пересборок */
+	size_t Reloads() const;
+	size_t Failures() const;
+
+private:
+	void Run();
+	void Rebuild();
+
+	std::string base_path_;
+	std::optional<std::string> gtfs_path_;
+	ReloaderSettings settings_;
+
+	mutable std::mutex mutex_;
+	DatasetPtr current_;
+
+	std::atomic<size_t> reloads_ = 0;
+	std::atomic<size_t> failures_ = 0;
+	std::atomic<bool> stopping_ = false;
+	std::unique_ptr<FileWatcher> watcher_;   // создаётся до потока: изменения после конструктора не теряются
+	std::thread worker_;
+};
+}
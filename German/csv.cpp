@@ -0,0 +1,183 @@
+#include "csv.h"
+
+#include <algorithm>
+
+using namespace std::literals;
+
+namespace csv {
+
+Reader::Reader(std::string_view data, bool final) : data_(data), final_(final) {
+	// Метка порядка байт UTF-8 в начале файла не является частью первого поля
+	if(data_.substr(0, 3) == "\xEF\xBB\xBF"sv) {
+		pos_ = 3;
+	}
+}
+
+/**
+ * РАЗБОР ОДНОЙ СТРОКИ
+ *
+ * АЛГОРИТМ:
+ * 1. Поле без кавычек - до ближайшей запятой или перевода строки
+ * 2. Поле в кавычках - до закрывающей кавычки; "" внутри означает кавычку,
+ *    и только такое поле копируется в unescaped_
+ * 3. Строка завершается \n (\r перед ним отбрасывается) или концом данных,
+ *    если final == true
+ * 4. Пустые строки пропускаются
+ *
+ * Позиция pos_ сдвигается только после успешного разбора всей строки,
+ * поэтому незавершённую строку можно разобрать заново после дочитывания.
+ */
+bool Reader::NextRow() {
+	while(true) {
+		fields_.clear();
+		unescaped_.clear();
+
+		size_t pos = pos_;
+		if(pos >= data_.size()) {
+			return false;
+		}
+
+		bool row_done = false;
+		while(!row_done) {
+			if(pos < data_.size() && data_[pos] == '"') {
+				// Поле в кавычках
+				size_t start = ++pos;
+				bool escaped = false;
+				while(true) {
+					size_t quote = data_.find('"', pos);
+					if(quote == std::string_view::npos) {
+						if(!final_) {
+							return false;
+						}
+						pos = data_.size();
+						break;
+					}
+					if(quote + 1 < data_.size() && data_[quote + 1] == '"') {
+						escaped = true;
+						pos = quote + 2;
+						continue;
+					}
+					if(quote + 1 == data_.size() && !final_) {
+						return false;  // не ясно, не начало ли это ""
+					}
+					pos = quote + 1;
+					break;
+				}
+
+				size_t field_end = std::min(pos, data_.size());
+				if(field_end > start && data_[field_end - 1] == '"') {
+					--field_end;
+				}
+				std::string_view field = data_.substr(start, field_end - start);
+				if(escaped) {
+					std::string &copy = unescaped_.emplace_back();
+					copy.reserve(field.size());
+					for(size_t i = 0; i < field.size(); ++i) {
+						copy.push_back(field[i]);
+						if(field[i] == '"' && i + 1 < field.size() && field[i + 1] == '"') {
+							++i;
+						}
+					}
+					field = copy;
+				}
+				fields_.push_back(field);
+
+				// После закрывающей кавычки допускаем мусор до разделителя
+				size_t next = data_.find_first_of(",\n"sv, pos);
+				pos = next == std::string_view::npos ? data_.size() : next;
+			} else {
+				size_t next = data_.find_first_of(",\n"sv, pos);
+				size_t field_end = next == std::string_view::npos ? data_.size() : next;
+				std::string_view field = data_.substr(pos, field_end - pos);
+				if(!field.empty() && field.back() == '\r') {
+					field.remove_suffix(1);
+				}
+				fields_.push_back(field);
+				pos = field_end;
+			}
+
+			if(pos >= data_.size()) {
+				if(!final_) {
+					return false;
+				}
+				row_done = true;
+			} else if(data_[pos] == '\n') {
+				++pos;
+				row_done = true;
+			} else {
+				++pos;  // запятая
+			}
+		}
+
+		pos_ = pos;
+		if(!(fields_.size() == 1 && fields_[0].empty())) {
+			return true;
+		}
+	}
+}
+
+Header::Header(const std::vector<std::string_view> &fields) {
+	names_.reserve(fields.size());
+	for(std::string_view field : fields) {
+		// Пробелы вокруг имён столбцов встречаются в реальных выгрузках
+		size_t begin = field.find_first_not_of(" \t"sv);
+		size_t end = field.find_last_not_of(" \t"sv);
+		names_.emplace_back(begin == std::string_view::npos ? std::string_view{} : field.substr(begin, end - begin + 1));
+	}
+}
+
+int Header::Find(std::string_view name) const {
+	auto it = std::find(names_.begin(), names_.end(), name);
+	return it == names_.end() ? -1 : static_cast<int>(it - names_.begin());
+}
+
+int Header::Require(std::string_view name) const {
+	int index = Find(name);
+	if(index < 0) {
+		throw std::runtime_error("CSV column not found: "s + std::string(name));
+	}
+	return index;
+}
+
+Header ReadHeader(std::istream &input, uint64_t &header_end) {
+	input.clear();
+	input.seekg(0);
+
+	std::string buffer;
+	while(true) {
+		const size_t old_size = buffer.size();
+		buffer.resize(old_size + CHUNK_SIZE);
+		input.read(buffer.data() + old_size, static_cast<std::streamsize>(CHUNK_SIZE));
+		buffer.resize(old_size + static_cast<size_t>(input.gcount()));
+		const bool final = !input;
+
+		Reader reader(buffer, final);
+		if(reader.NextRow()) {
+			header_end = reader.Consumed();
+			input.clear();
+			return Header(reader.Fields());
+		}
+		if(final) {
+			throw std::runtime_error("CSV header is missing"s);
+		}
+	}
+}
+
+uint64_t AlignToRow(std::istream &input, uint64_t offset, uint64_t file_size) {
+	if(offset == 0 || offset >= file_size) {
+		return std::min(offset, file_size);
+	}
+
+	input.clear();
+	input.seekg(static_cast<std::streamoff>(offset - 1));
+	char c;
+	while(input.get(c)) {
+		if(c == '\n') {
+			break;
+		}
+		++offset;
+	}
+	input.clear();
+	return std::min(offset, file_size);
+}
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+/*
+ * ПОТОКОВЫЙ РАЗБОР CSV БЕЗ КОПИРОВАНИЯ
+ *
+ * Модуль разбирает CSV (RFC 4180) так, как его пишут GTFS-выгрузки:
+ * - поля разделены запятыми, строки - \n или \r\n
+ * - поле может быть в кавычках, внутри кавычек "" означает одну кавычку,
+ *   а запятые и переводы строк являются частью значения
+ *
+ * ПРИНЦИПЫ РАБОТЫ:
+ * 1. Поля возвращаются как string_view на исходный буфер - без копирования.
+ *    Копия делается только для поля с экранированными кавычками ("")
+ * 2. Файл читается блоками; незавершённая строка в конце блока
+ *    переносится в начало следующего, поэтому память не зависит от размера файла
+ * 3. Файл можно обрабатывать по частям [begin, end) - так несколько потоков
+ *    разбирают один большой файл одновременно
+ */
+
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace csv {
+
+/**
+ * РАЗБОР СТРОК CSV ИЗ БУФЕРА
+ *
+ * Если final == false, буфер считается началом более длинного текста:
+ * строка, не завершённая переводом строки, не разбирается, и NextRow
+ * возвращает false - вызывающий должен дочитать данные.
+ */
+class Reader {
+public:
+	Reader(std::string_view data, bool final);
+
+	/** Разбирает следующую строку; false - данные кончились или строка не завершена */
+	bool NextRow();
+
+	/** Поля текущей строки (действительны до следующего вызова NextRow) */
+	const std::vector<std::string_view> &Fields() const {
+		return fields_;
+	}
+
+	/** Поле по номеру столбца; пустое, если столбца нет (index < 0 или строка короче) */
+	std::string_view Field(int index) const {
+		return index >= 0 && static_cast<size_t>(index) < fields_.size() ? fields_[index] : std::string_view{};
+	}
+
+	/** Число байт буфера, занятых полностью разобранными строками */
+	size_t Consumed() const {
+		return pos_;
+	}
+
+private:
+	std::string_view data_;
+	bool final_;
+	size_t pos_ = 0;
+	std::vector<std::string_view> fields_;
+	std::deque<std::string> unescaped_;  // deque: string_view на элементы не инвалидируются
+};
+
+/**
+ * ЗАГОЛОВОК CSV-ФАЙЛА
+ *
+ * Сопоставляет имена столбцов их номерам.
+ */
+class Header {
+public:
+	Header() = default;
+	explicit Header(const std::vector<std::string_view> &fields);
+
+	/** Номер столбца или -1, если столбца нет */
+	int Find(std::string_view name) const;
+
+	/** Номер обязательного столбца; std::runtime_error, если его нет */
+	int Require(std::string_view name) const;
+
+private:
+	std::vector<std::string> names_;
+};
+
+/** Размер блока чтения файла */
+inline constexpr size_t CHUNK_SIZE = 4 << 20;
+
+/**
+ * Читает заголовок (первую строку) потока.
+ * @param header_end Сюда записывается смещение начала первой строки данных
+ */
+Header ReadHeader(std::istream &input, uint64_t &header_end);
+
+/**
+ * Сдвигает offset на начало ближайшей строки (сразу после \n).
+ * Используется для разбиения файла на части между потоками; предполагается,
+ * что внутри полей в кавычках нет переводов строк (для stop_times.txt это так).
+ */
+uint64_t AlignToRow(std::istream &input, uint64_t offset, uint64_t file_size);
+
+/**
+ * Вызывает callback(const Reader &) для каждой строки, начинающейся
+ * в диапазоне [begin, end). Строка, начавшаяся до end, дочитывается целиком.
+ * begin должен указывать на начало строки.
+ */
+template <typename Callback>
+void ForEachRow(std::istream &input, uint64_t begin, uint64_t end, Callback &&callback) {
+	std::string buffer;
+	uint64_t buffer_offset = begin;  // смещение начала буфера в файле
+
+	input.clear();
+	input.seekg(static_cast<std::streamoff>(begin));
+
+	while(true) {
+		const size_t old_size = buffer.size();
+		buffer.resize(old_size + CHUNK_SIZE);
+		input.read(buffer.data() + old_size, static_cast<std::streamsize>(CHUNK_SIZE));
+		buffer.resize(old_size + static_cast<size_t>(input.gcount()));
+		const bool final = !input;
+
+		Reader reader(buffer, final);
+		while(buffer_offset + reader.Consumed() < end && reader.NextRow()) {
+			callback(static_cast<const Reader &>(reader));
+		}
+
+		if(final || buffer_offset + reader.Consumed() >= end) {
+			return;
+		}
+
+		buffer.erase(0, reader.Consumed());
+		buffer_offset += reader.Consumed();
+	}
+}
+}
@@ -0,0 +1,115 @@
+#include "definition_hash.h"
+#include "parallel.h"
+
+#include <algorithm>
+
+namespace catalogue::hashing {
+
+namespace {
+
+/** 64-битный FNV-1a */
+class Hasher {
+public:
+	void Bytes(const void *data, size_t size) {
+		const unsigned char *bytes = static_cast<const unsigned char *>(data);
+		for(size_t i = 0; i < size; ++i) {
+			hash_ = (hash_ ^ bytes[i]) * 0x100000001B3ull;
+		}
+	}
+
+	template <typename T>
+	void Put(T value) {
+		Bytes(&value, sizeof(T));
+	}
+
+	void PutString(std::string_view str) {
+		Put(static_cast<uint64_t>(str.size()));
+		Bytes(str.data(), str.size());
+	}
+
+	uint64_t Result() const {
+		return hash_;
+	}
+
+private:
+	uint64_t hash_ = 0xCBF29CE484222325ull;
+};
+}
+
+uint64_t HashStop(std::string_view name, const geo::Coordinates &coordinates,
+						std::vector<std::pair<std::string_view, int>> &distances) {
+	std::sort(distances.begin(), distances.end());
+
+	Hasher hasher;
+	hasher.PutString(name);
+	hasher.Put(coordinates.latitude);
+	hasher.Put(coordinates.longitude);
+	hasher.Put(static_cast<uint64_t>(distances.size()));
+	for(const auto &[to, distance] : distances) {
+		hasher.PutString(to);
+		hasher.Put(static_cast<int64_t>(distance));
+	}
+	return hasher.Result();
+}
+
+uint64_t HashBus(std::string_view name, const std::vector<std::string_view> &stops, bool is_roundtrip) {
+	Hasher hasher;
+	hasher.PutString(name);
+	hasher.Put(static_cast<uint8_t>(is_roundtrip));
+	hasher.Put(static_cast<uint64_t>(stops.size()));
+	for(std::string_view stop : stops) {
+		hasher.PutString(stop);
+	}
+	return hasher.Result();
+}
+
+/**
+ * ХЕШИ КАТАЛОГА
+ *
+ * АЛГОРИТМ:
+ * 1. Расстояния раскладываются по начальной остановке (сортировка
+ *    подсчётом по Stop::id): offsets[id]..offsets[id + 1] - расстояния от id
+ * 2. Остановки и маршруты хешируются параллельно, каждый номер -
+ *    в свою ячейку результата
+ */
+DefinitionHashes ComputeHashes(const TransportCatalogue &catalogue, size_t threads) {
+	const std::deque<transport::Stop> &stops = catalogue.GetAllStops();
+	const std::deque<transport::Bus> &buses = catalogue.GetAllBuses();
+	const detail::DistanceMap &distances = catalogue.GetAllDistances();
+
+	std::vector<size_t> offsets(stops.size() + 1, 0);
+	for(const auto &[stops_pair, distance] : distances) {
+		++offsets[stops_pair.first->id + 1];
+	}
+	for(size_t id = 0; id < stops.size(); ++id) {
+		offsets[id + 1] += offsets[id];
+	}
+	std::vector<std::pair<std::string_view, int>> edges(distances.size());
+	std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+	for(const auto &[stops_pair, distance] : distances) {
+		edges[cursor[stops_pair.first->id]++] = {stops_pair.second->name, distance};
+	}
+
+	DefinitionHashes hashes;
+	hashes.stops.resize(stops.size());
+	hashes.buses.resize(buses.size());
+	const size_t count = std::max(stops.size(), buses.size());
+	parallel::ForEachRange(count, threads, [&](size_t, size_t begin, size_t end) {
+		std::vector<std::pair<std::string_view, int>> stop_edges;
+		for(size_t id = begin; id < std::min(end, stops.size()); ++id) {
+			stop_edges.assign(edges.begin() + offsets[id], edges.begin() + offsets[id + 1]);
+			hashes.stops[id] = HashStop(stops[id].name, stops[id].coordinates, stop_edges);
+		}
+
+		std::vector<std::string_view> names;
+		for(size_t id = begin; id < std::min(end, buses.size()); ++id) {
+			names.clear();
+			for(const transport::Stop *stop : buses[id].stop_list) {
+				names.push_back(stop->name);
+			}
+			hashes.buses[id] = HashBus(buses[id].number, names, buses[id].is_roundtrip);
+		}
+	});
+	return hashes;
+}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+/*
+ * ХЕШИ ОПРЕДЕЛЕНИЙ ОСТАНОВОК И МАРШРУТОВ
+ *
+ * Дифференциальной загрузке base_requests (base_diff.h) нужно быстро
+ * понять, изменилось ли определение остановки или маршрута. Хеш считается
+ * по каноническому виду определения - одинаково для описания из JSON
+ * и для того, что уже лежит в каталоге:
+ * - остановка: название, координаты (биты double) и расстояния от неё
+ *   (название цели, метры), отсортированные по названию цели
+ * - маршрут: номер, признак кольцевого и названия остановок в порядке
+ *   Bus::stop_list (некольцевой - уже развёрнутый туда-обратно)
+ *
+ * Хеш - 64-битный FNV-1a; перед строкой пишется её длина, чтобы границы
+ * полей не сливались. Хеши всего каталога хранятся в снимке (journal.h)
+ * по Stop::id и Bus::id.
+ */
+
+#include "transport_catalogue.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace catalogue::hashing {
+
+/** Хеши определений по плотным номерам: stops[Stop::id], buses[Bus::id] */
+struct DefinitionHashes {
+	std::vector<uint64_t> stops;
+	std::vector<uint64_t> buses;
+};
+
+/** Хеш определения остановки; distances сортируются на месте */
+uint64_t HashStop(std::string_view name, const geo::Coordinates &coordinates,
+						std::vector<std::pair<std::string_view, int>> &distances);
+
+/** Хеш определения маршрута */
+uint64_t HashBus(std::string_view name, const std::vector<std::string_view> &stops, bool is_roundtrip);
+
+/**
+ * Хеши всех остановок и маршрутов каталога. Расстояния группируются по
+ * начальной остановке одним проходом по таблице, хеши считаются
+ * параллельно (parallel.h); threads == 0 - по числу ядер.
+ */
+DefinitionHashes ComputeHashes(const TransportCatalogue &catalogue, size_t threads = 0);
+}
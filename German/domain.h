@@ -12,6 +12,8 @@
  */
 
 #include "geo.h"
+#include "stop_list.h"
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -39,6 +41,7 @@ namespace transport {
 
 		std::string name;               // Название остановки (например, "Метро Сокольники")
 		geo::Coordinates coordinates;   // Географические координаты (широта, долгота)
+		uint32_t id = 0;                // Плотный номер: порядковый номер в каталоге
    };
 
    /**
@@ -65,7 +68,8 @@ namespace transport {
       }
 
       std::string number;                    // Номер маршрута (например, "14", "АТ-1")
-      std::vector<const Stop *> stop_list;   // Упорядоченный список указателей на остановки
+      StopList stop_list;                    // Упорядоченный список остановок (stop_list.h)
       bool is_roundtrip = false;             // true = кольцевой маршрут, false = линейный
+      uint32_t id = 0;                       // Плотный номер: порядковый номер в каталоге
    };
 } 
\ No newline at end of file
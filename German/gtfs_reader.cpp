@@ -0,0 +1,522 @@
+#include "gtfs_reader.h"
+#include "csv.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace std::literals;
+
+namespace catalogue::gtfs {
+
+namespace {
+
+constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+// === ВСПОМОГАТЕЛЬНЫЕ СТРУКТУРЫ ===
+
+/**
+ * Строковые идентификаторы GTFS → плотные номера 0, 1, 2, ...
+ * Ключи индекса ссылаются на собственное хранилище (deque не перемещает строки).
+ */
+class IdIndex {
+public:
+	/** Добавляет идентификатор; для повторного возвращает прежний номер */
+	uint32_t Add(std::string_view id) {
+		if(auto it = index_.find(id); it != index_.end()) {
+			return it->second;
+		}
+		const uint32_t number = static_cast<uint32_t>(ids_.size());
+		ids_.emplace_back(id);
+		index_.emplace(ids_.back(), number);
+		return number;
+	}
+
+	/** Номер идентификатора или NONE */
+	uint32_t Find(std::string_view id) const {
+		auto it = index_.find(id);
+		return it != index_.end() ? it->second : NONE;
+	}
+
+	const std::string &Id(uint32_t number) const {
+		return ids_[number];
+	}
+
+	size_t Size() const {
+		return ids_.size();
+	}
+
+private:
+	std::deque<std::string> ids_;
+	std::unordered_map<std::string_view, uint32_t> index_;
+};
+
+struct GtfsStop {
+	std::string name;
+	geo::Coordinates coordinates;
+};
+
+/** Данные выгрузки, нужные для разбора stop_times.txt (после загрузки только читаются) */
+struct Feed {
+	IdIndex stop_ids;
+	std::vector<GtfsStop> stops;
+	IdIndex route_ids;
+	std::vector<std::string> route_names;
+	IdIndex trip_ids;
+	std::vector<uint32_t> trip_routes;
+};
+
+/** Вариант маршрута: последовательность остановок и дорожные расстояния между соседними */
+struct Pattern {
+	uint32_t route = NONE;
+	std::vector<uint32_t> stops;
+	std::vector<int> distances;  // distances[i] - от stops[i] до stops[i + 1]
+};
+
+struct PatternHasher {
+	size_t operator()(const Pattern &pattern) const {
+		size_t hash = pattern.route;
+		for(uint32_t stop : pattern.stops) {
+			hash = hash * 1000003 ^ stop;
+		}
+		return hash;
+	}
+};
+
+// Варианты сравниваются без расстояний: берутся расстояния первого встреченного рейса
+struct PatternEqual {
+	bool operator()(const Pattern &lhs, const Pattern &rhs) const {
+		return lhs.route == rhs.route && lhs.stops == rhs.stops;
+	}
+};
+
+using PatternSet = std::unordered_set<Pattern, PatternHasher, PatternEqual>;
+
+struct StopTime {
+	uint32_t sequence;
+	uint32_t stop;
+	double shape_dist;  // NaN, если не задано
+};
+
+/** Строки stop_times.txt одного рейса */
+struct TripRows {
+	uint32_t trip = NONE;
+	std::vector<StopTime> rows;
+};
+
+/**
+ * Результат разбора одной части stop_times.txt.
+ * Первый и последний рейсы части могут продолжаться в соседних частях,
+ * поэтому они возвращаются как есть и достраиваются при слиянии.
+ */
+struct ChunkResult {
+	TripRows first;
+	TripRows last;
+	PatternSet patterns;
+	size_t rows = 0;
+};
+
+// === РАЗБОР ЗНАЧЕНИЙ ===
+
+std::string_view Trim(std::string_view text) {
+	size_t begin = text.find_first_not_of(" \t"sv);
+	if(begin == std::string_view::npos) {
+		return {};
+	}
+	size_t end = text.find_last_not_of(" \t"sv);
+	return text.substr(begin, end - begin + 1);
+}
+
+double ParseDouble(std::string_view text, double fallback) {
+	text = Trim(text);
+	double value = fallback;
+	auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+	return result.ec == std::errc{} ? value : fallback;
+}
+
+uint32_t ParseUInt(std::string_view text) {
+	text = Trim(text);
+	uint32_t value = 0;
+	std::from_chars(text.data(), text.data() + text.size(), value);
+	return value;
+}
+
+std::ifstream OpenFile(const std::filesystem::path &directory, std::string_view name) {
+	std::ifstream file(directory / name, std::ios::binary);
+	if(!file) {
+		throw std::runtime_error("cannot open GTFS file: "s + (directory / name).string());
+	}
+	return file;
+}
+
+uint64_t FileSize(std::istream &input) {
+	input.clear();
+	input.seekg(0, std::ios::end);
+	uint64_t size = static_cast<uint64_t>(input.tellg());
+	input.seekg(0);
+	return size;
+}
+
+// === ЧТЕНИЕ СПРАВОЧНЫХ ФАЙЛОВ ===
+
+/**
+ * Остановки (location_type 0 или пусто). Станции, входы и т.п. пропускаются:
+ * в stop_times.txt на них не ссылаются.
+ * Имена остановок в GTFS не уникальны, а каталог ищет по имени,
+ * поэтому повторное имя дополняется идентификатором: "Имя (stop_id)".
+ */
+void ReadStops(const std::filesystem::path &directory, Feed &feed) {
+	std::ifstream file = OpenFile(directory, "stops.txt"sv);
+	uint64_t data_begin = 0;
+	csv::Header header = csv::ReadHeader(file, data_begin);
+	const int id_col = header.Require("stop_id"sv);
+	const int name_col = header.Require("stop_name"sv);
+	const int lat_col = header.Require("stop_lat"sv);
+	const int lon_col = header.Require("stop_lon"sv);
+	const int type_col = header.Find("location_type"sv);
+
+	std::unordered_set<std::string> names;
+	csv::ForEachRow(file, data_begin, FileSize(file), [&](const csv::Reader &row) {
+		std::string_view type = Trim(row.Field(type_col));
+		if(!type.empty() && type != "0"sv) {
+			return;
+		}
+
+		std::string_view id = row.Field(id_col);
+		if(feed.stop_ids.Find(id) != NONE) {
+			return;
+		}
+		feed.stop_ids.Add(id);
+
+		std::string name(Trim(row.Field(name_col)));
+		if(!names.insert(name).second) {
+			name += " ("s + std::string(id) + ")"s;
+			names.insert(name);
+		}
+		feed.stops.push_back({std::move(name), {ParseDouble(row.Field(lat_col), 0.0), ParseDouble(row.Field(lon_col), 0.0)}});
+	});
+}
+
+void ReadRoutes(const std::filesystem::path &directory, Feed &feed) {
+	std::ifstream file = OpenFile(directory, "routes.txt"sv);
+	uint64_t data_begin = 0;
+	csv::Header header = csv::ReadHeader(file, data_begin);
+	const int id_col = header.Require("route_id"sv);
+	const int short_col = header.Find("route_short_name"sv);
+	const int long_col = header.Find("route_long_name"sv);
+
+	csv::ForEachRow(file, data_begin, FileSize(file), [&](const csv::Reader &row) {
+		std::string_view id = row.Field(id_col);
+		if(feed.route_ids.Find(id) != NONE) {
+			return;
+		}
+		feed.route_ids.Add(id);
+
+		std::string_view name = Trim(row.Field(short_col));
+		if(name.empty()) {
+			name = Trim(row.Field(long_col));
+		}
+		if(name.empty()) {
+			name = id;
+		}
+		feed.route_names.emplace_back(name);
+	});
+}
+
+void ReadTrips(const std::filesystem::path &directory, Feed &feed) {
+	std::ifstream file = OpenFile(directory, "trips.txt"sv);
+	uint64_t data_begin = 0;
+	csv::Header header = csv::ReadHeader(file, data_begin);
+	const int trip_col = header.Require("trip_id"sv);
+	const int route_col = header.Require("route_id"sv);
+
+	csv::ForEachRow(file, data_begin, FileSize(file), [&](const csv::Reader &row) {
+		uint32_t route = feed.route_ids.Find(row.Field(route_col));
+		if(route == NONE || feed.trip_ids.Find(row.Field(trip_col)) != NONE) {
+			return;
+		}
+		feed.trip_ids.Add(row.Field(trip_col));
+		feed.trip_routes.push_back(route);
+	});
+}
+
+// === РАЗБОР STOP_TIMES.TXT ===
+
+/**
+ * Превращает строки рейса в вариант маршрута:
+ * сортирует по stop_sequence, убирает повторы одной остановки подряд
+ * и вычисляет расстояния между соседними остановками.
+ */
+void AddPattern(TripRows &trip, const Feed &feed, const ImportSettings &settings, PatternSet &patterns) {
+	if(trip.trip == NONE || trip.rows.empty()) {
+		return;
+	}
+
+	std::stable_sort(trip.rows.begin(), trip.rows.end(), [](const StopTime &lhs, const StopTime &rhs) {
+		return lhs.sequence < rhs.sequence;
+	});
+
+	Pattern pattern;
+	pattern.route = feed.trip_routes[trip.trip];
+	pattern.stops.reserve(trip.rows.size());
+	pattern.distances.reserve(trip.rows.size());
+
+	const StopTime *prev = nullptr;
+	for(const StopTime &row : trip.rows) {
+		if(prev && prev->stop == row.stop) {
+			continue;
+		}
+		if(prev) {
+			double delta = (row.shape_dist - prev->shape_dist) * settings.shape_dist_scale;
+			if(!(delta > 0)) {  // NaN или неубывающие значения
+				delta = geo::ComputeDistance(feed.stops[prev->stop].coordinates, feed.stops[row.stop].coordinates);
+			}
+			pattern.distances.push_back(static_cast<int>(std::lround(delta)));
+		}
+		pattern.stops.push_back(row.stop);
+		prev = &row;
+	}
+
+	if(pattern.stops.size() >= 2) {
+		patterns.insert(std::move(pattern));
+	}
+}
+
+/**
+ * Разбирает часть stop_times.txt [begin, end).
+ * Строки с неизвестным рейсом или остановкой пропускаются.
+ */
+ChunkResult ParseStopTimesChunk(const std::filesystem::path &directory, const csv::Header &header,
+										  uint64_t begin, uint64_t end, const Feed &feed, const ImportSettings &settings) {
+	std::ifstream file = OpenFile(directory, "stop_times.txt"sv);
+	const int trip_col = header.Require("trip_id"sv);
+	const int stop_col = header.Require("stop_id"sv);
+	const int seq_col = header.Require("stop_sequence"sv);
+	const int dist_col = header.Find("shape_dist_traveled"sv);
+
+	ChunkResult result;
+	TripRows current;
+	bool has_first = false;
+
+	csv::ForEachRow(file, begin, end, [&](const csv::Reader &row) {
+		const uint32_t trip = feed.trip_ids.Find(row.Field(trip_col));
+		const uint32_t stop = feed.stop_ids.Find(row.Field(stop_col));
+		if(trip == NONE || stop == NONE) {
+			return;
+		}
+		++result.rows;
+
+		if(trip != current.trip) {
+			if(current.trip != NONE) {
+				if(!has_first) {
+					result.first = std::move(current);
+					has_first = true;
+				} else {
+					AddPattern(current, feed, settings, result.patterns);
+				}
+			}
+			current.trip = trip;
+			current.rows.clear();
+		}
+		current.rows.push_back({ParseUInt(row.Field(seq_col)), stop,
+										ParseDouble(row.Field(dist_col), std::numeric_limits<double>::quiet_NaN())});
+	});
+
+	if(current.trip != NONE) {
+		(has_first ? result.last : result.first) = std::move(current);
+	}
+	return result;
+}
+
+/**
+ * Параллельный разбор stop_times.txt.
+ *
+ * АЛГОРИТМ:
+ * 1. Файл делится на части по числу потоков, границы сдвигаются на начала строк
+ * 2. Каждый поток собирает свои варианты маршрутов
+ * 3. Рейсы на стыках частей склеиваются последовательно по порядку частей
+ * 4. Множества вариантов объединяются
+ */
+PatternSet ReadStopTimes(const std::filesystem::path &directory, const Feed &feed,
+								 const ImportSettings &settings, ImportStats &stats) {
+	std::ifstream file = OpenFile(directory, "stop_times.txt"sv);
+	uint64_t data_begin = 0;
+	csv::Header header = csv::ReadHeader(file, data_begin);
+	const uint64_t file_size = FileSize(file);
+
+	// Мелкие части не окупают отдельный поток
+	const size_t threads = std::max<size_t>(1, std::min<uint64_t>(parallel::ThreadCount(settings.threads),
+																					  (file_size - data_begin) / csv::CHUNK_SIZE + 1));
+	std::vector<uint64_t> bounds(threads + 1);
+	for(size_t i = 0; i <= threads; ++i) {
+		bounds[i] = csv::AlignToRow(file, data_begin + (file_size - data_begin) * i / threads, file_size);
+	}
+
+	std::vector<ChunkResult> chunks(threads);
+	parallel::ForEachRange(threads, threads, [&](size_t, size_t begin, size_t end) {
+		for(size_t i = begin; i < end; ++i) {
+			chunks[i] = ParseStopTimesChunk(directory, header, bounds[i], bounds[i + 1], feed, settings);
+		}
+	});
+
+	PatternSet patterns;
+	TripRows pending;
+	for(ChunkResult &chunk : chunks) {
+		stats.stop_times += chunk.rows;
+
+		if(chunk.first.trip != NONE) {
+			if(chunk.first.trip == pending.trip) {
+				pending.rows.insert(pending.rows.end(), chunk.first.rows.begin(), chunk.first.rows.end());
+			} else {
+				AddPattern(pending, feed, settings, patterns);
+				pending = std::move(chunk.first);
+			}
+		}
+		if(chunk.last.trip != NONE) {
+			AddPattern(pending, feed, settings, patterns);
+			pending = std::move(chunk.last);
+		}
+
+		if(patterns.empty()) {
+			patterns = std::move(chunk.patterns);
+		} else {
+			patterns.merge(chunk.patterns);
+		}
+	}
+	AddPattern(pending, feed, settings, patterns);
+
+	return patterns;
+}
+
+// === ЗАПОЛНЕНИЕ КАТАЛОГА ===
+
+void SetPatternDistances(const Pattern &pattern, const Feed &feed, TransportCatalogue &catalogue) {
+	for(size_t i = 0; i + 1 < pattern.stops.size(); ++i) {
+		catalogue.SetDistance(feed.stops[pattern.stops[i]].name, feed.stops[pattern.stops[i + 1]].name, pattern.distances[i]);
+	}
+}
+
+/**
+ * Добавляет в каталог автобусы одного маршрута.
+ * Вариант и его точный разворот объединяются в некольцевой автобус
+ * (список "туда и обратно", как его строит JsonReader), остальные
+ * варианты добавляются со списком остановок как есть.
+ */
+size_t AddRouteBuses(const std::string &name, std::vector<const Pattern *> &route_patterns, const Feed &feed,
+							const std::vector<const transport::Stop *> &stop_ptrs, TransportCatalogue &catalogue) {
+	// Порядок вариантов в множестве зависит от потоков - сортируем для детерминированного результата
+	std::sort(route_patterns.begin(), route_patterns.end(), [](const Pattern *lhs, const Pattern *rhs) {
+		return lhs->stops < rhs->stops;
+	});
+
+	std::map<std::vector<uint32_t>, size_t> index;
+	for(size_t i = 0; i < route_patterns.size(); ++i) {
+		index.emplace(route_patterns[i]->stops, i);
+	}
+
+	std::vector<bool> used(route_patterns.size(), false);
+	size_t added = 0;
+	for(size_t i = 0; i < route_patterns.size(); ++i) {
+		if(used[i]) {
+			continue;
+		}
+		used[i] = true;
+		const Pattern &pattern = *route_patterns[i];
+		SetPatternDistances(pattern, feed, catalogue);
+
+		std::vector<const transport::Stop *> stops;
+		for(uint32_t stop : pattern.stops) {
+			stops.push_back(stop_ptrs[stop]);
+		}
+
+		bool roundtrip = true;
+		if(pattern.stops.front() != pattern.stops.back()) {
+			std::vector<uint32_t> reversed(pattern.stops.rbegin(), pattern.stops.rend());
+			if(auto it = index.find(reversed); it != index.end() && !used[it->second]) {
+				used[it->second] = true;
+				SetPatternDistances(*route_patterns[it->second], feed, catalogue);
+				for(size_t k = 1; k < reversed.size(); ++k) {
+					stops.push_back(stop_ptrs[reversed[k]]);
+				}
+				roundtrip = false;
+			}
+		}
+
+		++added;
+		std::string bus_name = added == 1 ? name : name + " ["s + std::to_string(added) + "]"s;
+		catalogue.AddBus(bus_name, std::move(stops), roundtrip);
+	}
+	return added;
+}
+}
+
+/**
+ * ИМПОРТ GTFS
+ *
+ * ЭТАПЫ:
+ * 1. Справочники: stops.txt, routes.txt, trips.txt
+ * 2. Параллельный разбор stop_times.txt в варианты маршрутов
+ * 3. Добавление остановок, затем расстояний, затем автобусов
+ *    (в том же порядке, что и JsonReader::ApplyCommands)
+ */
+ImportStats Import(const std::string &directory, TransportCatalogue &catalogue, const ImportSettings &settings) {
+	const std::filesystem::path path(directory);
+	ImportStats stats;
+	Feed feed;
+
+	ReadStops(path, feed);
+	ReadRoutes(path, feed);
+	ReadTrips(path, feed);
+	stats.stops = feed.stops.size();
+	stats.routes = feed.route_names.size();
+	stats.trips = feed.trip_routes.size();
+
+	PatternSet patterns = ReadStopTimes(path, feed, settings, stats);
+	stats.patterns = patterns.size();
+
+	std::vector<const transport::Stop *> stop_ptrs;
+	stop_ptrs.reserve(feed.stops.size());
+	for(const GtfsStop &stop : feed.stops) {
+		catalogue.AddStop(stop.name, stop.coordinates);
+		stop_ptrs.push_back(catalogue.FindStop(stop.name));
+	}
+
+	std::vector<std::vector<const Pattern *>> by_route(feed.route_names.size());
+	for(const Pattern &pattern : patterns) {
+		by_route[pattern.route].push_back(&pattern);
+	}
+
+	// Одинаковые короткие номера у разных маршрутов различаем по route_id
+	std::unordered_map<std::string, size_t> name_count;
+	for(uint32_t route = 0; route < by_route.size(); ++route) {
+		if(!by_route[route].empty()) {
+			++name_count[feed.route_names[route]];
+		}
+	}
+
+	for(uint32_t route = 0; route < by_route.size(); ++route) {
+		if(by_route[route].empty()) {
+			continue;
+		}
+		std::string name = feed.route_names[route];
+		if(name_count[name] > 1) {
+			name += " ("s + feed.route_ids.Id(route) + ")"s;
+		}
+		stats.buses += AddRouteBuses(name, by_route[route], feed, stop_ptrs, catalogue);
+	}
+
+	return stats;
+}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+/*
+ * ИМПОРТ GTFS В ТРАНСПОРТНЫЙ КАТАЛОГ
+ *
+ * Загружает каталог напрямую из выгрузки GTFS, минуя преобразование в JSON:
+ * - stops.txt       → остановки (stop_id, stop_name, stop_lat, stop_lon)
+ * - routes.txt      → названия маршрутов (route_short_name / route_long_name)
+ * - trips.txt       → принадлежность рейсов маршрутам
+ * - stop_times.txt  → последовательности остановок рейсов и shape_dist_traveled
+ *
+ * ПРЕОБРАЗОВАНИЕ:
+ * 1. Рейсы одного маршрута с одинаковой последовательностью остановок
+ *    сворачиваются в один вариант маршрута (pattern)
+ * 2. Если у маршрута есть и вариант, и его точный разворот, они объединяются
+ *    в один некольцевой автобус - как в исходном формате каталога
+ * 3. Остальные варианты добавляются как автобусы со списком остановок
+ *    "как есть" (is_roundtrip = true); несколько вариантов одного маршрута
+ *    получают суффиксы " [2]", " [3]", ...
+ * 4. Дорожные расстояния - разности shape_dist_traveled соседних остановок;
+ *    если их нет, берётся расстояние по прямой (округлённое до метра)
+ *
+ * ПАМЯТЬ И СКОРОСТЬ:
+ * - CSV разбирается блоками без копирования полей (csv.h)
+ * - stop_times.txt - самый большой файл - делится на части по числу потоков
+ * - Хранятся только варианты маршрутов, а не все рейсы, поэтому пик памяти
+ *   определяется размером каталога и таблицей trip_id → маршрут
+ * - Ожидается, что строки одного рейса в stop_times.txt идут подряд
+ *   (так выгружают практически все системы); иначе рейс распадётся
+ *   на несколько вариантов
+ */
+
+#include "transport_catalogue.h"
+
+#include <cstddef>
+#include <string>
+
+namespace catalogue::gtfs {
+
+struct ImportSettings {
+	size_t threads = 0;             // потоки разбора stop_times.txt; 0 = по числу ядер
+	double shape_dist_scale = 1.0;  // множитель shape_dist_traveled → метры (1000, если в км)
+};
+
+/** Сводка импорта */
+struct ImportStats {
+	size_t stops = 0;
+	size_t routes = 0;
+	size_t trips = 0;
+	size_t stop_times = 0;
+	size_t patterns = 0;   // различных вариантов маршрутов
+	size_t buses = 0;      // добавлено автобусов в каталог
+};
+
+/**
+ * Импортирует GTFS из каталога directory в catalogue.
+ * @throws std::runtime_error при отсутствии файла или обязательного столбца
+ */
+ImportStats Import(const std::string &directory, TransportCatalogue &catalogue, const ImportSettings &settings = {});
+}
@@ -0,0 +1,679 @@
+#include "journal.h"
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std::literals;
+
+namespace catalogue::journal {
+
+namespace {
+
+constexpr std::string_view SNAPSHOT_MAGIC = "TCSNAP"sv;
+constexpr uint16_t SNAPSHOT_VERSION = 2;  // 1 - без хешей определений
+
+// Заголовок записи журнала: длина тела и его CRC32
+constexpr size_t RECORD_HEADER = 2 * sizeof(uint32_t);
+
+/** Таблица CRC32 (полином 0xEDB88320, как в zlib и gzip) */
+const std::array<uint32_t, 256> CRC_TABLE = [] {
+	std::array<uint32_t, 256> table{};
+	for(uint32_t i = 0; i < 256; ++i) {
+		uint32_t crc = i;
+		for(int bit = 0; bit < 8; ++bit) {
+			crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+		}
+		table[i] = crc;
+	}
+	return table;
+}();
+
+uint32_t Crc32(const char *data, size_t size) {
+	uint32_t crc = 0xFFFFFFFFu;
+	for(size_t i = 0; i < size; ++i) {
+		crc = CRC_TABLE[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+	}
+	return crc ^ 0xFFFFFFFFu;
+}
+
+/**
+ * Двоичная запись чисел и строк. Числа копируются байтами памяти,
+ * поэтому формат - little-endian на x86 и ARM, где работает сервер.
+ */
+class Encoder {
+public:
+	template <typename T>
+	void Put(T value) {
+		char bytes[sizeof(T)];
+		std::memcpy(bytes, &value, sizeof(T));
+		data_.append(bytes, sizeof(T));
+	}
+
+	void PutString(std::string_view str) {
+		Put(static_cast<uint32_t>(str.size()));
+		data_.append(str);
+	}
+
+	void PutCoordinates(const geo::Coordinates &coordinates) {
+		Put(coordinates.latitude);
+		Put(coordinates.longitude);
+	}
+
+	std::string &Data() {
+		return data_;
+	}
+
+private:
+	std::string data_;
+};
+
+/** Чтение того, что записал Encoder; выход за конец данных - std::runtime_error */
+class Decoder {
+public:
+	Decoder(const char *data, size_t size) : data_(data), size_(size) {}
+
+	template <typename T>
+	T Get() {
+		Require(sizeof(T));
+		T value;
+		std::memcpy(&value, data_ + position_, sizeof(T));
+		position_ += sizeof(T);
+		return value;
+	}
+
+	std::string GetString() {
+		const uint32_t length = Get<uint32_t>();
+		Require(length);
+		std::string str(data_ + position_, length);
+		position_ += length;
+		return str;
+	}
+
+	geo::Coordinates GetCoordinates() {
+		geo::Coordinates coordinates;
+		coordinates.latitude = Get<double>();
+		coordinates.longitude = Get<double>();
+		return coordinates;
+	}
+
+	bool AtEnd() const {
+		return position_ == size_;
+	}
+
+private:
+	void Require(size_t bytes) const {
+		if(size_ - position_ < bytes) {
+			throw std::runtime_error("unexpected end of data");
+		}
+	}
+
+	const char *data_;
+	size_t size_;
+	size_t position_ = 0;
+};
+
+/** Тело записи журнала: номер, тип и поля типа */
+std::string EncodeRecord(const Mutation &mutation, uint64_t sequence) {
+	Encoder body;
+	body.Put(sequence);
+	body.Put(static_cast<uint8_t>(mutation.type));
+	body.PutString(mutation.name);
+	switch(mutation.type) {
+		case MutationType::ADD_STOP:
+		case MutationType::UPDATE_STOP:
+			body.PutCoordinates(mutation.coordinates);
+			break;
+		case MutationType::ADD_BUS:
+			body.Put(static_cast<uint8_t>(mutation.is_roundtrip));
+			body.Put(static_cast<uint32_t>(mutation.stops.size()));
+			for(const std::string &stop : mutation.stops) {
+				body.PutString(stop);
+			}
+			break;
+		case MutationType::SET_DISTANCE:
+		case MutationType::UPDATE_DISTANCE:
+			body.PutString(mutation.to);
+			body.Put(static_cast<int32_t>(mutation.distance));
+			break;
+		case MutationType::REMOVE_DISTANCE:
+			body.PutString(mutation.to);
+			break;
+		case MutationType::REMOVE_STOP:
+		case MutationType::REMOVE_BUS:
+			break;
+	}
+	return std::move(body.Data());
+}
+
+Mutation DecodeMutation(Decoder &body) {
+	Mutation mutation;
+	const uint8_t type = body.Get<uint8_t>();
+	if(type < static_cast<uint8_t>(MutationType::ADD_STOP) || type > static_cast<uint8_t>(MutationType::REMOVE_BUS)) {
+		throw std::runtime_error("unknown mutation type");
+	}
+	mutation.type = static_cast<MutationType>(type);
+	mutation.name = body.GetString();
+	switch(mutation.type) {
+		case MutationType::ADD_STOP:
+		case MutationType::UPDATE_STOP:
+			mutation.coordinates = body.GetCoordinates();
+			break;
+		case MutationType::ADD_BUS: {
+			mutation.is_roundtrip = body.Get<uint8_t>() != 0;
+			const uint32_t count = body.Get<uint32_t>();
+			for(uint32_t i = 0; i < count; ++i) {
+				mutation.stops.push_back(body.GetString());
+			}
+			break;
+		}
+		case MutationType::SET_DISTANCE:
+		case MutationType::UPDATE_DISTANCE:
+			mutation.to = body.GetString();
+			mutation.distance = body.Get<int32_t>();
+			break;
+		case MutationType::REMOVE_DISTANCE:
+			mutation.to = body.GetString();
+			break;
+		case MutationType::REMOVE_STOP:
+		case MutationType::REMOVE_BUS:
+			break;
+	}
+	return mutation;
+}
+
+/** Сброс файла на диск: данные должны пережить сбой питания, а не только процесса */
+void SyncFile(std::FILE *file) {
+	if(std::fflush(file) != 0) {
+		throw std::runtime_error("journal write failed");
+	}
+#ifdef _WIN32
+	const int result = _commit(_fileno(file));
+#else
+	const int result = fsync(fileno(file));
+#endif
+	if(result != 0) {
+		throw std::runtime_error("fsync failed");
+	}
+}
+
+/** После rename нужно сбросить и сам каталог, иначе новая запись каталога может потеряться */
+void SyncDirectory(const std::string &directory) {
+#ifndef _WIN32
+	const int fd = open(directory.c_str(), O_RDONLY);
+	if(fd >= 0) {
+		fsync(fd);
+		close(fd);
+	}
+#else
+	(void)directory;
+#endif
+}
+
+std::string ReadFile(const std::string &path) {
+	std::ifstream file(path, std::ios::binary);
+	if(!file) {
+		return {};
+	}
+	return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+const transport::Stop *RequireStop(const TransportCatalogue &catalogue, std::string_view name) {
+	const transport::Stop *stop = catalogue.FindStop(name);
+	if(!stop) {
+		throw std::invalid_argument("stop not found");
+	}
+	return stop;
+}
+}
+
+/**
+ * ПРИМЕНЕНИЕ ИЗМЕНЕНИЯ
+ *
+ * Всё, что каталог молча пропустил бы (повторное добавление, расстояние
+ * до неизвестной остановки), отклоняется заранее: в журнал попадают
+ * только изменения, которые действительно меняют каталог.
+ */
+void Apply(const Mutation &mutation, TransportCatalogue &catalogue) {
+	switch(mutation.type) {
+		case MutationType::ADD_STOP:
+			if(catalogue.FindStop(mutation.name)) {
+				throw std::invalid_argument("stop already exists");
+			}
+			catalogue.AddStop(mutation.name, mutation.coordinates);
+			break;
+		case MutationType::ADD_BUS: {
+			if(catalogue.FindBus(mutation.name)) {
+				throw std::invalid_argument("bus already exists");
+			}
+			std::vector<const transport::Stop *> stops;
+			stops.reserve(mutation.stops.size());
+			for(const std::string &name : mutation.stops) {
+				stops.push_back(RequireStop(catalogue, name));
+			}
+			catalogue.AddBus(mutation.name, std::move(stops), mutation.is_roundtrip);
+			break;
+		}
+		case MutationType::SET_DISTANCE:
+			RequireStop(catalogue, mutation.name);
+			RequireStop(catalogue, mutation.to);
+			catalogue.SetDistance(mutation.name, mutation.to, mutation.distance);
+			break;
+		case MutationType::UPDATE_STOP:
+			catalogue.UpdateStop(mutation.name, mutation.coordinates);
+			break;
+		case MutationType::UPDATE_DISTANCE:
+			catalogue.UpdateDistance(mutation.name, mutation.to, mutation.distance);
+			break;
+		case MutationType::REMOVE_DISTANCE:
+			if(!catalogue.RemoveDistance(mutation.name, mutation.to)) {
+				throw std::invalid_argument("distance not found");
+			}
+			break;
+		case MutationType::REMOVE_STOP:
+			catalogue.RemoveStop(mutation.name);
+			break;
+		case MutationType::REMOVE_BUS:
+			catalogue.RemoveBus(mutation.name);
+			break;
+	}
+}
+
+// === СНИМОК ===
+
+/**
+ * Остановки и маршруты пишутся в порядке номеров, поэтому при загрузке
+ * AddStop и AddBus восстанавливают те же Stop::id и Bus::id, а маршруты
+ * и расстояния ссылаются на остановки по номеру, а не по названию.
+ */
+void SaveSnapshot(const TransportCatalogue &catalogue, const SnapshotInfo &info, const std::string &path) {
+	Encoder out;
+	out.Data().append(SNAPSHOT_MAGIC);
+	out.Put(SNAPSHOT_VERSION);
+	out.Put(info.sequence);
+	out.PutString(info.metadata);
+
+	const std::deque<transport::Stop> &stops = catalogue.GetAllStops();
+	const std::deque<transport::Bus> &buses = catalogue.GetAllBuses();
+	const detail::DistanceMap &distances = catalogue.GetAllDistances();
+	out.Put(static_cast<uint32_t>(stops.size()));
+	out.Put(static_cast<uint32_t>(buses.size()));
+	out.Put(static_cast<uint32_t>(distances.size()));
+
+	for(const transport::Stop &stop : stops) {
+		out.PutString(stop.name);
+		out.PutCoordinates(stop.coordinates);
+	}
+
+	for(const transport::Bus &bus : buses) {
+		out.PutString(bus.number);
+		out.Put(static_cast<uint8_t>(bus.is_roundtrip));
+		out.Put(static_cast<uint32_t>(bus.stop_list.size()));
+		for(const transport::Stop *stop : bus.stop_list) {
+			out.Put(stop->id);
+		}
+	}
+
+	for(const auto &[stops_pair, distance] : distances) {
+		out.Put(stops_pair.first->id);
+		out.Put(stops_pair.second->id);
+		out.Put(static_cast<int32_t>(distance));
+	}
+
+	const bool hashes_match = info.hashes.stops.size() == stops.size() && info.hashes.buses.size() == buses.size();
+	const hashing::DefinitionHashes hashes = hashes_match ? hashing::DefinitionHashes{} : hashing::ComputeHashes(catalogue);
+	const hashing::DefinitionHashes &stored = hashes_match ? info.hashes : hashes;
+	for(uint64_t hash : stored.stops) {
+		out.Put(hash);
+	}
+	for(uint64_t hash : stored.buses) {
+		out.Put(hash);
+	}
+
+	std::string &data = out.Data();
+	out.Put(Crc32(data.data(), data.size()));
+
+	const std::string temporary = path + ".tmp"s;
+	std::FILE *file = std::fopen(temporary.c_str(), "wb");
+	if(!file) {
+		throw std::runtime_error("cannot create "s + temporary);
+	}
+	const bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+	try {
+		if(!written) {
+			throw std::runtime_error("snapshot write failed");
+		}
+		SyncFile(file);
+	} catch(...) {
+		std::fclose(file);
+		throw;
+	}
+	std::fclose(file);
+
+	std::filesystem::rename(temporary, path);
+	SyncDirectory(std::filesystem::path(path).parent_path().string());
+}
+
+SnapshotInfo LoadSnapshot(const std::string &path, TransportCatalogue &catalogue) {
+	if(!catalogue.GetAllStops().empty() || !catalogue.GetAllBuses().empty()) {
+		throw std::logic_error("snapshot must be loaded into an empty catalogue");
+	}
+
+	const std::string data = ReadFile(path);
+	if(data.size() < SNAPSHOT_MAGIC.size() + sizeof(uint32_t)
+		|| std::string_view(data).substr(0, SNAPSHOT_MAGIC.size()) != SNAPSHOT_MAGIC) {
+		throw std::runtime_error("not a catalogue snapshot: "s + path);
+	}
+	const size_t body_size = data.size() - sizeof(uint32_t);
+	uint32_t crc;
+	std::memcpy(&crc, data.data() + body_size, sizeof(crc));
+	if(Crc32(data.data(), body_size) != crc) {
+		throw std::runtime_error("snapshot checksum mismatch: "s + path);
+	}
+
+	Decoder in(data.data() + SNAPSHOT_MAGIC.size(), body_size - SNAPSHOT_MAGIC.size());
+	const uint16_t version = in.Get<uint16_t>();
+	if(version < 1 || version > SNAPSHOT_VERSION) {
+		throw std::runtime_error("unsupported snapshot version: "s + path);
+	}
+	SnapshotInfo info;
+	info.sequence = in.Get<uint64_t>();
+	info.metadata = in.GetString();
+
+	const uint32_t stop_count = in.Get<uint32_t>();
+	const uint32_t bus_count = in.Get<uint32_t>();
+	const uint32_t distance_count = in.Get<uint32_t>();
+	catalogue.Reserve(stop_count, bus_count, distance_count);
+
+	for(uint32_t i = 0; i < stop_count; ++i) {
+		std::string name = in.GetString();
+		catalogue.AddStop(name, in.GetCoordinates());
+	}
+	const std::deque<transport::Stop> &stops = catalogue.GetAllStops();
+	if(stops.size() != stop_count) {
+		throw std::runtime_error("duplicate stop in snapshot");
+	}
+	auto stop_by_id = [&stops](uint32_t id) {
+		if(id >= stops.size()) {
+			throw std::runtime_error("bad stop id in snapshot");
+		}
+		return &stops[id];
+	};
+
+	for(uint32_t i = 0; i < bus_count; ++i) {
+		std::string name = in.GetString();
+		const bool is_roundtrip = in.Get<uint8_t>() != 0;
+		std::vector<const transport::Stop *> stop_list(in.Get<uint32_t>());
+		for(const transport::Stop *&stop : stop_list) {
+			stop = stop_by_id(in.Get<uint32_t>());
+		}
+		catalogue.AddBus(name, std::move(stop_list), is_roundtrip);
+	}
+
+	for(uint32_t i = 0; i < distance_count; ++i) {
+		const transport::Stop *from = stop_by_id(in.Get<uint32_t>());
+		const transport::Stop *to = stop_by_id(in.Get<uint32_t>());
+		catalogue.SetDistance(from->name, to->name, in.Get<int32_t>());
+	}
+
+	if(version >= 2) {
+		info.hashes.stops.resize(stop_count);
+		for(uint64_t &hash : info.hashes.stops) {
+			hash = in.Get<uint64_t>();
+		}
+		info.hashes.buses.resize(bus_count);
+		for(uint64_t &hash : info.hashes.buses) {
+			hash = in.Get<uint64_t>();
+		}
+	}
+
+	if(!in.AtEnd()) {
+		throw std::runtime_error("trailing data in snapshot: "s + path);
+	}
+	return info;
+}
+
+// === ХРАНИЛИЩЕ ===
+
+Store::Store(std::string directory, StoreSettings settings)
+	: directory_(std::move(directory)), settings_(settings) {
+	std::filesystem::create_directories(directory_);
+}
+
+Store::~Store() {
+	if(journal_) {
+		try {
+			Sync();
+		} catch(const std::exception &) {
+			// Из деструктора не бросаем; неподтверждённые записи клиенту не подтверждались
+		}
+		std::fclose(journal_);
+	}
+}
+
+std::string Store::SnapshotPath() const {
+	return (std::filesystem::path(directory_) / "snapshot.bin").string();
+}
+
+std::string Store::JournalPath() const {
+	return (std::filesystem::path(directory_) / "journal.bin").string();
+}
+
+bool Store::HasSnapshot() const {
+	return std::filesystem::exists(SnapshotPath());
+}
+
+void Store::OpenJournal(bool truncate) {
+	if(journal_) {
+		std::fclose(journal_);
+	}
+	journal_ = std::fopen(JournalPath().c_str(), truncate ? "wb" : "ab");
+	if(!journal_) {
+		throw std::runtime_error("cannot open "s + JournalPath());
+	}
+}
+
+/**
+ * ВОССТАНОВЛЕНИЕ
+ *
+ * АЛГОРИТМ:
+ * 1. Снимок (если есть) загружается в каталог, его номер - начальный
+ * 2. Журнал читается запись за записью; проверяются длина и CRC32
+ * 3. Записи с номером не больше текущего пропускаются (они уже в снимке),
+ *    остальные применяются к каталогу
+ * 4. Первая оборванная или повреждённая запись завершает журнал: файл
+ *    укорачивается до последней целой записи, и дозапись идёт с этого места
+ */
+RecoveryStats Store::Recover(TransportCatalogue &catalogue) {
+	RecoveryStats stats;
+	if(HasSnapshot()) {
+		SnapshotInfo info = LoadSnapshot(SnapshotPath(), catalogue);
+		sequence_ = info.sequence;
+		metadata_ = std::move(info.metadata);
+		// В снимке версии 1 хешей нет - они посчитаются при первом обращении
+		if(info.hashes.stops.size() == catalogue.GetAllStops().size() && info.hashes.buses.size() == catalogue.GetAllBuses().size()) {
+			hashes_ = std::move(info.hashes);
+			hashes_sequence_ = sequence_;
+			hashes_layout_ = catalogue.StopLayout();
+		}
+		stats.snapshot_loaded = true;
+		stats.snapshot_sequence = sequence_;
+	}
+
+	// Подряд идущие удаления остановок копятся и применяются одним RemoveStops
+	std::vector<std::string> removed_stops;
+	uint64_t removed_sequence = 0;
+	auto replay_removed = [&] {
+		if(removed_stops.empty()) {
+			return;
+		}
+		try {
+			catalogue.RemoveStops({removed_stops.begin(), removed_stops.end()});
+		} catch(const std::invalid_argument &e) {
+			throw std::runtime_error("journal records up to "s + std::to_string(removed_sequence) + " cannot be applied: "s + e.what());
+		}
+		sequence_ = removed_sequence;
+		stats.replayed += removed_stops.size();
+		removed_stops.clear();
+	};
+
+	const std::string data = ReadFile(JournalPath());
+	size_t position = 0;
+	while(data.size() - position >= RECORD_HEADER) {
+		uint32_t length;
+		uint32_t crc;
+		std::memcpy(&length, data.data() + position, sizeof(length));
+		std::memcpy(&crc, data.data() + position + sizeof(length), sizeof(crc));
+		const char *body_data = data.data() + position + RECORD_HEADER;
+		if(data.size() - position - RECORD_HEADER < length || Crc32(body_data, length) != crc) {
+			break;
+		}
+
+		Decoder body(body_data, length);
+		uint64_t sequence = 0;
+		Mutation mutation;
+		try {
+			sequence = body.Get<uint64_t>();
+			mutation = DecodeMutation(body);
+		} catch(const std::runtime_error &) {
+			break;  // CRC сошлась, но тело не разбирается - считаем хвост повреждённым
+		}
+
+		if(sequence <= sequence_) {
+			++stats.skipped;
+		} else if(mutation.type == MutationType::REMOVE_STOP) {
+			removed_stops.push_back(std::move(mutation.name));
+			removed_sequence = sequence;
+		} else {
+			replay_removed();
+			try {
+				journal::Apply(mutation, catalogue);
+			} catch(const std::invalid_argument &e) {
+				throw std::runtime_error("journal record "s + std::to_string(sequence) + " cannot be applied: "s + e.what());
+			}
+			sequence_ = sequence;
+			++stats.replayed;
+		}
+		position += RECORD_HEADER + length;
+	}
+	replay_removed();
+
+	stats.truncated_bytes = data.size() - position;
+	if(stats.truncated_bytes > 0) {
+		std::filesystem::resize_file(JournalPath(), position);
+	}
+	journal_bytes_ = position;
+	OpenJournal(false);
+	return stats;
+}
+
+/** Сначала изменение применяется: недопустимое бросает исключение и в журнал не попадает */
+void Store::Apply(const Mutation &mutation, TransportCatalogue &catalogue) {
+	if(!journal_) {
+		throw std::logic_error("journal is not open: call Recover first");
+	}
+	journal::Apply(mutation, catalogue);
+	Append(mutation);
+
+	if(journal_bytes_ >= settings_.checkpoint_bytes) {
+		Checkpoint(catalogue);
+	}
+}
+
+/**
+ * Подряд идущие REMOVE_STOP применяются одним RemoveStops: каждое
+ * удаление по отдельности - проход по всей таблице расстояний
+ */
+void Store::Apply(const std::vector<Mutation> &mutations, TransportCatalogue &catalogue) {
+	if(!journal_) {
+		throw std::logic_error("journal is not open: call Recover first");
+	}
+	for(size_t begin = 0; begin < mutations.size();) {
+		size_t end = begin + 1;
+		if(mutations[begin].type == MutationType::REMOVE_STOP) {
+			std::vector<std::string_view> names;
+			for(end = begin; end < mutations.size() && mutations[end].type == MutationType::REMOVE_STOP; ++end) {
+				names.push_back(mutations[end].name);
+			}
+			catalogue.RemoveStops(names);
+		} else {
+			journal::Apply(mutations[begin], catalogue);
+		}
+		for(; begin < end; ++begin) {
+			Append(mutations[begin]);
+		}
+
+		if(journal_bytes_ >= settings_.checkpoint_bytes) {
+			Checkpoint(catalogue);
+		}
+	}
+}
+
+void Store::Append(const Mutation &mutation) {
+	const std::string body = EncodeRecord(mutation, ++sequence_);
+	Encoder header;
+	header.Put(static_cast<uint32_t>(body.size()));
+	header.Put(Crc32(body.data(), body.size()));
+	pending_ += header.Data();
+	pending_ += body;
+	journal_bytes_ += RECORD_HEADER + body.size();
+}
+
+void Store::Sync() {
+	if(pending_.empty()) {
+		return;
+	}
+	if(std::fwrite(pending_.data(), 1, pending_.size(), journal_) != pending_.size()) {
+		throw std::runtime_error("journal write failed");
+	}
+	SyncFile(journal_);
+	pending_.clear();
+}
+
+/**
+ * Перед снимком журнал сбрасывается: если снимок не запишется,
+ * изменения всё равно останутся в журнале
+ */
+void Store::Checkpoint(const TransportCatalogue &catalogue) {
+	if(!journal_) {
+		throw std::logic_error("journal is not open: call Recover first");
+	}
+	Sync();
+	SaveSnapshot(catalogue, {sequence_, metadata_, Hashes(catalogue)}, SnapshotPath());
+	OpenJournal(true);
+	SyncFile(journal_);
+	journal_bytes_ = 0;
+}
+
+uint64_t Store::Sequence() const {
+	return sequence_;
+}
+
+void Store::SetMetadata(std::string metadata) {
+	metadata_ = std::move(metadata);
+}
+
+const std::string &Store::Metadata() const {
+	return metadata_;
+}
+
+const hashing::DefinitionHashes &Store::Hashes(const TransportCatalogue &catalogue) {
+	if(hashes_sequence_ != sequence_ || hashes_layout_ != catalogue.StopLayout()) {
+		hashes_ = hashing::ComputeHashes(catalogue);
+		hashes_sequence_ = sequence_;
+		hashes_layout_ = catalogue.StopLayout();
+	}
+	return hashes_;
+}
+}
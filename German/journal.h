@@ -0,0 +1,209 @@
+#pragma once
+
+/*
+ * ЖУРНАЛ ИЗМЕНЕНИЙ КАТАЛОГА (write-ahead log) И СНИМКИ
+ *
+ * Сервер, принимающий изменения каталога (AddStop, AddBus, RemoveBus...),
+ * после сбоя должен вернуться к тому же состоянию. Пересобирать каталог
+ * из JSON или GTFS долго (секунды на миллион остановок), поэтому
+ * состояние хранится в каталоге хранилища из двух файлов:
+ *
+ *   snapshot.bin - весь каталог в двоичном виде и номер последнего
+ *                  учтённого в нём изменения
+ *   journal.bin  - изменения после снимка, файл только дописывается
+ *
+ * Восстановление: снимок загружается напрямую в TransportCatalogue
+ * (без разбора JSON), затем применяются записи журнала с номером
+ * больше номера снимка.
+ *
+ * ФОРМАТ ЗАПИСИ ЖУРНАЛА (little-endian, как и снимок):
+ *   u32 длина тела | u32 CRC32 тела | тело: u64 номер, u8 тип, поля типа
+ *   строка - u32 длина и байты, координаты - два double, расстояние - i32
+ *
+ * ФОРМАТ СНИМКА:
+ *   "TCSNAP" u16 версия | u64 номер | строка метаданных приложения
+ *   | u32 число остановок, маршрутов, расстояний
+ *   | остановки: (строка, координаты)* | маршруты: (строка, u8 кольцевой,
+ *   u32 число, u32 Stop::id*)* | расстояния: (u32 Stop::id, u32 Stop::id, i32)*
+ *   | хеши определений (definition_hash.h): u64 по остановкам, u64 по маршрутам
+ *   | u32 CRC32 всего перед ним
+ *   Числа идут в начале, чтобы при загрузке сразу зарезервировать хеш-таблицы
+ *
+ * ДОЛГОВЕЧНОСТЬ:
+ * Apply только кладёт запись в буфер; Sync пишет накопленный пакет
+ * одним write и вызывает fsync. Сервер вызывает Sync перед тем, как
+ * сбросить ответы клиенту: ответ на изменение уходит только после
+ * того, как изменение на диске, а fsync оплачивается один раз на пакет.
+ *
+ * ОБРЫВ ЖУРНАЛА:
+ * Запись, оборванная сбоем на середине или с неверной CRC, и всё после
+ * неё при восстановлении отрезаются: до неё все записи целы, а ответ
+ * на неё клиенту не уходил.
+ *
+ * КОНТРОЛЬНАЯ ТОЧКА (Checkpoint):
+ * Снимок пишется во временный файл, fsync, rename поверх старого, затем
+ * журнал очищается. Сбой между шагами безопасен: записи с номером не
+ * больше номера снимка при восстановлении пропускаются. Контрольная
+ * точка делается и сама, когда журнал вырастает до checkpoint_bytes.
+ */
+
+#include "definition_hash.h"
+#include "transport_catalogue.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace catalogue::journal {
+
+enum class MutationType : uint8_t {
+	ADD_STOP = 1,
+	ADD_BUS,
+	SET_DISTANCE,
+	UPDATE_STOP,
+	UPDATE_DISTANCE,
+	REMOVE_DISTANCE,
+	REMOVE_STOP,
+	REMOVE_BUS,
+};
+
+/**
+ * ИЗМЕНЕНИЕ КАТАЛОГА
+ *
+ * Одна операция TransportCatalogue с аргументами по названиям.
+ * Используемые поля зависят от типа:
+ * - ADD_STOP, UPDATE_STOP: name, coordinates
+ * - ADD_BUS: name, stops (для некольцевого - уже развёрнутый туда-обратно), is_roundtrip
+ * - SET_DISTANCE, UPDATE_DISTANCE: name (откуда), to, distance
+ * - REMOVE_DISTANCE: name, to
+ * - REMOVE_STOP, REMOVE_BUS: name
+ */
+struct Mutation {
+	MutationType type = MutationType::ADD_STOP;
+	std::string name;
+	std::string to;
+	geo::Coordinates coordinates{};
+	int distance = 0;
+	std::vector<std::string> stops;
+	bool is_roundtrip = false;
+};
+
+/**
+ * Применяет изменение к каталогу. Недопустимое изменение (неизвестная
+ * остановка, повторное добавление, удаление остановки с маршрутами) -
+ * std::invalid_argument, каталог при этом не меняется.
+ */
+void Apply(const Mutation &mutation, TransportCatalogue &catalogue);
+
+/** Заголовок снимка */
+struct SnapshotInfo {
+	uint64_t sequence = 0;   // номер последнего учтённого изменения
+	std::string metadata;    // данные приложения, которые нужны вместе с каталогом
+	hashing::DefinitionHashes hashes;  // пустые при записи - считаются по каталогу
+};
+
+/** Пишет снимок каталога в path атомарно (временный файл, fsync, rename) */
+void SaveSnapshot(const TransportCatalogue &catalogue, const SnapshotInfo &info, const std::string &path);
+
+/**
+ * Загружает снимок в пустой каталог и возвращает его заголовок.
+ * Повреждённый снимок - std::runtime_error. Каталог не замораживается.
+ */
+SnapshotInfo LoadSnapshot(const std::string &path, TransportCatalogue &catalogue);
+
+struct StoreSettings {
+	uint64_t checkpoint_bytes = uint64_t{64} << 20;  // размер журнала для автоматической контрольной точки
+};
+
+/** Итоги восстановления */
+struct RecoveryStats {
+	bool snapshot_loaded = false;
+	uint64_t snapshot_sequence = 0;
+	size_t replayed = 0;           // применено записей журнала
+	size_t skipped = 0;            // записи, уже учтённые в снимке
+	uint64_t truncated_bytes = 0;  // отрезанный повреждённый хвост
+};
+
+/**
+ * ХРАНИЛИЩЕ: СНИМОК + ЖУРНАЛ
+ *
+ * Порядок работы:
+ * 1. Recover - восстанавливает каталог и открывает журнал на дозапись
+ * 2. Apply - применяет изменение к каталогу и, если оно допустимо,
+ *    добавляет его в журнал
+ * 3. Sync - сбрасывает пакет записей на диск
+ * Не потокобезопасно: изменения применяются из одного потока.
+ */
+class Store {
+public:
+	explicit Store(std::string directory, StoreSettings settings = {});
+	~Store();
+
+	Store(const Store &) = delete;
+	Store &operator=(const Store &) = delete;
+
+	/** В каталоге хранилища есть снимок */
+	bool HasSnapshot() const;
+
+	/**
+	 * Если снимок есть - загружает его в пустой catalogue; затем применяет
+	 * хвост журнала. Без снимка журнал применяется к уже заполненному
+	 * каталогу (например, из base_requests).
+	 */
+	RecoveryStats Recover(TransportCatalogue &catalogue);
+
+	/** Применяет изменение и добавляет его в журнал; недопустимое - std::invalid_argument */
+	void Apply(const Mutation &mutation, TransportCatalogue &catalogue);
+
+	/**
+	 * Применяет пакет изменений по порядку; подряд идущие удаления
+	 * остановок - одним проходом (RemoveStops). На недопустимом изменении -
+	 * std::invalid_argument, предшествующие остаются применёнными и в журнале.
+	 */
+	void Apply(const std::vector<Mutation> &mutations, TransportCatalogue &catalogue);
+
+	/** Пишет накопленные записи и ждёт fsync; ничего не делает, если их нет */
+	void Sync();
+
+	/** Новый снимок и пустой журнал */
+	void Checkpoint(const TransportCatalogue &catalogue);
+
+	/** Номер последнего изменения */
+	uint64_t Sequence() const;
+
+	/**
+	 * Метаданные снимка: пишутся при следующей контрольной точке,
+	 * читаются Recover. Сервер хранит в них render_settings, чтобы
+	 * при восстановлении не разбирать исходный JSON.
+	 */
+	void SetMetadata(std::string metadata);
+	const std::string &Metadata() const;
+
+	/**
+	 * Хеши определений каталога по номерам (для base_diff.h). Пока после
+	 * снимка не было изменений и остановки не перенумерованы
+	 * (TransportCatalogue::StopLayout) - хеши из снимка, иначе считаются заново.
+	 */
+	const hashing::DefinitionHashes &Hashes(const TransportCatalogue &catalogue);
+
+private:
+	std::string SnapshotPath() const;
+	std::string JournalPath() const;
+	void OpenJournal(bool truncate);
+	void Append(const Mutation &mutation);  // запись изменения в pending_ под следующим номером
+
+	std::string directory_;
+	StoreSettings settings_;
+	std::FILE *journal_ = nullptr;
+	std::string pending_;           // записи, ещё не отданные write
+	uint64_t journal_bytes_ = 0;    // размер журнала с учётом pending_
+	uint64_t sequence_ = 0;
+	std::string metadata_;
+	hashing::DefinitionHashes hashes_;
+	std::optional<uint64_t> hashes_sequence_;  // номер изменения, на котором посчитаны hashes_
+	uint64_t hashes_layout_ = 0;               // раскладка остановок, по номерам которой посчитаны hashes_
+};
+}
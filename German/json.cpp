@@ -1,6 +1,7 @@
 #include "json.h"
 
 #include <iterator>
+#include <stdexcept>
 
 /*
  * РЕАЛИЗАЦИЯ JSON ПАРСЕРА
@@ -345,11 +346,15 @@ struct PrintContext {
 	std::ostream& out;        // Поток для записи JSON
 	int indent_step = 4;      // Размер отступа (количество пробелов на уровень)
 	int indent = 0;           // Текущий отступ
+	bool pretty = true;       // false = компактный вывод в одну строку (NDJSON)
 
 	/**
 	 * Выводит отступ для текущего уровня вложенности
 	 */
 	void PrintIndent() const {
+		if (!pretty) {
+			return;
+		}
 		for (int i = 0; i < indent; ++i) {
 			out.put(' ');
 		}
@@ -360,7 +365,14 @@ struct PrintContext {
 	 * Используется при входе в массив или объект
 	 */
 	PrintContext Indented() const {
-		return {out, indent_step, indent_step + indent};
+		return {out, indent_step, indent_step + indent, pretty};
+	}
+
+	/** Перевод строки между элементами (в компактном режиме не выводится) */
+	void PrintNewLine() const {
+		if (pretty) {
+			out.put('\n');
+		}
 	}
 };
 
@@ -420,19 +432,21 @@ void PrintValue<bool>(const bool& value, const PrintContext& ctx) {
 template <>
 void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
 	std::ostream& out = ctx.out;
-	out << "[\n"sv;
+	out.put('[');
+	ctx.PrintNewLine();
 	bool first = true;
 	auto inner_ctx = ctx.Indented();
 	for (const Node& node : nodes) {
 		if (first) {
 			first = false;
 		} else {
-			out << ",\n"sv;
+			out.put(',');
+			ctx.PrintNewLine();
 		}
 		inner_ctx.PrintIndent();
 		PrintNode(node, inner_ctx);
 	}
-	out.put('\n');
+	ctx.PrintNewLine();
 	ctx.PrintIndent();
 	out.put(']');
 }
@@ -440,21 +454,23 @@ void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
 template <>
 void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
 	std::ostream& out = ctx.out;
-	out << "{\n"sv;
+	out.put('{');
+	ctx.PrintNewLine();
 	bool first = true;
 	auto inner_ctx = ctx.Indented();
 	for (const auto& [key, node] : nodes) {
 		if (first) {
 			first = false;
 		} else {
-			out << ",\n"sv;
+			out.put(',');
+			ctx.PrintNewLine();
 		}
 		inner_ctx.PrintIndent();
 		PrintString(key, ctx.out);
-		out << ": "sv;
+		out << (ctx.pretty ? ": "sv : ":"sv);
 		PrintNode(node, inner_ctx);
 	}
-	out.put('\n');
+	ctx.PrintNewLine();
 	ctx.PrintIndent();
 	out.put('}');
 }
@@ -509,4 +525,123 @@ void Print(const Document& doc, std::ostream& output) {
 	PrintNode(doc.GetRoot(), PrintContext{output});
 }
 
-}  // namespace json 
\ No newline at end of file
+/**
+ * КОМПАКТНЫЙ ВЫВОД JSON УЗЛА
+ * 
+ * Выводит узел в одну строку без отступов и переносов.
+ * Используется для построчных потоков NDJSON (режим сервера, журнал запросов).
+ * 
+ * @param node Узел для вывода
+ * @param output Поток для записи
+ */
+void PrintCompact(const Node& node, std::ostream& output) {
+	PrintNode(node, PrintContext{output, 0, 0, false});
+}
+
+// === ПОТОКОВЫЙ ВЫВОД ===
+
+void StreamWriter::BeforeValue() {
+	if(levels_.empty()) {
+		return;
+	}
+	Level &level = levels_.back();
+	if(level.is_dict) {
+		if(!after_key_) {
+			throw std::logic_error("Cannot write value - dictionary expects a key");
+		}
+		after_key_ = false;
+		return;
+	}
+	if(!level.empty) {
+		output_.put(',');
+	}
+	level.empty = false;
+}
+
+StreamWriter &StreamWriter::StartDict() {
+	BeforeValue();
+	output_.put('{');
+	levels_.push_back({true, true});
+	return *this;
+}
+
+StreamWriter &StreamWriter::EndDict() {
+	if(levels_.empty() || !levels_.back().is_dict || after_key_) {
+		throw std::logic_error("Cannot end dict - current value is not a finished dictionary");
+	}
+	levels_.pop_back();
+	output_.put('}');
+	return *this;
+}
+
+StreamWriter &StreamWriter::StartArray() {
+	BeforeValue();
+	output_.put('[');
+	levels_.push_back({false, true});
+	return *this;
+}
+
+StreamWriter &StreamWriter::EndArray() {
+	if(levels_.empty() || levels_.back().is_dict) {
+		throw std::logic_error("Cannot end array - current value is not an array");
+	}
+	levels_.pop_back();
+	output_.put(']');
+	return *this;
+}
+
+StreamWriter &StreamWriter::Key(const std::string &key) {
+	if(levels_.empty() || !levels_.back().is_dict || after_key_) {
+		throw std::logic_error("Cannot use Key() - current object is not a dictionary");
+	}
+	if(!levels_.back().empty) {
+		output_.put(',');
+	}
+	levels_.back().empty = false;
+	PrintString(key, output_);
+	output_.put(':');
+	after_key_ = true;
+	return *this;
+}
+
+StreamWriter &StreamWriter::Value(std::nullptr_t) {
+	BeforeValue();
+	output_ << "null"sv;
+	return *this;
+}
+
+StreamWriter &StreamWriter::Value(bool value) {
+	BeforeValue();
+	output_ << (value ? "true"sv : "false"sv);
+	return *this;
+}
+
+StreamWriter &StreamWriter::Value(int value) {
+	BeforeValue();
+	output_ << value;
+	return *this;
+}
+
+StreamWriter &StreamWriter::Value(double value) {
+	BeforeValue();
+	output_ << value;
+	return *this;
+}
+
+StreamWriter &StreamWriter::Value(const std::string &value) {
+	BeforeValue();
+	PrintString(value, output_);
+	return *this;
+}
+
+StreamWriter &StreamWriter::Value(const char *value) {
+	return Value(std::string(value));
+}
+
+StreamWriter &StreamWriter::Value(const Node &node) {
+	BeforeValue();
+	PrintCompact(node, output_);
+	return *this;
+}
+
+}  // namespace json
@@ -302,4 +302,68 @@ Document Load(std::istream& input);
  */
 void Print(const Document& doc, std::ostream& output);
 
+/**
+ * КОМПАКТНЫЙ ВЫВОД JSON В ПОТОК
+ * 
+ * Выводит узел в одну строку (без отступов и переносов строк).
+ * Это формат одной записи NDJSON; перевод строки после записи добавляет вызывающий.
+ * 
+ * @param node Узел для вывода
+ * @param output Поток для записи JSON
+ */
+void PrintCompact(const Node& node, std::ostream& output);
+
+/**
+ * ПОТОКОВЫЙ ВЫВОД JSON
+ * 
+ * Пишет компактный JSON по мере вызовов, не собирая дерево Node целиком:
+ * для ответов, которые в виде дерева заняли бы в несколько раз больше
+ * памяти, чем текст (отчёт по всей сети). Запятые между элементами
+ * расставляются автоматически. Методы повторяют json::Builder, поэтому
+ * один шаблон вывода может писать и в Builder, и в поток.
+ * 
+ * ПРИМЕР:
+ *   StreamWriter writer(out);
+ *   writer.StartDict().Key("items").StartArray();
+ *   for(...) writer.Value(item);
+ *   writer.EndArray().EndDict();
+ * 
+ * @throws std::logic_error при нарушении структуры (Key вне словаря,
+ *         значение без ключа в словаре, лишний End*)
+ */
+class StreamWriter {
+public:
+	explicit StreamWriter(std::ostream &output) : output_(output) {}
+
+	StreamWriter &StartDict();
+	StreamWriter &EndDict();
+	StreamWriter &StartArray();
+	StreamWriter &EndArray();
+	StreamWriter &Key(const std::string &key);
+
+	/** Скаляры пишутся сразу в поток, без временного Node */
+	StreamWriter &Value(std::nullptr_t);
+	StreamWriter &Value(bool value);
+	StreamWriter &Value(int value);
+	StreamWriter &Value(double value);
+	StreamWriter &Value(const std::string &value);
+	StreamWriter &Value(const char *value);
+	/** Готовое поддерево (массив или словарь) */
+	StreamWriter &Value(const Node &node);
+
+private:
+	/** Открытый словарь или массив */
+	struct Level {
+		bool is_dict = false;
+		bool empty = true;
+	};
+
+	/** Запятая перед элементом и проверка, что значение здесь допустимо */
+	void BeforeValue();
+
+	std::ostream &output_;
+	std::vector<Level> levels_;
+	bool after_key_ = false;
+};
+
 }  // namespace json 
\ No newline at end of file
@@ -1,6 +1,13 @@
 #include "json_reader.h"
 #include "json_builder.h"
+#include "network_report.h"
+#include "route_similarity.h"
+#include "stop_proximity.h"
+#include <algorithm>
+#include <limits>
+#include <optional>
 #include <sstream>
+#include <unordered_map>
 using namespace std::literals;
 
 namespace catalogue::input {
@@ -110,6 +117,75 @@ render::RenderSettings ParseRenderSettings(const json::Dict &settings) {
 
 	return result;
 }
+
+render::RenderSettings LoadBase(const json::Dict &requests, TransportCatalogue &catalogue) {
+	// base_requests может отсутствовать, если каталог уже заполнен (например, из GTFS)
+	if(auto it = requests.find("base_requests"s); it != requests.end()) {
+		JsonReader reader;
+		reader.ParseDocument(it->second.AsArray());
+		reader.ApplyCommands(catalogue);
+	}
+	catalogue.Freeze();
+
+	return ParseRenderSettings(requests.at("render_settings").AsDict());
+}
+
+/**
+ * Запросы на изменение каталога в серверном режиме:
+ *   {"id": 1, "type": "AddStop", "name": "A", "latitude": 55.6, "longitude": 37.2}
+ *   {"id": 2, "type": "AddBus", "name": "14", "stops": ["A", "B"], "is_roundtrip": false}
+ *   {"id": 3, "type": "SetDistance", "from": "A", "to": "B", "distance": 1200}
+ * а также UpdateStop (как AddStop), UpdateDistance (как SetDistance),
+ * RemoveDistance (from, to), RemoveStop и RemoveBus (name).
+ * Маршрут задаётся так же, как в base_requests.
+ */
+std::optional<journal::Mutation> ParseMutation(const json::Dict &request) {
+	static const std::unordered_map<std::string_view, journal::MutationType> types = {
+		{"AddStop"sv, journal::MutationType::ADD_STOP},
+		{"AddBus"sv, journal::MutationType::ADD_BUS},
+		{"SetDistance"sv, journal::MutationType::SET_DISTANCE},
+		{"UpdateStop"sv, journal::MutationType::UPDATE_STOP},
+		{"UpdateDistance"sv, journal::MutationType::UPDATE_DISTANCE},
+		{"RemoveDistance"sv, journal::MutationType::REMOVE_DISTANCE},
+		{"RemoveStop"sv, journal::MutationType::REMOVE_STOP},
+		{"RemoveBus"sv, journal::MutationType::REMOVE_BUS},
+	};
+
+	auto type = types.find(request.at("type").AsString());
+	if(type == types.end()) {
+		return std::nullopt;
+	}
+
+	journal::Mutation mutation;
+	mutation.type = type->second;
+	switch(mutation.type) {
+		case journal::MutationType::ADD_STOP:
+		case journal::MutationType::UPDATE_STOP:
+			mutation.name = request.at("name").AsString();
+			mutation.coordinates = geo::Coordinates(request.at("latitude").AsDouble(), request.at("longitude").AsDouble());
+			break;
+		case journal::MutationType::ADD_BUS: {
+			BusDescription bus(request);
+			mutation.name = bus.name;
+			mutation.stops.assign(bus.stops.begin(), bus.stops.end());
+			mutation.is_roundtrip = bus.is_roundtrip;
+			break;
+		}
+		case journal::MutationType::SET_DISTANCE:
+		case journal::MutationType::UPDATE_DISTANCE:
+			mutation.distance = request.at("distance").AsInt();
+			[[fallthrough]];
+		case journal::MutationType::REMOVE_DISTANCE:
+			mutation.name = request.at("from").AsString();
+			mutation.to = request.at("to").AsString();
+			break;
+		case journal::MutationType::REMOVE_STOP:
+		case journal::MutationType::REMOVE_BUS:
+			mutation.name = request.at("name").AsString();
+			break;
+	}
+	return mutation;
+}
 }
 
 namespace catalogue::output {
@@ -168,18 +244,201 @@ json::Node LoadMapNode(const json::Dict &stat_info, const TransportCatalogue &ca
 					  .EndDict().Build();
 }
 
+/**
+ * Запросы по набору остановок: {"id": 1, "type": "CommonBuses", "stops": ["A", "B"]}
+ * Неизвестная остановка в наборе - ответ "not found", как у запроса Stop.
+ */
+template <typename Query>
+json::Node LoadStopSetNode(const json::Dict &stat_info, const TransportCatalogue &catalogue, Query query) {
+	json::Builder builder;
+	builder.StartDict().Key("request_id").Value(stat_info.at("id").AsInt());
+
+	std::vector<const transport::Stop *> stops;
+	for(const json::Node &name : stat_info.at("stops").AsArray()) {
+		const transport::Stop *stop = catalogue.FindStop(name.AsString());
+		if(!stop) {
+			return builder.Key("error_message").Value("not found").EndDict().Build();
+		}
+		stops.push_back(stop);
+	}
+
+	json::Array json_buses;
+	for(std::string_view bus : (catalogue.*query)(stops)) {
+		json_buses.push_back(json::Node(std::string(bus)));
+	}
+	return builder.Key("buses").Value(json_buses).EndDict().Build();
+}
+
+/**
+ * Первые K по показателю: {"id": 1, "type": "TopK", "metric": "route_length", "k": 50}
+ * metric: route_length, curvature, stop_count, unique_stop_count (маршруты)
+ * или stop_degree (остановки); необязательный "order": "asc" - по возрастанию.
+ */
+json::Node LoadTopKNode(const json::Dict &stat_info, const TransportCatalogue &catalogue) {
+	static const std::unordered_map<std::string_view, detail::RankMetric> metrics = {
+		{"route_length"sv, detail::RankMetric::ROUTE_LENGTH},
+		{"curvature"sv, detail::RankMetric::CURVATURE},
+		{"stop_count"sv, detail::RankMetric::STOP_COUNT},
+		{"unique_stop_count"sv, detail::RankMetric::UNIQUE_STOP_COUNT},
+		{"stop_degree"sv, detail::RankMetric::STOP_DEGREE},
+	};
+
+	json::Builder builder;
+	builder.StartDict().Key("request_id").Value(stat_info.at("id").AsInt());
+
+	auto metric = metrics.find(stat_info.at("metric").AsString());
+	if(metric == metrics.end()) {
+		return builder.Key("error_message").Value("unknown metric").EndDict().Build();
+	}
+	const int k = stat_info.at("k").AsInt();
+	auto order = stat_info.find("order"s);
+	const bool ascending = order != stat_info.end() && order->second.AsString() == "asc"s;
+
+	// Кривизна дробная, остальные показатели - целые числа
+	const bool integer = metric->second != detail::RankMetric::CURVATURE;
+	json::Array items;
+	for(const detail::RankEntry &entry : catalogue.GetTopK(metric->second, k > 0 ? k : 0, ascending)) {
+		json::Node::Value value = integer ? json::Node::Value(static_cast<int>(entry.value)) : json::Node::Value(entry.value);
+		items.push_back(json::Builder{}.StartDict()
+											 .Key("name").Value(std::string(entry.name))
+											 .Key("value").Value(std::move(value))
+											 .EndDict().Build());
+	}
+	return builder.Key("items").Value(items).EndDict().Build();
+}
+
+/**
+ * Дублирующие маршруты: {"id": 1, "type": "SimilarBuses", "threshold": 0.7}
+ * Необязательные поля: "name" - только маршруты, похожие на данный
+ * (ответ "buses"), иначе все пары (ответ "pairs"); "limit" - не больше
+ * стольких элементов. Сходство - оценка MinHash (route_similarity.h)
+ * по индексу, который каталог строит один раз (GetSimilarityIndex).
+ */
+json::Node LoadSimilarBusesNode(const json::Dict &stat_info, const TransportCatalogue &catalogue) {
+	json::Builder builder;
+	builder.StartDict().Key("request_id").Value(stat_info.at("id").AsInt());
+
+	const double threshold = stat_info.at("threshold").AsDouble();
+	size_t limit = std::numeric_limits<size_t>::max();
+	if(auto it = stat_info.find("limit"s); it != stat_info.end()) {
+		limit = static_cast<size_t>(std::max(0, it->second.AsInt()));
+	}
+
+	const transport::Bus *bus = nullptr;
+	if(auto it = stat_info.find("name"s); it != stat_info.end()) {
+		bus = catalogue.FindBus(it->second.AsString());
+		if(!bus) {
+			return builder.Key("error_message").Value("not found").EndDict().Build();
+		}
+	}
+
+	const std::shared_ptr<const similarity::RouteSimilarityIndex> index = catalogue.GetSimilarityIndex();
+	const std::vector<similarity::SimilarPair> pairs = bus ? index->FindSimilar(*bus, threshold) : index->FindPairs(threshold);
+
+	json::Array items;
+	for(size_t i = 0; i < std::min(limit, pairs.size()); ++i) {
+		const similarity::SimilarPair &pair = pairs[i];
+		json::Builder item;
+		item.StartDict();
+		if(bus) {
+			item.Key("name").Value(pair.second->number);
+		} else {
+			item.Key("first").Value(pair.first->number).Key("second").Value(pair.second->number);
+		}
+		items.push_back(item.Key("similarity").Value(pair.similarity)
+								  .Key("segment_similarity").Value(pair.segment_similarity)
+								  .EndDict().Build());
+	}
+	return builder.Key(bus ? "buses"s : "pairs"s).Value(items).EndDict().Build();
+}
+
+/**
+ * Кандидаты на слияние: {"id": 1, "type": "NearbyStopPairs", "radius": 15}
+ * Пары остановок не дальше radius метров, по возрастанию расстояния;
+ * необязательный "limit" - не больше стольких пар.
+ */
+json::Node LoadNearbyStopPairsNode(const json::Dict &stat_info, const TransportCatalogue &catalogue) {
+	size_t limit = std::numeric_limits<size_t>::max();
+	if(auto it = stat_info.find("limit"s); it != stat_info.end()) {
+		limit = static_cast<size_t>(std::max(0, it->second.AsInt()));
+	}
+
+	const std::vector<proximity::StopPair> pairs = proximity::FindNearbyStopPairs(catalogue, stat_info.at("radius").AsDouble());
+	json::Array items;
+	for(size_t i = 0; i < std::min(limit, pairs.size()); ++i) {
+		items.push_back(json::Builder{}.StartDict()
+											 .Key("first").Value(pairs[i].first->name)
+											 .Key("second").Value(pairs[i].second->name)
+											 .Key("distance").Value(pairs[i].distance)
+											 .EndDict().Build());
+	}
+	return json::Builder{}.StartDict()
+								 .Key("request_id").Value(stat_info.at("id").AsInt())
+								 .Key("pairs").Value(items)
+								 .EndDict().Build();
+}
+
+json::Node ContainerStatsNode(const detail::ContainerStats &stats) {
+	return json::Builder{}.StartDict()
+								 .Key("size").Value(static_cast<int>(stats.size))
+								 .Key("bucket_count").Value(static_cast<int>(stats.bucket_count))
+								 .Key("load_factor").Value(stats.load_factor)
+								 .Key("bytes").Value(static_cast<double>(stats.bytes))
+								 .EndDict().Build();
+}
+
+// Объёмы памяти выводятся как double: в int не помещается больше 2 ГБ
+json::Node LoadCatalogueStatsNode(const json::Dict &stat_info, const TransportCatalogue &catalogue) {
+	detail::CatalogueStats stats = catalogue.GetStats();
+
+	return json::Builder{}.StartDict()
+								 .Key("request_id").Value(stat_info.at("id").AsInt())
+								 .Key("stops").Value(ContainerStatsNode(stats.stops).GetValue())
+								 .Key("buses").Value(ContainerStatsNode(stats.buses).GetValue())
+								 .Key("stops_ptr").Value(ContainerStatsNode(stats.stops_ptr).GetValue())
+								 .Key("buses_ptr").Value(ContainerStatsNode(stats.buses_ptr).GetValue())
+								 .Key("stop_buses").Value(ContainerStatsNode(stats.stop_buses).GetValue())
+								 .Key("distances").Value(ContainerStatsNode(stats.distances).GetValue())
+								 .Key("stop_bus_index").Value(ContainerStatsNode(stats.stop_bus_index).GetValue())
+								 .Key("ranks").Value(ContainerStatsNode(stats.ranks).GetValue())
+								 .Key("string_bytes").Value(static_cast<double>(stats.string_bytes))
+								 .Key("stop_list_bytes").Value(static_cast<double>(stats.stop_list_bytes))
+								 .Key("total_bytes").Value(static_cast<double>(stats.total_bytes))
+								 .EndDict().Build();
+}
+
+std::optional<json::Node> ProcessStatRequest(const json::Dict &request, const TransportCatalogue &catalogue, const render::RenderSettings &settings) {
+	if(request.at("type").AsString() == "Bus"s) {
+		return LoadBusNode(request, catalogue);
+	} else if(request.at("type").AsString() == "Stop"s) {
+		return LoadStopNode(request, catalogue);
+	} else if(request.at("type").AsString() == "Map"s) {
+		return LoadMapNode(request, catalogue, settings);
+	} else if(request.at("type").AsString() == "CatalogueStats"s) {
+		return LoadCatalogueStatsNode(request, catalogue);
+	} else if(request.at("type").AsString() == "CommonBuses"s) {
+		return LoadStopSetNode(request, catalogue, &TransportCatalogue::GetCommonBuses);
+	} else if(request.at("type").AsString() == "BusesServingAny"s) {
+		return LoadStopSetNode(request, catalogue, &TransportCatalogue::GetBusesServingAny);
+	} else if(request.at("type").AsString() == "TopK"s) {
+		return LoadTopKNode(request, catalogue);
+	} else if(request.at("type").AsString() == "SimilarBuses"s) {
+		return LoadSimilarBusesNode(request, catalogue);
+	} else if(request.at("type").AsString() == "NearbyStopPairs"s) {
+		return LoadNearbyStopPairsNode(request, catalogue);
+	} else if(request.at("type").AsString() == "NetworkReport"s) {
+		return report::NetworkReportNode(report::BuildNetworkReport(catalogue), request.at("id").AsInt());
+	}
+
+	return std::nullopt;
+}
+
 json::Document PrintStat(const json::Array &stats, const TransportCatalogue &catalogue, const render::RenderSettings &settings) {
 	json::Builder builder;
 	builder.StartArray();
 	for(const json::Node &stat : stats) {
-		const json::Dict request = stat.AsDict();
-
-		if(request.at("type").AsString() == "Bus"s) {
-			builder.Value(LoadBusNode(request, catalogue).GetValue());
-		} else if(request.at("type").AsString() == "Stop"s) {
-			builder.Value(LoadStopNode(request, catalogue).GetValue());
-		} else if(request.at("type").AsString() == "Map"s) {
-			builder.Value(LoadMapNode(request, catalogue, settings).GetValue());
+		if(std::optional<json::Node> response = ProcessStatRequest(stat.AsDict(), catalogue, settings)) {
+			builder.Value(std::move(response->GetValue()));
 		}
 	}
 	builder.EndArray();
@@ -1,8 +1,11 @@
 #pragma once
+#include "journal.h"
 #include "json.h"
 #include "map_renderer.h"
 #include "transport_catalogue.h"
 
+#include <optional>
+
 namespace catalogue::input {
 struct BusDescription {
 	BusDescription() = default;
@@ -69,8 +72,19 @@ private:
 };
 
 render::RenderSettings ParseRenderSettings(const json::Dict &settings);
+
+// Заполняет каталог из раздела base_requests, замораживает его (Freeze)
+// и возвращает настройки из render_settings
+render::RenderSettings LoadBase(const json::Dict &requests, TransportCatalogue &catalogue);
+
+// Разбирает запрос на изменение каталога (AddStop, AddBus, SetDistance, ...);
+// std::nullopt, если тип запроса - не изменение
+std::optional<journal::Mutation> ParseMutation(const json::Dict &request);
 }
 
 namespace catalogue::output {
+// Обрабатывает один stat-запрос; std::nullopt для неизвестного типа запроса
+std::optional<json::Node> ProcessStatRequest(const json::Dict &request, const TransportCatalogue &catalogue, const render::RenderSettings &settings);
+
 json::Document PrintStat(const json::Array &stats, const TransportCatalogue &catalogue, const render::RenderSettings &settings);
 } 
\ No newline at end of file
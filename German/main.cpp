@@ -18,16 +18,280 @@
  * - Модульная структура с разделением ответственности
  * - Использование пространств имён для организации кода
  * - Потоковая обработка JSON (stdin → stdout)
+ * 
+ * РЕЖИМЫ ЗАПУСКА:
+ *   main                                 пакетный режим: один документ из stdin
+ *   main --serve --base <file>           серверный режим: base_requests и render_settings
+ *                                        из файла, stat-запросы построчно (NDJSON) из stdin
+ *   main --serve --base <file> --record <log>
+ *                                        то же, с записью потока запросов в журнал
+ *                                        для последующего воспроизведения (tools/replay.cpp)
+ *   main --serve --base <file> --journal <dir>
+ *                                        то же, с приёмом изменений каталога: снимок
+ *                                        и журнал изменений в <dir> (journal.h); при
+ *                                        наличии снимка каталог и render_settings
+ *                                        восстанавливаются из него, а --base и --gtfs
+ *                                        не читаются (--base можно не указывать)
+ *   main --serve --base <file> --watch   то же, без изменений каталога: при изменении <file>
+ *                                        каталог пересобирается в фоне и подменяется
+ *                                        (catalogue_reloader.h)
+ *   main [--serve ...] --compact-stops   после загрузки списки остановок маршрутов сжимаются
+ *                                        (stop_list.h): меньше памяти на очень больших сетях
+ *   main [--serve ...] --stop-order <routes|hilbert>
+ *                                        после загрузки остановки перекладываются в памяти
+ *                                        в порядке обхода маршрутов или вдоль кривой Гильберта
+ *                                        (TransportCatalogue::ReorderStops; замеры - tools/bench_layout.cpp)
+ *   main --gtfs <dir> [...]              остановки и маршруты загружаются из GTFS;
+ *                                        base_requests во входном документе необязательны
+ *                                        и применяются поверх данных GTFS
+ *   main --gtfs <dir> --gtfs-dist-scale <k> [...]
+ *                                        shape_dist_traveled умножается на k, чтобы получить
+ *                                        метры (1000, если выгрузка в километрах)
+ *   main [--gtfs <dir>] [--base <file>] --export <dir>
+ *                                        режим экспорта: каталог из GTFS и/или base_requests
+ *                                        (из --base или, если не задано ни то ни другое, из stdin)
+ *                                        выгружается в CSV и GeoJSON (catalogue_exporter.h)
  */
 
+#include <cmath>
+#include <fstream>
 #include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 
+#include "catalogue_exporter.h"
+#include "catalogue_reloader.h"
+#include "gtfs_reader.h"
+#include "journal.h"
 #include "json_reader.h"
 #include "request_handler.h"
+#include "request_log.h"
+#include "request_server.h"
 
 using namespace std;
 
+namespace {
+
+/** Параметры командной строки */
+struct Options {
+	bool serve = false;          // --serve
+	string base_path;            // --base <file>
+	optional<string> record_path;  // --record <file>
+	optional<string> gtfs_path;    // --gtfs <dir>
+	catalogue::gtfs::ImportSettings gtfs;  // --gtfs-dist-scale <k>
+	optional<string> export_path;  // --export <dir>
+	optional<string> journal_path; // --journal <dir>
+	bool watch = false;            // --watch
+	catalogue::reload::StorageSettings storage;  // --compact-stops, --stop-order <routes|hilbert>
+};
+
+/** Краткая справка для ошибок в аргументах; подробно - в комментарии к main */
+constexpr string_view USAGE =
+	"usage: main [--serve] [--base <file>] [--record <file>] [--journal <dir>] [--watch]\n"
+	"            [--gtfs <dir> [--gtfs-dist-scale <k>]] [--export <dir>]\n"
+	"            [--compact-stops] [--stop-order routes|hilbert]"sv;
+
+Options ParseOptions(int argc, char *argv[]) {
+	Options options;
+	for(int i = 1; i < argc; ++i) {
+		string_view arg = argv[i];
+		if(arg == "--serve"sv) {
+			options.serve = true;
+		} else if(arg == "--base"sv && i + 1 < argc) {
+			options.base_path = argv[++i];
+		} else if(arg == "--record"sv && i + 1 < argc) {
+			options.record_path = argv[++i];
+		} else if(arg == "--gtfs"sv && i + 1 < argc) {
+			options.gtfs_path = argv[++i];
+		} else if(arg == "--gtfs-dist-scale"sv && i + 1 < argc) {
+			const string scale = argv[++i];
+			size_t parsed = 0;
+			try {
+				options.gtfs.shape_dist_scale = stod(scale, &parsed);
+			} catch(const logic_error &) {
+				parsed = 0;
+			}
+			if(parsed != scale.size() || !(options.gtfs.shape_dist_scale > 0) || !isfinite(options.gtfs.shape_dist_scale)) {
+				throw invalid_argument("invalid GTFS distance scale: "s + scale);
+			}
+		} else if(arg == "--export"sv && i + 1 < argc) {
+			options.export_path = argv[++i];
+		} else if(arg == "--journal"sv && i + 1 < argc) {
+			options.journal_path = argv[++i];
+		} else if(arg == "--watch"sv) {
+			options.watch = true;
+		} else if(arg == "--compact-stops"sv) {
+			options.storage.compact_stop_lists = true;
+		} else if(arg == "--stop-order"sv && i + 1 < argc) {
+			string_view order = argv[++i];
+			if(order == "routes"sv) {
+				options.storage.stop_order = catalogue::detail::StopOrder::ROUTES;
+			} else if(order == "hilbert"sv) {
+				options.storage.stop_order = catalogue::detail::StopOrder::HILBERT;
+			} else {
+				throw invalid_argument("unknown stop order: "s + string(order));
+			}
+		} else {
+			throw invalid_argument("unknown argument: "s + string(arg));
+		}
+	}
+	return options;
+}
+
+/** Обработка потока запросов с записью в журнал воспроизведения, если он задан */
+int RunServer(const catalogue::server::RequestServer &server, const Options &options) {
+	// Без синхронизации с stdio у cin свой буфер: in_avail() видит готовые
+	// запросы, и Serve сбрасывает вывод и журнал один раз на пакет.
+	// Вывод сбрасывает сам Serve - cin не привязан к cout
+	ios::sync_with_stdio(false);
+	cin.tie(nullptr);
+
+	if(options.record_path) {
+		ofstream log_file(*options.record_path, ios::app);
+		if(!log_file) {
+			cerr << "cannot open "sv << *options.record_path << endl;
+			return 1;
+		}
+		catalogue::replay::RequestRecorder recorder(log_file);
+		server.Serve(cin, cout, &recorder);
+	} else {
+		server.Serve(cin, cout);
+	}
+	return 0;
+}
+
+/**
+ * СЕРВЕРНЫЙ РЕЖИМ С ГОРЯЧЕЙ ПЕРЕЗАГРУЗКОЙ
+ * 
+ * Первая версия собирается до начала обработки; следующие - в фоне,
+ * при каждом изменении файла --base. Журнал изменений с --watch
+ * несовместим: пересборка из файла отбросила бы принятые изменения
+ * (новую выгрузку в такой сервер загружает запрос DiffLoad).
+ */
+int ServeWatched(const Options &options) {
+	if(options.base_path.empty() || options.journal_path) {
+		cerr << "--watch requires --base <file> and cannot be combined with --journal"sv << endl;
+		return 1;
+	}
+
+	catalogue::reload::ReloaderSettings settings;
+	settings.storage = options.storage;
+	settings.gtfs = options.gtfs;
+	catalogue::reload::CatalogueReloader reloader(
+		options.base_path, options.gtfs_path,
+		catalogue::reload::LoadDataset(options.base_path, options.gtfs_path, options.storage, options.gtfs), settings);
+	return RunServer(catalogue::server::RequestServer(reloader), options);
+}
+
+/**
+ * СЕРВЕРНЫЙ РЕЖИМ
+ * 
+ * Каталог загружается из файла один раз, после чего stdin обрабатывается
+ * как поток NDJSON stat-запросов до конца ввода.
+ */
+int Serve(const Options &options) {
+	if(options.watch) {
+		return ServeWatched(options);
+	}
+
+	optional<catalogue::journal::Store> store;
+	if(options.journal_path) {
+		store.emplace(*options.journal_path);
+	}
+
+	catalogue::TransportCatalogue catalogue;
+	render::RenderSettings settings;
+
+	if(store && store->HasSnapshot()) {
+		// Каталог и настройки карты - из снимка и хвоста журнала, исходный JSON не читается
+		catalogue::journal::RecoveryStats stats = store->Recover(catalogue);
+		catalogue.Freeze();
+		istringstream settings_text(store->Metadata());
+		settings = catalogue::input::ParseRenderSettings(json::Load(settings_text).GetRoot().AsDict());
+		cerr << "recovered snapshot #"sv << stats.snapshot_sequence << " + "sv << stats.replayed << " journal records"sv;
+		if(stats.truncated_bytes > 0) {
+			cerr << ", truncated "sv << stats.truncated_bytes << " bytes of damaged tail"sv;
+		}
+		cerr << endl;
+	} else {
+		if(options.base_path.empty()) {
+			cerr << "--serve requires --base <file>"sv << endl;
+			return 1;
+		}
+
+		ifstream base_file(options.base_path);
+		if(!base_file) {
+			cerr << "cannot open "sv << options.base_path << endl;
+			return 1;
+		}
+
+		if(options.gtfs_path) {
+			catalogue::gtfs::Import(*options.gtfs_path, catalogue, options.gtfs);
+		}
+		json::Document base = json::Load(base_file);
+		const json::Dict &requests = base.GetRoot().AsDict();
+		settings = catalogue::input::LoadBase(requests, catalogue);
+
+		if(store) {
+			// Первый запуск: снимок загруженного каталога, дальше - только журнал
+			ostringstream settings_text;
+			json::PrintCompact(requests.at("render_settings"), settings_text);
+			store->SetMetadata(settings_text.str());
+			store->Recover(catalogue);
+			store->Checkpoint(catalogue);
+		}
+	}
+
+	catalogue::reload::ApplyStorageSettings(catalogue, options.storage);
+
+	// Без журнала каталог только для чтения: изменения не пережили бы перезапуск
+	catalogue::server::RequestServer server = store ? catalogue::server::RequestServer(catalogue, settings, &*store)
+																	: catalogue::server::RequestServer(as_const(catalogue), settings);
+
+	return RunServer(server, options);
+}
+
+/**
+ * РЕЖИМ ЭКСПОРТА
+ * 
+ * Каталог собирается из GTFS и/или base_requests и выгружается в каталог
+ * *options.export_path. stat_requests и render_settings не требуются.
+ */
+int Export(const Options &options) {
+	catalogue::TransportCatalogue catalogue;
+	if(options.gtfs_path) {
+		catalogue::gtfs::Import(*options.gtfs_path, catalogue, options.gtfs);
+	}
+
+	if(!options.base_path.empty() || !options.gtfs_path) {
+		ifstream base_file;
+		if(!options.base_path.empty()) {
+			base_file.open(options.base_path);
+			if(!base_file) {
+				cerr << "cannot open "sv << options.base_path << endl;
+				return 1;
+			}
+		}
+		json::Document base = json::Load(options.base_path.empty() ? cin : base_file);
+		const json::Dict &requests = base.GetRoot().AsDict();
+		if(auto it = requests.find("base_requests"s); it != requests.end()) {
+			catalogue::input::JsonReader reader;
+			reader.ParseDocument(it->second.AsArray());
+			reader.ApplyCommands(catalogue);
+		}
+	}
+
+	catalogue::exporter::ExportStats stats = catalogue::exporter::Export(*options.export_path, catalogue);
+	cerr << "exported "sv << stats.stops << " stops, "sv << stats.buses << " buses, "sv
+		  << stats.stop_times << " stop times, "sv << stats.distances << " distances"sv << endl;
+	return 0;
+}
+}
+
 /**
  * ГЛАВНАЯ ФУНКЦИЯ ПРОГРАММЫ
  * 
@@ -47,12 +311,33 @@ using namespace std;
  * - Отсутствующие ключи в JSON приведут к исключению std::out_of_range
  * - Некорректные типы данных вызовут исключения из Node::As* методов
  */
-int main() {
+int main(int argc, char *argv[]) {
+	// === РАЗБОР АРГУМЕНТОВ ===
+	
+	Options options;
+	try {
+		options = ParseOptions(argc, argv);
+	} catch(const invalid_argument &e) {
+		cerr << e.what() << '\n' << USAGE << endl;
+		return 1;
+	}
+	if(options.serve) {
+		return Serve(options);
+	}
+	if(options.export_path) {
+		return Export(options);
+	}
+	
 	// === ИНИЦИАЛИЗАЦИЯ ===
 	
 	// Создаем пустой транспортный каталог
 	catalogue::TransportCatalogue catalogue;
 	
+	// При --gtfs основные данные берутся из выгрузки GTFS
+	if(options.gtfs_path) {
+		catalogue::gtfs::Import(*options.gtfs_path, catalogue, options.gtfs);
+	}
+	
 	// === ЗАГРУЗКА И ПАРСИНГ JSON ===
 	
 	// Загружаем JSON документ из стандартного ввода
@@ -61,7 +346,9 @@ int main() {
 	
 	// Извлекаем разделы запроса
 	const json::Dict &render_request = requests.at("render_settings").AsDict();  // Настройки карты
-	const json::Array base_requests = requests.at("base_requests").AsArray();    // Команды создания
+	const json::Array base_requests = options.gtfs_path && !requests.count("base_requests")
+												 ? json::Array{}                                  // Всё уже загружено из GTFS
+												 : requests.at("base_requests").AsArray();        // Команды создания
 	const json::Array stat_requests = requests.at("stat_requests").AsArray();    // Запросы информации
 	
 	// === ПАРСИНГ НАСТРОЕК ===
@@ -80,6 +367,10 @@ int main() {
 	// Применяем команды к каталогу (заполняем данными)
 	reader.ApplyCommands(catalogue);
 	
+	// Строим индексы для запросов (CommonBuses, BusesServingAny)
+	catalogue.Freeze();
+	catalogue::reload::ApplyStorageSettings(catalogue, options.storage);
+	
 	// === ОБРАБОТКА ЗАПРОСОВ И ВЫВОД ===
 	
 	// Обрабатываем запросы на получение информации и генерируем JSON ответ
@@ -1,5 +1,7 @@
 #include "map_renderer.h"
 
+#include <iterator>
+
 namespace render {
 MapRenderer::MapRenderer(const RenderSettings &render_settings) : settings_(render_settings) {}
 
@@ -43,8 +45,10 @@ void MapRenderer::RenderBusesLabels(svg::Document &doc, const std::deque<transpo
 		if(!bus.is_roundtrip) {
 			size_t last_index = bus.stop_list.size() / 2;
 			
-			if(last_index > 0 && bus.stop_list[0] != bus.stop_list[last_index]) {
-				end_points.push_back(bus.stop_list[last_index]);
+			// Список читается только подряд (stop_list.h) - до середины идём итератором
+			const transport::Stop *last_stop = *std::next(bus.stop_list.begin(), last_index);
+			if(last_index > 0 && bus.stop_list.front() != last_stop) {
+				end_points.push_back(last_stop);
 			}
 		}
 
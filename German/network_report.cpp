@@ -0,0 +1,167 @@
+#include "network_report.h"
+#include "json_builder.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace catalogue::report {
+
+namespace {
+
+using StopPair = std::pair<const transport::Stop *, const transport::Stop *>;
+
+/** Частичные итоги одного потока */
+struct Partial {
+	double total_length = 0;
+	size_t total_route_stops = 0;
+	std::vector<StopPair> distance_gaps;
+};
+
+/**
+ * Ответ в writer (json::Builder или json::StreamWriter).
+ * Ключи идут по алфавиту - в том же порядке, в котором Builder
+ * выводит словари, поэтому оба способа дают одинаковый текст.
+ */
+template <typename Writer>
+void Emit(const NetworkReport &report, int request_id, Writer &writer) {
+	writer.StartDict();
+
+	writer.Key("buses");
+	writer.StartArray();
+	for(const BusReport &bus : report.buses) {
+		writer.StartDict();
+		writer.Key("curvature");
+		writer.Value(bus.info.curvature);
+		writer.Key("distance_gaps");
+		writer.Value(static_cast<int>(bus.distance_gaps));
+		writer.Key("name");
+		writer.Value(bus.bus->number);
+		writer.Key("route_length");
+		writer.Value(bus.info.length);
+		writer.Key("stop_count");
+		writer.Value(bus.info.stops);
+		writer.Key("unique_stop_count");
+		writer.Value(bus.info.unique_stops);
+		writer.EndDict();
+	}
+	writer.EndArray();
+
+	writer.Key("distance_gaps");
+	writer.StartArray();
+	for(const auto &[from, to] : report.distance_gaps) {
+		writer.StartDict();
+		writer.Key("from");
+		writer.Value(from->name);
+		writer.Key("to");
+		writer.Value(to->name);
+		writer.EndDict();
+	}
+	writer.EndArray();
+
+	writer.Key("request_id");
+	writer.Value(request_id);
+
+	writer.Key("stops");
+	writer.StartArray();
+	for(const StopReport &stop : report.stops) {
+		writer.StartDict();
+		writer.Key("degree");
+		writer.Value(static_cast<int>(stop.degree));
+		writer.Key("name");
+		writer.Value(stop.stop->name);
+		writer.EndDict();
+	}
+	writer.EndArray();
+
+	// Суммы выводятся как double: в int не помещается больше 2^31
+	writer.Key("total_length");
+	writer.Value(report.total_length);
+	writer.Key("total_route_stops");
+	writer.Value(static_cast<double>(report.total_route_stops));
+
+	writer.EndDict();
+}
+}
+
+/**
+ * ПОСТРОЕНИЕ ОТЧЁТА
+ *
+ * АЛГОРИТМ:
+ * 1. Каждый поток берёт свой диапазон номеров маршрутов: BusInfo (из кэша
+ *    замороженного каталога), обход перегонов в поиске пробелов
+ * 2. Тот же поток берёт свой диапазон номеров остановок: степень
+ * 3. Свёртка: суммы частичных итогов, объединение пробелов, сортировка
+ *    по названиям и удаление повторов; строки остановок - по названию
+ *
+ * Строки отчёта пишутся каждая на своё место, без блокировок.
+ */
+NetworkReport BuildNetworkReport(const TransportCatalogue &catalogue, size_t threads) {
+	const std::deque<transport::Bus> &buses = catalogue.GetAllBuses();
+	const std::deque<transport::Stop> &stops = catalogue.GetAllStops();
+
+	NetworkReport report;
+	report.buses.resize(buses.size());
+	report.stops.resize(stops.size());
+
+	const size_t count = std::max(buses.size(), stops.size());
+	std::vector<Partial> partials(parallel::ThreadCount(threads));
+	const size_t parts = parallel::ForEachRange(count, threads, [&](size_t part, size_t begin, size_t end) {
+		Partial &partial = partials[part];
+
+		for(size_t id = begin; id < std::min(end, buses.size()); ++id) {
+			const transport::Bus &bus = buses[id];
+			BusReport &row = report.buses[id];
+			row.bus = &bus;
+			row.info = catalogue.GetBusInfo(bus);
+			const transport::Stop *previous = nullptr;
+			for(const transport::Stop *stop : bus.stop_list) {
+				if(previous && catalogue.GetDistance(previous, stop) == 0) {
+					++row.distance_gaps;
+					partial.distance_gaps.emplace_back(previous, stop);
+				}
+				previous = stop;
+			}
+			partial.total_length += row.info.length;
+			partial.total_route_stops += static_cast<size_t>(row.info.stops);
+		}
+
+		for(size_t id = begin; id < std::min(end, stops.size()); ++id) {
+			report.stops[id] = {&stops[id], catalogue.GetStopDegree(stops[id])};
+		}
+
+		// Повторы внутри части убираются сразу: меньше работы свёртке
+		std::sort(partial.distance_gaps.begin(), partial.distance_gaps.end());
+		partial.distance_gaps.erase(std::unique(partial.distance_gaps.begin(), partial.distance_gaps.end()),
+											 partial.distance_gaps.end());
+	});
+
+	for(size_t part = 0; part < parts; ++part) {
+		Partial &partial = partials[part];
+		report.total_length += partial.total_length;
+		report.total_route_stops += partial.total_route_stops;
+		report.distance_gaps.insert(report.distance_gaps.end(), partial.distance_gaps.begin(), partial.distance_gaps.end());
+	}
+
+	auto by_name = [](const StopPair &lhs, const StopPair &rhs) {
+		return std::tie(lhs.first->name, lhs.second->name) < std::tie(rhs.first->name, rhs.second->name);
+	};
+	std::sort(report.distance_gaps.begin(), report.distance_gaps.end(), by_name);
+	report.distance_gaps.erase(std::unique(report.distance_gaps.begin(), report.distance_gaps.end()), report.distance_gaps.end());
+	std::sort(report.stops.begin(), report.stops.end(), [](const StopReport &lhs, const StopReport &rhs) {
+		return lhs.stop->name < rhs.stop->name;
+	});
+	return report;
+}
+
+void WriteNetworkReport(const NetworkReport &report, int request_id, std::ostream &output) {
+	json::StreamWriter writer(output);
+	Emit(report, request_id, writer);
+}
+
+json::Node NetworkReportNode(const NetworkReport &report, int request_id) {
+	json::Builder builder;
+	Emit(report, request_id, builder);
+	return builder.Build();
+}
+}
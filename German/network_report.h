@@ -0,0 +1,64 @@
+#pragma once
+
+/*
+ * ОТЧЁТ ПО ВСЕЙ СЕТИ
+ *
+ * Сводка, которую раньше собирали запросами Bus и Stop по каждому объекту:
+ * - BusInfo каждого маршрута и число перегонов без заданного расстояния
+ * - степень каждой остановки (число различных маршрутов)
+ * - итоги: длина сети (сумма длин маршрутов), число остановок на маршрутах
+ * - пробелы в расстояниях: пары соседних остановок маршрутов, для которых
+ *   GetDistance возвращает 0 (без повторов, по названиям остановок)
+ *
+ * ВЫЧИСЛЕНИЕ:
+ * Один параллельный проход (parallel.h): каждый поток обходит свою часть
+ * маршрутов и остановок, записывает строки отчёта на их места (по id)
+ * и копит частичные итоги и пробелы у себя. Затем частичные итоги
+ * складываются, а пробелы объединяются и сортируются. Остановки и пробелы
+ * упорядочены по названиям, а не по Stop::id: отчёт не зависит от
+ * порядка остановок в памяти (ReorderStops).
+ *
+ * ВЫВОД:
+ * WriteNetworkReport пишет ответ через json::StreamWriter, не собирая
+ * дерево json::Node: для сети в миллион остановок дерево заняло бы
+ * в разы больше памяти, чем сам текст ответа.
+ */
+
+#include "json.h"
+#include "transport_catalogue.h"
+
+#include <cstddef>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace catalogue::report {
+
+struct BusReport {
+	const transport::Bus *bus = nullptr;
+	detail::BusInfo info{};
+	size_t distance_gaps = 0;   // перегонов маршрута с GetDistance == 0
+};
+
+struct StopReport {
+	const transport::Stop *stop = nullptr;
+	size_t degree = 0;
+};
+
+struct NetworkReport {
+	std::vector<BusReport> buses;            // в порядке Bus::id
+	std::vector<StopReport> stops;           // по названию остановки
+	double total_length = 0;                 // сумма длин маршрутов, м
+	size_t total_route_stops = 0;            // сумма BusInfo::stops
+	std::vector<std::pair<const transport::Stop *, const transport::Stop *>> distance_gaps;
+};
+
+/** Строит отчёт за один параллельный проход; threads == 0 - по числу ядер */
+NetworkReport BuildNetworkReport(const TransportCatalogue &catalogue, size_t threads = 0);
+
+/** Пишет ответ на запрос NetworkReport одной строкой компактного JSON */
+void WriteNetworkReport(const NetworkReport &report, int request_id, std::ostream &output);
+
+/** Тот же ответ в виде json::Node - для пакетного режима и Handle */
+json::Node NetworkReportNode(const NetworkReport &report, int request_id);
+}
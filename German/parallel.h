@@ -0,0 +1,75 @@
+#pragma once
+
+/*
+ * ПАРАЛЛЕЛЬНАЯ ОБРАБОТКА ДИАПАЗОНОВ
+ *
+ * Минимальный помощник для задач вида "разбить N элементов на части
+ * и обработать каждую часть в своём потоке":
+ * - ThreadCount: число потоков по умолчанию
+ * - ForEachRange: запускает функцию на непересекающихся поддиапазонах
+ *
+ * ПРИНЦИПЫ:
+ * 1. Потоки создаются на время одного вызова - без пула и глобального состояния
+ * 2. Исключение из любого потока пробрасывается вызывающему после join
+ * 3. При одном потоке функция вызывается в текущем потоке без создания новых
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+/** Число потоков: requested, либо число ядер, если requested == 0 */
+inline size_t ThreadCount(size_t requested = 0) {
+	if(requested > 0) {
+		return requested;
+	}
+	return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+/**
+ * Делит [0, count) на threads частей примерно равного размера и вызывает
+ * func(part, begin, end) для каждой части в отдельном потоке.
+ * part - номер части (0..threads-1), удобен для индексации частичных результатов.
+ *
+ * @return Фактическое число частей (не больше count)
+ */
+template <typename Func>
+size_t ForEachRange(size_t count, size_t threads, Func func) {
+	threads = std::max<size_t>(1, std::min(ThreadCount(threads), count));
+
+	if(threads == 1) {
+		func(size_t{0}, size_t{0}, count);
+		return 1;
+	}
+
+	std::vector<std::thread> workers;
+	std::vector<std::exception_ptr> errors(threads);
+	workers.reserve(threads);
+
+	for(size_t part = 0; part < threads; ++part) {
+		const size_t begin = count * part / threads;
+		const size_t end = count * (part + 1) / threads;
+		workers.emplace_back([&func, &errors, part, begin, end] {
+			try {
+				func(part, begin, end);
+			} catch(...) {
+				errors[part] = std::current_exception();
+			}
+		});
+	}
+
+	for(std::thread &worker : workers) {
+		worker.join();
+	}
+	for(const std::exception_ptr &error : errors) {
+		if(error) {
+			std::rethrow_exception(error);
+		}
+	}
+	return threads;
+}
+}
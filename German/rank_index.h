@@ -0,0 +1,114 @@
+#pragma once
+
+/*
+ * РАНГОВЫЙ ИНДЕКС
+ *
+ * Упорядоченный по значению набор пар (значение, название) для ответов
+ * "первые K по показателю" за O(log N + K) без перебора всех элементов.
+ * Номер - плотный номер маршрута или остановки (Bus::id, Stop::id),
+ * название - Bus::number или Stop::name того же объекта.
+ *
+ * ОБНОВЛЕНИЕ:
+ * Значение номера можно заменить в любой момент (Update) за O(log N):
+ * старая пара удаляется, новая вставляется. Поэтому индекс остаётся
+ * верным при добавлении данных в замороженный каталог. Erase убирает
+ * номер совсем - при удалении маршрута или остановки.
+ *
+ * ПОРЯДОК:
+ * По убыванию значения; при равных значениях - по возрастанию названия.
+ * Номера в порядок не входят: перенумерация остановок (ReorderStops)
+ * не меняет ответов. Обход по возрастанию идёт в точно обратном порядке.
+ *
+ * ВЛАДЕНИЕ:
+ * Индекс хранит указатели на строки названий и сравнивает их при каждой
+ * вставке и удалении. Поэтому объект, чьё название переезжает или
+ * уничтожается, сначала убирается из индекса (Erase, Clear) и только
+ * потом переносится.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace catalogue::rank {
+
+class RankIndex {
+public:
+	/** Задаёт значение номера (вставка или замена); name живёт, пока номер в индексе */
+	void Update(uint32_t id, double value, const std::string &name) {
+		if(id < values_.size() && names_[id]) {
+			if(values_[id] == value && names_[id] == &name) {
+				return;
+			}
+			order_.erase({values_[id], names_[id]});
+		}
+		if(id >= values_.size()) {
+			values_.resize(id + 1, 0);
+			names_.resize(id + 1, nullptr);
+		}
+		values_[id] = value;
+		names_[id] = &name;
+		order_.insert({value, &name});
+	}
+
+	/** Убирает номер из индекса (удалённый маршрут или остановка) */
+	void Erase(uint32_t id) {
+		if(id < values_.size() && names_[id]) {
+			order_.erase({values_[id], names_[id]});
+			names_[id] = nullptr;
+		}
+	}
+
+	/** Убирает все номера (перед перенумерацией) */
+	void Clear() {
+		order_.clear();
+		values_.clear();
+		names_.clear();
+	}
+
+	/** Вызывает func(name, value) для первых k элементов */
+	template <typename Func>
+	void ForEachTop(size_t k, bool ascending, Func func) const {
+		if(ascending) {
+			for(auto it = order_.rbegin(); it != order_.rend() && k > 0; ++it, --k) {
+				func(*it->second, it->first);
+			}
+		} else {
+			for(auto it = order_.begin(); it != order_.end() && k > 0; ++it, --k) {
+				func(*it->second, it->first);
+			}
+		}
+	}
+
+	size_t Size() const {
+		return order_.size();
+	}
+
+	/** Приблизительный объём памяти: узлы дерева libstdc++ и массивы по номерам */
+	size_t MemoryBytes() const {
+		// Узел красно-чёрного дерева: цвет, три указателя и значение, с выравниванием malloc
+		constexpr size_t NODE_BYTES = (sizeof(void *) * 4 + sizeof(Entry) + 15) / 16 * 16;
+		return order_.size() * NODE_BYTES + values_.capacity() * sizeof(double) + names_.capacity() * sizeof(const std::string *);
+	}
+
+private:
+	using Entry = std::pair<double, const std::string *>;
+
+	/** Больше значение - раньше; при равенстве раньше меньшее название */
+	struct Descending {
+		bool operator()(const Entry &lhs, const Entry &rhs) const {
+			if(lhs.first != rhs.first) {
+				return lhs.first > rhs.first;
+			}
+			return *lhs.second < *rhs.second;
+		}
+	};
+
+	std::set<Entry, Descending> order_;
+	std::vector<double> values_;                // текущее значение по номеру
+	std::vector<const std::string *> names_;    // название номера в индексе; nullptr - номера нет
+};
+}
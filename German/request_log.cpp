@@ -0,0 +1,176 @@
+#include "request_log.h"
+#include "json_builder.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace std::literals;
+
+namespace catalogue::replay {
+
+RequestRecorder::RequestRecorder(std::ostream &output)
+	: output_(output), last_(std::chrono::steady_clock::now()) {}
+
+void RequestRecorder::Record(const json::Dict &request) {
+	const auto now = std::chrono::steady_clock::now();
+	const auto delay = std::chrono::duration_cast<std::chrono::microseconds>(now - last_);
+	last_ = now;
+
+	// Пауза длиннее ~35 минут не помещается в int и при воспроизведении бесполезна
+	const int delay_us = static_cast<int>(std::min<std::chrono::microseconds::rep>(delay.count(), std::numeric_limits<int>::max()));
+
+	json::Node record = json::Builder{}.StartDict()
+										.Key("delay_us").Value(delay_us)
+										.Key("request").Value(request)
+										.EndDict().Build();
+	json::PrintCompact(record, output_);
+	output_.put('\n');
+}
+
+namespace {
+
+// Вызывает callback для каждой непустой строки NDJSON-потока
+template <typename Callback>
+void ForEachLine(std::istream &input, Callback callback) {
+	std::string line;
+	while(std::getline(input, line)) {
+		if(line.find_first_not_of(" \t\r"sv) == std::string::npos) {
+			continue;
+		}
+		std::istringstream line_stream(line);
+		callback(json::Load(line_stream).GetRoot());
+	}
+}
+
+std::chrono::nanoseconds Percentile(const std::vector<std::chrono::nanoseconds> &sorted, double p) {
+	if(sorted.empty()) {
+		return std::chrono::nanoseconds{0};
+	}
+	size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+	return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// Сверка идёт по тексту ответа: именно его видит клиент, а double
+// после вывода с округлением не совпал бы с вычисленным значением
+std::string ToCompactString(const json::Node &node) {
+	std::ostringstream out;
+	json::PrintCompact(node, out);
+	return out.str();
+}
+
+double ToMicroseconds(std::chrono::nanoseconds value) {
+	return value.count() / 1000.0;
+}
+}
+
+std::vector<LoggedRequest> ReadRequestLog(std::istream &input) {
+	std::vector<LoggedRequest> log;
+	std::chrono::microseconds offset{0};
+	ForEachLine(input, [&log, &offset](const json::Node &node) {
+		const json::Dict &record = node.AsDict();
+		offset += std::chrono::microseconds(record.at("delay_us").AsInt());
+		log.push_back({offset, record.at("request").AsDict()});
+	});
+	return log;
+}
+
+std::vector<std::string> ReadResponses(std::istream &input) {
+	std::vector<std::string> responses;
+	ForEachLine(input, [&responses](const json::Node &node) {
+		responses.push_back(ToCompactString(node));
+	});
+	return responses;
+}
+
+/**
+ * ВОСПРОИЗВЕДЕНИЕ ЖУРНАЛА
+ *
+ * АЛГОРИТМ:
+ * 1. Для каждого запроса вычисляем запланированный момент отправки
+ *    (в режиме MAX - момент окончания предыдущего запроса)
+ * 2. В режиме ORIGINAL ждём наступления этого момента
+ * 3. Обрабатываем запрос через RequestServer::Handle
+ * 4. Записываем задержку, при необходимости сохраняем и сверяем ответ
+ *
+ * Сохранение и сверка ответов не входят в измеряемое время.
+ */
+ReplayReport Replay(const std::vector<LoggedRequest> &log, const server::RequestServer &server, const ReplayOptions &options) {
+	using Clock = std::chrono::steady_clock;
+
+	ReplayReport report;
+	std::vector<std::chrono::nanoseconds> latencies;
+	latencies.reserve(log.size());
+
+	const Clock::time_point start = Clock::now();
+	Clock::time_point finish = start;
+
+	for(size_t i = 0; i < log.size(); ++i) {
+		Clock::time_point scheduled = Clock::now();
+		if(options.speed == ReplaySpeed::ORIGINAL) {
+			scheduled = start + log[i].offset;
+			std::this_thread::sleep_until(scheduled);
+		}
+
+		json::Node response;
+		try {
+			response = server.Handle(log[i].request);
+		} catch(const std::exception &e) {
+			response = json::Builder{}.StartDict().Key("error_message").Value(std::string(e.what())).EndDict().Build();
+		}
+
+		finish = Clock::now();
+		latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(finish - std::min(scheduled, finish)));
+
+		if(options.responses || options.expected) {
+			const std::string text = ToCompactString(response);
+
+			if(options.responses) {
+				*options.responses << text << '\n';
+			}
+			if(options.expected && (i >= options.expected->size() || (*options.expected)[i] != text)) {
+				report.mismatches.push_back(i);
+			}
+		}
+	}
+
+	// Эталон длиннее журнала - тоже расхождение
+	if(options.expected) {
+		for(size_t i = log.size(); i < options.expected->size(); ++i) {
+			report.mismatches.push_back(i);
+		}
+	}
+
+	report.requests = log.size();
+	report.seconds = std::chrono::duration<double>(finish - start).count();
+	report.throughput = report.seconds > 0 ? report.requests / report.seconds : 0.0;
+
+	std::sort(latencies.begin(), latencies.end());
+	report.p50 = Percentile(latencies, 0.50);
+	report.p90 = Percentile(latencies, 0.90);
+	report.p99 = Percentile(latencies, 0.99);
+	report.p999 = Percentile(latencies, 0.999);
+	report.max = latencies.empty() ? std::chrono::nanoseconds{0} : latencies.back();
+
+	return report;
+}
+
+void PrintReport(const ReplayReport &report, std::ostream &output) {
+	output << "requests:    "sv << report.requests << '\n'
+			 << "time:        "sv << report.seconds << " s\n"sv
+			 << "throughput:  "sv << report.throughput << " req/s\n"sv
+			 << "latency p50: "sv << ToMicroseconds(report.p50) << " us\n"sv
+			 << "latency p90: "sv << ToMicroseconds(report.p90) << " us\n"sv
+			 << "latency p99: "sv << ToMicroseconds(report.p99) << " us\n"sv
+			 << "latency p99.9: "sv << ToMicroseconds(report.p999) << " us\n"sv
+			 << "latency max: "sv << ToMicroseconds(report.max) << " us\n"sv
+			 << "mismatches:  "sv << report.mismatches.size() << '\n';
+
+	const size_t shown = std::min<size_t>(report.mismatches.size(), 10);
+	for(size_t i = 0; i < shown; ++i) {
+		output << "  differs at request #"sv << report.mismatches[i] << '\n';
+	}
+}
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+/*
+ * ЖУРНАЛ STAT-ЗАПРОСОВ: ЗАПИСЬ И ВОСПРОИЗВЕДЕНИЕ
+ *
+ * Модуль позволяет снять реальный поток stat-запросов с рабочего сервера
+ * вместе с моментами их поступления, а затем прогнать его на другой
+ * сборке каталога:
+ * - RequestRecorder: записывает запросы в NDJSON-журнал
+ * - ReadRequestLog: читает журнал обратно
+ * - Replay: воспроизводит журнал через RequestServer и собирает статистику
+ *
+ * ФОРМАТ ЖУРНАЛА (одна строка = один запрос):
+ *   {"delay_us":1534,"request":{"id":1,"name":"114","type":"Bus"}}
+ * delay_us - пауза после предыдущего запроса в микросекундах
+ * (относительные паузы не переполняют int даже на многочасовых записях)
+ *
+ * ПРОВЕРКА ОТВЕТОВ:
+ * Ответы одной сборки сохраняются в NDJSON-файл (строка на запрос).
+ * При воспроизведении на другой сборке ответы сравниваются с ним
+ * поэлементно, поэтому оптимизация не может незаметно изменить результат.
+ */
+
+#include "json.h"
+#include "request_server.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace catalogue::replay {
+
+/** Запрос из журнала вместе со смещением от начала записи (сумма пауз delay_us) */
+struct LoggedRequest {
+	std::chrono::microseconds offset{0};
+	json::Dict request;
+};
+
+/**
+ * ЗАПИСЬ ПОТОКА ЗАПРОСОВ
+ *
+ * Отсчёт времени начинается в момент создания объекта.
+ * Каждая запись - одна строка NDJSON, поэтому журнал, оборванный
+ * аварийным завершением, остаётся читаемым до последней полной строки.
+ */
+class RequestRecorder {
+public:
+	explicit RequestRecorder(std::ostream &output);
+
+	/** Дописывает запрос в журнал с текущим смещением по времени */
+	void Record(const json::Dict &request);
+
+private:
+	std::ostream &output_;
+	std::chrono::steady_clock::time_point last_;  // момент предыдущей записи
+};
+
+/** Читает журнал запросов; пустые строки пропускаются */
+std::vector<LoggedRequest> ReadRequestLog(std::istream &input);
+
+/**
+ * Читает NDJSON-файл ответов (по одному JSON значению на строку).
+ * Строки нормализуются через PrintCompact, поэтому сверка не зависит
+ * от пробелов в файле, но чувствительна к любому изменению значений.
+ */
+std::vector<std::string> ReadResponses(std::istream &input);
+
+/** Скорость воспроизведения */
+enum class ReplaySpeed {
+	ORIGINAL,  // с исходными интервалами между запросами
+	MAX        // без пауз, максимально быстро
+};
+
+struct ReplayOptions {
+	ReplaySpeed speed = ReplaySpeed::MAX;
+	const std::vector<std::string> *expected = nullptr;  // эталонные ответы (если нужна сверка)
+	std::ostream *responses = nullptr;                  // куда сохранить ответы текущей сборки
+};
+
+/**
+ * РЕЗУЛЬТАТ ВОСПРОИЗВЕДЕНИЯ
+ *
+ * Задержка считается от запланированного момента отправки запроса
+ * до готовности ответа. В режиме ORIGINAL это включает ожидание в очереди,
+ * если сборка не успевает за исходным темпом, - иначе медленная сборка
+ * выглядела бы быстрее, чем есть на самом деле.
+ */
+struct ReplayReport {
+	size_t requests = 0;
+	double seconds = 0;       // общее время прогона
+	double throughput = 0;    // запросов в секунду
+	std::chrono::nanoseconds p50{0};
+	std::chrono::nanoseconds p90{0};
+	std::chrono::nanoseconds p99{0};
+	std::chrono::nanoseconds p999{0};
+	std::chrono::nanoseconds max{0};
+	std::vector<size_t> mismatches;  // номера запросов, ответы на которые отличаются от эталона
+};
+
+/** Воспроизводит журнал через тот же путь обработки, что и серверный режим */
+ReplayReport Replay(const std::vector<LoggedRequest> &log, const server::RequestServer &server, const ReplayOptions &options);
+
+/** Выводит отчёт в человекочитаемом виде */
+void PrintReport(const ReplayReport &report, std::ostream &output);
+}
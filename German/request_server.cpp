@@ -0,0 +1,207 @@
+#include "request_server.h"
+#include "base_diff.h"
+#include "catalogue_reloader.h"
+#include "journal.h"
+#include "json_builder.h"
+#include "json_reader.h"
+#include "network_report.h"
+#include "request_log.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std::literals;
+
+namespace catalogue::server {
+
+RequestServer::RequestServer(const TransportCatalogue &catalogue, const render::RenderSettings &settings)
+	: catalogue_(&catalogue), settings_(&settings) {}
+
+RequestServer::RequestServer(TransportCatalogue &catalogue, const render::RenderSettings &settings, journal::Store *store)
+	: catalogue_(&catalogue), settings_(&settings), writable_(&catalogue), store_(store) {}
+
+RequestServer::RequestServer(const reload::CatalogueReloader &reloader)
+	: reloader_(&reloader) {}
+
+RequestServer::Data RequestServer::CurrentData() const {
+	if(reloader_) {
+		reload::DatasetPtr version = reloader_->Current();
+		const reload::Dataset &dataset = *version;
+		return {std::move(version), dataset.catalogue, dataset.settings};
+	}
+	return {nullptr, *catalogue_, *settings_};
+}
+
+json::Node RequestServer::Handle(const json::Dict &request) const {
+	if(request.at("type").AsString() == "Checkpoint"s || input::ParseMutation(request)) {
+		return ApplyMutation(request);
+	}
+	if(request.at("type").AsString() == "DiffLoad"s) {
+		return LoadDiff(request);
+	}
+
+	const Data data = CurrentData();
+	if(std::optional<json::Node> response = output::ProcessStatRequest(request, data.catalogue, data.settings)) {
+		return std::move(*response);
+	}
+
+	// Неизвестный тип запроса: в пакетном режиме он пропускается,
+	// а серверу нужно ответить на каждую строку
+	json::Builder builder;
+	builder.StartDict();
+	if(auto it = request.find("id"s); it != request.end() && it->second.IsInt()) {
+		builder.Key("request_id").Value(it->second.AsInt());
+	}
+	return builder.Key("error_message").Value("unknown request type").EndDict().Build();
+}
+
+/**
+ * Изменение каталога: через хранилище (с записью в журнал) или напрямую.
+ * Недопустимое изменение (неизвестная остановка и т.п.) - error_message.
+ */
+json::Node RequestServer::ApplyMutation(const json::Dict &request) const {
+	json::Builder builder;
+	builder.StartDict();
+	if(auto it = request.find("id"s); it != request.end() && it->second.IsInt()) {
+		builder.Key("request_id").Value(it->second.AsInt());
+	}
+
+	if(!writable_) {
+		return builder.Key("error_message").Value("catalogue is read-only").EndDict().Build();
+	}
+	try {
+		if(request.at("type").AsString() == "Checkpoint"s) {
+			if(!store_) {
+				return builder.Key("error_message").Value("no journal").EndDict().Build();
+			}
+			store_->Checkpoint(*writable_);
+		} else if(store_) {
+			store_->Apply(*input::ParseMutation(request), *writable_);
+		} else {
+			journal::Apply(*input::ParseMutation(request), *writable_);
+		}
+	} catch(const std::invalid_argument &e) {
+		return builder.Key("error_message").Value(std::string(e.what())).EndDict().Build();
+	}
+	return builder.EndDict().Build();
+}
+
+/**
+ * Дифференциальная загрузка: {"id": 1, "type": "DiffLoad", "path": "base.json"}
+ * Из файла берутся только base_requests. Изменения проходят через журнал,
+ * после них делается контрольная точка - новый снимок с новыми хешами.
+ * Ответ - счётчики diff::DiffStats.
+ */
+json::Node RequestServer::LoadDiff(const json::Dict &request) const {
+	json::Builder builder;
+	builder.StartDict().Key("request_id").Value(request.at("id").AsInt());
+	if(!writable_ || !store_) {
+		return builder.Key("error_message").Value("no journal").EndDict().Build();
+	}
+
+	std::ifstream file(request.at("path").AsString());
+	if(!file) {
+		return builder.Key("error_message").Value("cannot open file").EndDict().Build();
+	}
+	json::Document base = json::Load(file);
+
+	diff::DiffStats stats;
+	const std::vector<journal::Mutation> mutations = diff::Diff(base.GetRoot().AsDict().at("base_requests").AsArray(),
+																					*writable_, store_->Hashes(*writable_), stats);
+	store_->Apply(mutations, *writable_);
+	store_->Checkpoint(*writable_);
+
+	return builder.Key("stops_added").Value(static_cast<int>(stats.stops_added))
+					  .Key("stops_changed").Value(static_cast<int>(stats.stops_changed))
+					  .Key("stops_removed").Value(static_cast<int>(stats.stops_removed))
+					  .Key("buses_added").Value(static_cast<int>(stats.buses_added))
+					  .Key("buses_changed").Value(static_cast<int>(stats.buses_changed))
+					  .Key("buses_removed").Value(static_cast<int>(stats.buses_removed))
+					  .Key("distances_changed").Value(static_cast<int>(stats.distances_changed))
+					  .Key("unchanged").Value(static_cast<int>(stats.unchanged))
+					  .EndDict().Build();
+}
+
+/**
+ * ОСНОВНОЙ ЦИКЛ СЕРВЕРА
+ *
+ * АЛГОРИТМ:
+ * 1. Читаем строку, пустые строки пропускаем
+ * 2. Парсим JSON объект запроса и (при необходимости) пишем его в журнал
+ * 3. Ответ одной строкой копится в собственном буфере пакета
+ * 4. Пакет отдаётся в output, когда во входном буфере не осталось готовых
+ *    запросов (и тогда output сбрасывается) или когда пакет вырос до
+ *    BATCH_BYTES. Перед этим на диск сбрасывается журнал (Store::Sync):
+ *    ни один байт ответа на изменение не попадает в output, пока изменение
+ *    не сохранено - даже если буфер output сбросится сам. fsync делается
+ *    один раз на пакет, клиент не ждёт ответа на последний запрос пакета
+ * 5. NetworkReport пишется в output потоково (см. network_report.h),
+ *    поэтому перед ним отдаётся накопленный пакет
+ *
+ * Готовые запросы видны через in_avail(): для std::cin это требует
+ * std::ios::sync_with_stdio(false) - иначе буфера нет, in_avail() всегда 0
+ * и пакет отдаётся на каждой строке
+ */
+void RequestServer::Serve(std::istream &input, std::ostream &output, replay::RequestRecorder *recorder) const {
+	constexpr size_t BATCH_BYTES = 1 << 20;
+
+	std::ostringstream batch;
+	auto write_batch = [&] {
+		if(store_) {
+			store_->Sync();
+		}
+		const std::string responses = batch.str();
+		output.write(responses.data(), static_cast<std::streamsize>(responses.size()));
+		batch.str({});
+	};
+
+	std::string line;
+	while(std::getline(input, line)) {
+		if(line.find_first_not_of(" \t\r"sv) == std::string::npos) {
+			continue;
+		}
+
+		json::Node response;
+		bool streamed = false;
+		try {
+			std::istringstream line_stream(line);
+			json::Document doc = json::Load(line_stream);
+			const json::Dict &request = doc.GetRoot().AsDict();
+
+			if(recorder) {
+				recorder->Record(request);
+			}
+
+			// Отчёт по сети пишется в поток сразу, без дерева json::Node
+			if(auto type = request.find("type"s); type != request.end() && type->second == json::Node("NetworkReport"s)) {
+				const Data data = CurrentData();   // отчёт ссылается на остановки и маршруты каталога
+				report::NetworkReport network = report::BuildNetworkReport(data.catalogue);
+				write_batch();
+				report::WriteNetworkReport(network, request.at("id").AsInt(), output);
+				streamed = true;
+			} else {
+				response = Handle(request);
+			}
+		} catch(const std::exception &e) {
+			response = json::Builder{}.StartDict().Key("error_message").Value(std::string(e.what())).EndDict().Build();
+		}
+
+		if(streamed) {
+			output.put('\n');
+		} else {
+			json::PrintCompact(response, batch);
+			batch.put('\n');
+		}
+
+		if(input.rdbuf()->in_avail() <= 0) {
+			write_batch();
+			output.flush();
+		} else if(static_cast<size_t>(batch.tellp()) >= BATCH_BYTES) {
+			write_batch();
+		}
+	}
+	write_batch();
+	output.flush();
+}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+/*
+ * СЕРВЕРНЫЙ РЕЖИМ ОБРАБОТКИ ЗАПРОСОВ (NDJSON)
+ *
+ * В пакетном режиме программа читает один JSON документ и выводит один ответ.
+ * В серверном режиме каталог загружается один раз, а stat-запросы приходят
+ * потоком - по одному JSON объекту на строку (NDJSON). На каждую строку
+ * запроса выводится ровно одна строка ответа.
+ *
+ * ПРИМЕР ПОТОКА:
+ *   вход:  {"id":1,"type":"Bus","name":"114"}
+ *   выход: {"curvature":1.23199,"request_id":1,"route_length":1700,...}
+ *
+ * АРХИТЕКТУРНЫЕ РЕШЕНИЯ:
+ * 1. Обработка одного запроса (Handle) отделена от ввода-вывода (Serve),
+ *    поэтому тот же путь используется инструментом воспроизведения журналов
+ * 2. Ошибка в одной строке не останавливает сервер - в ответ выводится error_message
+ * 3. Сервер, созданный с изменяемым каталогом, принимает и запросы на
+ *    изменение (AddStop, AddBus, RemoveBus... - см. input::ParseMutation),
+ *    отвечая {"request_id": id}. С хранилищем (journal.h) изменения пишутся
+ *    в журнал, а журнал сбрасывается на диск до вывода ответов;
+ *    запрос {"type": "Checkpoint"} делает контрольную точку, а
+ *    {"type": "DiffLoad", "path": "base.json"} - дифференциальную загрузку
+ *    новой выгрузки base_requests (base_diff.h)
+ * 4. Сервер с перезагрузчиком (catalogue_reloader.h) каждый запрос выполняет
+ *    на текущей версии каталога; замена версии не прерывает начатый запрос
+ */
+
+#include "json.h"
+#include "map_renderer.h"
+#include "transport_catalogue.h"
+
+#include <iostream>
+#include <memory>
+
+namespace catalogue::replay {
+class RequestRecorder;
+}
+
+namespace catalogue::journal {
+class Store;
+}
+
+namespace catalogue::reload {
+class CatalogueReloader;
+struct Dataset;
+}
+
+namespace catalogue::server {
+
+/**
+ * ОБРАБОТЧИК ПОТОКА STAT-ЗАПРОСОВ
+ *
+ * Хранит ссылки на загруженный каталог и настройки рендеринга либо на
+ * перезагрузчик, у которого берёт текущую версию того и другого.
+ * Запросы чтения каталог не изменяют. Изменения (AddStop, RemoveBus, ...),
+ * Checkpoint и DiffLoad Handle применяет к изменяемому каталогу и журналу
+ * store, поэтому порядок вызовов Handle важен, а повтор запроса изменения
+ * изменяет каталог повторно.
+ */
+class RequestServer {
+public:
+	RequestServer(const TransportCatalogue &catalogue, const render::RenderSettings &settings);
+
+	/** Сервер с изменяемым каталогом; store может быть nullptr - изменения без журнала */
+	RequestServer(TransportCatalogue &catalogue, const render::RenderSettings &settings, journal::Store *store);
+
+	/** Сервер только для чтения поверх версий, которые подменяет reloader */
+	explicit RequestServer(const reload::CatalogueReloader &reloader);
+
+	/**
+	 * Обрабатывает один запрос; на неизвестный тип возвращает error_message.
+	 * Изменение каталога, пришедшее серверу без изменяемого каталога, - тоже ошибка.
+	 */
+	json::Node Handle(const json::Dict &request) const;
+
+	/**
+	 * Читает запросы построчно из input и пишет ответы построчно в output
+	 * до конца потока. Если задан recorder, каждый запрос попадает в журнал.
+	 * Ответ на изменение попадает в output только после Store::Sync.
+	 */
+	void Serve(std::istream &input, std::ostream &output, replay::RequestRecorder *recorder = nullptr) const;
+
+private:
+	/** Данные одного запроса; version удерживает версию перезагрузчика до конца запроса */
+	struct Data {
+		std::shared_ptr<const reload::Dataset> version;
+		const TransportCatalogue &catalogue;
+		const render::RenderSettings &settings;
+	};
+
+	Data CurrentData() const;
+	json::Node ApplyMutation(const json::Dict &request) const;
+	json::Node LoadDiff(const json::Dict &request) const;
+
+	const TransportCatalogue *catalogue_ = nullptr;
+	const render::RenderSettings *settings_ = nullptr;
+	const reload::CatalogueReloader *reloader_ = nullptr;
+	TransportCatalogue *writable_ = nullptr;   // тот же каталог, если изменения разрешены
+	journal::Store *store_ = nullptr;
+};
+}
@@ -0,0 +1,248 @@
+#include "route_similarity.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <limits>
+#include <string_view>
+#include <utility>
+
+namespace catalogue::similarity {
+
+namespace {
+
+constexpr uint32_t EMPTY = std::numeric_limits<uint32_t>::max();
+
+/** Перемешивание 64 бит (splitmix64): близкие номера дают независимые хеши */
+uint64_t Mix(uint64_t x) {
+	x += 0x9E3779B97F4A7C15ull;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	return x ^ (x >> 31);
+}
+
+/**
+ * Признак остановки - хеш названия (FNV-1a), а не Stop::id: сигнатуры
+ * и ответы не зависят от порядка остановок в памяти (ReorderStops)
+ */
+uint64_t StopFeature(std::string_view name) {
+	uint64_t hash = 14695981039346656037ull;
+	for(char c : name) {
+		hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+	}
+	return hash;
+}
+
+/**
+ * Учитывает признак feature в сигнатуре. Хеш-функции семейства -
+ * h1 + i * h2 по двум половинам одного 64-битного хеша (Кирш - Митценмахер),
+ * с финальным перемешиванием: один вызов Mix на признак вместо hashes.
+ */
+void Update(uint32_t *signature, size_t hashes, uint64_t feature) {
+	const uint64_t hash = Mix(feature);
+	const uint32_t h1 = static_cast<uint32_t>(hash);
+	const uint32_t h2 = static_cast<uint32_t>(hash >> 32) | 1;
+	for(size_t i = 0; i < hashes; ++i) {
+		uint32_t value = h1 + static_cast<uint32_t>(i) * h2;
+		value ^= value >> 15;
+		value *= 0x2C1B3C6Du;
+		value ^= value >> 12;
+		signature[i] = std::min(signature[i], value);
+	}
+}
+
+/** Упакованная пара номеров маршрутов (меньший номер в старших битах) */
+uint64_t PackPair(uint32_t first, uint32_t second) {
+	return first < second ? (uint64_t{first} << 32 | second) : (uint64_t{second} << 32 | first);
+}
+
+bool BySimilarity(const SimilarPair &lhs, const SimilarPair &rhs) {
+	if(lhs.similarity != rhs.similarity) {
+		return lhs.similarity > rhs.similarity;
+	}
+	return std::make_pair(lhs.first->id, lhs.second->id) < std::make_pair(rhs.first->id, rhs.second->id);
+}
+}
+
+/**
+ * ПОСТРОЕНИЕ ИНДЕКСА
+ *
+ * 1. Сигнатуры маршрутов - параллельно по диапазонам Bus::id
+ * 2. Полосы LSH - параллельно по номерам полос: для каждой полосы
+ *    отсортированный массив (ключ полосы, маршрут); корзина - отрезок
+ *    с одинаковым ключом
+ */
+RouteSimilarityIndex::RouteSimilarityIndex(const TransportCatalogue &catalogue, const SimilaritySettings &settings)
+	: buses_(catalogue.GetAllBuses()), settings_(settings), hashes_(settings.bands * settings.rows) {
+	const size_t count = buses_.size();
+	stop_signatures_.assign(count * hashes_, EMPTY);
+	segment_signatures_.assign(count * hashes_, EMPTY);
+	has_stops_.assign(count, false);
+
+	const std::deque<transport::Stop> &stops = catalogue.GetAllStops();
+	std::vector<uint64_t> features(stops.size());
+	parallel::ForEachRange(stops.size(), settings_.threads, [&](size_t, size_t begin, size_t end) {
+		for(size_t id = begin; id < end; ++id) {
+			features[id] = StopFeature(stops[id].name);
+		}
+	});
+
+	parallel::ForEachRange(count, settings_.threads, [this, &features](size_t, size_t begin, size_t end) {
+		for(size_t id = begin; id < end; ++id) {
+			uint32_t *stop_signature = stop_signatures_.data() + id * hashes_;
+			uint32_t *segment_signature = segment_signatures_.data() + id * hashes_;
+			const transport::Stop *previous = nullptr;
+			for(const transport::Stop *stop : buses_[id].stop_list) {
+				Update(stop_signature, hashes_, features[stop->id]);
+				if(previous) {
+					// Перегон без направления: концы упорядочены по признаку
+					const uint64_t a = std::min(features[previous->id], features[stop->id]);
+					const uint64_t b = std::max(features[previous->id], features[stop->id]);
+					Update(segment_signature, hashes_, Mix(a) ^ b);
+				}
+				previous = stop;
+			}
+		}
+	});
+	// vector<bool> нельзя писать из нескольких потоков - заполняем отдельно
+	for(size_t id = 0; id < count; ++id) {
+		has_stops_[id] = !buses_[id].stop_list.empty();
+	}
+
+	bands_.resize(settings_.bands);
+	parallel::ForEachRange(settings_.bands, settings_.threads, [this, count](size_t, size_t begin, size_t end) {
+		for(size_t band = begin; band < end; ++band) {
+			std::vector<std::pair<uint64_t, uint32_t>> &keys = bands_[band];
+			keys.reserve(count);
+			for(uint32_t id = 0; id < count; ++id) {
+				if(has_stops_[id]) {
+					keys.emplace_back(BandKey(id, band), id);
+				}
+			}
+			std::sort(keys.begin(), keys.end());
+		}
+	});
+}
+
+uint64_t RouteSimilarityIndex::BandKey(uint32_t bus, size_t band) const {
+	const uint32_t *values = StopSignature(bus) + band * settings_.rows;
+	uint64_t key = band;
+	for(size_t i = 0; i < settings_.rows; ++i) {
+		key = Mix(key ^ values[i]);
+	}
+	return key;
+}
+
+/** Доли совпавших позиций сигнатур; маршрут без перегонов ни на что не похож по перегонам */
+SimilarPair RouteSimilarityIndex::Estimate(uint32_t first, uint32_t second) const {
+	Signature stops1 = StopSignature(first);
+	Signature stops2 = StopSignature(second);
+	Signature segments1 = SegmentSignature(first);
+	Signature segments2 = SegmentSignature(second);
+
+	size_t stop_matches = 0;
+	size_t segment_matches = 0;
+	for(size_t i = 0; i < hashes_; ++i) {
+		stop_matches += stops1[i] == stops2[i];
+		segment_matches += segments1[i] == segments2[i] && segments1[i] != EMPTY;
+	}
+
+	SimilarPair pair;
+	pair.first = &buses_[first];
+	pair.second = &buses_[second];
+	pair.similarity = static_cast<double>(stop_matches) / static_cast<double>(hashes_);
+	pair.segment_similarity = static_cast<double>(segment_matches) / static_cast<double>(hashes_);
+	return pair;
+}
+
+/**
+ * ВСЕ ПОХОЖИЕ ПАРЫ
+ *
+ * АЛГОРИТМ:
+ * 1. Каждый поток обходит свои полосы и выписывает пары из корзин
+ * 2. Кандидаты всех потоков объединяются, повторы (пара совпала
+ *    в нескольких полосах) удаляются сортировкой
+ * 3. Сходство кандидатов оценивается параллельно, пары ниже порога отбрасываются
+ */
+std::vector<SimilarPair> RouteSimilarityIndex::FindPairs(double threshold) const {
+	const size_t threads = parallel::ThreadCount(settings_.threads);
+
+	std::vector<std::vector<uint64_t>> partial_candidates(threads);
+	size_t parts = parallel::ForEachRange(settings_.bands, threads, [&](size_t part, size_t begin, size_t end) {
+		std::vector<uint64_t> &candidates = partial_candidates[part];
+		for(size_t band = begin; band < end; ++band) {
+			const std::vector<std::pair<uint64_t, uint32_t>> &keys = bands_[band];
+			for(size_t run = 0; run < keys.size();) {
+				size_t run_end = run + 1;
+				while(run_end < keys.size() && keys[run_end].first == keys[run].first) {
+					++run_end;
+				}
+				for(size_t i = run; i < run_end; ++i) {
+					const size_t window_end = std::min(run_end, i + 1 + settings_.max_bucket);
+					for(size_t j = i + 1; j < window_end; ++j) {
+						candidates.push_back(PackPair(keys[i].second, keys[j].second));
+					}
+				}
+				run = run_end;
+			}
+		}
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+	});
+
+	std::vector<uint64_t> candidates;
+	for(size_t part = 0; part < parts; ++part) {
+		candidates.insert(candidates.end(), partial_candidates[part].begin(), partial_candidates[part].end());
+		std::vector<uint64_t>().swap(partial_candidates[part]);
+	}
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+	std::vector<std::vector<SimilarPair>> partial_pairs(threads);
+	parts = parallel::ForEachRange(candidates.size(), threads, [&](size_t part, size_t begin, size_t end) {
+		for(size_t i = begin; i < end; ++i) {
+			SimilarPair pair = Estimate(static_cast<uint32_t>(candidates[i] >> 32), static_cast<uint32_t>(candidates[i]));
+			if(pair.similarity >= threshold) {
+				partial_pairs[part].push_back(pair);
+			}
+		}
+	});
+
+	std::vector<SimilarPair> pairs;
+	for(size_t part = 0; part < parts; ++part) {
+		pairs.insert(pairs.end(), partial_pairs[part].begin(), partial_pairs[part].end());
+	}
+	std::sort(pairs.begin(), pairs.end(), BySimilarity);
+	return pairs;
+}
+
+/** Кандидаты - маршруты из тех же корзин, что и bus, хотя бы в одной полосе */
+std::vector<SimilarPair> RouteSimilarityIndex::FindSimilar(const transport::Bus &bus, double threshold) const {
+	if(bus.id >= buses_.size() || &buses_[bus.id] != &bus || !has_stops_[bus.id]) {
+		return {};  // маршрут не из этого каталога или без остановок
+	}
+
+	std::vector<uint32_t> candidates;
+	for(size_t band = 0; band < settings_.bands; ++band) {
+		const std::vector<std::pair<uint64_t, uint32_t>> &keys = bands_[band];
+		const uint64_t key = BandKey(bus.id, band);
+		auto it = std::lower_bound(keys.begin(), keys.end(), std::make_pair(key, uint32_t{0}));
+		for(; it != keys.end() && it->first == key; ++it) {
+			if(it->second != bus.id) {
+				candidates.push_back(it->second);
+			}
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+	std::vector<SimilarPair> pairs;
+	for(uint32_t other : candidates) {
+		SimilarPair pair = Estimate(bus.id, other);
+		if(pair.similarity >= threshold) {
+			pairs.push_back(pair);
+		}
+	}
+	std::sort(pairs.begin(), pairs.end(), BySimilarity);
+	return pairs;
+}
+}
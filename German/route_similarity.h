@@ -0,0 +1,97 @@
+#pragma once
+
+/*
+ * ПОИСК ДУБЛИРУЮЩИХ МАРШРУТОВ (MinHash + LSH)
+ *
+ * Два маршрута считаются похожими, если велико сходство Жаккара их
+ * множеств остановок |A ∩ B| / |A ∪ B|. Точное попарное сравнение
+ * квадратично по числу маршрутов, поэтому:
+ *
+ * 1. MinHash: для каждого маршрута (параллельно, parallel.h) считаются
+ *    две сигнатуры по bands * rows минимумов хешей:
+ *    - по множеству остановок (хеш названия, а не Stop::id: ответы
+ *      не зависят от перенумерации остановок)
+ *    - по множеству перегонов: пар соседних остановок без учёта
+ *      направления, так что маршрут "туда" похож на маршрут "обратно"
+ *    Доля совпавших позиций сигнатур - оценка сходства Жаккара.
+ * 2. LSH: сигнатура остановок делится на bands полос по rows значений.
+ *    Маршруты с одинаковой полосой попадают в одну корзину и становятся
+ *    кандидатами. Пара со сходством s становится кандидатом с вероятностью
+ *    1 - (1 - s^rows)^bands: при 16 x 4 это 0.64 для s = 0.5
+ *    и больше 0.99 для s >= 0.7.
+ * 3. Для кандидатов оценивается сходство по сигнатурам, пары ниже
+ *    порога отбрасываются.
+ *
+ * Память: 2 * bands * rows * 4 байта на маршрут (512 байт при 64 хешах).
+ * Корзина больше max_bucket не разворачивается во все пары: каждый её
+ * маршрут сравнивается только с max_bucket следующими, чтобы тысячи
+ * одинаковых маршрутов не дали квадратичного числа пар.
+ */
+
+#include "transport_catalogue.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace catalogue::similarity {
+
+struct SimilaritySettings {
+	size_t bands = 16;
+	size_t rows = 4;              // значений сигнатуры в полосе; всего bands * rows
+	size_t max_bucket = 256;
+	size_t threads = 0;           // 0 - по числу ядер
+};
+
+/** Пара похожих маршрутов: first->id < second->id */
+struct SimilarPair {
+	const transport::Bus *first = nullptr;
+	const transport::Bus *second = nullptr;
+	double similarity = 0;           // оценка Жаккара по остановкам
+	double segment_similarity = 0;   // оценка Жаккара по перегонам
+};
+
+/**
+ * ИНДЕКС СХОДСТВА МАРШРУТОВ
+ *
+ * Строится по каталогу один раз и отвечает на запросы "все похожие пары"
+ * и "маршруты, похожие на данный". Хранит указатели на маршруты каталога,
+ * поэтому не должен переживать его. Для запросов индекс хранит сам
+ * каталог (TransportCatalogue::GetSimilarityIndex).
+ */
+class RouteSimilarityIndex {
+public:
+	RouteSimilarityIndex(const TransportCatalogue &catalogue, const SimilaritySettings &settings = {});
+
+	/** Все пары со сходством по остановкам не ниже threshold, по убыванию сходства */
+	std::vector<SimilarPair> FindPairs(double threshold) const;
+
+	/** Маршруты, похожие на bus (bus - в поле first), по убыванию сходства */
+	std::vector<SimilarPair> FindSimilar(const transport::Bus &bus, double threshold) const;
+
+private:
+	using Signature = const uint32_t *;
+
+	Signature StopSignature(uint32_t bus) const {
+		return stop_signatures_.data() + bus * hashes_;
+	}
+	Signature SegmentSignature(uint32_t bus) const {
+		return segment_signatures_.data() + bus * hashes_;
+	}
+
+	/** Ключ полосы band сигнатуры остановок */
+	uint64_t BandKey(uint32_t bus, size_t band) const;
+
+	SimilarPair Estimate(uint32_t first, uint32_t second) const;
+
+	const std::deque<transport::Bus> &buses_;
+	SimilaritySettings settings_;
+	size_t hashes_;
+	std::vector<uint32_t> stop_signatures_;      // hashes_ значений на маршрут, по Bus::id
+	std::vector<uint32_t> segment_signatures_;
+	std::vector<bool> has_stops_;                // у маршрута непустой список остановок
+	std::vector<std::vector<std::pair<uint64_t, uint32_t>>> bands_;  // по полосе: (ключ, маршрут), по возрастанию
+};
+}
@@ -0,0 +1,116 @@
+#include "stop_list.h"
+#include "domain.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace transport {
+
+/** Перемещённый список - пустой обычный, а не сжатый без байтов */
+StopList::StopList(StopList &&other) noexcept
+	: plain_(std::move(other.plain_)), packed_(std::move(other.packed_)),
+	  table_(std::exchange(other.table_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+StopList &StopList::operator=(StopList &&other) noexcept {
+	plain_ = std::move(other.plain_);
+	packed_ = std::move(other.packed_);
+	table_ = std::exchange(other.table_, nullptr);
+	size_ = std::exchange(other.size_, 0);
+	other.plain_.clear();
+	other.packed_.clear();
+	return *this;
+}
+
+StopList::Iterator StopList::begin() const {
+	Iterator it;
+	it.size_ = size_;
+	if(!table_) {
+		it.plain_ = plain_.data();
+		return it;
+	}
+	it.table_ = table_;
+	it.cursor_ = packed_.data();
+	if(size_ > 0) {
+		it.Decode();
+	}
+	return it;
+}
+
+StopList::Iterator StopList::end() const {
+	Iterator it;
+	it.index_ = size_;
+	it.size_ = size_;
+	return it;
+}
+
+/**
+ * СЖАТИЕ
+ *
+ * Каждая остановка - varint зигзаг-кода разности с предыдущим номером
+ * (для первой - с нулём); разность берётся по модулю 2^32, так что
+ * расшифровка тем же сложением по модулю восстанавливает номер.
+ */
+void StopList::Compact(const StopTable &table) {
+	if(table_) {
+		table_ = &table;
+		return;
+	}
+
+	packed_.clear();
+	uint32_t previous = 0;
+	for(const Stop *stop : plain_) {
+		const int32_t delta = static_cast<int32_t>(stop->id - previous);
+		uint32_t value = (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31);
+		while(value >= 0x80u) {
+			packed_.push_back(static_cast<uint8_t>(value | 0x80u));
+			value >>= 7;
+		}
+		packed_.push_back(static_cast<uint8_t>(value));
+		previous = stop->id;
+	}
+	packed_.shrink_to_fit();
+
+	table_ = &table;
+	plain_.clear();
+	plain_.shrink_to_fit();
+}
+
+void StopList::Expand() {
+	if(!table_) {
+		return;
+	}
+	plain_ = ToVector();
+	table_ = nullptr;
+	packed_.clear();
+	packed_.shrink_to_fit();
+}
+
+std::vector<const Stop *> StopList::ToVector() const {
+	if(!table_) {
+		return plain_;
+	}
+	std::vector<const Stop *> stops;
+	stops.reserve(size_);
+	stops.assign(begin(), end());
+	return stops;
+}
+
+void StopList::Replace(const Stop *from, const Stop *to) {
+	if(!table_) {
+		std::replace(plain_.begin(), plain_.end(), from, to);
+		return;
+	}
+	const StopTable &table = *table_;
+	Expand();
+	std::replace(plain_.begin(), plain_.end(), from, to);
+	Compact(table);
+}
+
+size_t StopList::MemoryBytes() const {
+	return table_ ? packed_.capacity() : plain_.capacity() * sizeof(const Stop *);
+}
+
+bool StopList::operator==(const StopList &other) const {
+	return size_ == other.size_ && std::equal(begin(), end(), other.begin());
+}
+}
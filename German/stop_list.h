@@ -0,0 +1,155 @@
+#pragma once
+
+/*
+ * СПИСОК ОСТАНОВОК МАРШРУТА (StopList)
+ *
+ * Bus::stop_list хранится в одной из двух форм:
+ * - обычная: std::vector<const Stop *>, 8 байт на остановку маршрута
+ * - сжатая: разности соседних Stop::id, зигзаг-кодирование и varint
+ *   (7 бит на байт, старший бит - продолжение). Если номера остановок
+ *   идут в порядке обхода маршрутов (TransportCatalogue::CompactStopLists),
+ *   соседние остановки маршрута получают близкие номера и большинство
+ *   разностей помещается в один байт
+ *
+ * Сжатый список расшифровывается только последовательно: итератор
+ * хранит текущий номер и позицию в байтах, указатель на остановку
+ * берётся из таблицы StopTable (номер → остановка) каталога. Поэтому
+ * произвольного доступа по индексу нет - все обходы маршрутов идут
+ * итератором от начала.
+ *
+ * ИЗМЕНЕНИЕ: список меняется только целиком (Replace, Expand) - сжатый
+ * список при этом перекодируется; это делает каталог, а не клиенты.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace transport {
+
+struct Stop;
+
+/** Остановки каталога по Stop::id - для расшифровки сжатых списков */
+using StopTable = std::vector<const Stop *>;
+
+class StopList {
+public:
+	/** Последовательный итератор по остановкам в обеих формах */
+	class Iterator {
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type = const Stop *;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Stop *const *;
+		using reference = const Stop *;
+
+		const Stop *operator*() const {
+			return plain_ ? plain_[index_] : (*table_)[id_];
+		}
+
+		Iterator &operator++() {
+			if(++index_ < size_ && !plain_) {
+				Decode();
+			}
+			return *this;
+		}
+
+		Iterator operator++(int) {
+			Iterator previous = *this;
+			++*this;
+			return previous;
+		}
+
+		bool operator==(const Iterator &other) const {
+			return index_ == other.index_;
+		}
+
+		bool operator!=(const Iterator &other) const {
+			return index_ != other.index_;
+		}
+
+	private:
+		friend class StopList;
+
+		void Decode() {
+			uint32_t value = *cursor_++;
+			if(value & 0x80u) {
+				value &= 0x7Fu;
+				int shift = 7;
+				uint8_t byte;
+				do {
+					byte = *cursor_++;
+					value |= static_cast<uint32_t>(byte & 0x7Fu) << shift;
+					shift += 7;
+				} while(byte & 0x80u);
+			}
+			id_ += (value >> 1) ^ (0u - (value & 1u));  // зигзаг: 0, -1, 1, -2, ... → 0, 1, 2, 3, ...
+		}
+
+		const Stop *const *plain_ = nullptr;
+		const uint8_t *cursor_ = nullptr;
+		const StopTable *table_ = nullptr;
+		uint32_t id_ = 0;
+		size_t index_ = 0;
+		size_t size_ = 0;
+	};
+
+	using const_iterator = Iterator;
+	using value_type = const Stop *;
+
+	StopList() = default;
+
+	StopList(std::vector<const Stop *> stops)
+		: plain_(std::move(stops)), size_(plain_.size()) {}
+
+	StopList(const StopList &) = default;
+	StopList &operator=(const StopList &) = default;
+	StopList(StopList &&other) noexcept;
+	StopList &operator=(StopList &&other) noexcept;
+
+	Iterator begin() const;
+	Iterator end() const;
+
+	size_t size() const {
+		return size_;
+	}
+
+	bool empty() const {
+		return size_ == 0;
+	}
+
+	const Stop *front() const {
+		return *begin();
+	}
+
+	/** Сжатая форма */
+	bool IsCompact() const {
+		return table_ != nullptr;
+	}
+
+	/** Переводит в сжатую форму; table должна пережить список и покрывать все Stop::id */
+	void Compact(const StopTable &table);
+
+	/** Переводит в обычную форму */
+	void Expand();
+
+	/** Остановки обычным вектором (копия) */
+	std::vector<const Stop *> ToVector() const;
+
+	/** Заменяет остановку from на to, сохраняя форму */
+	void Replace(const Stop *from, const Stop *to);
+
+	/** Память под элементы списка (по capacity) */
+	size_t MemoryBytes() const;
+
+	bool operator==(const StopList &other) const;
+
+private:
+	std::vector<const Stop *> plain_;
+	std::vector<uint8_t> packed_;
+	const StopTable *table_ = nullptr;   // не nullptr - сжатая форма
+	size_t size_ = 0;
+};
+}
@@ -0,0 +1,142 @@
+#include "stop_proximity.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+
+namespace catalogue::proximity {
+
+namespace {
+
+// Метров в градусе широты при радиусе Земли из geo::ComputeDistance
+constexpr double METERS_PER_DEGREE = 6371000.0 * 3.14159265358979323846 / 180.0;
+
+// Выше этой широты ширина ячейки не растёт: у полюса градус долготы вырождается
+constexpr double MAX_LATITUDE = 89.0;
+
+struct CellEntry {
+	int64_t row = 0;
+	int64_t column = 0;
+	const transport::Stop *stop = nullptr;
+
+	bool operator<(const CellEntry &other) const {
+		return std::tie(row, column) < std::tie(other.row, other.column);
+	}
+};
+
+/** Отрезок [begin, end) отсортированного массива с одной ячейкой */
+struct Cell {
+	size_t begin = 0;
+	size_t end = 0;
+};
+
+/**
+ * Пара упорядочивается по названиям до расчёта: ответ не зависит от номеров остановок.
+ * У совпадающих точек аргумент acos в ComputeDistance может из-за округления
+ * превысить 1, и расстояние выходит NaN - такая пара считается на расстоянии 0.
+ */
+void CheckPair(const transport::Stop *lhs, const transport::Stop *rhs, double radius, std::vector<StopPair> &pairs) {
+	if(lhs->name > rhs->name) {
+		std::swap(lhs, rhs);
+	}
+	double distance = geo::ComputeDistance(lhs->coordinates, rhs->coordinates);
+	if(std::isnan(distance)) {
+		distance = 0;
+	}
+	if(distance <= radius) {
+		pairs.push_back({lhs, rhs, distance});
+	}
+}
+}
+
+/**
+ * САМОСОЕДИНЕНИЕ ПО СЕТКЕ
+ *
+ * Ячейки не меньше radius по обеим осям, поэтому пара на расстоянии
+ * не больше radius лежит в одной ячейке или в соседних. Ячейки
+ * просматриваются параллельно; соседи ищутся бинарным поиском по
+ * отсортированному массиву.
+ */
+std::vector<StopPair> FindNearbyStopPairs(const TransportCatalogue &catalogue, double radius, size_t threads) {
+	const std::deque<transport::Stop> &stops = catalogue.GetAllStops();
+	if(stops.empty() || radius < 0) {
+		return {};
+	}
+
+	double max_latitude = 0;
+	for(const transport::Stop &stop : stops) {
+		max_latitude = std::max(max_latitude, std::abs(stop.coordinates.latitude));
+	}
+	max_latitude = std::min(max_latitude, MAX_LATITUDE);
+
+	// Небольшой запас на округление; при radius == 0 ячейка не вырождается
+	const double cell_latitude = std::max(radius * 1.001 / METERS_PER_DEGREE, 1e-9);
+	const double cell_longitude = cell_latitude / std::cos(max_latitude * 3.14159265358979323846 / 180.0);
+
+	std::vector<CellEntry> entries;
+	entries.reserve(stops.size());
+	for(const transport::Stop &stop : stops) {
+		entries.push_back({static_cast<int64_t>(std::floor(stop.coordinates.latitude / cell_latitude)),
+								 static_cast<int64_t>(std::floor(stop.coordinates.longitude / cell_longitude)), &stop});
+	}
+	std::sort(entries.begin(), entries.end());
+
+	std::vector<Cell> cells;
+	for(size_t begin = 0; begin < entries.size();) {
+		size_t end = begin + 1;
+		while(end < entries.size() && !(entries[begin] < entries[end])) {
+			++end;
+		}
+		cells.push_back({begin, end});
+		begin = end;
+	}
+
+	auto find_cell = [&entries](int64_t row, int64_t column) {
+		const CellEntry key{row, column, nullptr};
+		auto begin = std::lower_bound(entries.begin(), entries.end(), key);
+		auto end = begin;
+		while(end != entries.end() && !(key < *end)) {
+			++end;
+		}
+		return Cell{static_cast<size_t>(begin - entries.begin()), static_cast<size_t>(end - entries.begin())};
+	};
+
+	const size_t thread_count = parallel::ThreadCount(threads);
+	std::vector<std::vector<StopPair>> partial(thread_count);
+	const size_t parts = parallel::ForEachRange(cells.size(), thread_count, [&](size_t part, size_t begin, size_t end) {
+		std::vector<StopPair> &pairs = partial[part];
+		for(size_t c = begin; c < end; ++c) {
+			const Cell &cell = cells[c];
+			for(size_t i = cell.begin; i < cell.end; ++i) {
+				for(size_t j = i + 1; j < cell.end; ++j) {
+					CheckPair(entries[i].stop, entries[j].stop, radius, pairs);
+				}
+			}
+
+			// Соседи "вперёд": каждая пара соседних ячеек - ровно один раз
+			const int64_t row = entries[cell.begin].row;
+			const int64_t column = entries[cell.begin].column;
+			const int64_t forward[4][2] = {{0, 1}, {1, -1}, {1, 0}, {1, 1}};
+			for(const auto &[d_row, d_column] : forward) {
+				const Cell neighbour = find_cell(row + d_row, column + d_column);
+				for(size_t i = cell.begin; i < cell.end; ++i) {
+					for(size_t j = neighbour.begin; j < neighbour.end; ++j) {
+						CheckPair(entries[i].stop, entries[j].stop, radius, pairs);
+					}
+				}
+			}
+		}
+	});
+
+	std::vector<StopPair> pairs;
+	for(size_t part = 0; part < parts; ++part) {
+		pairs.insert(pairs.end(), partial[part].begin(), partial[part].end());
+	}
+	std::sort(pairs.begin(), pairs.end(), [](const StopPair &lhs, const StopPair &rhs) {
+		return std::tie(lhs.distance, lhs.first->name, lhs.second->name) < std::tie(rhs.distance, rhs.first->name, rhs.second->name);
+	});
+	return pairs;
+}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+/*
+ * ПОИСК БЛИЗКО РАСПОЛОЖЕННЫХ ОСТАНОВОК (пространственное самосоединение)
+ *
+ * В импортированных данных много остановок в нескольких метрах друг от
+ * друга под разными названиями. FindNearbyStopPairs находит все пары
+ * остановок не дальше radius метров - кандидатов на слияние.
+ *
+ * АЛГОРИТМ (сетка + сортировка, почти линейный):
+ * 1. Плоскость делится на ячейки не меньше radius по каждой оси: высота
+ *    ячейки - radius в градусах широты, ширина - radius в градусах долготы
+ *    на самой высокой широте данных (там градус долготы короче всего)
+ * 2. Остановки сортируются по ключу ячейки; ячейка - отрезок массива
+ * 3. Пары ищутся внутри ячейки и с четырьмя соседями "вперёд"
+ *    (справа, снизу-слева, снизу, снизу-справа) - каждая пара соседних
+ *    ячеек просматривается один раз. Ячейки делятся между потоками (parallel.h)
+ * 4. Расстояние кандидатов проверяется geo::ComputeDistance
+ *
+ * Сложность: O(N log N) на сортировку и O(N + пары в соседних ячейках)
+ * на поиск. Переход через 180-й меридиан не учитывается.
+ */
+
+#include "transport_catalogue.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace catalogue::proximity {
+
+/** Пара близких остановок: first->name < second->name */
+struct StopPair {
+	const transport::Stop *first = nullptr;
+	const transport::Stop *second = nullptr;
+	double distance = 0;   // м, geo::ComputeDistance
+};
+
+/** Все пары остановок не дальше radius метров, по возрастанию расстояния; threads == 0 - по числу ядер */
+std::vector<StopPair> FindNearbyStopPairs(const TransportCatalogue &catalogue, double radius, size_t threads = 0);
+}
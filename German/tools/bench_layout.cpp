@@ -0,0 +1,366 @@
+/*
+ * ЗАМЕР РАСКЛАДКИ ОСТАНОВОК В ПАМЯТИ
+ *
+ * Отдельная утилита: загружает каталог и прогоняет одни и те же нагрузки
+ * при разных порядках остановок (TransportCatalogue::ReorderStops):
+ *   input   - порядок входного файла (как после загрузки)
+ *   routes  - порядок обхода маршрутов (StopOrder::ROUTES)
+ *   hilbert - вдоль кривой Гильберта (StopOrder::HILBERT)
+ *
+ * НАГРУЗКИ (в одном потоке, чтобы счётчики относились ко всей работе):
+ *   route_walk - обход всех маршрутов: координаты и дорожные расстояния
+ *                соседних остановок, как при расчёте BusInfo
+ *   nearby     - самосоединение по сетке (FindNearbyStopPairs, --radius)
+ *   render     - построение SVG-документа карты (MapRenderer::RenderMap)
+ *
+ * СЧЁТЧИКИ: на Linux - аппаратные счётчики процессора через perf_event_open
+ * (такты, инструкции, промахи последнего уровня кэша, L1D и dTLB при
+ * чтении), только пользовательский режим. Если счётчик недоступен (не Linux,
+ * нет прав - kernel.perf_event_paranoid, виртуальная машина без PMU),
+ * в его столбце "-", а время замеряется всегда.
+ *
+ * ИСПОЛЬЗОВАНИЕ:
+ *   bench_layout --base <base.json> [--repeat 3] [--radius 50] [--compact-stops]
+ *                [--requests <stat.ndjson>]
+ *
+ * С --compact-stops списки сжимаются (CompactStopLists) начиная с routes;
+ * в столбце stop_list_bytes видно, как порядок влияет на размер сжатых списков.
+ *
+ * ПРОВЕРКА ОТВЕТОВ:
+ * С --requests поток stat-запросов (как для --serve) прогоняется при каждом
+ * порядке остановок, и ответы сравниваются побайтно с ответами при порядке
+ * input. Раскладка в памяти не должна менять ни одного ответа: при первом
+ * расхождении утилита называет раскладку и строку запроса и завершается с кодом 1.
+ */
+
+#include "json_reader.h"
+#include "map_renderer.h"
+#include "request_server.h"
+#include "stop_proximity.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+struct Options {
+	string base_path;
+	string requests_path;   // stat-запросы для проверки ответов; пусто - без проверки
+	int repeat = 3;
+	double radius = 50;
+	bool compact_stops = false;
+};
+
+Options ParseOptions(int argc, char *argv[]) {
+	Options options;
+	for(int i = 1; i < argc; ++i) {
+		string_view arg = argv[i];
+		if(arg == "--base"sv && i + 1 < argc) {
+			options.base_path = argv[++i];
+		} else if(arg == "--repeat"sv && i + 1 < argc) {
+			options.repeat = max(1, stoi(argv[++i]));
+		} else if(arg == "--radius"sv && i + 1 < argc) {
+			options.radius = stod(argv[++i]);
+		} else if(arg == "--compact-stops"sv) {
+			options.compact_stops = true;
+		} else if(arg == "--requests"sv && i + 1 < argc) {
+			options.requests_path = argv[++i];
+		} else {
+			throw invalid_argument("unknown argument: "s + string(arg));
+		}
+	}
+	if(options.base_path.empty()) {
+		throw invalid_argument("usage: bench_layout --base <file> [--repeat 3] [--radius 50] [--compact-stops] [--requests <file>]"s);
+	}
+	return options;
+}
+
+// === АППАРАТНЫЕ СЧЁТЧИКИ ===
+
+constexpr size_t COUNTER_COUNT = 5;
+constexpr array<string_view, COUNTER_COUNT> COUNTER_NAMES = {"cycles"sv, "instructions"sv, "llc_misses"sv,
+																				 "l1d_misses"sv, "dtlb_misses"sv};
+
+using CounterValues = array<optional<uint64_t>, COUNTER_COUNT>;
+
+/**
+ * Группа счётчиков с общим включением. Счётчики, которые не открылись,
+ * остаются пустыми; если не открылся первый (такты), группы нет вовсе.
+ */
+class PerfCounters {
+public:
+	PerfCounters() {
+#if defined(__linux__)
+		const uint64_t cache_read_miss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		const array<pair<uint32_t, uint64_t>, COUNTER_COUNT> events = {{
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+			{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | cache_read_miss},
+			{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | cache_read_miss},
+		}};
+		for(size_t i = 0; i < COUNTER_COUNT; ++i) {
+			perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = events[i].first;
+			attr.config = events[i].second;
+			attr.disabled = i == 0 ? 1 : 0;   // члены группы следуют за ведущим
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			const int leader = i == 0 ? -1 : fds_[0];
+			fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+			if(i == 0 && fds_[0] < 0) {
+				error_ = "perf_event_open: "s + strerror(errno);
+				return;
+			}
+		}
+#else
+		error_ = "hardware counters require Linux perf_event_open"s;
+#endif
+	}
+
+	~PerfCounters() {
+#if defined(__linux__)
+		for(int fd : fds_) {
+			if(fd >= 0) {
+				close(fd);
+			}
+		}
+#endif
+	}
+
+	PerfCounters(const PerfCounters &) = delete;
+	PerfCounters &operator=(const PerfCounters &) = delete;
+
+	/** Почему счётчиков нет; пусто - открыт хотя бы счётчик тактов */
+	const string &Error() const {
+		return error_;
+	}
+
+	void Start() {
+#if defined(__linux__)
+		if(fds_[0] >= 0) {
+			ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+			ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		}
+#endif
+	}
+
+	CounterValues Stop() {
+		CounterValues values;
+#if defined(__linux__)
+		if(fds_[0] >= 0) {
+			ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+		}
+		for(size_t i = 0; i < COUNTER_COUNT; ++i) {
+			uint64_t value = 0;
+			if(fds_[i] >= 0 && read(fds_[i], &value, sizeof(value)) == sizeof(value)) {
+				values[i] = value;
+			}
+		}
+#endif
+		return values;
+	}
+
+private:
+	array<int, COUNTER_COUNT> fds_ = {-1, -1, -1, -1, -1};
+	string error_;
+};
+
+// === НАГРУЗКИ ===
+
+/** Результат нагрузки уходит сюда, чтобы компилятор её не выбросил */
+volatile double sink = 0;
+
+void WalkRoutes(const catalogue::TransportCatalogue &catalogue) {
+	double total = 0;
+	for(const transport::Bus &bus : catalogue.GetAllBuses()) {
+		const transport::Stop *previous = nullptr;
+		for(const transport::Stop *stop : bus.stop_list) {
+			if(previous) {
+				total += geo::ComputeDistance(previous->coordinates, stop->coordinates);
+				total += catalogue.GetDistance(previous, stop);
+			}
+			previous = stop;
+		}
+	}
+	sink = total;
+}
+
+void FindNearby(const catalogue::TransportCatalogue &catalogue, double radius) {
+	sink = static_cast<double>(catalogue::proximity::FindNearbyStopPairs(catalogue, radius, 1).size());
+}
+
+void RenderMap(const catalogue::TransportCatalogue &catalogue, const render::RenderSettings &settings) {
+	render::MapRenderer renderer(settings);
+	svg::Document document = renderer.RenderMap(catalogue);
+	sink = static_cast<double>(sizeof(document));
+}
+
+struct Workload {
+	string_view name;
+	function<void()> run;
+};
+
+/** Строка таблицы: среднее по повторам время и значения счётчиков */
+void Measure(string_view layout, const Workload &workload, int repeat, PerfCounters &counters, size_t stop_list_bytes) {
+	using Clock = chrono::steady_clock;
+
+	workload.run();  // прогрев: первое касание страниц не должно попасть в замер
+	array<uint64_t, COUNTER_COUNT> totals = {};
+	array<bool, COUNTER_COUNT> available;
+	available.fill(true);
+	Clock::duration elapsed{};
+	for(int i = 0; i < repeat; ++i) {
+		const Clock::time_point start = Clock::now();
+		counters.Start();
+		workload.run();
+		const CounterValues values = counters.Stop();
+		elapsed += Clock::now() - start;
+		for(size_t k = 0; k < COUNTER_COUNT; ++k) {
+			if(values[k]) {
+				totals[k] += *values[k];
+			} else {
+				available[k] = false;
+			}
+		}
+	}
+
+	cout << left << setw(9) << layout << setw(12) << workload.name << right << fixed << setprecision(1) << setw(10)
+		  << chrono::duration<double, milli>(elapsed).count() / repeat;
+	for(size_t k = 0; k < COUNTER_COUNT; ++k) {
+		cout << setw(15);
+		if(available[k]) {
+			cout << totals[k] / repeat;
+		} else {
+			cout << "-"sv;
+		}
+	}
+	cout << setw(8);
+	if(available[0] && available[1] && totals[0] > 0) {
+		cout << setprecision(2) << static_cast<double>(totals[1]) / static_cast<double>(totals[0]);
+	} else {
+		cout << "-"sv;
+	}
+	cout << setw(17) << stop_list_bytes << endl;
+}
+
+/** Ответы сервера на все запросы потока, по строке на запрос */
+string Respond(const catalogue::TransportCatalogue &catalogue, const render::RenderSettings &settings, const string &requests) {
+	istringstream input(requests);
+	ostringstream output;
+	catalogue::server::RequestServer(catalogue, settings).Serve(input, output);
+	return output.str();
+}
+
+/** Номер первой различающейся строки (с 1) */
+size_t FirstDifferentLine(const string &lhs, const string &rhs) {
+	const size_t position = mismatch(lhs.begin(), lhs.begin() + min(lhs.size(), rhs.size()), rhs.begin()).first - lhs.begin();
+	return static_cast<size_t>(count(lhs.begin(), lhs.begin() + position, '\n')) + 1;
+}
+
+void PrintHeader() {
+	cout << left << setw(9) << "layout"sv << setw(12) << "workload"sv << right << setw(10) << "ms"sv;
+	for(string_view name : COUNTER_NAMES) {
+		cout << setw(15) << name;
+	}
+	cout << setw(8) << "ipc"sv << setw(17) << "stop_list_bytes"sv << endl;
+}
+}
+
+int main(int argc, char *argv[]) {
+	try {
+		const Options options = ParseOptions(argc, argv);
+
+		catalogue::TransportCatalogue catalogue;
+		ifstream base_file(options.base_path);
+		if(!base_file) {
+			throw runtime_error("cannot open "s + options.base_path);
+		}
+		json::Document base = json::Load(base_file);
+		const render::RenderSettings settings = catalogue::input::LoadBase(base.GetRoot().AsDict(), catalogue);
+
+		string requests;
+		string expected;   // ответы при порядке input
+		if(!options.requests_path.empty()) {
+			ifstream requests_file(options.requests_path);
+			if(!requests_file) {
+				throw runtime_error("cannot open "s + options.requests_path);
+			}
+			requests.assign(istreambuf_iterator<char>(requests_file), istreambuf_iterator<char>());
+		}
+
+		PerfCounters counters;
+		if(!counters.Error().empty()) {
+			cerr << "hardware counters unavailable ("sv << counters.Error() << "), measuring time only"sv << endl;
+		}
+
+		const vector<Workload> workloads = {
+			{"route_walk"sv, [&] { WalkRoutes(catalogue); }},
+			{"nearby"sv, [&] { FindNearby(catalogue, options.radius); }},
+			{"render"sv, [&] { RenderMap(catalogue, settings); }},
+		};
+
+		const array<pair<string_view, optional<catalogue::detail::StopOrder>>, 3> layouts = {{
+			{"input"sv, nullopt},
+			{"routes"sv, catalogue::detail::StopOrder::ROUTES},
+			{"hilbert"sv, catalogue::detail::StopOrder::HILBERT},
+		}};
+
+		PrintHeader();
+		for(const auto &[name, order] : layouts) {
+			if(order) {
+				catalogue.ReorderStops(*order);
+				if(options.compact_stops) {
+					catalogue.CompactStopLists();  // после первого вызова списки пересжимаются ReorderStops
+				}
+			}
+			if(!requests.empty()) {
+				const string responses = Respond(catalogue, settings, requests);
+				if(!order) {
+					expected = responses;
+				} else if(responses != expected) {
+					cerr << "layout "sv << name << ": response to request line "sv << FirstDifferentLine(expected, responses)
+						  << " differs from layout input"sv << endl;
+					return 1;
+				}
+			}
+			const size_t stop_list_bytes = catalogue.GetStats().stop_list_bytes;
+			for(const Workload &workload : workloads) {
+				Measure(name, workload, options.repeat, counters, stop_list_bytes);
+			}
+		}
+		if(!requests.empty()) {
+			cerr << "responses identical across layouts"sv << endl;
+		}
+		return 0;
+	} catch(const exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+}
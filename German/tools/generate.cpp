@@ -0,0 +1,515 @@
+/*
+ * ГЕНЕРАТОР СИНТЕТИЧЕСКИХ НАБОРОВ ДАННЫХ
+ *
+ * Отдельная утилита для проверки масштабируемости каталога на входах,
+ * намного больших любого реального города (до 10M остановок и 1M маршрутов).
+ * Пишет полноценный входной документ (base_requests, render_settings,
+ * stat_requests) потоком прямо в файл - память не зависит от размера набора.
+ *
+ * ИСПОЛЬЗОВАНИЕ:
+ *   generate [--seed 1] [--stops 10000] [--buses 1000] [--clusters N]
+ *            [--corridors 6] [--min-route 5] [--max-route 30]
+ *            [--stat-requests 1000] [--mix bus=45,stop=45,map=10]
+ *            [--missing 0.05] [--output file.json]
+ *
+ * МОДЕЛЬ ГОРОДА:
+ * - Остановки сгруппированы в кластеры (районы), центры кластеров
+ *   разбросаны по прямоугольнику, размер которого растёт с их числом
+ * - Внутри кластера остановки стоят вдоль нескольких лучей-коридоров,
+ *   расходящихся от центра; нулевые остановки коридоров образуют узел пересадок
+ * - Маршрут идёт по одному коридору к центру и уходит по другому -
+ *   поэтому маршруты одного района перекрываются на общих участках
+ * - Дорожные расстояния задаются для соседних остановок коридора и между
+ *   узловыми остановками: это в 1.1-1.4 раза больше расстояния по прямой
+ *
+ * ДЕТЕРМИНИЗМ И ОГРАНИЧЕННАЯ ПАМЯТЬ:
+ * Все свойства остановки (координаты, соседи) вычисляются из seed и её номера,
+ * поэтому генератор ничего не хранит: при выводе маршрутов координаты
+ * и имена остановок вычисляются заново. Одинаковые параметры и seed
+ * дают побайтно одинаковый файл.
+ */
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../geo.h"
+
+using namespace std;
+
+namespace {
+
+// === ДЕТЕРМИНИРОВАННЫЕ СЛУЧАЙНЫЕ ЧИСЛА ===
+
+/** Хеш-функция splitmix64: одно и то же значение для одних и тех же аргументов */
+uint64_t Mix(uint64_t x) {
+	x += 0x9E3779B97F4A7C15ull;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	return x ^ (x >> 31);
+}
+
+uint64_t Hash(uint64_t seed, uint64_t a, uint64_t b = 0) {
+	return Mix(seed ^ Mix(a ^ Mix(b)));
+}
+
+/** Равномерное число в [0, 1) */
+double Unit(uint64_t h) {
+	return (h >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/** Последовательный генератор для выбора параметров маршрутов и запросов */
+class Random {
+public:
+	explicit Random(uint64_t seed) : state_(seed) {}
+
+	uint64_t Next() {
+		return Mix(state_++);
+	}
+
+	size_t Below(size_t bound) {
+		return bound == 0 ? 0 : Next() % bound;
+	}
+
+	double NextUnit() {
+		return Unit(Next());
+	}
+
+private:
+	uint64_t state_;
+};
+
+// === БУФЕРИЗОВАННЫЙ ВЫВОД ===
+
+/**
+ * Пишет текст крупными блоками; числа форматируются через to_chars
+ * без локалей и временных строк.
+ */
+class Writer {
+public:
+	explicit Writer(ostream &out) : out_(out) {
+		buffer_.reserve(kCapacity + 256);
+	}
+
+	~Writer() {
+		Flush();
+	}
+
+	Writer &operator<<(string_view text) {
+		buffer_.append(text);
+		MaybeFlush();
+		return *this;
+	}
+
+	Writer &operator<<(char c) {
+		buffer_.push_back(c);
+		MaybeFlush();
+		return *this;
+	}
+
+	Writer &operator<<(uint64_t value) {
+		char chars[24];
+		auto result = to_chars(chars, chars + sizeof(chars), value);
+		return *this << string_view(chars, result.ptr - chars);
+	}
+
+	Writer &operator<<(double value) {
+		char chars[32];
+		auto result = to_chars(chars, chars + sizeof(chars), value, chars_format::fixed, 6);
+		return *this << string_view(chars, result.ptr - chars);
+	}
+
+	void Flush() {
+		out_.write(buffer_.data(), static_cast<streamsize>(buffer_.size()));
+		buffer_.clear();
+	}
+
+private:
+	static constexpr size_t kCapacity = 1 << 20;
+
+	void MaybeFlush() {
+		if(buffer_.size() >= kCapacity) {
+			Flush();
+		}
+	}
+
+	ostream &out_;
+	string buffer_;
+};
+
+// === ПАРАМЕТРЫ ===
+
+struct Options {
+	uint64_t seed = 1;
+	uint64_t stops = 10000;
+	uint64_t buses = 1000;
+	uint64_t clusters = 0;        // 0 = примерно 2000 остановок на кластер
+	uint64_t corridors = 6;
+	uint64_t min_route = 5;       // число остановок маршрута (в одну сторону)
+	uint64_t max_route = 30;
+	uint64_t stat_requests = 1000;
+	uint64_t mix_bus = 45;        // доли типов stat-запросов
+	uint64_t mix_stop = 45;
+	uint64_t mix_map = 10;
+	double missing = 0.05;        // доля запросов к несуществующим объектам
+	string output;
+};
+
+uint64_t ParseNumber(string_view text) {
+	uint64_t value = 0;
+	auto result = from_chars(text.data(), text.data() + text.size(), value);
+	if(result.ec != errc{} || result.ptr != text.data() + text.size()) {
+		throw invalid_argument("not a number: "s + string(text));
+	}
+	return value;
+}
+
+void ParseMix(string_view text, Options &options) {
+	options.mix_bus = options.mix_stop = options.mix_map = 0;
+	while(!text.empty()) {
+		size_t comma = text.find(',');
+		string_view item = text.substr(0, comma);
+		size_t eq = item.find('=');
+		if(eq == string_view::npos) {
+			throw invalid_argument("bad --mix item: "s + string(item));
+		}
+		string_view key = item.substr(0, eq);
+		uint64_t value = ParseNumber(item.substr(eq + 1));
+		if(key == "bus"sv) {
+			options.mix_bus = value;
+		} else if(key == "stop"sv) {
+			options.mix_stop = value;
+		} else if(key == "map"sv) {
+			options.mix_map = value;
+		} else {
+			throw invalid_argument("bad --mix key: "s + string(key));
+		}
+		text = comma == string_view::npos ? string_view{} : text.substr(comma + 1);
+	}
+}
+
+Options ParseOptions(int argc, char *argv[]) {
+	Options options;
+	for(int i = 1; i + 1 < argc; i += 2) {
+		string_view arg = argv[i];
+		string_view value = argv[i + 1];
+		if(arg == "--seed"sv) {
+			options.seed = ParseNumber(value);
+		} else if(arg == "--stops"sv) {
+			options.stops = ParseNumber(value);
+		} else if(arg == "--buses"sv) {
+			options.buses = ParseNumber(value);
+		} else if(arg == "--clusters"sv) {
+			options.clusters = ParseNumber(value);
+		} else if(arg == "--corridors"sv) {
+			options.corridors = ParseNumber(value);
+		} else if(arg == "--min-route"sv) {
+			options.min_route = ParseNumber(value);
+		} else if(arg == "--max-route"sv) {
+			options.max_route = ParseNumber(value);
+		} else if(arg == "--stat-requests"sv) {
+			options.stat_requests = ParseNumber(value);
+		} else if(arg == "--mix"sv) {
+			ParseMix(value, options);
+		} else if(arg == "--missing"sv) {
+			options.missing = stod(string(value));
+		} else if(arg == "--output"sv) {
+			options.output = value;
+		} else {
+			throw invalid_argument("unknown argument: "s + string(arg));
+		}
+	}
+
+	if(options.stops == 0) {
+		throw invalid_argument("--stops must be positive"s);
+	}
+	if(options.clusters == 0) {
+		options.clusters = max<uint64_t>(1, options.stops / 2000);
+	}
+	options.clusters = min(options.clusters, options.stops);
+	options.corridors = max<uint64_t>(1, options.corridors);
+	options.min_route = max<uint64_t>(2, options.min_route);
+	options.max_route = max(options.min_route, options.max_route);
+	if(options.mix_bus + options.mix_stop + options.mix_map == 0) {
+		throw invalid_argument("--mix must contain a positive share"s);
+	}
+	return options;
+}
+
+// === МОДЕЛЬ ГОРОДА ===
+
+/** Остановка задаётся кластером, коридором и шагом от центра кластера */
+struct StopPosition {
+	uint64_t cluster;
+	uint64_t corridor;
+	uint64_t step;
+};
+
+class City {
+public:
+	explicit City(const Options &options) : options_(options) {
+		grid_ = static_cast<uint64_t>(ceil(sqrt(static_cast<double>(options.clusters))));
+	}
+
+	uint64_t ClusterBegin(uint64_t cluster) const {
+		return cluster * options_.stops / options_.clusters;
+	}
+
+	uint64_t ClusterSize(uint64_t cluster) const {
+		return ClusterBegin(cluster + 1) - ClusterBegin(cluster);
+	}
+
+	/** Число шагов в коридоре (последний коридор может быть короче) */
+	uint64_t CorridorLength(uint64_t cluster, uint64_t corridor) const {
+		uint64_t size = ClusterSize(cluster);
+		return size / options_.corridors + (corridor < size % options_.corridors ? 1 : 0);
+	}
+
+	/** Коридоров в кластере: маленький кластер может не заполнить все */
+	uint64_t Corridors(uint64_t cluster) const {
+		return min(options_.corridors, ClusterSize(cluster));
+	}
+
+	uint64_t Index(const StopPosition &pos) const {
+		return ClusterBegin(pos.cluster) + pos.step * options_.corridors + pos.corridor;
+	}
+
+	StopPosition Position(uint64_t index) const {
+		// Кластер ищем двоичным поиском по границам (границы монотонны)
+		uint64_t lo = 0;
+		uint64_t hi = options_.clusters;
+		while(hi - lo > 1) {
+			uint64_t mid = (lo + hi) / 2;
+			(ClusterBegin(mid) <= index ? lo : hi) = mid;
+		}
+		uint64_t offset = index - ClusterBegin(lo);
+		return {lo, offset % options_.corridors, offset / options_.corridors};
+	}
+
+	/**
+	 * Координаты остановки: центр кластера плюс шаги вдоль коридора
+	 * (около 400 м) и небольшой случайный сдвиг
+	 */
+	geo::Coordinates Coordinates(uint64_t index) const {
+		StopPosition pos = Position(index);
+		const double cell = 0.08;  // размер ячейки сетки центров кластеров, градусы
+		double center_lat = 55.0 + (pos.cluster / grid_) * cell + Unit(Hash(options_.seed, pos.cluster, 1)) * cell * 0.3;
+		double center_lng = 37.0 + (pos.cluster % grid_) * cell * 1.7 + Unit(Hash(options_.seed, pos.cluster, 2)) * cell * 0.5;
+
+		double angle = 2 * M_PI * (pos.corridor + 0.3 * Unit(Hash(options_.seed, pos.cluster, 3 + pos.corridor))) / Corridors(pos.cluster);
+		double radius = 0.0036 * (pos.step + 0.25);
+		double jitter_lat = (Unit(Hash(options_.seed, index, 4)) - 0.5) * 0.001;
+		double jitter_lng = (Unit(Hash(options_.seed, index, 5)) - 0.5) * 0.0016;
+
+		return {center_lat + radius * sin(angle) + jitter_lat,
+				  center_lng + radius * cos(angle) * 1.7 + jitter_lng};
+	}
+
+	/** Дорожное расстояние: расстояние по прямой с коэффициентом извилистости 1.1-1.4 */
+	uint64_t RoadDistance(uint64_t from, uint64_t to) const {
+		double direct = geo::ComputeDistance(Coordinates(from), Coordinates(to));
+		double factor = 1.1 + 0.3 * Unit(Hash(options_.seed, min(from, to), max(from, to)));
+		return max<uint64_t>(1, static_cast<uint64_t>(direct * factor));
+	}
+
+private:
+	const Options &options_;
+	uint64_t grid_ = 1;
+};
+
+void WriteStopName(Writer &out, uint64_t index) {
+	out << "\"Stop "sv << index << '"';
+}
+
+void WriteBusName(Writer &out, uint64_t index) {
+	out << "\"Bus "sv << index << '"';
+}
+
+// === ВЫВОД РАЗДЕЛОВ ДОКУМЕНТА ===
+
+/**
+ * Остановка с дорожными расстояниями: до следующей остановки коридора,
+ * а у узловой (нулевой) остановки - ещё и до узловых остановок других коридоров
+ */
+void WriteStop(Writer &out, const City &city, uint64_t index) {
+	StopPosition pos = city.Position(index);
+	geo::Coordinates coords = city.Coordinates(index);
+
+	out << "{\"type\":\"Stop\",\"name\":"sv;
+	WriteStopName(out, index);
+	out << ",\"latitude\":"sv << coords.latitude << ",\"longitude\":"sv << coords.longitude
+		 << ",\"road_distances\":{"sv;
+
+	bool first = true;
+	auto add_distance = [&](uint64_t to) {
+		if(!first) {
+			out << ',';
+		}
+		first = false;
+		WriteStopName(out, to);
+		out << ':' << city.RoadDistance(index, to);
+	};
+
+	if(pos.step + 1 < city.CorridorLength(pos.cluster, pos.corridor)) {
+		add_distance(city.Index({pos.cluster, pos.corridor, pos.step + 1}));
+	}
+	if(pos.step == 0) {
+		for(uint64_t corridor = pos.corridor + 1; corridor < city.Corridors(pos.cluster); ++corridor) {
+			add_distance(city.Index({pos.cluster, corridor, 0}));
+		}
+	}
+	out << "}}"sv;
+}
+
+/**
+ * Маршрут: по коридору a от шага s к центру, затем по коридору b до шага t;
+ * если a и b совпали - только по коридору a (когда его хватает на min_route).
+ * Если коридоры короче min_route, между ними вставляются узловые остановки
+ * других коридоров (узлы связаны дорожными расстояниями друг с другом).
+ * Кольцевой маршрут возвращается тем же путём к начальной остановке,
+ * не повторяя остановку разворота.
+ */
+void WriteBus(Writer &out, const City &city, const Options &options, Random &random, uint64_t index) {
+	uint64_t cluster = random.Below(options.clusters);
+	uint64_t corridors = city.Corridors(cluster);
+	uint64_t a = random.Below(corridors);
+	uint64_t b = random.Below(corridors);
+	uint64_t length = options.min_route + random.Below(options.max_route - options.min_route + 1);
+	if(a == b && city.CorridorLength(cluster, a) < options.min_route && corridors > 1) {
+		b = (a + 1) % corridors;   // одного коридора не хватает на маршрут
+	}
+
+	uint64_t a_split = 1 + random.Below(length);
+	uint64_t a_steps = min(city.CorridorLength(cluster, a), a == b ? length : a_split);
+	uint64_t b_steps = a == b ? 0 : min(city.CorridorLength(cluster, b), length - min(length, a_steps));
+	a_steps = min(city.CorridorLength(cluster, a), max(a_steps, length - b_steps));   // b короче остатка
+	bool roundtrip = random.NextUnit() < 0.3;
+
+	vector<uint64_t> stops;
+	stops.reserve(roundtrip ? 2 * length : length);
+	for(uint64_t step = a_steps; step-- > 0;) {
+		stops.push_back(city.Index({cluster, a, step}));
+	}
+	for(uint64_t corridor = 0; corridor < corridors && stops.size() + b_steps < options.min_route; ++corridor) {
+		if(corridor != a && corridor != b) {
+			stops.push_back(city.Index({cluster, corridor, 0}));
+		}
+	}
+	for(uint64_t step = 0; step < b_steps; ++step) {
+		stops.push_back(city.Index({cluster, b, step}));
+	}
+	if(roundtrip) {
+		for(size_t i = stops.size() - 1; i-- > 0;) {
+			stops.push_back(stops[i]);
+		}
+	}
+
+	out << "{\"type\":\"Bus\",\"name\":"sv;
+	WriteBusName(out, index);
+	out << ",\"is_roundtrip\":"sv << (roundtrip ? "true"sv : "false"sv) << ",\"stops\":["sv;
+	for(size_t i = 0; i < stops.size(); ++i) {
+		if(i > 0) {
+			out << ',';
+		}
+		WriteStopName(out, stops[i]);
+	}
+	out << "]}"sv;
+}
+
+void WriteRenderSettings(Writer &out) {
+	out << "\"render_settings\":{\"width\":1200,\"height\":1200,\"padding\":50,"
+			 "\"stop_radius\":3,\"line_width\":4,"
+			 "\"bus_label_font_size\":14,\"bus_label_offset\":[7,15],"
+			 "\"stop_label_font_size\":10,\"stop_label_offset\":[7,-3],"
+			 "\"underlayer_color\":[255,255,255,0.85],\"underlayer_width\":3,"
+			 "\"color_palette\":[\"green\",[255,160,0],\"red\",[0,100,200],[140,40,160,0.9]]}"sv;
+}
+
+void WriteStatRequests(Writer &out, const Options &options, Random &random) {
+	const uint64_t total = options.mix_bus + options.mix_stop + options.mix_map;
+
+	out << "\"stat_requests\":["sv;
+	for(uint64_t id = 1; id <= options.stat_requests; ++id) {
+		if(id > 1) {
+			out << ",\n"sv;
+		}
+		out << "{\"id\":"sv << id << ",\"type\":"sv;
+
+		uint64_t choice = random.Below(total);
+		bool missing = random.NextUnit() < options.missing;
+		if(choice < options.mix_bus) {
+			out << "\"Bus\",\"name\":"sv;
+			if(missing) {
+				out << "\"Bus missing "sv << id << '"';
+			} else {
+				WriteBusName(out, random.Below(max<uint64_t>(1, options.buses)));
+			}
+		} else if(choice < options.mix_bus + options.mix_stop) {
+			out << "\"Stop\",\"name\":"sv;
+			if(missing) {
+				out << "\"Stop missing "sv << id << '"';
+			} else {
+				WriteStopName(out, random.Below(options.stops));
+			}
+		} else {
+			out << "\"Map\""sv;
+		}
+		out << '}';
+	}
+	out << ']';
+}
+
+void Generate(const Options &options, ostream &stream) {
+	Writer out(stream);
+	City city(options);
+
+	// Маршруты и stat-запросы берут параметры из отдельных потоков
+	// случайных чисел, поэтому число остановок не сдвигает их выбор
+	Random bus_random(Hash(options.seed, 0xB05));
+	Random stat_random(Hash(options.seed, 0x57A7));
+
+	out << "{\"base_requests\":[\n"sv;
+	for(uint64_t i = 0; i < options.stops; ++i) {
+		if(i > 0) {
+			out << ",\n"sv;
+		}
+		WriteStop(out, city, i);
+	}
+	for(uint64_t i = 0; i < options.buses; ++i) {
+		out << ",\n"sv;
+		WriteBus(out, city, options, bus_random, i);
+	}
+	out << "\n],\n"sv;
+
+	WriteRenderSettings(out);
+	out << ",\n"sv;
+	WriteStatRequests(out, options, stat_random);
+	out << "}\n"sv;
+}
+}
+
+int main(int argc, char *argv[]) {
+	try {
+		Options options = ParseOptions(argc, argv);
+
+		if(options.output.empty()) {
+			Generate(options, cout);
+		} else {
+			ofstream file(options.output, ios::binary);
+			if(!file) {
+				throw runtime_error("cannot open "s + options.output);
+			}
+			Generate(options, file);
+		}
+	} catch(const exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,124 @@
+/*
+ * ВОСПРОИЗВЕДЕНИЕ ЖУРНАЛА STAT-ЗАПРОСОВ
+ *
+ * Отдельная утилита: загружает каталог, прогоняет записанный журнал
+ * (main --serve --record <log>) через тот же путь обработки, что и
+ * серверный режим, и печатает пропускную способность и распределение задержек.
+ *
+ * ИСПОЛЬЗОВАНИЕ:
+ *   replay --base <base.json> --log <requests.ndjson>
+ *          [--speed original|max]       темп воспроизведения (по умолчанию max)
+ *          [--save-responses <file>]    сохранить ответы этой сборки (эталон)
+ *          [--expect <file>]            сверить ответы с эталоном другой сборки
+ *
+ * ТИПИЧНЫЙ СЦЕНАРИЙ СРАВНЕНИЯ СБОРОК:
+ *   old/replay --base city.json --log prod.ndjson --save-responses old.ndjson
+ *   new/replay --base city.json --log prod.ndjson --expect old.ndjson
+ *
+ * Код возврата 2 означает, что ответы новой сборки отличаются от эталона.
+ */
+
+#include "json_reader.h"
+#include "request_log.h"
+#include "request_server.h"
+
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+namespace {
+
+struct Options {
+	string base_path;
+	string log_path;
+	catalogue::replay::ReplaySpeed speed = catalogue::replay::ReplaySpeed::MAX;
+	optional<string> save_path;
+	optional<string> expect_path;
+};
+
+Options ParseOptions(int argc, char *argv[]) {
+	Options options;
+	for(int i = 1; i < argc; i += 2) {
+		string_view arg = argv[i];
+		if(i + 1 >= argc) {
+			throw invalid_argument("missing value for "s + string(arg));
+		}
+		string_view value = argv[i + 1];
+		if(arg == "--base"sv) {
+			options.base_path = value;
+		} else if(arg == "--log"sv) {
+			options.log_path = value;
+		} else if(arg == "--speed"sv) {
+			if(value == "original"sv) {
+				options.speed = catalogue::replay::ReplaySpeed::ORIGINAL;
+			} else if(value == "max"sv) {
+				options.speed = catalogue::replay::ReplaySpeed::MAX;
+			} else {
+				throw invalid_argument("unknown replay speed: "s + string(value));
+			}
+		} else if(arg == "--save-responses"sv) {
+			options.save_path = value;
+		} else if(arg == "--expect"sv) {
+			options.expect_path = value;
+		} else {
+			throw invalid_argument("unknown argument: "s + string(arg));
+		}
+	}
+	if(options.base_path.empty() || options.log_path.empty()) {
+		throw invalid_argument("usage: replay --base <file> --log <file> [--speed original|max] "
+									  "[--save-responses <file>] [--expect <file>]"s);
+	}
+	return options;
+}
+
+ifstream OpenInput(const string &path) {
+	ifstream file(path);
+	if(!file) {
+		throw runtime_error("cannot open "s + path);
+	}
+	return file;
+}
+}
+
+int main(int argc, char *argv[]) {
+	try {
+		Options options = ParseOptions(argc, argv);
+
+		catalogue::TransportCatalogue catalogue;
+		ifstream base_file = OpenInput(options.base_path);
+		json::Document base = json::Load(base_file);
+		render::RenderSettings settings = catalogue::input::LoadBase(base.GetRoot().AsDict(), catalogue);
+
+		ifstream log_file = OpenInput(options.log_path);
+		vector<catalogue::replay::LoggedRequest> log = catalogue::replay::ReadRequestLog(log_file);
+
+		catalogue::replay::ReplayOptions replay_options;
+		replay_options.speed = options.speed;
+
+		vector<string> expected;
+		if(options.expect_path) {
+			ifstream expect_file = OpenInput(*options.expect_path);
+			expected = catalogue::replay::ReadResponses(expect_file);
+			replay_options.expected = &expected;
+		}
+
+		ofstream save_file;
+		if(options.save_path) {
+			save_file.open(*options.save_path);
+			replay_options.responses = &save_file;
+		}
+
+		catalogue::server::RequestServer server(catalogue, settings);
+		catalogue::replay::ReplayReport report = catalogue::replay::Replay(log, server, replay_options);
+		catalogue::replay::PrintReport(report, cout);
+
+		return report.mismatches.empty() ? 0 : 2;
+	} catch(const exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+}
@@ -1,7 +1,11 @@
 #include "transport_catalogue.h"
+#include "parallel.h"
+#include "route_similarity.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <stdexcept>
 #include <unordered_set>
 
 /*
@@ -23,24 +27,26 @@ namespace catalogue {
  * Добавляет новую остановку в систему с защитой от дублирования.
  * 
  * АЛГОРИТМ:
- * 1. Проверяем, не существует ли уже такая остановка
+ * 1. Проверяем по индексу, не существует ли уже остановка с таким названием
  * 2. Добавляем в основное хранилище (stops_)
  * 3. Создаем индекс для быстрого поиска (stops_ptr_)
  * 4. Инициализируем пустой список маршрутов (stop_buses_)
  * 
- * СЛОЖНОСТЬ: O(n) из-за поиска дубликатов
+ * СЛОЖНОСТЬ: O(1) в среднем - поиск дубликата идёт по хеш-таблице,
+ * а не линейным проходом по stops_ (иначе загрузка была бы квадратичной)
  * 
  * @param name Название остановки
  * @param coord Географические координаты
  */
 void TransportCatalogue::AddStop(const std::string_view name, geo::Coordinates coord) {
-	// Проверяем дубликаты (можно было бы оптимизировать через хеш-таблицу)
-	if(std::find(stops_.begin(), stops_.end(), transport::Stop{std::string(name), coord}) != stops_.end()) {
+	// Проверяем дубликаты: остановка с тем же названием всё равно была бы
+	// недоступна через FindStop, поэтому повторная не добавляется
+	if(stops_ptr_.count(name) > 0) {
 		return;
 	}
 
 	// Добавляем остановку в основное хранилище
-	stops_.push_back(transport::Stop{std::string(name), coord});
+	stops_.push_back(transport::Stop{std::string(name), coord, static_cast<uint32_t>(stops_.size())});
 	transport::Stop &stop = stops_.back();
 	
 	// Создаем индекс для быстрого поиска
@@ -48,6 +54,14 @@ void TransportCatalogue::AddStop(const std::string_view name, geo::Coordinates c
 	
 	// Инициализируем пустой набор маршрутов для этой остановки
 	stop_buses_.insert({stop.name, {}});
+
+	if(frozen_) {
+		stop_bus_index_.emplace_back();
+		RankStop(stop.id);
+	}
+	if(stop_table_) {
+		stop_table_->push_back(&stop);
+	}
 }
 
 /**
@@ -70,7 +84,8 @@ void TransportCatalogue::AddBus(const std::string_view name, const std::vector<c
  * Основная реализация добавления маршрута с оптимизацией через move семантику.
  * 
  * АЛГОРИТМ:
- * 1. Проверяем дубликаты маршрутов
+ * 1. Проверяем дубликаты: маршрут с тем же номером ищется по индексу
+ *    (O(1) в среднем), остановки сравниваются только при совпадении номера
  * 2. Добавляем в основное хранилище (buses_)
  * 3. Создаем индекс для быстрого поиска (buses_ptr_)
  * 4. Обновляем обратный индекс (stop_buses_) для всех остановок маршрута
@@ -84,24 +99,349 @@ void TransportCatalogue::AddBus(const std::string_view name, const std::vector<c
  * @param is_rountrip true если маршрут кольцевой
  */
 void TransportCatalogue::AddBus(const std::string_view name, std::vector<const transport::Stop*> &&stops_list, bool is_rountrip) {
-	// Проверяем дубликаты
-	if(std::find(buses_.begin(), buses_.end(), transport::Bus{std::string(name), stops_list}) != buses_.end()) {
-		return;
+	// Дубликат - тот же номер и те же остановки. Тот же номер с другими
+	// остановками - маршрут хранится, но FindBus находит первый
+	bool shadowed = false;
+	if(auto it = buses_ptr_.find(name); it != buses_ptr_.end()) {
+		auto same_stops = [&stops_list](const transport::Bus &bus) {
+			return bus.stop_list.size() == stops_list.size() && std::equal(stops_list.begin(), stops_list.end(), bus.stop_list.begin());
+		};
+		if(same_stops(*it->second)) {
+			return;
+		}
+		if(shadowed_buses_ > 0 && std::any_of(buses_.begin(), buses_.end(), [&](const transport::Bus &bus) {
+			return bus.number == name && same_stops(bus);
+		})) {
+			return;
+		}
+		shadowed = true;
 	}
 
 	// Добавляем маршрут в основное хранилище с перемещением данных
-	buses_.push_back(transport::Bus{std::string(name), std::move(stops_list), is_rountrip});
+	buses_.push_back(transport::Bus{std::string(name), std::move(stops_list), is_rountrip, static_cast<uint32_t>(buses_.size())});
+	if(stop_table_) {
+		buses_.back().stop_list.Compact(*stop_table_);
+	}
 	const transport::Bus &bus = buses_.back();
 	
-	// Создаем индекс для быстрого поиска
-	buses_ptr_.insert({bus.number, &bus});
+	// Создаем индексы: поиск по номеру и обратный индекс остановок
+	LinkBus(bus.id);
+	if(shadowed) {
+		++shadowed_buses_;
+	}
+	similarity_index_.reset();
 
-	// Обновляем обратный индекс: добавляем этот маршрут ко всем его остановкам
+	// Замороженный каталог: BusInfo и ранги только нового маршрута и его остановок
+	if(frozen_) {
+		bus_info_.push_back(ComputeBusInfo(bus));
+		RankBus(bus.id);
+		for(const transport::Stop *stop : bus.stop_list) {
+			RankStop(stop->id);
+		}
+	}
+}
+
+void TransportCatalogue::Reserve(size_t stops, size_t buses, size_t distances) {
+	stops_ptr_.reserve(stops);
+	stop_buses_.reserve(stops);
+	buses_ptr_.reserve(buses);
+	distances_.reserve(distances);
+}
+
+/**
+ * ИНДЕКСЫ МАРШРУТА
+ * 
+ * Маршрут buses_[id] заносится в поиск по номеру и в обратный индекс
+ * каждой своей остановки (а в замороженном каталоге - в битовое
+ * множество остановки). Ключи - string_view на buses_[id].number,
+ * поэтому при переносе маршрута на другое место его нужно сначала
+ * убрать из индексов (UnlinkBus), а потом занести заново.
+ */
+void TransportCatalogue::LinkBus(uint32_t id) {
+	const transport::Bus &bus = buses_[id];
+	buses_ptr_.insert({bus.number, &bus});
 	for(const transport::Stop *stop : bus.stop_list) {
 		stop_buses_[stop->name].insert(bus.number);
+		if(frozen_) {
+			stop_bus_index_[stop->id].Add(bus.id);
+		}
+	}
+}
+
+void TransportCatalogue::UnlinkBus(uint32_t id) {
+	const transport::Bus &bus = buses_[id];
+	if(auto it = buses_ptr_.find(bus.number); it != buses_ptr_.end() && it->second == &bus) {
+		buses_ptr_.erase(it);
+	}
+	for(const transport::Stop *stop : bus.stop_list) {
+		stop_buses_[stop->name].erase(bus.number);
+		if(frozen_) {
+			stop_bus_index_[stop->id].Remove(bus.id);
+		}
+	}
+}
+
+// === МЕТОДЫ ИЗМЕНЕНИЯ ДАННЫХ ===
+
+transport::Stop &TransportCatalogue::StopForUpdate(std::string_view name) {
+	const transport::Stop *stop = FindStop(name);
+	if(!stop) {
+		throw std::invalid_argument("stop not found");
+	}
+	return stops_[stop->id];
+}
+
+/** Новые координаты меняют длину по прямой, а с ней извилистость маршрутов остановки */
+void TransportCatalogue::UpdateStop(std::string_view name, geo::Coordinates coord) {
+	transport::Stop &stop = StopForUpdate(name);
+	stop.coordinates = coord;
+	if(frozen_) {
+		RefreshBuses(&stop, &stop);
+	}
+}
+
+void TransportCatalogue::RemoveStop(std::string_view name) {
+	RemoveStops({name});
+}
+
+/**
+ * УДАЛЕНИЕ ОСТАНОВОК
+ * 
+ * АЛГОРИТМ:
+ * 1. Проверка всех названий до первого изменения: пакет удаляется целиком
+ *    или не удаляется вовсе
+ * 2. Из k удаляемых часть лежит среди последних k номеров; остальные
+ *    освобождают места, которые занимают оставшиеся остановки с хвоста
+ *    (stops_ остаётся плотным)
+ * 3. Один проход по таблице расстояний: расстояния удаляемых стираются,
+ *    расстояния переезжающих откладываются с новыми адресами
+ * 4. Переезжающая остановка переносится на новое место, ключи stops_ptr_
+ *    и stop_buses_ заносятся заново, в списках её маршрутов старый
+ *    указатель заменяется новым
+ * 5. Индексы замороженного каталога: битовое множество переезжает
+ *    вместе с остановкой, степень - под новым номером
+ */
+void TransportCatalogue::RemoveStops(const std::vector<std::string_view> &names) {
+	const size_t count = stops_.size();
+	std::vector<bool> removed(count, false);
+	size_t removed_count = 0;
+	for(std::string_view name : names) {
+		const transport::Stop &stop = StopForUpdate(name);
+		if(!stop_buses_.at(stop.name).empty()) {
+			throw std::invalid_argument("stop is served by buses");
+		}
+		if(!removed[stop.id]) {
+			removed[stop.id] = true;
+			++removed_count;
+		}
+	}
+	if(removed_count == 0) {
+		return;
+	}
+
+	// Освободившиеся места среди первых count - k номеров и остановки хвоста, которые их займут
+	const size_t kept_count = count - removed_count;
+	std::vector<uint32_t> holes;
+	std::vector<uint32_t> movers;
+	for(size_t id = 0; id < count; ++id) {
+		if(id < kept_count && removed[id]) {
+			holes.push_back(static_cast<uint32_t>(id));
+		} else if(id >= kept_count && !removed[id]) {
+			movers.push_back(static_cast<uint32_t>(id));
+		}
+	}
+	std::vector<uint32_t> target(count);
+	for(size_t id = 0; id < count; ++id) {
+		target[id] = static_cast<uint32_t>(id);
+	}
+	for(size_t i = 0; i < movers.size(); ++i) {
+		target[movers[i]] = holes[i];
+	}
+
+	std::vector<std::pair<std::pair<const transport::Stop *, const transport::Stop *>, int>> moved;
+	for(auto it = distances_.begin(); it != distances_.end();) {
+		const auto [from, to] = it->first;
+		if(removed[from->id] || removed[to->id]) {
+			it = distances_.erase(it);
+		} else if(from->id >= kept_count || to->id >= kept_count) {
+			moved.push_back({{&stops_[target[from->id]], &stops_[target[to->id]]}, it->second});
+			it = distances_.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	for(size_t id = 0; id < count; ++id) {
+		if(removed[id]) {
+			stop_buses_.erase(stops_[id].name);
+			stops_ptr_.erase(stops_[id].name);
+		}
+	}
+
+	// Ранговый индекс сравнивает названия: остановки хвоста и места удалённых
+	// убираются из него до переноса названий
+	if(frozen_) {
+		for(uint32_t id : holes) {
+			ranks_[static_cast<size_t>(detail::RankMetric::STOP_DEGREE)].Erase(id);
+		}
+		for(size_t id = kept_count; id < count; ++id) {
+			ranks_[static_cast<size_t>(detail::RankMetric::STOP_DEGREE)].Erase(static_cast<uint32_t>(id));
+		}
+	}
+
+	for(size_t i = 0; i < movers.size(); ++i) {
+		transport::Stop *last = &stops_[movers[i]];
+		transport::Stop *hole = &stops_[holes[i]];
+
+		auto node = stop_buses_.extract(last->name);
+		stops_ptr_.erase(last->name);
+
+		*hole = std::move(*last);
+		hole->id = holes[i];
+
+		node.key() = hole->name;
+		stop_buses_.insert(std::move(node));
+		stops_ptr_.insert({hole->name, hole});
+
+		if(shadowed_buses_ > 0) {
+			// Маршрут-тень не найти по номеру из stop_buses_
+			for(transport::Bus &bus : buses_) {
+				bus.stop_list.Replace(last, hole);
+			}
+		} else {
+			for(std::string_view bus_name : stop_buses_.at(hole->name)) {
+				buses_[buses_ptr_.at(bus_name)->id].stop_list.Replace(last, hole);
+			}
+		}
+		if(frozen_) {
+			stop_bus_index_[holes[i]] = std::move(stop_bus_index_[movers[i]]);
+		}
+	}
+	stops_.resize(kept_count);
+	distances_.insert(moved.begin(), moved.end());
+	if(stop_table_) {
+		stop_table_->resize(kept_count);  // места переехавших остановок - прежние адреса
+	}
+
+	if(frozen_) {
+		stop_bus_index_.resize(kept_count);
+		for(uint32_t id : holes) {
+			RankStop(id);
+		}
+	}
+}
+
+/**
+ * УДАЛЕНИЕ МАРШРУТА
+ * 
+ * Маршруты того же номера (см. shadowed_buses_) удаляются вместе с
+ * найденным, начиная с последнего: перенос на место удалённого их не затрагивает.
+ */
+void TransportCatalogue::RemoveBus(std::string_view name) {
+	const transport::Bus *found = FindBus(name);
+	if(!found) {
+		throw std::invalid_argument("bus not found");
+	}
+
+	if(shadowed_buses_ > 0) {
+		const std::string number = found->number;   // name может ссылаться на номер удаляемого
+		std::vector<uint32_t> shadows;
+		for(const transport::Bus &bus : buses_) {
+			if(bus.number == number && &bus != found) {
+				shadows.push_back(bus.id);
+			}
+		}
+		for(auto it = shadows.rbegin(); it != shadows.rend(); ++it) {
+			RemoveBusAt(*it);
+			--shadowed_buses_;
+		}
+		found = FindBus(number);
+	}
+	RemoveBusAt(found->id);
+	similarity_index_.reset();
+}
+
+/**
+ * Последний маршрут переносится на место удалённого, чтобы номера
+ * оставались плотными. Оба маршрута сначала убираются из индексов,
+ * перенесённый заносится под новым номером. Кэш BusInfo переезжает
+ * вместе с маршрутом; степени остановок удалённого маршрута пересчитываются.
+ */
+void TransportCatalogue::RemoveBusAt(uint32_t id) {
+	const uint32_t last_id = static_cast<uint32_t>(buses_.size() - 1);
+	UnlinkBus(id);
+	if(id != last_id) {
+		UnlinkBus(last_id);
+	}
+
+	// Ранговые индексы сравнивают номера маршрутов: оба убираются до переноса
+	if(frozen_) {
+		for(detail::RankMetric metric : {detail::RankMetric::ROUTE_LENGTH, detail::RankMetric::CURVATURE,
+													detail::RankMetric::STOP_COUNT, detail::RankMetric::UNIQUE_STOP_COUNT}) {
+			ranks_[static_cast<size_t>(metric)].Erase(id);
+			ranks_[static_cast<size_t>(metric)].Erase(last_id);
+		}
+	}
+
+	transport::StopList stops = std::move(buses_[id].stop_list);
+	if(id != last_id) {
+		buses_[id] = std::move(buses_.back());
+		buses_[id].id = id;
+	}
+	buses_.pop_back();
+	if(id != last_id) {
+		LinkBus(id);
+	}
+
+	if(frozen_) {
+		bus_info_[id] = bus_info_[last_id];
+		bus_info_.pop_back();
+		if(id != last_id) {
+			RankBus(id);
+		}
+		for(const transport::Stop *stop : stops) {
+			RankStop(stop->id);
+		}
+	}
+
+	// Перенесённая тень не должна оказаться раньше первого маршрута своего
+	// номера: снимок (journal.h) восстанавливает маршруты по порядку номеров
+	if(id != last_id && IsShadowed(id)) {
+		if(const uint32_t first = FindBus(buses_[id].number)->id; first > id) {
+			SwapBuses(id, first);
+		}
+	}
+}
+
+void TransportCatalogue::SwapBuses(uint32_t lhs, uint32_t rhs) {
+	UnlinkBus(lhs);
+	UnlinkBus(rhs);
+	if(frozen_) {
+		for(detail::RankMetric metric : {detail::RankMetric::ROUTE_LENGTH, detail::RankMetric::CURVATURE,
+													detail::RankMetric::STOP_COUNT, detail::RankMetric::UNIQUE_STOP_COUNT}) {
+			ranks_[static_cast<size_t>(metric)].Erase(lhs);
+			ranks_[static_cast<size_t>(metric)].Erase(rhs);
+		}
+	}
+
+	std::swap(buses_[lhs], buses_[rhs]);
+	buses_[lhs].id = lhs;
+	buses_[rhs].id = rhs;
+	// Первым заносится меньший номер - он и попадает в buses_ptr_
+	LinkBus(std::min(lhs, rhs));
+	LinkBus(std::max(lhs, rhs));
+
+	if(frozen_) {
+		std::swap(bus_info_[lhs], bus_info_[rhs]);
+		RankBus(lhs);
+		RankBus(rhs);
 	}
 }
 
+bool TransportCatalogue::IsShadowed(uint32_t id) const {
+	return shadowed_buses_ > 0 && FindBus(buses_[id].number) != &buses_[id];
+}
+
 // === МЕТОДЫ ПОИСКА ===
 
 /** Поиск остановки по названию за O(1) благодаря хеш-таблице */
@@ -138,29 +478,37 @@ const transport::Bus* TransportCatalogue::FindBus(std::string_view num) const {
  * @return BusInfo со всей статистикой маршрута
  */
 detail::BusInfo TransportCatalogue::GetBusInfo(const transport::Bus &bus) const {
-	int stops = bus.stop_list.size();
-	std::unordered_set<std::string_view> unique_stops;
+	// После заморозки - из кэша, если маршрут принадлежит этому каталогу
+	if(frozen_ && bus.id < bus_info_.size() && &buses_[bus.id] == &bus) {
+		return bus_info_[bus.id];
+	}
+	return ComputeBusInfo(bus);
+}
 
-	// ОПТИМИЗАЦИЯ: O(n) вместо O(n²) для поиска уникальных остановок
-	// Используем unordered_set вместо линейного поиска для каждой остановки
-	for(const transport::Stop *stop : bus.stop_list) {
-		unique_stops.insert(stop->name);
+/** Вычисление BusInfo по списку остановок, без кэша */
+detail::BusInfo TransportCatalogue::ComputeBusInfo(const transport::Bus &bus) const {
+	if(bus.stop_list.empty()) {
+		return {0, 0, 0, 0.0};  // все остановки маршрута были неизвестны при загрузке
 	}
 
+	int stops = bus.stop_list.size();
+	std::unordered_set<std::string_view> unique_stops;
+
 	int length = 0;        // Длина по дорогам (реальная)
 	double real_length = 0; // Длина по прямой (геодезическая)
 
-	// ОПТИМИЗАЦИЯ: Избегаем копирования объектов Stop, работаем с указателями
-	const transport::Stop *prev = bus.stop_list[0];
-	for(size_t i = 1; i < bus.stop_list.size(); ++i) {
-		const transport::Stop *cur = bus.stop_list[i];
-
-		// Вычисляем расстояние по прямой (геодезическое)
-		real_length += geo::ComputeDistance(prev->coordinates, cur->coordinates);
-		
-		// Вычисляем расстояние по дорогам (из кэша)
-		length += GetDistance(prev->name, cur->name);
-		
+	// Один последовательный проход: сжатый список (stop_list.h) читается только подряд.
+	// ОПТИМИЗАЦИЯ: O(n) вместо O(n²) для поиска уникальных остановок - unordered_set
+	const transport::Stop *prev = nullptr;
+	for(const transport::Stop *cur : bus.stop_list) {
+		unique_stops.insert(cur->name);
+		if(prev) {
+			// Вычисляем расстояние по прямой (геодезическое)
+			real_length += geo::ComputeDistance(prev->coordinates, cur->coordinates);
+			
+			// Вычисляем расстояние по дорогам (из кэша)
+			length += GetDistance(prev, cur);
+		}
 		prev = cur;
 	}
 
@@ -192,6 +540,12 @@ std::vector<std::string_view> TransportCatalogue::GetStopInfo(const transport::S
 	return {};  // Пустой список если остановка не найдена
 }
 
+/** Размер набора маршрутов остановки в обратном индексе */
+size_t TransportCatalogue::GetStopDegree(const transport::Stop &stop) const {
+	auto it = stop_buses_.find(stop.name);
+	return it != stop_buses_.end() ? it->second.size() : 0;
+}
+
 // === МЕТОДЫ РАБОТЫ С РАССТОЯНИЯМИ ===
 
 /**
@@ -210,7 +564,42 @@ void TransportCatalogue::SetDistance(const std::string_view from, const std::str
 	assert(stop1 && stop2);  // Остановки должны существовать
 
 	auto p = std::make_pair(stop1, stop2);
-	distances_.insert({p, distance});
+	const bool inserted = distances_.insert({p, distance}).second;
+
+	if(frozen_ && inserted) {
+		RefreshBuses(stop1, stop2);
+	}
+}
+
+/** В отличие от SetDistance, заменяет уже заданное расстояние */
+void TransportCatalogue::UpdateDistance(std::string_view from, std::string_view to, int distance) {
+	const transport::Stop *stop1 = &StopForUpdate(from);
+	const transport::Stop *stop2 = &StopForUpdate(to);
+	distances_.insert_or_assign(std::make_pair(stop1, stop2), distance);
+	if(frozen_) {
+		RefreshBuses(stop1, stop2);
+	}
+}
+
+bool TransportCatalogue::RemoveDistance(std::string_view from, std::string_view to) {
+	const transport::Stop *stop1 = &StopForUpdate(from);
+	const transport::Stop *stop2 = &StopForUpdate(to);
+	const bool erased = distances_.erase(std::make_pair(stop1, stop2)) > 0;
+	if(frozen_ && erased) {
+		RefreshBuses(stop1, stop2);
+	}
+	return erased;
+}
+
+/**
+ * Расстояние или координаты меняют длину только маршрутов, проходящих
+ * через обе остановки (в любом направлении): их находит пересечение множеств
+ */
+void TransportCatalogue::RefreshBuses(const transport::Stop *stop1, const transport::Stop *stop2) {
+	for(uint32_t id : bitmap::Bitmap::And(stop_bus_index_[stop1->id], stop_bus_index_[stop2->id]).ToVector()) {
+		bus_info_[id] = ComputeBusInfo(buses_[id]);
+		RankBus(id);
+	}
 }
 
 /**
@@ -236,6 +625,14 @@ int TransportCatalogue::GetDistance(const std::string_view from, const std::stri
 		return 0;  // Одна из остановок не существует
 	}
 
+	return GetDistance(stop1, stop2);
+}
+
+/**
+ * Та же логика поиска для уже найденных остановок: при обходе маршрута
+ * не нужно дважды хешировать названия на каждом перегоне
+ */
+int TransportCatalogue::GetDistance(const transport::Stop *stop1, const transport::Stop *stop2) const {
 	// Ищем прямое направление (from → to)
 	auto it = distances_.find(std::make_pair(stop1, stop2));
 	if(it != distances_.end()) {
@@ -251,8 +648,491 @@ int TransportCatalogue::GetDistance(const std::string_view from, const std::stri
 	return 0;  // Расстояние не задано
 }
 
-/** Возвращает копию всех маршрутов в системе */
-const std::deque<transport::Bus> TransportCatalogue::GetAllBuses() const {
+// === ЗАМОРОЗКА И ИНДЕКСЫ ===
+
+/**
+ * ЗАМОРОЗКА КАТАЛОГА
+ * 
+ * Строит индексы замороженного каталога:
+ * 1. Битовые множества маршрутов для каждой остановки. Маршруты
+ *    перебираются по возрастанию Bus::id, поэтому каждое добавление
+ *    в множество - запись в конец массива, без поиска места
+ * 2. Кэш BusInfo всех маршрутов (параллельно, parallel.h)
+ * 3. Ранговые индексы по полям BusInfo и степени остановок
+ * 
+ * СЛОЖНОСТЬ: O(суммарная длина маршрутов + (маршруты + остановки) * log)
+ */
+void TransportCatalogue::Freeze() {
+	if(frozen_) {
+		return;
+	}
+
+	stop_bus_index_.assign(stops_.size(), {});
+	for(const transport::Bus &bus : buses_) {
+		for(const transport::Stop *stop : bus.stop_list) {
+			stop_bus_index_[stop->id].Add(bus.id);
+		}
+	}
+	for(bitmap::Bitmap &buses : stop_bus_index_) {
+		buses.ShrinkToFit();
+	}
+
+	// BusInfo маршрутов независимы - считаем параллельно
+	bus_info_.resize(buses_.size());
+	parallel::ForEachRange(buses_.size(), 0, [this](size_t, size_t begin, size_t end) {
+		for(size_t id = begin; id < end; ++id) {
+			bus_info_[id] = ComputeBusInfo(buses_[id]);
+		}
+	});
+
+	for(const transport::Bus &bus : buses_) {
+		RankBus(bus.id);
+	}
+	for(const transport::Stop &stop : stops_) {
+		RankStop(stop.id);
+	}
+	frozen_ = true;
+}
+
+bool TransportCatalogue::IsFrozen() const {
+	return frozen_;
+}
+
+namespace {
+
+/** Сторона решётки кривой Гильберта: 2^16 клеток по каждой оси */
+constexpr uint32_t HILBERT_SIDE = 1u << 16;
+
+/**
+ * Номер клетки (x, y) на кривой Гильберта решётки HILBERT_SIDE x HILBERT_SIDE.
+ * Соседние номера - соседние клетки, поэтому близкие точки, за редкими
+ * исключениями на границах крупных квадрантов, получают близкие номера.
+ */
+uint64_t HilbertIndex(uint32_t x, uint32_t y) {
+	uint64_t index = 0;
+	for(uint32_t side = HILBERT_SIDE / 2; side > 0; side /= 2) {
+		const uint32_t rx = (x & side) ? 1 : 0;
+		const uint32_t ry = (y & side) ? 1 : 0;
+		index += static_cast<uint64_t>(side) * side * ((3 * rx) ^ ry);
+		// Поворот четверти, чтобы кривая внутри неё начиналась у предыдущей
+		if(ry == 0) {
+			if(rx == 1) {
+				x = HILBERT_SIDE - 1 - x;
+				y = HILBERT_SIDE - 1 - y;
+			}
+			std::swap(x, y);
+		}
+	}
+	return index;
+}
+
+/** Клетка решётки для значения из [min, max] */
+uint32_t HilbertCell(double value, double min, double max) {
+	if(max <= min) {
+		return 0;
+	}
+	const double cell = (value - min) / (max - min) * (HILBERT_SIDE - 1);
+	return static_cast<uint32_t>(std::clamp(cell, 0.0, static_cast<double>(HILBERT_SIDE - 1)));
+}
+}
+
+/**
+ * ПЕРЕКЛАДКА ОСТАНОВОК
+ *
+ * ПОРЯДКИ:
+ * - ROUTES: маршруты по Bus::id, в каждом - остановки по порядку; остановка
+ *   получает следующий номер при первой встрече, остановки без маршрутов
+ *   идут в конце в прежнем порядке
+ * - HILBERT: координаты приводятся к решётке 2^16 x 2^16 по охватывающему
+ *   прямоугольнику, остановки сортируются по номеру клетки на кривой
+ *   Гильберта (при равенстве - по прежнему номеру)
+ *
+ * Сжатые списки после перенумерации сжимаются заново по новым номерам.
+ *
+ * Сложность: ROUTES - O(остановки + суммарная длина маршрутов),
+ * HILBERT - O(остановки * log); плюс перенумерация (RenumberStops).
+ */
+void TransportCatalogue::ReorderStops(detail::StopOrder order) {
+	if(!frozen_) {
+		throw std::logic_error("catalogue is not frozen");
+	}
+
+	std::vector<uint32_t> stop_order;
+	stop_order.reserve(stops_.size());
+	if(order == detail::StopOrder::ROUTES) {
+		std::vector<bool> placed(stops_.size(), false);
+		for(const transport::Bus &bus : buses_) {
+			for(const transport::Stop *stop : bus.stop_list) {
+				if(!placed[stop->id]) {
+					placed[stop->id] = true;
+					stop_order.push_back(stop->id);
+				}
+			}
+		}
+		for(uint32_t id = 0; id < stops_.size(); ++id) {
+			if(!placed[id]) {
+				stop_order.push_back(id);
+			}
+		}
+	} else {
+		geo::Coordinates min{90, 180};
+		geo::Coordinates max{-90, -180};
+		for(const transport::Stop &stop : stops_) {
+			min.latitude = std::min(min.latitude, stop.coordinates.latitude);
+			min.longitude = std::min(min.longitude, stop.coordinates.longitude);
+			max.latitude = std::max(max.latitude, stop.coordinates.latitude);
+			max.longitude = std::max(max.longitude, stop.coordinates.longitude);
+		}
+		std::vector<std::pair<uint64_t, uint32_t>> keys(stops_.size());
+		parallel::ForEachRange(stops_.size(), 0, [&](size_t, size_t begin, size_t end) {
+			for(size_t id = begin; id < end; ++id) {
+				const geo::Coordinates &coordinates = stops_[id].coordinates;
+				keys[id] = {HilbertIndex(HilbertCell(coordinates.longitude, min.longitude, max.longitude),
+												 HilbertCell(coordinates.latitude, min.latitude, max.latitude)),
+								static_cast<uint32_t>(id)};
+			}
+		});
+		std::sort(keys.begin(), keys.end());
+		for(const auto &[key, id] : keys) {
+			stop_order.push_back(id);
+		}
+	}
+
+	RenumberStops(stop_order);
+	stops_reordered_ = true;
+	++stop_layout_;
+	if(stop_table_) {
+		CompactAllStopLists();
+	}
+}
+
+uint64_t TransportCatalogue::StopLayout() const {
+	return stop_layout_;
+}
+
+/**
+ * СЖАТИЕ СПИСКОВ ОСТАНОВОК
+ *
+ * Разности номеров малы, только если остановки маршрута лежат рядом
+ * в нумерации: без выбранного порядка остановки сначала перекладываются
+ * в порядке обхода маршрутов (StopOrder::ROUTES). Порядок HILBERT,
+ * выбранный раньше, не разрушается - сжатие идёт по нему.
+ *
+ * Сложность: O(остановки + расстояния + суммарная длина маршрутов).
+ */
+void TransportCatalogue::CompactStopLists() {
+	if(!frozen_) {
+		throw std::logic_error("catalogue is not frozen");
+	}
+	if(stop_table_) {
+		return;
+	}
+	if(!stops_reordered_) {
+		ReorderStops(detail::StopOrder::ROUTES);
+	}
+	stop_table_ = std::make_unique<transport::StopTable>();
+	CompactAllStopLists();
+}
+
+void TransportCatalogue::CompactAllStopLists() {
+	stop_table_->clear();
+	stop_table_->reserve(stops_.size());
+	for(const transport::Stop &stop : stops_) {
+		stop_table_->push_back(&stop);
+	}
+	parallel::ForEachRange(buses_.size(), 0, [this](size_t, size_t begin, size_t end) {
+		for(size_t id = begin; id < end; ++id) {
+			buses_[id].stop_list.Compact(*stop_table_);
+		}
+	});
+}
+
+bool TransportCatalogue::HasCompactStopLists() const {
+	return stop_table_ != nullptr;
+}
+
+/**
+ * ПЕРЕНУМЕРАЦИЯ ОСТАНОВОК
+ *
+ * Остановки переносятся в новый deque в порядке order, поэтому меняются
+ * и номера, и адреса. Перемещённая остановка в старом deque сохраняет
+ * прежний Stop::id - по нему старый указатель переводится в новый, пока
+ * старый deque не освобождён. Заново строятся: поиск по названию,
+ * обратный индекс, ключи расстояний, списки маршрутов (в обычной форме),
+ * битовые множества и ранги остановок.
+ */
+void TransportCatalogue::RenumberStops(const std::vector<uint32_t> &order) {
+	const size_t count = stops_.size();
+
+	// Узлы обоих индексов по названию извлекаются по старым номерам, пока
+	// названия-ключи на месте, и вставляются обратно с новыми ключами -
+	// без новых выделений памяти под узлы и множества маршрутов
+	std::vector<decltype(stops_ptr_)::node_type> stop_nodes(count);
+	std::vector<decltype(stop_buses_)::node_type> bus_nodes(count);
+	for(size_t id = 0; id < count; ++id) {
+		stop_nodes[id] = stops_ptr_.extract(stops_[id].name);
+		bus_nodes[id] = stop_buses_.extract(stops_[id].name);
+	}
+
+	// Ранги остановок ссылаются на названия в старом deque - строятся заново
+	ranks_[static_cast<size_t>(detail::RankMetric::STOP_DEGREE)].Clear();
+
+	std::deque<transport::Stop> old_stops;
+	old_stops.swap(stops_);
+	std::vector<const transport::Stop *> moved(count);
+	for(uint32_t id = 0; id < count; ++id) {
+		transport::Stop &stop = stops_.emplace_back(std::move(old_stops[order[id]]));
+		stop.id = id;
+		moved[order[id]] = &stop;
+
+		stop_nodes[order[id]].key() = stop.name;
+		stop_nodes[order[id]].mapped() = &stop;
+		stops_ptr_.insert(std::move(stop_nodes[order[id]]));
+		bus_nodes[order[id]].key() = stop.name;
+		stop_buses_.insert(std::move(bus_nodes[order[id]]));
+	}
+
+	// Расстояния вставляются по возрастанию новых номеров: узлы таблицы
+	// выделяются в памяти в том же порядке, что и остановки
+	std::vector<std::pair<std::pair<const transport::Stop *, const transport::Stop *>, int>> entries;
+	entries.reserve(distances_.size());
+	for(const auto &[stops_pair, distance] : distances_) {
+		entries.push_back({{moved[stops_pair.first->id], moved[stops_pair.second->id]}, distance});
+	}
+	std::sort(entries.begin(), entries.end(), [](const auto &lhs, const auto &rhs) {
+		return std::make_pair(lhs.first.first->id, lhs.first.second->id) < std::make_pair(rhs.first.first->id, rhs.first.second->id);
+	});
+	detail::DistanceMap distances;
+	distances.rehash(distances_.bucket_count());  // прежняя заполненность: промахи GetDistance не дороже
+	distances.insert(entries.begin(), entries.end());
+	distances_ = std::move(distances);
+
+	for(transport::Bus &bus : buses_) {
+		std::vector<const transport::Stop *> stops = bus.stop_list.ToVector();
+		for(const transport::Stop *&stop : stops) {
+			stop = moved[stop->id];
+		}
+		bus.stop_list = std::move(stops);
+	}
+
+	if(frozen_) {
+		std::vector<bitmap::Bitmap> stop_bus_index(count);
+		for(uint32_t id = 0; id < count; ++id) {
+			stop_bus_index[id] = std::move(stop_bus_index_[order[id]]);
+		}
+		stop_bus_index_ = std::move(stop_bus_index);
+		for(uint32_t id = 0; id < count; ++id) {
+			RankStop(id);
+		}
+	}
+}
+
+std::vector<std::string_view> TransportCatalogue::BusNames(const bitmap::Bitmap &buses) const {
+	std::vector<std::string_view> names;
+	for(uint32_t id : buses.ToVector()) {
+		names.push_back(buses_[id].number);
+	}
+	std::sort(names.begin(), names.end());
+	names.erase(std::unique(names.begin(), names.end()), names.end());   // маршруты одного номера
+	return names;
+}
+
+/**
+ * ОБЩИЕ МАРШРУТЫ НЕСКОЛЬКИХ ОСТАНОВОК
+ * 
+ * Множества пересекаются от меньшего к большему: промежуточный
+ * результат не растёт, а при пустом пересечении работа прекращается.
+ */
+std::vector<std::string_view> TransportCatalogue::GetCommonBuses(const std::vector<const transport::Stop *> &stops) const {
+	if(!frozen_) {
+		throw std::logic_error("catalogue is not frozen");
+	}
+	if(stops.empty()) {
+		return {};
+	}
+
+	std::vector<const bitmap::Bitmap *> sets;
+	sets.reserve(stops.size());
+	for(const transport::Stop *stop : stops) {
+		sets.push_back(&stop_bus_index_[stop->id]);
+	}
+	std::sort(sets.begin(), sets.end(), [](const bitmap::Bitmap *lhs, const bitmap::Bitmap *rhs) {
+		return lhs->Cardinality() < rhs->Cardinality();
+	});
+
+	bitmap::Bitmap common = *sets.front();
+	for(size_t i = 1; i < sets.size() && !common.Empty(); ++i) {
+		common.AndWith(*sets[i]);
+	}
+	return BusNames(common);
+}
+
+/** Маршруты хотя бы одной из остановок: объединение множеств */
+std::vector<std::string_view> TransportCatalogue::GetBusesServingAny(const std::vector<const transport::Stop *> &stops) const {
+	if(!frozen_) {
+		throw std::logic_error("catalogue is not frozen");
+	}
+
+	bitmap::Bitmap any;
+	for(const transport::Stop *stop : stops) {
+		any.OrWith(stop_bus_index_[stop->id]);
+	}
+	return BusNames(any);
+}
+
+void TransportCatalogue::RankBus(uint32_t id) {
+	if(IsShadowed(id)) {
+		return;   // показатели номера - у первого маршрута, как в ответе Bus
+	}
+	const detail::BusInfo &info = bus_info_[id];
+	const std::string &name = buses_[id].number;
+	ranks_[static_cast<size_t>(detail::RankMetric::ROUTE_LENGTH)].Update(id, info.length, name);
+	ranks_[static_cast<size_t>(detail::RankMetric::CURVATURE)].Update(id, info.curvature, name);
+	ranks_[static_cast<size_t>(detail::RankMetric::STOP_COUNT)].Update(id, info.stops, name);
+	ranks_[static_cast<size_t>(detail::RankMetric::UNIQUE_STOP_COUNT)].Update(id, info.unique_stops, name);
+}
+
+void TransportCatalogue::RankStop(uint32_t id) {
+	// Степень - число номеров: маршруты одного номера считаются один раз
+	const size_t degree = shadowed_buses_ > 0 ? GetStopDegree(stops_[id]) : stop_bus_index_[id].Cardinality();
+	ranks_[static_cast<size_t>(detail::RankMetric::STOP_DEGREE)].Update(id, static_cast<double>(degree), stops_[id].name);
+}
+
+/** Первые k по показателю: обход рангового индекса от начала или с конца */
+std::vector<detail::RankEntry> TransportCatalogue::GetTopK(detail::RankMetric metric, size_t k, bool ascending) const {
+	if(!frozen_) {
+		throw std::logic_error("catalogue is not frozen");
+	}
+
+	std::vector<detail::RankEntry> top;
+	ranks_[static_cast<size_t>(metric)].ForEachTop(k, ascending, [&](const std::string &name, double value) {
+		top.push_back({name, value});
+	});
+	return top;
+}
+
+/** Возвращает все остановки без копирования */
+/** Построение - под мьютексом: параллельные запросы ждут один индекс, а не строят свои */
+std::shared_ptr<const similarity::RouteSimilarityIndex> TransportCatalogue::GetSimilarityIndex() const {
+	std::lock_guard lock(similarity_mutex_);
+	if(!similarity_index_) {
+		similarity_index_ = std::make_shared<const similarity::RouteSimilarityIndex>(*this);
+	}
+	return similarity_index_;
+}
+
+const std::deque<transport::Stop> &TransportCatalogue::GetAllStops() const {
+	return stops_;
+}
+
+/** Возвращает все маршруты без копирования */
+const std::deque<transport::Bus> &TransportCatalogue::GetAllBuses() const {
 	return buses_;
 }
-} 
\ No newline at end of file
+
+/** Возвращает таблицу расстояний без копирования */
+const detail::DistanceMap &TransportCatalogue::GetAllDistances() const {
+	return distances_;
+}
+
+// === СТАТИСТИКА ПАМЯТИ ===
+
+namespace {
+
+// Блок памяти выделяется malloc с выравниванием на 16 байт
+size_t AllocationSize(size_t bytes) {
+	return (bytes + 15) / 16 * 16;
+}
+
+/**
+ * Оценка хеш-таблицы libstdc++: массив корзин + узел на каждый элемент
+ * (указатель на следующий узел, значение, кэшированный хеш)
+ */
+template <typename HashTable>
+detail::ContainerStats HashTableStats(const HashTable &table) {
+	using Value = typename HashTable::value_type;
+	detail::ContainerStats stats;
+	stats.size = table.size();
+	stats.bucket_count = table.bucket_count();
+	stats.load_factor = table.load_factor();
+	stats.bytes = table.bucket_count() * sizeof(void *)
+					+ table.size() * AllocationSize(sizeof(void *) + sizeof(Value) + sizeof(size_t));
+	return stats;
+}
+
+/** Оценка deque libstdc++: блоки по 512 байт + карта указателей на блоки */
+template <typename T>
+detail::ContainerStats DequeStats(const std::deque<T> &deque) {
+	const size_t per_block = sizeof(T) < 512 ? 512 / sizeof(T) : 1;
+	const size_t blocks = deque.size() / per_block + 1;
+	detail::ContainerStats stats;
+	stats.size = deque.size();
+	stats.bytes = blocks * AllocationSize(per_block * sizeof(T)) + (blocks + 2) * sizeof(void *);
+	return stats;
+}
+
+/** Динамическая память строки: 0, если строка хранится внутри объекта (SSO) */
+size_t StringHeapBytes(const std::string &str) {
+	const char *data = str.data();
+	const char *object = reinterpret_cast<const char *>(&str);
+	if(data >= object && data < object + sizeof(str)) {
+		return 0;
+	}
+	return AllocationSize(str.capacity() + 1);
+}
+}
+
+/**
+ * ОЦЕНКА ПАМЯТИ КАТАЛОГА
+ * 
+ * Проходит по всем контейнерам и суммирует приблизительные размеры.
+ * Для stop_buses_ учитываются и вложенные множества маршрутов остановок.
+ * 
+ * СЛОЖНОСТЬ: O(остановки + маршруты + записи stop_buses_)
+ */
+detail::CatalogueStats TransportCatalogue::GetStats() const {
+	detail::CatalogueStats stats;
+	stats.stops = DequeStats(stops_);
+	stats.buses = DequeStats(buses_);
+	stats.stops_ptr = HashTableStats(stops_ptr_);
+	stats.buses_ptr = HashTableStats(buses_ptr_);
+	stats.distances = HashTableStats(distances_);
+
+	// Вложенные множества считаем в составе stop_buses_
+	stats.stop_buses = HashTableStats(stop_buses_);
+	for(const auto &[stop, buses] : stop_buses_) {
+		stats.stop_buses.bytes += HashTableStats(buses).bytes;
+	}
+
+	stats.stop_bus_index.size = stop_bus_index_.size();
+	stats.stop_bus_index.bytes = stop_bus_index_.capacity() * sizeof(bitmap::Bitmap);
+	for(const bitmap::Bitmap &buses : stop_bus_index_) {
+		stats.stop_bus_index.bytes += buses.MemoryBytes();
+	}
+
+	stats.ranks.size = bus_info_.size();
+	stats.ranks.bytes = bus_info_.capacity() * sizeof(detail::BusInfo);
+	for(const rank::RankIndex &index : ranks_) {
+		stats.ranks.bytes += index.MemoryBytes();
+	}
+
+	for(const transport::Stop &stop : stops_) {
+		stats.string_bytes += StringHeapBytes(stop.name);
+	}
+	for(const transport::Bus &bus : buses_) {
+		stats.string_bytes += StringHeapBytes(bus.number);
+		if(bus.stop_list.MemoryBytes() > 0) {
+			stats.stop_list_bytes += AllocationSize(bus.stop_list.MemoryBytes());
+		}
+	}
+	if(stop_table_) {
+		stats.stop_list_bytes += AllocationSize(stop_table_->capacity() * sizeof(const transport::Stop *));
+	}
+
+	stats.total_bytes = stats.stops.bytes + stats.buses.bytes + stats.stops_ptr.bytes
+							+ stats.buses_ptr.bytes + stats.stop_buses.bytes + stats.distances.bytes
+							+ stats.stop_bus_index.bytes + stats.ranks.bytes
+							+ stats.string_bytes + stats.stop_list_bytes;
+	return stats;
+}
+}
\ No newline at end of file
@@ -14,18 +14,29 @@
  * 2. Индексация через unordered_map для быстрого поиска O(1)
  * 3. Хранение указателей для избежания копирования данных
  * 4. Специальный хешер для пар указателей на остановки
+ * 5. Плотные номера остановок и маршрутов (Stop::id, Bus::id) и индексы
+ *    по ним, которые строятся один раз при заморозке (Freeze)
  */
 
+#include "bitmap.h"
 #include "domain.h"
+#include "rank_index.h"
 
+#include <array>
 #include <utility>
 #include <string_view>
 #include <deque>
+#include <memory>
+#include <mutex>
 #include <unordered_set>
 #include <unordered_map>
 
 namespace catalogue {
 
+namespace similarity {
+class RouteSimilarityIndex;
+}
+
 namespace detail {  // Вспомогательные структуры
 	
 	/**
@@ -44,6 +55,83 @@ namespace detail {  // Вспомогательные структуры
 		double curvature;   // Коэффициент извилистости маршрута
 	};
 
+	/**
+	 * СТАТИСТИКА ОДНОГО КОНТЕЙНЕРА
+	 * 
+	 * - size: число элементов
+	 * - bucket_count, load_factor: параметры хеш-таблицы (0 для deque)
+	 * - bytes: приблизительный объём памяти самого контейнера
+	 *   (узлы, корзины, блоки deque), без строк и списков остановок
+	 */
+	struct ContainerStats {
+		size_t size = 0;
+		size_t bucket_count = 0;
+		double load_factor = 0;
+		size_t bytes = 0;
+	};
+
+	/**
+	 * СТАТИСТИКА ПАМЯТИ КАТАЛОГА
+	 * 
+	 * Оценка того, куда уходит память загруженного каталога.
+	 * Размеры узлов оцениваются по устройству libstdc++ (указатель на
+	 * следующий узел + значение + кэшированный хеш), поэтому это
+	 * приближение, а не точный учёт аллокатора.
+	 * 
+	 * - string_bytes: динамическая память имён остановок и маршрутов
+	 *   (короткие строки, хранимые внутри std::string, не учитываются)
+	 * - stop_list_bytes: память списков остановок маршрутов (по capacity)
+	 * - total_bytes: сумма всех оценок
+	 */
+	struct CatalogueStats {
+		ContainerStats stops;
+		ContainerStats buses;
+		ContainerStats stops_ptr;
+		ContainerStats buses_ptr;
+		ContainerStats stop_buses;
+		ContainerStats distances;
+		ContainerStats stop_bus_index;  // битовые множества маршрутов остановок (после Freeze)
+		ContainerStats ranks;           // ранговые индексы и кэш BusInfo (после Freeze)
+		size_t string_bytes = 0;
+		size_t stop_list_bytes = 0;
+		size_t total_bytes = 0;
+	};
+
+	/**
+	 * ПОКАЗАТЕЛИ РАНГОВЫХ ИНДЕКСОВ
+	 * 
+	 * Для маршрутов - поля BusInfo, для остановок - степень
+	 * (число различных маршрутов через остановку).
+	 */
+	enum class RankMetric {
+		ROUTE_LENGTH,
+		CURVATURE,
+		STOP_COUNT,
+		UNIQUE_STOP_COUNT,
+		STOP_DEGREE,
+	};
+
+	inline constexpr size_t RANK_METRIC_COUNT = 5;
+
+	/**
+	 * ПОРЯДОК ОСТАНОВОК В ПАМЯТИ (TransportCatalogue::ReorderStops)
+	 * 
+	 * - ROUTES: в порядке обхода маршрутов - остановки одного маршрута
+	 *   лежат рядом, разности номеров в сжатых списках малы
+	 * - HILBERT: вдоль кривой Гильберта по координатам - рядом лежат
+	 *   остановки, близкие на карте, в том числе с разных маршрутов
+	 */
+	enum class StopOrder {
+		ROUTES,
+		HILBERT,
+	};
+
+	/** Элемент ответа TopK: название маршрута или остановки и значение показателя */
+	struct RankEntry {
+		std::string_view name;
+		double value;
+	};
+
 	/**
 	 * ХЕШЕР ДЛЯ ПАР УКАЗАТЕЛЕЙ НА ОСТАНОВКИ
 	 * 
@@ -62,6 +150,9 @@ namespace detail {  // Вспомогательные структуры
 			return hash1 + hash2 * 37;  // Простая формула комбинирования хешей
 		}
 	};
+
+	/** Расстояния по дорогам: (от, до) → метры */
+	using DistanceMap = std::unordered_map<std::pair<const transport::Stop *, const transport::Stop *>, int, PairStopHasher>;
 }
 
 /**
@@ -90,15 +181,62 @@ public:
 	
 	// === МЕТОДЫ ДОБАВЛЕНИЯ ДАННЫХ ===
 	
-	/** Добавляет остановку в каталог */
+	/**
+	 * Добавляет остановку в каталог. Остановка с уже занятым названием
+	 * не добавляется: маршруты находят остановки через FindStop, так что
+	 * вторая была бы недоступна.
+	 */
 	void AddStop(const std::string_view name, geo::Coordinates coord);
 	
 	/** Добавляет маршрут в каталог (версия с копированием списка остановок) */
 	void AddBus(const std::string_view name, const std::vector<const transport::Stop*> &stops_list, bool is_rountrip);
 	
-	/** Добавляет маршрут в каталог (версия с перемещением списка остановок) */
+	/**
+	 * Добавляет маршрут в каталог (версия с перемещением списка остановок).
+	 * Маршрут с тем же номером и теми же остановками - дубликат и не
+	 * добавляется. С тем же номером, но другими остановками - хранится:
+	 * FindBus по-прежнему находит первый, а остановки второго перечисляют
+	 * этот номер и второй маршрут рисуется на карте (см. shadowed_buses_).
+	 */
 	void AddBus(const std::string_view name, std::vector<const transport::Stop*> &&stops_list, bool is_rountrip);
 	
+	/**
+	 * Резервирует место в хеш-таблицах под известное заранее число
+	 * остановок, маршрутов и расстояний (загрузка снимка): без этого
+	 * таблицы многократно перестраиваются по мере роста
+	 */
+	void Reserve(size_t stops, size_t buses, size_t distances);
+	
+	// === МЕТОДЫ ИЗМЕНЕНИЯ ДАННЫХ ===
+	// Работают и до, и после Freeze: индексы замороженного каталога
+	// обновляются только для затронутых маршрутов и остановок.
+	// Неизвестная остановка или маршрут - std::invalid_argument.
+	
+	/** Меняет координаты остановки; BusInfo её маршрутов пересчитывается */
+	void UpdateStop(std::string_view name, geo::Coordinates coord);
+	
+	/**
+	 * Удаляет остановку, через которую не проходит ни один маршрут
+	 * (иначе std::invalid_argument), вместе с её расстояниями.
+	 * Место занимает последняя остановка: её Stop::id меняется, указатели
+	 * на неё в маршрутах и расстояниях переставляются. O(число расстояний).
+	 */
+	void RemoveStop(std::string_view name);
+	
+	/**
+	 * Удаляет несколько остановок за один проход по расстояниям; если хоть
+	 * одну удалить нельзя - std::invalid_argument, каталог не меняется.
+	 * Освободившиеся места занимают остановки с конца, как в RemoveStop.
+	 */
+	void RemoveStops(const std::vector<std::string_view> &names);
+	
+	/**
+	 * Удаляет маршрут вместе с маршрутами того же номера. Место
+	 * занимает последний маршрут: его Bus::id меняется, остальные номера
+	 * остаются плотными.
+	 */
+	void RemoveBus(std::string_view name);
+	
 	// === МЕТОДЫ ПОИСКА ===
 	
 	/** Ищет остановку по названию */
@@ -109,22 +247,112 @@ public:
 	
 	// === МЕТОДЫ ПОЛУЧЕНИЯ ИНФОРМАЦИИ ===
 	
-	/** Вычисляет полную информацию о маршруте (длина, количество остановок, etc.) */
+	/** Вычисляет полную информацию о маршруте (длина, количество остановок, etc.); после Freeze - из кэша */
 	detail::BusInfo GetBusInfo(const transport::Bus &bus) const;
 	
 	/** Возвращает список маршрутов, проходящих через остановку */
 	std::vector<std::string_view> GetStopInfo(const transport::Stop &stop) const;
 	
-	/** Возвращает список всех маршрутов */
-	const std::deque<transport::Bus> GetAllBuses() const;
+	/** Число различных маршрутов через остановку, O(1) */
+	size_t GetStopDegree(const transport::Stop &stop) const;
+	
+	/** Возвращает все остановки в порядке добавления */
+	const std::deque<transport::Stop> &GetAllStops() const;
+	
+	/** Возвращает все маршруты в порядке добавления */
+	const std::deque<transport::Bus> &GetAllBuses() const;
+	
+	/** Возвращает все заданные расстояния (в том направлении, в котором они заданы) */
+	const detail::DistanceMap &GetAllDistances() const;
+	
+	/** Оценивает занимаемую каталогом память по контейнерам */
+	detail::CatalogueStats GetStats() const;
+	
+	// === ЗАМОРОЗКА И ИНДЕКСЫ ===
+	
+	/**
+	 * Строит индексы по плотным номерам после загрузки. Повторный вызов
+	 * ничего не делает; добавленные после заморозки данные попадают
+	 * в индексы сразу при добавлении.
+	 */
+	void Freeze();
+	
+	/** true после Freeze */
+	bool IsFrozen() const;
+	
+	/**
+	 * Перекладывает остановки в памяти в порядке order и перенумеровывает
+	 * их так же: меняются Stop::id и адреса остановок, полученные раньше
+	 * указатели на остановки недействительны. Списки маршрутов, индексы
+	 * и расстояния переводятся на новые номера. Добавленные после остановки
+	 * идут в конец. Требует Freeze, иначе std::logic_error.
+	 */
+	void ReorderStops(detail::StopOrder order);
+	
+	/**
+	 * Номер раскладки остановок: растёт при каждой перенумерации Stop::id
+	 * (ReorderStops). Данные по Stop::id, сохранённые при другом номере
+	 * (хеши определений снимка), к каталогу больше не относятся.
+	 */
+	uint64_t StopLayout() const;
+	
+	/**
+	 * Переводит списки остановок всех маршрутов в сжатую форму (stop_list.h)
+	 * для очень больших сетей: около байта на остановку маршрута вместо 8.
+	 * Если порядок остановок ещё не выбран (ReorderStops), перед сжатием
+	 * применяется StopOrder::ROUTES, иначе выбранный порядок сохраняется.
+	 * Маршруты, добавленные после, сжимаются сразу. Повторный вызов ничего
+	 * не делает. Требует Freeze, иначе std::logic_error.
+	 */
+	void CompactStopLists();
+	
+	/** true после CompactStopLists */
+	bool HasCompactStopLists() const;
+	
+	/**
+	 * Маршруты, проходящие через каждую из остановок (пересечение), по алфавиту.
+	 * Требует Freeze, иначе std::logic_error.
+	 */
+	std::vector<std::string_view> GetCommonBuses(const std::vector<const transport::Stop *> &stops) const;
+	
+	/**
+	 * Маршруты, проходящие хотя бы через одну из остановок (объединение), по алфавиту.
+	 * Требует Freeze, иначе std::logic_error.
+	 */
+	std::vector<std::string_view> GetBusesServingAny(const std::vector<const transport::Stop *> &stops) const;
+	
+	/**
+	 * Первые k маршрутов или остановок по показателю за O(log N + k):
+	 * по убыванию, либо по возрастанию при ascending; равные значения -
+	 * по названию, так что ответ не зависит от порядка остановок в памяти.
+	 * Требует Freeze, иначе std::logic_error.
+	 */
+	std::vector<detail::RankEntry> GetTopK(detail::RankMetric metric, size_t k, bool ascending = false) const;
+	
+	/**
+	 * Индекс сходства маршрутов (route_similarity.h) с настройками по
+	 * умолчанию. Строится при первом вызове и хранится, пока не изменится
+	 * набор маршрутов (AddBus, RemoveBus). Возвращённый индекс годен до
+	 * следующего изменения каталога.
+	 */
+	std::shared_ptr<const similarity::RouteSimilarityIndex> GetSimilarityIndex() const;
 	
 	// === МЕТОДЫ РАБОТЫ С РАССТОЯНИЯМИ ===
 	
-	/** Устанавливает расстояние между остановками */
+	/** Устанавливает расстояние между остановками; уже заданное не меняется */
 	void SetDistance(const std::string_view from, const std::string_view to, int distance);
 	
+	/** Задаёт или заменяет расстояние from → to */
+	void UpdateDistance(std::string_view from, std::string_view to, int distance);
+	
+	/** Удаляет расстояние from → to (обратное направление остаётся); false, если его не было */
+	bool RemoveDistance(std::string_view from, std::string_view to);
+	
 	/** Получает расстояние между остановками */
 	int GetDistance(const std::string_view from, const std::string_view to) const;
+	
+	/** Получает расстояние между остановками без поиска по названиям */
+	int GetDistance(const transport::Stop *from, const transport::Stop *to) const;
 
 private:
 	// === ХРАНИЛИЩА ОСНОВНЫХ ДАННЫХ ===
@@ -155,6 +383,15 @@ private:
 	 * Значение: указатель на маршрут в buses_
 	 */
 	std::unordered_map<std::string_view, const transport::Bus *> buses_ptr_;
+	
+	/**
+	 * Число маршрутов, номер которых уже занят маршрутом с меньшим
+	 * Bus::id и другими остановками (AddBus). buses_ptr_ указывает на
+	 * первый, в ранговые индексы попадает только он, а обратный индекс
+	 * остановок получает номер от каждого. Пока число 0 - а так почти
+	 * всегда, - проходы по buses_ в поисках таких маршрутов не нужны.
+	 */
+	size_t shadowed_buses_ = 0;
 
 	// === ВСПОМОГАТЕЛЬНЫЕ ИНДЕКСЫ ===
 	
@@ -172,6 +409,84 @@ private:
 	 * Ключ: пара указателей на остановки (от, до)
 	 * Значение: расстояние в метрах
 	 */
-	std::unordered_map<std::pair<const transport::Stop *, const transport::Stop *>, int, detail::PairStopHasher> distances_;
+	detail::DistanceMap distances_;
+	
+	// === ИНДЕКСЫ ЗАМОРОЖЕННОГО КАТАЛОГА ===
+	
+	bool frozen_ = false;
+	
+	/**
+	 * Остановка → маршруты в виде сжатого битового множества номеров
+	 * маршрутов (Bus::id). Индекс вектора - Stop::id.
+	 * Пересечение и объединение таких множеств для пересадочных узлов
+	 * на порядки быстрее слияния отсортированных списков названий.
+	 */
+	std::vector<bitmap::Bitmap> stop_bus_index_;
+	
+	/**
+	 * Кэш BusInfo по Bus::id. Пересчитывается только для затронутых
+	 * маршрутов: при добавлении маршрута и при новом расстоянии между
+	 * остановками (маршруты, проходящие через обе остановки).
+	 */
+	std::vector<detail::BusInfo> bus_info_;
+	
+	/** Ранговые индексы по показателям RankMetric */
+	std::array<rank::RankIndex, detail::RANK_METRIC_COUNT> ranks_;
+	
+	/**
+	 * Остановки по Stop::id для расшифровки сжатых списков; не nullptr -
+	 * списки сжаты. Отдельный объект в куче: сжатые списки ссылаются на
+	 * него, и адрес не меняется ни при росте таблицы, ни при перемещении каталога.
+	 */
+	std::unique_ptr<transport::StopTable> stop_table_;
+	
+	/** Индекс сходства маршрутов; nullptr - ещё не нужен или устарел */
+	mutable std::shared_ptr<const similarity::RouteSimilarityIndex> similarity_index_;
+	mutable std::mutex similarity_mutex_;
+	
+	/** Остановки уже переложены ReorderStops */
+	bool stops_reordered_ = false;
+	
+	/** См. StopLayout */
+	uint64_t stop_layout_ = 0;
+	
+	/** Остановка по названию для изменения; нет такой - std::invalid_argument */
+	transport::Stop &StopForUpdate(std::string_view name);
+	
+	/** Пересчитывает BusInfo и ранги маршрутов, проходящих через обе остановки */
+	void RefreshBuses(const transport::Stop *stop1, const transport::Stop *stop2);
+	
+	/** Заносит маршрут buses_[id] в buses_ptr_, stop_buses_ и индекс остановок */
+	void LinkBus(uint32_t id);
+	
+	/** Обратное к LinkBus: маршрут пропадает из всех индексов, но остаётся в buses_ */
+	void UnlinkBus(uint32_t id);
+	
+	/** buses_[id] хранится, но FindBus находит по его номеру другой маршрут */
+	bool IsShadowed(uint32_t id) const;
+	
+	/** Удаляет один маршрут buses_[id]; на его место переносится последний */
+	void RemoveBusAt(uint32_t id);
+	
+	/** Меняет маршруты buses_[lhs] и buses_[rhs] местами вместе с индексами */
+	void SwapBuses(uint32_t lhs, uint32_t rhs);
+	
+	/** Названия маршрутов по множеству номеров, по алфавиту */
+	std::vector<std::string_view> BusNames(const bitmap::Bitmap &buses) const;
+	
+	/** Вычисляет BusInfo заново, без кэша */
+	detail::BusInfo ComputeBusInfo(const transport::Bus &bus) const;
+	
+	/** Переносит bus_info_[id] в ранговые индексы маршрутов */
+	void RankBus(uint32_t id);
+	
+	/** Обновляет степень остановки в ранговом индексе */
+	void RankStop(uint32_t id);
+	
+	/** Новый порядок остановок: order[новый Stop::id] = прежний; все ссылки на остановки переводятся */
+	void RenumberStops(const std::vector<uint32_t> &order);
+	
+	/** Заполняет таблицу номер → остановка и сжимает по ней все списки маршрутов */
+	void CompactAllStopLists();
 };
 } 
\ No newline at end of file
@@ -0,0 +1,157 @@
+/*
+ * НАГРУЗОЧНЫЙ ТЕСТ КЛИЕНТА API БАНКОВ
+ *
+ * В процессе поднимается имитация API банка - MockServer из tests/mock_server.h
+ * поверх TLS с самоподписанным сертификатом; на авторизацию он отвечает
+ * через заданную задержку (SetLatency). Несколько "касс" отправляют запросы авторизации
+ * к трём банкам (vtb, alfa, center_invest) по очереди; измеряется время
+ * авторизации (p50/p90/p99/max) и число открытых соединений:
+ * - fresh:   новое соединение и полное TLS-рукопожатие на каждый запрос
+ * - resume:  новое соединение, TLS-сессия возобновляется из кэша
+ * - pooled:  соединения keep-alive из пула (режим по умолчанию в терминале)
+ *
+ * ЗАПУСК:
+ *   bench_api_client [--lanes N] [--requests N] [--delay-ms N] [--max-connections N]
+ */
+
+#include "network/api_client.h"
+
+#include "mock_server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace paygo;
+
+namespace {
+
+struct Options {
+	size_t lanes = 8;             // одновременно работающих касс
+	size_t requests = 200;        // авторизаций на кассу
+	size_t delay_ms = 2;          // обработка запроса банком
+	size_t max_connections = 4;   // на банк
+};
+
+Options ParseOptions(int argc, char *argv[]) {
+	Options options;
+	for(int i = 1; i < argc; ++i) {
+		string_view arg = argv[i];
+		if(i + 1 >= argc) {
+			throw invalid_argument("missing value for "s + string(arg));
+		}
+		if(arg == "--lanes"sv) {
+			options.lanes = stoul(argv[++i]);
+		} else if(arg == "--requests"sv) {
+			options.requests = stoul(argv[++i]);
+		} else if(arg == "--delay-ms"sv) {
+			options.delay_ms = stoul(argv[++i]);
+		} else if(arg == "--max-connections"sv) {
+			options.max_connections = stoul(argv[++i]);
+		} else {
+			throw invalid_argument("unknown argument: "s + string(arg));
+		}
+	}
+	return options;
+}
+
+const vector<string> BANKS = {"vtb", "alfa", "center_invest"};
+
+double Percentile(const vector<double> &sorted, double fraction) {
+	if(sorted.empty()) {
+		return 0;
+	}
+	const size_t index = min(sorted.size() - 1, static_cast<size_t>(fraction * static_cast<double>(sorted.size())));
+	return sorted[index];
+}
+
+void Run(string_view name, const Options &options, const string &base_url, bool keep_alive, bool session_cache) {
+	network::TlsSettings tls;
+	tls.verify_peer = false;  // самоподписанный сертификат имитации
+	tls.session_cache = session_cache;
+	network::SslManager ssl(tls);
+
+	network::ApiClientSettings settings;
+	for(const string &bank : BANKS) {
+		network::EndpointSettings endpoint;
+		endpoint.name = bank;
+		endpoint.base_url = base_url + "/"s + bank;
+		endpoint.max_connections = options.max_connections;
+		endpoint.keep_alive = keep_alive;
+		settings.endpoints.push_back(endpoint);
+	}
+	network::ApiClient client(settings, ssl);
+
+	vector<double> latencies;
+	mutex latencies_mutex;
+	atomic<size_t> errors{0};
+	vector<thread> lanes;
+
+	const auto start = chrono::steady_clock::now();
+	for(size_t lane = 0; lane < options.lanes; ++lane) {
+		lanes.emplace_back([&, lane] {
+			vector<double> local;
+			for(size_t i = 0; i < options.requests; ++i) {
+				network::HttpRequest request;
+				request.endpoint = BANKS[(lane + i) % BANKS.size()];
+				request.path = "/authorize"s;
+				request.headers = {"Content-Type: application/json"s};
+				request.body = R"({"amount":15000,"currency":"RUB","reference":"PAY-)"s + to_string(lane) + "-"s + to_string(i) + "\"}"s;
+				try {
+					network::HttpResponse response = client.Execute(move(request));
+					if(response.status != 200) {
+						++errors;
+					}
+					local.push_back(static_cast<double>(response.elapsed.count()) / 1000.0);
+				} catch(const network::NetworkError &) {
+					++errors;
+				}
+			}
+			lock_guard lock(latencies_mutex);
+			latencies.insert(latencies.end(), local.begin(), local.end());
+		});
+	}
+	for(thread &lane : lanes) {
+		lane.join();
+	}
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	uint64_t connections = 0;
+	for(const string &bank : BANKS) {
+		connections += client.GetStats(bank).connections;
+	}
+
+	sort(latencies.begin(), latencies.end());
+	printf("%-7s %8.0f req/s  p50 %6.2f  p90 %6.2f  p99 %6.2f  max %7.2f ms  (%llu connections, %zu errors)\n",
+			 string(name).c_str(), static_cast<double>(latencies.size()) / seconds, Percentile(latencies, 0.5),
+			 Percentile(latencies, 0.9), Percentile(latencies, 0.99), latencies.empty() ? 0.0 : latencies.back(),
+			 static_cast<unsigned long long>(connections), errors.load());
+}
+}
+
+int main(int argc, char *argv[]) {
+	try {
+		Options options = ParseOptions(argc, argv);
+		test::MockServer acquirer(true, [](const test::MockRequest &) {
+			return test::MockResponse{200, R"({"status":"approved","authorization_code":"123456"})"s};
+		});
+		acquirer.SetLatency(chrono::milliseconds(options.delay_ms));
+
+		Run("fresh"sv, options, acquirer.BaseUrl(), false, false);
+		Run("resume"sv, options, acquirer.BaseUrl(), false, true);
+		Run("pooled"sv, options, acquirer.BaseUrl(), true, true);
+	} catch(const exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * НАГРУЗОЧНЫЙ ТЕСТ КЭША
+ *
+ * Несколько потоков читают ключи с неравномерным (zipf) распределением -
+ * как токены постоянных покупателей и конфигурация при авторизации.
+ * Значения лежат в SQLite (SqliteCacheStore); сравниваются:
+ * - sqlite:   каждое чтение идёт в базу
+ * - cache/1:  CacheManager с одной частью (один общий mutex)
+ * - cache/N:  CacheManager с N частями
+ *
+ * ЗАПУСК:
+ *   bench_cache_manager [--db <file>] [--threads N] [--keys N] [--ops N]
+ *                       [--shards N] [--max-bytes N] [--value-size N]
+ */
+
+#include "database/cache_manager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace paygo;
+
+namespace {
+
+struct Options {
+	string db = "/tmp/paygo_cache_bench.db";
+	size_t threads = 8;
+	size_t keys = 100000;
+	size_t ops = 200000;       // чтений на поток
+	size_t shards = 16;
+	size_t max_bytes = 8 << 20;
+	size_t value_size = 64;
+};
+
+Options ParseOptions(int argc, char *argv[]) {
+	Options options;
+	for(int i = 1; i < argc; ++i) {
+		string_view arg = argv[i];
+		if(i + 1 >= argc) {
+			throw invalid_argument("missing value for "s + string(arg));
+		}
+		if(arg == "--db"sv) {
+			options.db = argv[++i];
+		} else if(arg == "--threads"sv) {
+			options.threads = stoul(argv[++i]);
+		} else if(arg == "--keys"sv) {
+			options.keys = stoul(argv[++i]);
+		} else if(arg == "--ops"sv) {
+			options.ops = stoul(argv[++i]);
+		} else if(arg == "--shards"sv) {
+			options.shards = stoul(argv[++i]);
+		} else if(arg == "--max-bytes"sv) {
+			options.max_bytes = stoul(argv[++i]);
+		} else if(arg == "--value-size"sv) {
+			options.value_size = stoul(argv[++i]);
+		} else {
+			throw invalid_argument("unknown argument: "s + string(arg));
+		}
+	}
+	return options;
+}
+
+string Key(size_t index) {
+	return "card_token:"s + to_string(index);
+}
+
+/**
+ * Заранее сгенерированная последовательность номеров ключей с распределением
+ * Ципфа (s = 1): генерация не должна попадать в измерение
+ */
+vector<uint32_t> ZipfSequence(size_t keys, size_t count, uint64_t seed) {
+	vector<double> cumulative(keys);
+	double sum = 0;
+	for(size_t i = 0; i < keys; ++i) {
+		sum += 1.0 / static_cast<double>(i + 1);
+		cumulative[i] = sum;
+	}
+
+	mt19937_64 random(seed);
+	uniform_real_distribution<double> uniform(0, sum);
+	vector<uint32_t> sequence(count);
+	for(uint32_t &key : sequence) {
+		key = static_cast<uint32_t>(lower_bound(cumulative.begin(), cumulative.end(), uniform(random)) - cumulative.begin());
+	}
+	return sequence;
+}
+
+template <typename Read>
+void Run(string_view name, const Options &options, const vector<vector<uint32_t>> &sequences, Read read) {
+	vector<thread> workers;
+	vector<size_t> found(options.threads, 0);
+
+	const auto start = chrono::steady_clock::now();
+	for(size_t t = 0; t < options.threads; ++t) {
+		workers.emplace_back([&, t] {
+			string key;
+			for(uint32_t index : sequences[t]) {
+				key = Key(index);
+				found[t] += read(key) ? 1 : 0;
+			}
+		});
+	}
+	for(thread &worker : workers) {
+		worker.join();
+	}
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	size_t total = 0;
+	for(size_t count : found) {
+		total += count;
+	}
+	printf("%-10s %12.0f reads/s  (%zu found)\n", string(name).c_str(), options.threads * options.ops / seconds, total);
+}
+}
+
+int main(int argc, char *argv[]) {
+	try {
+		Options options = ParseOptions(argc, argv);
+		for(const char *suffix : {"", "-wal", "-shm"}) {
+			remove((options.db + suffix).c_str());
+		}
+
+		database::SqliteSettings sqlite;
+		sqlite.path = options.db;
+		sqlite.synchronous = database::Synchronous::OFF;  // заполнение базы не измеряется
+		database::SqliteCacheStore store(sqlite);
+		const string value(options.value_size, 'x');
+		for(size_t i = 0; i < options.keys; ++i) {
+			store.Save(Key(i), value);
+		}
+
+		vector<vector<uint32_t>> sequences;
+		for(size_t t = 0; t < options.threads; ++t) {
+			sequences.push_back(ZipfSequence(options.keys, options.ops, t + 1));
+		}
+
+		Run("sqlite"sv, options, sequences, [&store](const string &key) {
+			return store.Load(key).has_value();
+		});
+
+		for(size_t shards : {size_t{1}, options.shards}) {
+			database::CacheSettings settings;
+			settings.shards = shards;
+			settings.max_bytes = options.max_bytes;
+			database::CacheManager cache(settings, store.MakeLoader());
+
+			Run("cache/"s + to_string(shards), options, sequences, [&cache](const string &key) {
+				return cache.Get(key).has_value();
+			});
+
+			database::CacheStats stats = cache.GetStats();
+			printf("           hit rate %.1f%%, %zu entries, %zu bytes, %llu evictions\n",
+					 100.0 * stats.hits / max<uint64_t>(1, stats.hits + stats.misses), stats.entries, stats.bytes,
+					 static_cast<unsigned long long>(stats.evictions));
+		}
+
+		for(const char *suffix : {"", "-wal", "-shm"}) {
+			remove((options.db + suffix).c_str());
+		}
+	} catch(const exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,196 @@
+/*
+ * НАГРУЗОЧНЫЙ ТЕСТ КОНФИГУРАЦИИ
+ *
+ * 1. parse: стоимость разбора terminal_config.json (её платёж больше
+ *    не платит - только перезагрузка)
+ * 2. read: --threads потоков непрерывно берут снимок (Current) и читают
+ *    лимиты, пока основной поток каждые --interval-ms перезаписывает файл
+ *    (временный файл + rename, как при развёртывании). Выводится скорость
+ *    чтения, задержка Current (p50/p99/max по выборке), число
+ *    перезагрузок, увиденных читателями, и нарушения целостности снимка
+ *    (daily_limit всегда записывается равным max_amount * 10)
+ *
+ * ЗАПУСК:
+ *   bench_config_manager [--config <path>] [--dir <path>] [--threads N] [--seconds N] [--interval-ms N]
+ */
+
+#include "core/config_manager.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace paygo;
+
+namespace {
+
+struct Options {
+	string config = "config/terminal_config.json";
+	string dir = "/tmp/paygo_config_bench";
+	size_t threads = 4;
+	size_t seconds = 3;
+	size_t interval_ms = 50;
+};
+
+Options ParseOptions(int argc, char *argv[]) {
+	Options options;
+	for(int i = 1; i < argc; ++i) {
+		string_view arg = argv[i];
+		if(i + 1 >= argc) {
+			throw invalid_argument("missing value for "s + string(arg));
+		}
+		if(arg == "--config"sv) {
+			options.config = argv[++i];
+		} else if(arg == "--dir"sv) {
+			options.dir = argv[++i];
+		} else if(arg == "--threads"sv) {
+			options.threads = stoul(argv[++i]);
+		} else if(arg == "--seconds"sv) {
+			options.seconds = stoul(argv[++i]);
+		} else if(arg == "--interval-ms"sv) {
+			options.interval_ms = stoul(argv[++i]);
+		} else {
+			throw invalid_argument("unknown argument: "s + string(arg));
+		}
+	}
+	return options;
+}
+
+string ReadFile(const string &path) {
+	ifstream file(path);
+	if(!file) {
+		throw runtime_error("cannot open "s + path);
+	}
+	ostringstream text;
+	text << file.rdbuf();
+	return text.str();
+}
+
+/** Записывает конфигурацию с max_amount = rubles атомарно: временный файл + rename */
+void WriteConfig(nlohmann::json config, const filesystem::path &path, double rubles) {
+	config["payment"]["limits"]["max_amount"] = rubles;
+	config["payment"]["limits"]["daily_limit"] = rubles * 10;
+	const filesystem::path temporary = path.string() + ".tmp"s;
+	{
+		ofstream file(temporary);
+		file << config.dump(2);
+	}
+	filesystem::rename(temporary, path);
+}
+
+double Percentile(vector<double> &values, double fraction) {
+	if(values.empty()) {
+		return 0;
+	}
+	sort(values.begin(), values.end());
+	return values[min(values.size() - 1, static_cast<size_t>(fraction * static_cast<double>(values.size())))];
+}
+}
+
+int main(int argc, char *argv[]) {
+	try {
+		Options options = ParseOptions(argc, argv);
+		const string text = ReadFile(options.config);
+
+		// 1. Разбор
+		constexpr size_t PARSES = 2000;
+		auto start = chrono::steady_clock::now();
+		for(size_t i = 0; i < PARSES; ++i) {
+			core::ConfigSnapshot snapshot = core::ParseConfig(text);
+			if(snapshot.terminal_id.empty()) {
+				throw runtime_error("parse: empty terminal id");
+			}
+		}
+		const double parse_us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / PARSES;
+		printf("parse    %8.1f us per ParseConfig\n", parse_us);
+
+		// 2. Чтение во время перезагрузок
+		filesystem::remove_all(options.dir);
+		filesystem::create_directories(options.dir);
+		const filesystem::path path = filesystem::path(options.dir) / "terminal_config.json";
+		const nlohmann::json base = nlohmann::json::parse(text);
+		WriteConfig(base, path, 100000);
+
+		core::ConfigManagerSettings settings;
+		settings.path = path.string();
+		settings.debounce = chrono::milliseconds(5);
+		core::ConfigManager manager(settings);
+
+		atomic<bool> stop{false};
+		vector<size_t> reads(options.threads);
+		vector<size_t> torn(options.threads);
+		vector<size_t> generations(options.threads);
+		vector<vector<double>> latencies(options.threads);
+		vector<thread> readers;
+		for(size_t t = 0; t < options.threads; ++t) {
+			readers.emplace_back([&, t] {
+				uint64_t last_generation = 0;
+				size_t count = 0;
+				while(!stop.load(memory_order_relaxed)) {
+					const bool sample = (count & 1023) == 0;
+					const auto begin = sample ? chrono::steady_clock::now() : chrono::steady_clock::time_point{};
+					shared_ptr<const core::ConfigSnapshot> config = manager.Current();
+					if(sample) {
+						latencies[t].push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count());
+					}
+					if(config->payment.limits.daily_limit != config->payment.limits.max_amount * 10) {
+						++torn[t];
+					}
+					if(config->generation != last_generation) {
+						last_generation = config->generation;
+						++generations[t];
+					}
+					++count;
+				}
+				reads[t] = count;
+			});
+		}
+
+		start = chrono::steady_clock::now();
+		const auto end = start + chrono::seconds(options.seconds);
+		size_t writes = 0;
+		while(chrono::steady_clock::now() < end) {
+			this_thread::sleep_for(chrono::milliseconds(options.interval_ms));
+			WriteConfig(base, path, 100000 + static_cast<double>(++writes));
+		}
+		stop = true;
+		for(thread &reader : readers) {
+			reader.join();
+		}
+		const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		size_t total_reads = 0;
+		size_t total_torn = 0;
+		size_t seen = 0;
+		vector<double> samples;
+		for(size_t t = 0; t < options.threads; ++t) {
+			total_reads += reads[t];
+			total_torn += torn[t];
+			seen = max(seen, generations[t]);
+			samples.insert(samples.end(), latencies[t].begin(), latencies[t].end());
+		}
+		const double max_ns = samples.empty() ? 0 : *max_element(samples.begin(), samples.end());
+		printf("read     %8.1f M reads/s  Current p50 %.0f p99 %.0f max %.0f ns  (%zu threads)\n",
+				 static_cast<double>(total_reads) / seconds / 1e6, Percentile(samples, 0.5), Percentile(samples, 0.99), max_ns,
+				 options.threads);
+		printf("reload   %zu writes, generation %llu, up to %zu generations seen by a reader, %zu torn snapshots\n", writes,
+				 static_cast<unsigned long long>(manager.Generation()), seen, total_torn);
+	} catch(const exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,212 @@
+/*
+ * НАГРУЗОЧНЫЙ ТЕСТ ИНДЕКСА ЛИЦ
+ *
+ * Камера не нужна: эмбеддинги читаются из файла (--embeddings, подряд
+ * float32 по --dimension чисел, например выгрузка шаблонов модели
+ * распознавания) или генерируются: случайные нормированные векторы.
+ * Запрос - эмбеддинг зарегистрированного пользователя с шумом --noise
+ * (новый снимок того же лица).
+ *
+ * 1. enroll: регистрация --enrollments пользователей, размер файла
+ * 2. open: повторное открытие индекса (mmap, без чтения векторов)
+ * 3. search: задержка поиска top-k (p50/p99) в int8 против полного
+ *    прохода по float, доля запросов, где первым найден нужный
+ *    пользователь, и совпадение top-k с точным поиском по float
+ *
+ * ЗАПУСК:
+ *   bench_face_index [--embeddings <file>] [--dimension N] [--enrollments N] [--queries N]
+ *                    [--k N] [--noise X] [--path <file>]
+ */
+
+#include "biometry/face_index.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+using namespace paygo;
+
+namespace {
+
+struct Options {
+	string embeddings;
+	size_t dimension = 512;
+	size_t enrollments = 100000;
+	size_t queries = 200;
+	size_t k = 5;
+	double noise = 0.5;          // норма шума относительно нормы эмбеддинга
+	string path = "/tmp/paygo_face_index.bin";
+};
+
+Options ParseOptions(int argc, char *argv[]) {
+	Options options;
+	for(int i = 1; i < argc; ++i) {
+		string_view arg = argv[i];
+		if(i + 1 >= argc) {
+			throw invalid_argument("missing value for "s + string(arg));
+		}
+		if(arg == "--embeddings"sv) {
+			options.embeddings = argv[++i];
+		} else if(arg == "--dimension"sv) {
+			options.dimension = stoul(argv[++i]);
+		} else if(arg == "--enrollments"sv) {
+			options.enrollments = stoul(argv[++i]);
+		} else if(arg == "--queries"sv) {
+			options.queries = stoul(argv[++i]);
+		} else if(arg == "--k"sv) {
+			options.k = stoul(argv[++i]);
+		} else if(arg == "--noise"sv) {
+			options.noise = stod(argv[++i]);
+		} else if(arg == "--path"sv) {
+			options.path = argv[++i];
+		} else {
+			throw invalid_argument("unknown argument: "s + string(arg));
+		}
+	}
+	return options;
+}
+
+void Normalize(float *vector, size_t dimension) {
+	double squares = 0;
+	for(size_t i = 0; i < dimension; ++i) {
+		squares += static_cast<double>(vector[i]) * vector[i];
+	}
+	const float inverse = static_cast<float>(1.0 / sqrt(squares));
+	for(size_t i = 0; i < dimension; ++i) {
+		vector[i] *= inverse;
+	}
+}
+
+/** Записанные эмбеддинги или случайные нормированные векторы */
+vector<float> LoadEmbeddings(const Options &options, mt19937_64 &random) {
+	vector<float> embeddings(options.enrollments * options.dimension);
+	if(!options.embeddings.empty()) {
+		ifstream file(options.embeddings, ios::binary);
+		if(!file.read(reinterpret_cast<char *>(embeddings.data()), static_cast<streamsize>(embeddings.size() * sizeof(float)))) {
+			throw runtime_error("cannot read "s + to_string(options.enrollments) + " embeddings from "s + options.embeddings);
+		}
+	} else {
+		normal_distribution<float> gauss;
+		for(float &value : embeddings) {
+			value = gauss(random);
+		}
+	}
+	for(size_t row = 0; row < options.enrollments; ++row) {
+		Normalize(embeddings.data() + row * options.dimension, options.dimension);
+	}
+	return embeddings;
+}
+
+/** Точный top-k по float: полный проход */
+vector<size_t> ExactTopK(const vector<float> &embeddings, const float *query, size_t dimension, size_t k) {
+	const size_t rows = embeddings.size() / dimension;
+	vector<pair<float, size_t>> scores(rows);
+	for(size_t row = 0; row < rows; ++row) {
+		const float *vector = embeddings.data() + row * dimension;
+		float dot = 0;
+		for(size_t i = 0; i < dimension; ++i) {
+			dot += vector[i] * query[i];
+		}
+		scores[row] = {dot, row};
+	}
+	partial_sort(scores.begin(), scores.begin() + static_cast<ptrdiff_t>(min(k, rows)), scores.end(), greater<>());
+	vector<size_t> top;
+	for(size_t i = 0; i < min(k, rows); ++i) {
+		top.push_back(scores[i].second);
+	}
+	return top;
+}
+
+double Percentile(vector<double> &values, double fraction) {
+	if(values.empty()) {
+		return 0;
+	}
+	sort(values.begin(), values.end());
+	return values[min(values.size() - 1, static_cast<size_t>(fraction * static_cast<double>(values.size())))];
+}
+}
+
+int main(int argc, char *argv[]) {
+	try {
+		Options options = ParseOptions(argc, argv);
+		mt19937_64 random(42);
+		const vector<float> embeddings = LoadEmbeddings(options, random);
+		filesystem::remove(options.path);
+
+		biometry::FaceIndexSettings settings;
+		settings.path = options.path;
+		settings.dimension = options.dimension;
+
+		// 1. Регистрация
+		auto start = chrono::steady_clock::now();
+		{
+			biometry::FaceIndex index(settings);
+			for(size_t row = 0; row < options.enrollments; ++row) {
+				index.Enroll(row + 1, embeddings.data() + row * options.dimension);
+			}
+			index.Sync();
+		}
+		const double enroll_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		printf("enroll   %8.0f enrollments/s  file %.1f MB (float would be %.1f MB)\n",
+				 static_cast<double>(options.enrollments) / enroll_seconds, static_cast<double>(filesystem::file_size(options.path)) / 1e6,
+				 static_cast<double>(embeddings.size() * sizeof(float)) / 1e6);
+
+		// 2. Открытие
+		start = chrono::steady_clock::now();
+		biometry::FaceIndex index(settings);
+		printf("open     %8.2f ms for %zu enrollments\n", chrono::duration<double, milli>(chrono::steady_clock::now() - start).count(),
+				 index.Size());
+
+		// 3. Поиск
+		uniform_int_distribution<size_t> pick(0, options.enrollments - 1);
+		normal_distribution<float> gauss(0, static_cast<float>(options.noise / sqrt(static_cast<double>(options.dimension))));
+		vector<float> query(options.dimension);
+		vector<double> int8_ms;
+		vector<double> float_ms;
+		size_t top1_hits = 0;
+		size_t overlap = 0;
+		for(size_t q = 0; q < options.queries; ++q) {
+			const size_t row = pick(random);
+			for(size_t i = 0; i < options.dimension; ++i) {
+				query[i] = embeddings[row * options.dimension + i] + gauss(random);
+			}
+			Normalize(query.data(), options.dimension);
+
+			auto begin = chrono::steady_clock::now();
+			const vector<biometry::FaceMatch> matches = index.Search(query.data(), options.k);
+			int8_ms.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count());
+
+			begin = chrono::steady_clock::now();
+			const vector<size_t> exact = ExactTopK(embeddings, query.data(), options.dimension, options.k);
+			float_ms.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count());
+
+			if(!matches.empty() && matches.front().user_id == row + 1) {
+				++top1_hits;
+			}
+			for(size_t expected : exact) {
+				overlap += count_if(matches.begin(), matches.end(), [expected](const biometry::FaceMatch &match) {
+					return match.user_id == expected + 1;
+				});
+			}
+		}
+		const double queries = static_cast<double>(max<size_t>(1, options.queries));
+		printf("search   int8 p50 %.2f p99 %.2f ms  float p50 %.2f p99 %.2f ms  (%zu enrollments, k=%zu)\n", Percentile(int8_ms, 0.5),
+				 Percentile(int8_ms, 0.99), Percentile(float_ms, 0.5), Percentile(float_ms, 0.99), options.enrollments, options.k);
+		printf("accuracy top-1 %.1f%%  top-%zu agreement with float %.1f%%\n", 100.0 * static_cast<double>(top1_hits) / queries, options.k,
+				 100.0 * static_cast<double>(overlap) / (queries * static_cast<double>(options.k)));
+	} catch(const exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * НАГРУЗОЧНЫЙ ТЕСТ ЖУРНАЛА
+ *
+ * Несколько потоков пишут в журнал записи, похожие на записи платёжного пути
+ * (ссылка на платёж, сумма, время). Измеряется процессорное время потока
+ * на один вызов (не зависит от того, сколько потоков делят ядро):
+ * - sync:   fprintf + fflush под общим mutex (как запись напрямую в файл)
+ * - async:  PAYGO_LOG в core::Logger
+ * Для async выводится число потерянных записей и время до окончания записи в файл.
+ *
+ * ЗАПУСК:
+ *   bench_logger [--path <file>] [--threads N] [--records N] [--ring-bytes N]
+ */
+
+#include "core/logger.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace paygo;
+
+namespace {
+
+struct Options {
+	string path = "/tmp/paygo_logger_bench.log";
+	size_t threads = 4;
+	size_t records = 50000;    // записей на поток (по умолчанию помещаются в буфер)
+	size_t ring_bytes = 4 << 20;
+};
+
+Options ParseOptions(int argc, char *argv[]) {
+	Options options;
+	for(int i = 1; i < argc; ++i) {
+		string_view arg = argv[i];
+		if(i + 1 >= argc) {
+			throw invalid_argument("missing value for "s + string(arg));
+		}
+		if(arg == "--path"sv) {
+			options.path = argv[++i];
+		} else if(arg == "--threads"sv) {
+			options.threads = stoul(argv[++i]);
+		} else if(arg == "--records"sv) {
+			options.records = stoul(argv[++i]);
+		} else if(arg == "--ring-bytes"sv) {
+			options.ring_bytes = stoul(argv[++i]);
+		} else {
+			throw invalid_argument("unknown argument: "s + string(arg));
+		}
+	}
+	return options;
+}
+
+double ThreadCpuSeconds() {
+	timespec time;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+	return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) * 1e-9;
+}
+
+/** Запускает потоки и возвращает среднее процессорное время одной записи в наносекундах */
+template <typename Write>
+double Run(const Options &options, Write write) {
+	vector<thread> workers;
+	vector<double> seconds(options.threads, 0);
+
+	for(size_t t = 0; t < options.threads; ++t) {
+		workers.emplace_back([&, t] {
+			const string reference = "PAY-"s + to_string(t) + "-000000";
+			const double start = ThreadCpuSeconds();
+			for(size_t i = 0; i < options.records; ++i) {
+				write(reference, static_cast<int64_t>(i * 100 + 50), 1.5 + static_cast<double>(i % 10));
+			}
+			seconds[t] = ThreadCpuSeconds() - start;
+		});
+	}
+	for(thread &worker : workers) {
+		worker.join();
+	}
+
+	double total = 0;
+	for(double value : seconds) {
+		total += value;
+	}
+	return total * 1e9 / static_cast<double>(options.threads * options.records);
+}
+}
+
+int main(int argc, char *argv[]) {
+	try {
+		Options options = ParseOptions(argc, argv);
+		remove(options.path.c_str());
+
+		{
+			FILE *file = fopen(options.path.c_str(), "a");
+			if(!file) {
+				throw runtime_error("cannot open "s + options.path);
+			}
+			mutex file_mutex;
+			const double ns = Run(options, [&](const string &reference, int64_t amount, double elapsed) {
+				lock_guard lock(file_mutex);
+				fprintf(file, "INFO payment %s approved: amount %lld, %g ms [bench_logger.cpp:%d]\n", reference.c_str(),
+						  static_cast<long long>(amount), elapsed, __LINE__);
+				fflush(file);
+			});
+			fclose(file);
+			printf("%-6s %10.1f ns/record\n", "sync", ns);
+		}
+		remove(options.path.c_str());
+
+		{
+			core::LoggerSettings settings;
+			settings.path = options.path;
+			settings.ring_bytes = options.ring_bytes;
+			settings.max_file_bytes = 0;  // без ротации
+			core::Logger logger(settings);
+			core::Logger::SetDefault(&logger);
+
+			const double ns = Run(options, [](const string &reference, int64_t amount, double elapsed) {
+				PAYGO_LOG(core::LogLevel::INFO, "payment {} approved: amount {}, {} ms", reference, amount, elapsed);
+			});
+
+			const auto start = chrono::steady_clock::now();
+			logger.Flush();
+			const double flush_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+			core::LoggerStats stats = logger.GetStats();
+			printf("%-6s %10.1f ns/record  (%llu written, %llu dropped, flush %.1f ms)\n", "async", ns,
+					 static_cast<unsigned long long>(stats.written), static_cast<unsigned long long>(stats.dropped), flush_ms);
+			core::Logger::SetDefault(nullptr);
+		}
+		remove(options.path.c_str());
+	} catch(const exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
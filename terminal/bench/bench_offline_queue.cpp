@@ -0,0 +1,193 @@
+/*
+ * НАГРУЗОЧНЫЙ ТЕСТ ОФЛАЙН-ОЧЕРЕДИ
+ *
+ * 1. enqueue: несколько касс одновременно ставят платежи в очередь;
+ *    измеряется время вызова Enqueue и время до записи на диск (p50/p99),
+ *    число fdatasync (групповая запись)
+ * 2. forward: в процессе поднимается заменитель сервера PayGo - MockServer
+ *    из tests/mock_server.h, который первые --outage-ms отвечает 503
+ *    (FailFor), а затем принимает платёж (201) или отвечает 409 на повтор
+ *    уже встречавшегося Idempotency-Key, как настоящий сервер; OfflineForwarder
+ *    отправляет очередь с повторами. Выводится время до полной доставки,
+ *    скорость отправки после восстановления и число повторов с тем же
+ *    ключом идемпотентности (сервер отвечает на них 409)
+ *
+ * ЗАПУСК:
+ *   bench_offline_queue [--dir <path>] [--threads N] [--payments N] [--outage-ms N] [--batch N]
+ */
+
+#include "core/offline_queue.h"
+#include "core/payment_processor.h"
+
+#include "mock_server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+using namespace paygo;
+
+namespace {
+
+struct Options {
+	string dir = "/tmp/paygo_offline_bench";
+	size_t threads = 4;
+	size_t payments = 2000;    // платежей на кассу
+	size_t outage_ms = 2000;
+	size_t batch = 32;
+};
+
+Options ParseOptions(int argc, char *argv[]) {
+	Options options;
+	for(int i = 1; i < argc; ++i) {
+		string_view arg = argv[i];
+		if(i + 1 >= argc) {
+			throw invalid_argument("missing value for "s + string(arg));
+		}
+		if(arg == "--dir"sv) {
+			options.dir = argv[++i];
+		} else if(arg == "--threads"sv) {
+			options.threads = stoul(argv[++i]);
+		} else if(arg == "--payments"sv) {
+			options.payments = stoul(argv[++i]);
+		} else if(arg == "--outage-ms"sv) {
+			options.outage_ms = stoul(argv[++i]);
+		} else if(arg == "--batch"sv) {
+			options.batch = stoul(argv[++i]);
+		} else {
+			throw invalid_argument("unknown argument: "s + string(arg));
+		}
+	}
+	return options;
+}
+
+double Percentile(vector<double> &values, double fraction) {
+	if(values.empty()) {
+		return 0;
+	}
+	sort(values.begin(), values.end());
+	return values[min(values.size() - 1, static_cast<size_t>(fraction * static_cast<double>(values.size())))];
+}
+
+common::Transaction MakePayment(size_t lane, size_t index) {
+	common::Transaction transaction;
+	transaction.reference = "OFF-"s + to_string(lane) + "-"s + to_string(index);
+	transaction.terminal_id = "TERMINAL_001"s;
+	transaction.amount = 15000 + static_cast<int64_t>(index);
+	transaction.method = common::PaymentMethod::NFC;
+	transaction.card_token = "tok_"s + to_string(index);
+	transaction.description = "Кофе"s;
+	return transaction;
+}
+}
+
+int main(int argc, char *argv[]) {
+	try {
+		Options options = ParseOptions(argc, argv);
+		filesystem::remove_all(options.dir);
+
+		core::OfflineQueueSettings settings;
+		settings.directory = options.dir;
+		settings.max_pending = options.threads * options.payments;
+		settings.segment_bytes = 256 << 10;  // несколько сегментов, чтобы проверить их удаление
+		core::OfflineQueue queue(settings);
+
+		// 1. Постановка в очередь
+		vector<vector<double>> call_us(options.threads);
+		vector<vector<double>> durable_us(options.threads);
+		vector<thread> lanes;
+		const auto start = chrono::steady_clock::now();
+		for(size_t lane = 0; lane < options.threads; ++lane) {
+			lanes.emplace_back([&, lane] {
+				for(size_t i = 0; i < options.payments; ++i) {
+					const auto begin = chrono::steady_clock::now();
+					future<uint64_t> done = queue.Enqueue(MakePayment(lane, i));
+					const auto queued = chrono::steady_clock::now();
+					done.get();
+					const auto synced = chrono::steady_clock::now();
+					call_us[lane].push_back(chrono::duration<double, micro>(queued - begin).count());
+					durable_us[lane].push_back(chrono::duration<double, micro>(synced - begin).count());
+				}
+			});
+		}
+		for(thread &lane : lanes) {
+			lane.join();
+		}
+		const double enqueue_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		vector<double> calls;
+		vector<double> durables;
+		for(size_t lane = 0; lane < options.threads; ++lane) {
+			calls.insert(calls.end(), call_us[lane].begin(), call_us[lane].end());
+			durables.insert(durables.end(), durable_us[lane].begin(), durable_us[lane].end());
+		}
+		core::OfflineQueueStats stats = queue.GetStats();
+		printf("enqueue  %8.0f payments/s  call p50 %.1f p99 %.1f us  durable p50 %.0f p99 %.0f us  (%llu fdatasync, %zu segments)\n",
+				 static_cast<double>(calls.size()) / enqueue_seconds, Percentile(calls, 0.5), Percentile(calls, 0.99),
+				 Percentile(durables, 0.5), Percentile(durables, 0.99), static_cast<unsigned long long>(stats.syncs), stats.segments);
+
+		// 2. Отправка после восстановления связи
+		mutex keys_mutex;
+		unordered_set<string> keys;
+		atomic<size_t> duplicates{0};
+		test::MockServer server(false, [&](const test::MockRequest &request) {
+			lock_guard lock(keys_mutex);
+			if(keys.insert(request.Header("Idempotency-Key")).second) {
+				return test::MockResponse{201, "{}"s};
+			}
+			++duplicates;
+			return test::MockResponse{409, "{}"s};
+		});
+		const auto available_at = chrono::steady_clock::now() + chrono::milliseconds(options.outage_ms);
+		server.FailFor(chrono::milliseconds(options.outage_ms));
+
+		network::SslManager ssl(network::TlsSettings{});
+		network::ApiClientSettings client_settings;
+		network::EndpointSettings endpoint;
+		endpoint.name = "paygo"s;
+		endpoint.base_url = server.BaseUrl();
+		endpoint.max_connections = options.batch;
+		client_settings.endpoints.push_back(endpoint);
+		network::ApiClient client(client_settings, ssl);
+
+		core::ForwarderSettings forwarder_settings;
+		forwarder_settings.batch_size = options.batch;
+		forwarder_settings.initial_backoff = chrono::milliseconds(100);
+		forwarder_settings.max_backoff = chrono::milliseconds(1000);
+		const size_t total = calls.size();
+		{
+			core::OfflineForwarder forwarder(forwarder_settings, queue, client);
+			while(queue.GetStats().pending > 0) {
+				this_thread::sleep_for(chrono::milliseconds(1));
+			}
+			const auto drained = chrono::steady_clock::now();
+			const double after_outage = chrono::duration<double>(drained - available_at).count();
+
+			core::ForwarderStats forwarded = forwarder.GetStats();
+			const size_t accepted = [&] {
+				lock_guard lock(keys_mutex);
+				return keys.size();
+			}();
+			printf("forward  %8.0f payments/s after outage, drained %.2f s after recovery  (%llu delivered, %llu retries, %zu accepted, %zu duplicates)\n",
+					 static_cast<double>(total) / max(after_outage, 1e-6), after_outage,
+					 static_cast<unsigned long long>(forwarded.delivered), static_cast<unsigned long long>(forwarded.retries),
+					 accepted, duplicates.load());
+		}
+		printf("segments %zu after delivery\n", queue.GetStats().segments);
+	} catch(const exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,166 @@
+/*
+ * НАГРУЗОЧНЫЙ ТЕСТ РАСПОЗНАВАНИЯ QR-КОДОВ
+ *
+ * Камера не нужна: кадры читаются из записанного видео (--video).
+ *
+ * 1. baseline: поиск и декодирование во всём кадре (detectAndDecode)
+ *    для каждого кадра в одном потоке - как без конвейера
+ * 2. pipeline: QrScanner (захват, поиск в области интереса, декодирование
+ *    в трёх потоках); задержка от захвата кадра до декодированного кода
+ *    (p50/p99), число обработанных и отброшенных кадров
+ * Для обоих выводятся кадры/с и процессорное время на кадр (getrusage).
+ * С --pace 1 видео воспроизводится в темпе записи, как с камеры: тогда
+ * важны задержка и загрузка процессора, а не кадры/с.
+ *
+ * ЗАПУСК:
+ *   bench_qr_scanner --video <file> [--pace 0|1] [--detect-scale X] [--pool N]
+ */
+
+#include "hardware/qr_scanner.h"
+
+#include <opencv2/objdetect.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+using namespace paygo;
+
+namespace {
+
+struct Options {
+	string video;
+	bool pace = false;
+	double detect_scale = 0.5;
+	size_t pool = 4;
+};
+
+Options ParseOptions(int argc, char *argv[]) {
+	Options options;
+	for(int i = 1; i < argc; ++i) {
+		string_view arg = argv[i];
+		if(i + 1 >= argc) {
+			throw invalid_argument("missing value for "s + string(arg));
+		}
+		if(arg == "--video"sv) {
+			options.video = argv[++i];
+		} else if(arg == "--pace"sv) {
+			options.pace = stoul(argv[++i]) != 0;
+		} else if(arg == "--detect-scale"sv) {
+			options.detect_scale = stod(argv[++i]);
+		} else if(arg == "--pool"sv) {
+			options.pool = stoul(argv[++i]);
+		} else {
+			throw invalid_argument("unknown argument: "s + string(arg));
+		}
+	}
+	if(options.video.empty()) {
+		throw invalid_argument("--video is required");
+	}
+	return options;
+}
+
+/** Процессорное время процесса (все потоки), с */
+double CpuSeconds() {
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+	return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+			 static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+double Percentile(vector<double> &values, double fraction) {
+	if(values.empty()) {
+		return 0;
+	}
+	sort(values.begin(), values.end());
+	return values[min(values.size() - 1, static_cast<size_t>(fraction * static_cast<double>(values.size())))];
+}
+
+void RunBaseline(const Options &options) {
+	cv::VideoCapture video(options.video);
+	if(!video.isOpened()) {
+		throw runtime_error("cannot open "s + options.video);
+	}
+	cv::QRCodeDetector detector;
+	cv::Mat frame;
+	set<string> codes;
+	size_t frames = 0;
+	size_t decoded = 0;
+
+	const double cpu_start = CpuSeconds();
+	const auto start = chrono::steady_clock::now();
+	while(video.read(frame) && !frame.empty()) {
+		++frames;
+		const string payload = detector.detectAndDecode(frame);
+		if(!payload.empty()) {
+			++decoded;
+			codes.insert(payload);
+		}
+	}
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	const double cpu = CpuSeconds() - cpu_start;
+	printf("baseline %7.1f frames/s  cpu %.2f ms/frame  (%zu frames, %zu decoded, %zu distinct codes)\n",
+			 static_cast<double>(frames) / seconds, 1e3 * cpu / static_cast<double>(max<size_t>(1, frames)), frames, decoded, codes.size());
+}
+
+void RunPipeline(const Options &options) {
+	hardware::QrScannerSettings settings;
+	settings.source = options.video;
+	settings.pace_to_fps = options.pace;
+	settings.detect_scale = options.detect_scale;
+	settings.pool_size = options.pool;
+	settings.duplicate_window = chrono::milliseconds(0);  // считать каждое декодирование
+
+	mutex mutex;
+	vector<double> latency_ms;
+	vector<double> decode_ms;
+	set<string> codes;
+
+	const double cpu_start = CpuSeconds();
+	const auto start = chrono::steady_clock::now();
+	hardware::QrScanner scanner(settings, [&](const hardware::QrResult &result) {
+		lock_guard lock(mutex);
+		latency_ms.push_back(chrono::duration<double, milli>(result.decoded_at - result.captured_at).count());
+		decode_ms.push_back(chrono::duration<double, milli>(result.decoded_at - result.detected_at).count());
+		codes.insert(result.payload);
+	});
+	while(!scanner.WaitFinished(chrono::milliseconds(1000))) {
+	}
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	const double cpu = CpuSeconds() - cpu_start;
+
+	const hardware::QrScannerStats stats = scanner.GetStats();
+	lock_guard lock(mutex);
+	printf("pipeline %7.1f frames/s  cpu %.2f ms/frame  latency p50 %.1f p99 %.1f ms  decode p50 %.1f ms\n",
+			 static_cast<double>(stats.captured) / seconds, 1e3 * cpu / static_cast<double>(max<uint64_t>(1, stats.captured)),
+			 Percentile(latency_ms, 0.5), Percentile(latency_ms, 0.99), Percentile(decode_ms, 0.5));
+	printf("         %llu captured, %llu dropped, %llu detected (%llu in ROI), %llu found, %llu decoded, %llu failed, %zu distinct codes\n",
+			 static_cast<unsigned long long>(stats.captured), static_cast<unsigned long long>(stats.dropped),
+			 static_cast<unsigned long long>(stats.detected), static_cast<unsigned long long>(stats.roi_scans),
+			 static_cast<unsigned long long>(stats.found), static_cast<unsigned long long>(stats.decoded),
+			 static_cast<unsigned long long>(stats.decode_failures), codes.size());
+}
+}
+
+int main(int argc, char *argv[]) {
+	try {
+		Options options = ParseOptions(argc, argv);
+		RunBaseline(options);
+		RunPipeline(options);
+	} catch(const exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * НАГРУЗОЧНЫЙ ТЕСТ ХРАНИЛИЩА ТРАНЗАКЦИЙ
+ *
+ * Сравнивает два способа записи транзакций при одновременной работе
+ * нескольких касс (потоков):
+ * - single: каждая вставка фиксируется отдельно (один fsync на транзакцию)
+ * - group:  TransactionStorage с групповой фиксацией
+ *
+ * Каждый поток работает как касса: ставит транзакцию и ждёт подтверждения
+ * записи, только потом переходит к следующей (замкнутый цикл).
+ *
+ * ЗАПУСК:
+ *   bench_transaction_storage [--db <file>] [--threads N] [--count N]
+ *                             [--batch N] [--delay-us N] [--mode single|group|both]
+ *
+ * ВЫВОД: транзакций в секунду и задержка подтверждения (p50/p99/max).
+ */
+
+#include "database/sqlite_manager.h"
+#include "database/transaction_storage.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace paygo;
+
+namespace {
+
+struct Options {
+	string db = "/tmp/paygo_bench.db";
+	size_t threads = 8;
+	size_t count = 500;        // транзакций на поток
+	size_t batch = 256;
+	int64_t delay_us = 1000;
+	string mode = "both";
+};
+
+Options ParseOptions(int argc, char *argv[]) {
+	Options options;
+	for(int i = 1; i < argc; ++i) {
+		string_view arg = argv[i];
+		if(i + 1 >= argc) {
+			throw invalid_argument("missing value for "s + string(arg));
+		}
+		if(arg == "--db"sv) {
+			options.db = argv[++i];
+		} else if(arg == "--threads"sv) {
+			options.threads = stoul(argv[++i]);
+		} else if(arg == "--count"sv) {
+			options.count = stoul(argv[++i]);
+		} else if(arg == "--batch"sv) {
+			options.batch = stoul(argv[++i]);
+		} else if(arg == "--delay-us"sv) {
+			options.delay_us = stoll(argv[++i]);
+		} else if(arg == "--mode"sv) {
+			options.mode = argv[++i];
+		} else {
+			throw invalid_argument("unknown argument: "s + string(arg));
+		}
+	}
+	return options;
+}
+
+void RemoveDatabase(const string &path) {
+	for(const char *suffix : {"", "-wal", "-shm"}) {
+		remove((path + suffix).c_str());
+	}
+}
+
+common::Transaction MakeTransaction(size_t thread, size_t index) {
+	common::Transaction transaction;
+	transaction.reference = "T"s + to_string(thread) + "-"s + to_string(index);
+	transaction.terminal_id = "TERMINAL_001"s;
+	transaction.amount = 10000 + static_cast<int64_t>(index % 5000);
+	transaction.method = common::PaymentMethod::NFC;
+	transaction.card_token = "tok_0123456789abcdef"s;
+	transaction.created_at = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+	return transaction;
+}
+
+/** Запускает threads потоков, каждый вызывает submit(thread, index) count раз и меряет задержку */
+template <typename Submit>
+void Run(string_view name, const Options &options, Submit submit) {
+	vector<vector<double>> latencies(options.threads);
+	vector<thread> workers;
+
+	const auto start = chrono::steady_clock::now();
+	for(size_t t = 0; t < options.threads; ++t) {
+		workers.emplace_back([&, t] {
+			latencies[t].reserve(options.count);
+			for(size_t i = 0; i < options.count; ++i) {
+				const auto begin = chrono::steady_clock::now();
+				submit(t, i);
+				latencies[t].push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count());
+			}
+		});
+	}
+	for(thread &worker : workers) {
+		worker.join();
+	}
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	vector<double> all;
+	for(const vector<double> &part : latencies) {
+		all.insert(all.end(), part.begin(), part.end());
+	}
+	sort(all.begin(), all.end());
+	auto percentile = [&all](double p) {
+		return all.empty() ? 0.0 : all[min(all.size() - 1, static_cast<size_t>(p * all.size()))];
+	};
+
+	printf("%-8s %8zu tx  %10.0f tx/s  p50 %8.0f us  p99 %8.0f us  max %8.0f us\n", string(name).c_str(), all.size(),
+			 all.size() / seconds, percentile(0.50), percentile(0.99), all.empty() ? 0.0 : all.back());
+}
+
+/** Одна фиксация на вставку: у каждого потока своё соединение */
+void RunSingle(const Options &options) {
+	RemoveDatabase(options.db);
+	database::StorageSettings settings;
+	settings.database.path = options.db;
+	{
+		database::TransactionStorage storage(settings);  // создаёт схему
+	}
+
+	vector<unique_ptr<database::SqliteManager>> connections;
+	for(size_t t = 0; t < options.threads; ++t) {
+		connections.push_back(make_unique<database::SqliteManager>(settings.database));
+	}
+
+	Run("single"sv, options, [&](size_t thread, size_t index) {
+		common::Transaction transaction = MakeTransaction(thread, index);
+		database::StatementScope insert(connections[thread]->Prepare(
+			"INSERT INTO transactions(reference, terminal_id, amount, currency, payment_method, status, card_token, description, created_at) "
+			"VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?)"s));
+		insert->Bind(1, transaction.reference)
+			 .Bind(2, transaction.terminal_id)
+			 .Bind(3, transaction.amount)
+			 .Bind(4, transaction.currency)
+			 .Bind(5, common::ToString(transaction.method))
+			 .Bind(6, common::ToString(transaction.status))
+			 .Bind(7, transaction.card_token)
+			 .Bind(8, transaction.description)
+			 .Bind(9, transaction.created_at);
+		insert->Step();
+	});
+}
+
+void RunGroup(const Options &options) {
+	RemoveDatabase(options.db);
+	database::StorageSettings settings;
+	settings.database.path = options.db;
+	settings.max_batch = options.batch;
+	settings.max_delay = chrono::microseconds(options.delay_us);
+
+	database::TransactionStorage storage(settings);
+	Run("group"sv, options, [&](size_t thread, size_t index) {
+		storage.Store(MakeTransaction(thread, index)).get();
+	});
+
+	database::StorageStats stats = storage.GetStats();
+	printf("         %llu commits, %.1f tx/commit on average, largest batch %llu\n",
+			 static_cast<unsigned long long>(stats.commits),
+			 stats.commits ? static_cast<double>(stats.operations) / stats.commits : 0.0,
+			 static_cast<unsigned long long>(stats.max_batch));
+}
+}
+
+int main(int argc, char *argv[]) {
+	try {
+		Options options = ParseOptions(argc, argv);
+		if(options.mode == "single"sv || options.mode == "both"sv) {
+			RunSingle(options);
+		}
+		if(options.mode == "group"sv || options.mode == "both"sv) {
+			RunGroup(options);
+		}
+		RemoveDatabase(options.db);
+	} catch(const exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
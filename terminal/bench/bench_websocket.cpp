@@ -0,0 +1,290 @@
+/*
+ * НАГРУЗОЧНЫЙ ТЕСТ WEBSOCKET
+ *
+ * 1. unmask: снятие маски векторными инструкциями против побайтного цикла
+ * 2. echo: в процессе поднимается эхо-сервер на том же кодеке (роль SERVER:
+ *    разбор на месте, ответ ссылается на буфер приёма без копии, writev).
+ *    Клиент отправляет окна по --window сообщений и ждёт эхо; сверяется
+ *    содержимое. Выводятся сообщения/с и МБ/с для нескольких размеров
+ *
+ * Проверки протокола (фрагменты, PING/PONG, UTF-8, пределы размера) -
+ * в tests/test_websocket.cpp.
+ *
+ * ЗАПУСК:
+ *   bench_websocket [--messages N] [--window N] [--unmask-mb N]
+ */
+
+#include "network/websocket_client.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace paygo;
+
+namespace {
+
+struct Options {
+	size_t messages = 200000;
+	size_t window = 64;          // сообщений в полёте
+	size_t unmask_mb = 256;
+};
+
+Options ParseOptions(int argc, char *argv[]) {
+	Options options;
+	for(int i = 1; i < argc; ++i) {
+		string_view arg = argv[i];
+		if(i + 1 >= argc) {
+			throw invalid_argument("missing value for "s + string(arg));
+		}
+		if(arg == "--messages"sv) {
+			options.messages = stoul(argv[++i]);
+		} else if(arg == "--window"sv) {
+			options.window = stoul(argv[++i]);
+		} else if(arg == "--unmask-mb"sv) {
+			options.unmask_mb = stoul(argv[++i]);
+		} else {
+			throw invalid_argument("unknown argument: "s + string(arg));
+		}
+	}
+	return options;
+}
+
+/**
+ * ЭХО-СЕРВЕР
+ *
+ * Принимает одно соединение за раз, отвечает на рукопожатие и возвращает
+ * каждое сообщение (фрагменты - фрагментами). Ответ ссылается на данные
+ * в буфере приёма, поэтому очередь отправляется до следующего чтения.
+ */
+class EchoServer {
+public:
+	EchoServer() {
+		listener_ = socket(AF_INET, SOCK_STREAM, 0);
+		int yes = 1;
+		setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		if(bind(listener_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(listener_, 16) != 0) {
+			throw runtime_error("echo server: cannot listen");
+		}
+		socklen_t length = sizeof(address);
+		getsockname(listener_, reinterpret_cast<sockaddr *>(&address), &length);
+		port_ = ntohs(address.sin_port);
+
+		thread_ = thread([this] {
+			while(!stop_) {
+				const int fd = accept(listener_, nullptr, nullptr);
+				if(fd < 0) {
+					continue;
+				}
+				int nodelay = 1;
+				setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+				try {
+					Serve(fd);
+				} catch(const exception &e) {
+					cerr << "echo server: " << e.what() << endl;
+				}
+				close(fd);
+			}
+		});
+	}
+
+	~EchoServer() {
+		stop_ = true;
+		shutdown(listener_, SHUT_RDWR);
+		close(listener_);
+		thread_.join();
+	}
+
+	uint16_t Port() const {
+		return port_;
+	}
+
+private:
+	void Serve(int fd) {
+		network::ReceiveRing ring(1 << 20);
+		if(!Upgrade(fd, ring)) {
+			return;
+		}
+
+		network::FrameReaderSettings settings;
+		settings.role = network::Role::SERVER;
+		settings.deliver_fragments = true;
+		network::FrameReader reader(settings);
+		network::FrameWriter writer(network::Role::SERVER);
+
+		bool continuation = false;
+		bool closed = false;
+		while(!closed) {
+			const ssize_t count = read(fd, ring.WriteData(), ring.Writable());
+			if(count <= 0) {
+				return;
+			}
+			ring.Produce(static_cast<size_t>(count));
+			reader.Parse(ring, [&](const network::Message &message) {
+				if(message.opcode == network::Opcode::PING) {
+					writer.Add(network::Opcode::PONG, message.data);
+				} else if(message.opcode == network::Opcode::CLOSE) {
+					writer.Add(network::Opcode::CLOSE, message.data);
+					closed = true;
+				} else if(message.opcode != network::Opcode::PONG) {
+					writer.Add(continuation ? network::Opcode::CONTINUATION : message.opcode, message.data, message.final);
+					continuation = !message.final;
+				}
+			});
+			// Ответы ссылаются на разобранные байты буфера: отправить до следующего read
+			while(!writer.Flush(fd)) {
+				pollfd descriptor{fd, POLLOUT, 0};
+				poll(&descriptor, 1, -1);
+			}
+		}
+	}
+
+	bool Upgrade(int fd, network::ReceiveRing &ring) {
+		size_t header_end;
+		while(true) {
+			const string_view received(reinterpret_cast<const char *>(ring.ReadData()), ring.Readable());
+			if((header_end = received.find("\r\n\r\n")) != string_view::npos) {
+				break;
+			}
+			const ssize_t count = read(fd, ring.WriteData(), ring.Writable());
+			if(count <= 0) {
+				return false;
+			}
+			ring.Produce(static_cast<size_t>(count));
+		}
+
+		const string_view request(reinterpret_cast<const char *>(ring.ReadData()), header_end);
+		const size_t position = request.find("Sec-WebSocket-Key: ");
+		if(position == string_view::npos) {
+			return false;
+		}
+		const size_t end = request.find("\r\n", position);
+		const string key(request.substr(position + 19, end == string_view::npos ? string_view::npos : end - position - 19));
+		ring.Consume(header_end + 4);
+
+		const string response = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: "s +
+										network::ComputeAcceptKey(key) + "\r\n\r\n"s;
+		return write(fd, response.data(), response.size()) == static_cast<ssize_t>(response.size());
+	}
+
+	int listener_ = -1;
+	uint16_t port_ = 0;
+	atomic<bool> stop_{false};
+	thread thread_;
+};
+
+void BenchUnmask(size_t megabytes) {
+	vector<uint8_t> data(1 << 20);
+	for(size_t i = 0; i < data.size(); ++i) {
+		data[i] = static_cast<uint8_t>(i * 31);
+	}
+	const uint32_t mask = 0x5A3C96E1u;
+	uint8_t key[4];
+	memcpy(key, &mask, 4);
+
+	auto start = chrono::steady_clock::now();
+	for(size_t round = 0; round < megabytes; ++round) {
+		network::Unmask(data.data(), data.size(), mask);
+	}
+	const double vector_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	start = chrono::steady_clock::now();
+	for(size_t round = 0; round < megabytes; ++round) {
+		volatile uint8_t *bytes = data.data();  // без автовекторизации
+		for(size_t i = 0; i < data.size(); ++i) {
+			bytes[i] = bytes[i] ^ key[i & 3];
+		}
+	}
+	const double byte_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	// Чётное число проходов каждым способом возвращает исходные данные
+	for(size_t i = 0; i < data.size(); ++i) {
+		if(megabytes % 2 == 0 && data[i] != static_cast<uint8_t>(i * 31)) {
+			throw runtime_error("unmask: result mismatch at byte "s + to_string(i));
+		}
+	}
+	const double gigabytes = static_cast<double>(megabytes) / 1024.0;
+	printf("unmask   %6.2f GB/s vectorized   %6.2f GB/s bytewise\n", gigabytes / vector_seconds, gigabytes / byte_seconds);
+}
+
+void BenchEcho(uint16_t port, size_t payload_size, const Options &options) {
+	network::WebSocketSettings settings;
+	settings.port = port;
+	settings.path = "/ws/terminal"s;
+	settings.ring_bytes = 1 << 20;
+	network::WebSocketClient client(settings);
+
+	string payload(payload_size, '\0');
+	for(size_t i = 0; i < payload.size(); ++i) {
+		payload[i] = static_cast<char>('a' + i % 26);
+	}
+
+	size_t received = 0;
+	size_t mismatches = 0;
+	auto on_message = [&](const network::Message &message) {
+		if(message.opcode == network::Opcode::BINARY) {
+			if(message.data != payload) {
+				++mismatches;
+			}
+			++received;
+		}
+	};
+
+	const size_t messages = max<size_t>(1, options.messages * 64 / max<size_t>(64, payload_size));
+	const auto start = chrono::steady_clock::now();
+	size_t sent = 0;
+	while(received < messages) {
+		while(sent < messages && sent - received < options.window) {
+			client.Send(network::Opcode::BINARY, payload);
+			++sent;
+		}
+		if(!client.Poll(on_message, chrono::milliseconds(1000))) {
+			throw runtime_error("echo: connection closed");
+		}
+	}
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	if(mismatches > 0) {
+		throw runtime_error("echo: "s + to_string(mismatches) + " corrupted messages"s);
+	}
+	printf("echo %6zu B  %9.0f msgs/s  %8.1f MB/s  (%zu messages)\n", payload_size, static_cast<double>(messages) / seconds,
+			 static_cast<double>(messages * payload_size) / seconds / 1e6, messages);
+
+	client.Close();
+	while(client.Poll([](const network::Message &) {}, chrono::milliseconds(1000))) {
+	}
+}
+}
+
+int main(int argc, char *argv[]) {
+	try {
+		Options options = ParseOptions(argc, argv);
+		BenchUnmask(options.unmask_mb);
+
+		EchoServer server;
+		for(size_t size : {size_t{64}, size_t{1024}, size_t{16384}}) {
+			BenchEcho(server.Port(), size, options);
+		}
+	} catch(const exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,360 @@
+/*
+ * НАГРУЗОЧНЫЙ ДРАЙВЕР ПЛАТЕЖЕЙ (СКВОЗНОЙ)
+ *
+ * Имитирует --terminals касс, одновременно проводящих платежи через весь
+ * paygo_core. Каждая касса работает в замкнутом цикле:
+ *
+ *   card      - чтение карты (заглушка NFC-считывателя: пауза --card-ms)
+ *   store     - запись транзакции PENDING в TransactionStorage
+ *   authorize - PaymentProcessor -> ApiClient -> имитация эквайера
+ *   finalize  - смена состояния на COMPLETED / FAILED
+ *
+ * Имитация эквайера - MockServer из tests/mock_server.h (HTTP/1.1,
+ * keep-alive): отвечает через --acquirer-ms (±50%, SetLatency), отклоняет
+ * долю --decline-rate платежей (402) и на долю --error-rate отвечает 503
+ * (FailRate) - тогда платёж уходит в офлайн-очередь, как при сбое сервера.
+ *
+ * После 503 PaymentProcessor --probe-ms не обращается к эквайеру и
+ * ставит платежи в очередь сразу. По умолчанию окно 0: каждый платёж
+ * идёт к эквайеру, и --error-rate - доля ошибок на запрос. С окном
+ * (в терминале - 30 с) видно, какую часть времени касса работает без сети.
+ * Офлайн-очередь разбирает OfflineForwarder, как в терминале; после
+ * последнего платежа драйвер ждёт, пока очередь опустеет.
+ *
+ * ВЫВОД: платежей/с, задержка платежа целиком (p50/p90/p99/max), разбивка
+ * по стадиям (p50/p99/среднее и доля во времени платежа), исходы,
+ * время без сети, разбор очереди, статистика групповой записи и
+ * соединений. По этим числам подбираются число касс на терминал и
+ * мощность сервера.
+ *
+ * ЗАПУСК:
+ *   paygo_load_driver [--terminals N] [--payments N] [--card-ms N] [--acquirer-ms N]
+ *                     [--decline-rate X] [--error-rate X] [--probe-ms N] [--think-ms N] [--dir <path>]
+ */
+
+#include "core/offline_queue.h"
+#include "core/payment_processor.h"
+#include "database/transaction_storage.h"
+#include "network/api_client.h"
+#include "network/ssl_manager.h"
+
+#include "mock_server.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace paygo;
+
+namespace {
+
+struct Options {
+	size_t terminals = 8;
+	size_t payments = 500;         // платежей на кассу
+	double card_ms = 5;
+	double acquirer_ms = 20;
+	double decline_rate = 0.02;
+	double error_rate = 0;
+	double probe_ms = 0;           // PaymentSettings::offline_probe_interval
+	double think_ms = 0;           // пауза кассира между платежами
+	string dir = "/tmp/paygo_load";
+};
+
+Options ParseOptions(int argc, char *argv[]) {
+	Options options;
+	for(int i = 1; i < argc; ++i) {
+		string_view arg = argv[i];
+		if(i + 1 >= argc) {
+			throw invalid_argument("missing value for "s + string(arg));
+		}
+		if(arg == "--terminals"sv) {
+			options.terminals = stoul(argv[++i]);
+		} else if(arg == "--payments"sv) {
+			options.payments = stoul(argv[++i]);
+		} else if(arg == "--card-ms"sv) {
+			options.card_ms = stod(argv[++i]);
+		} else if(arg == "--acquirer-ms"sv) {
+			options.acquirer_ms = stod(argv[++i]);
+		} else if(arg == "--decline-rate"sv) {
+			options.decline_rate = stod(argv[++i]);
+		} else if(arg == "--error-rate"sv) {
+			options.error_rate = stod(argv[++i]);
+		} else if(arg == "--probe-ms"sv) {
+			options.probe_ms = stod(argv[++i]);
+		} else if(arg == "--think-ms"sv) {
+			options.think_ms = stod(argv[++i]);
+		} else if(arg == "--dir"sv) {
+			options.dir = argv[++i];
+		} else {
+			throw invalid_argument("unknown argument: "s + string(arg));
+		}
+	}
+	return options;
+}
+
+chrono::duration<double, milli> Jittered(double milliseconds, mt19937_64 &random) {
+	uniform_real_distribution<double> jitter(0.5, 1.5);
+	return chrono::duration<double, milli>(milliseconds * jitter(random));
+}
+
+/**
+ * Ответ эквайера на запрос, который дошёл до обработчика: 503 на долю
+ * --error-rate вносит MockServer, поэтому доля отказов здесь пересчитана
+ * так, чтобы от всех запросов отклонялась --decline-rate
+ */
+test::MockServer::Handler AcquirerHandler(const Options &options) {
+	const double decline = options.error_rate < 1 ? options.decline_rate / (1 - options.error_rate) : 0;
+	return [decline](const test::MockRequest &) {
+		thread_local mt19937_64 random(random_device{}());
+		if(uniform_real_distribution<double>(0, 1)(random) < decline) {
+			return test::MockResponse{402, "{\"status\":\"declined\"}\n"s};
+		}
+		return test::MockResponse{201, "{\"status\":\"approved\"}\n"s};
+	};
+}
+
+/** Заглушка NFC-считывателя: время поднесения и обмена с картой */
+class CardReaderStub {
+public:
+	CardReaderStub(double milliseconds, uint64_t seed) : milliseconds_(milliseconds), random_(seed) {}
+
+	string Read() {
+		if(milliseconds_ > 0) {
+			this_thread::sleep_for(Jittered(milliseconds_, random_));
+		}
+		return "tok_"s + to_string(random_() % 1000000);
+	}
+
+private:
+	double milliseconds_;
+	mt19937_64 random_;
+};
+
+enum Stage {
+	CARD,
+	STORE,
+	AUTHORIZE,
+	FINALIZE,
+	TOTAL,
+	STAGES,
+};
+
+constexpr array<string_view, STAGES> STAGE_NAMES = {"card"sv, "store"sv, "authorize"sv, "finalize"sv, "total"sv};
+
+struct LaneResult {
+	array<vector<double>, STAGES> ms;
+	array<size_t, 4> outcomes{};   // по PaymentOutcome
+	size_t skipped = 0;            // поставлено в очередь без запроса: окно --probe-ms
+};
+
+double Percentile(vector<double> &values, double fraction) {
+	if(values.empty()) {
+		return 0;
+	}
+	sort(values.begin(), values.end());
+	return values[min(values.size() - 1, static_cast<size_t>(fraction * static_cast<double>(values.size())))];
+}
+
+double Mean(const vector<double> &values) {
+	double sum = 0;
+	for(double value : values) {
+		sum += value;
+	}
+	return values.empty() ? 0 : sum / static_cast<double>(values.size());
+}
+
+void RemoveDatabase(const string &path) {
+	for(const char *suffix : {"", "-wal", "-shm"}) {
+		filesystem::remove(path + suffix);
+	}
+}
+}
+
+int main(int argc, char *argv[]) {
+	try {
+		Options options = ParseOptions(argc, argv);
+		filesystem::remove_all(options.dir);
+		filesystem::create_directories(options.dir);
+
+		test::MockServer acquirer(false, AcquirerHandler(options));
+		acquirer.SetLatency(chrono::duration_cast<chrono::microseconds>(chrono::duration<double, milli>(options.acquirer_ms)), 0.5);
+		acquirer.FailRate(options.error_rate, 503);
+
+		database::StorageSettings storage_settings;
+		storage_settings.database.path = options.dir + "/terminal.db"s;
+		RemoveDatabase(storage_settings.database.path);
+		database::TransactionStorage storage(storage_settings);
+
+		core::OfflineQueueSettings queue_settings;
+		queue_settings.directory = options.dir + "/offline"s;
+		queue_settings.max_pending = options.terminals * options.payments;
+		core::OfflineQueue queue(queue_settings);
+
+		network::SslManager ssl(network::TlsSettings{});
+		network::ApiClientSettings client_settings;
+		network::EndpointSettings endpoint;
+		endpoint.name = "paygo"s;
+		endpoint.base_url = acquirer.BaseUrl();
+		endpoint.max_connections = options.terminals;
+		client_settings.endpoints.push_back(endpoint);
+		network::ApiClient client(client_settings, ssl);
+
+		core::PaymentSettings payment_settings;
+		payment_settings.offline_probe_interval = chrono::milliseconds(static_cast<int64_t>(options.probe_ms));
+		core::PaymentProcessor processor(payment_settings, client, queue);
+
+		core::ForwarderSettings forwarder_settings;
+		forwarder_settings.initial_backoff = chrono::milliseconds(100);
+		forwarder_settings.max_backoff = chrono::milliseconds(2000);
+		forwarder_settings.idle_poll = chrono::milliseconds(100);
+		core::OfflineForwarder forwarder(forwarder_settings, queue, client, &processor);
+
+		// Время без сети - по опросу раз в миллисекунду, пока идут платежи
+		atomic<bool> running{true};
+		atomic<uint64_t> offline_ticks{0};
+		atomic<uint64_t> ticks{0};
+		thread sampler([&] {
+			while(running) {
+				++ticks;
+				if(!processor.Online()) {
+					++offline_ticks;
+				}
+				this_thread::sleep_for(chrono::milliseconds(1));
+			}
+		});
+
+		vector<LaneResult> results(options.terminals);
+		vector<thread> lanes;
+		const auto start = chrono::steady_clock::now();
+		for(size_t lane = 0; lane < options.terminals; ++lane) {
+			lanes.emplace_back([&, lane] {
+				CardReaderStub reader(options.card_ms, lane + 1);
+				mt19937_64 random(lane + 1000);
+				LaneResult &result = results[lane];
+				for(size_t i = 0; i < options.payments; ++i) {
+					auto mark = chrono::steady_clock::now();
+					const auto begin = mark;
+					auto stage_done = [&](Stage stage) {
+						const auto now = chrono::steady_clock::now();
+						result.ms[stage].push_back(chrono::duration<double, milli>(now - mark).count());
+						mark = now;
+					};
+
+					common::Transaction transaction;
+					transaction.reference = "LOAD-"s + to_string(lane) + "-"s + to_string(i);
+					transaction.terminal_id = "TERMINAL_"s + to_string(lane);
+					transaction.amount = 10000 + static_cast<int64_t>(random() % 90000);
+					transaction.method = common::PaymentMethod::NFC;
+					transaction.card_token = reader.Read();
+					transaction.description = "Нагрузочный тест"s;
+					transaction.created_at =
+						chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+					stage_done(CARD);
+
+					const int64_t id = storage.Store(transaction).get();
+					stage_done(STORE);
+
+					const bool online = processor.Online();
+					const core::PaymentResult payment = processor.Process(transaction);
+					stage_done(AUTHORIZE);
+					++result.outcomes[static_cast<size_t>(payment.outcome)];
+					if(!online && payment.outcome == core::PaymentOutcome::QUEUED_OFFLINE) {
+						++result.skipped;
+					}
+
+					if(payment.outcome != core::PaymentOutcome::QUEUED_OFFLINE) {
+						const common::TransactionStatus status = payment.outcome == core::PaymentOutcome::APPROVED
+																				 ? common::TransactionStatus::COMPLETED
+																				 : common::TransactionStatus::FAILED;
+						storage.UpdateStatus(id, status).get();
+					}
+					stage_done(FINALIZE);
+					result.ms[TOTAL].push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count());
+
+					if(options.think_ms > 0) {
+						this_thread::sleep_for(Jittered(options.think_ms, random));
+					}
+				}
+			});
+		}
+		for(thread &lane : lanes) {
+			lane.join();
+		}
+		const auto finish = chrono::steady_clock::now();
+		const double seconds = chrono::duration<double>(finish - start).count();
+		running = false;
+		sampler.join();
+
+		// Разбор очереди после последнего платежа; 503 эквайера откладывают пачки и здесь
+		constexpr auto DRAIN_TIMEOUT = chrono::seconds(60);
+		while(queue.GetStats().pending > 0 && chrono::steady_clock::now() - finish < DRAIN_TIMEOUT) {
+			this_thread::sleep_for(chrono::milliseconds(10));
+		}
+		const double drain_seconds = chrono::duration<double>(chrono::steady_clock::now() - finish).count();
+		const size_t still_pending = queue.GetStats().pending;
+		const core::ForwarderStats forwarder_stats = forwarder.GetStats();
+
+		LaneResult all;
+		for(const LaneResult &result : results) {
+			for(size_t stage = 0; stage < STAGES; ++stage) {
+				all.ms[stage].insert(all.ms[stage].end(), result.ms[stage].begin(), result.ms[stage].end());
+			}
+			for(size_t outcome = 0; outcome < all.outcomes.size(); ++outcome) {
+				all.outcomes[outcome] += result.outcomes[outcome];
+			}
+			all.skipped += result.skipped;
+		}
+
+		const size_t payments = all.ms[TOTAL].size();
+		const double total_mean = Mean(all.ms[TOTAL]);
+		printf("payments %zu in %.2f s: %.1f payments/s (%zu terminals)\n", payments, seconds, static_cast<double>(payments) / seconds,
+				 options.terminals);
+		printf("latency  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f ms\n", Percentile(all.ms[TOTAL], 0.5), Percentile(all.ms[TOTAL], 0.9),
+				 Percentile(all.ms[TOTAL], 0.99), Percentile(all.ms[TOTAL], 1.0));
+		printf("%-10s %9s %9s %9s %7s\n", "stage", "p50 ms", "p99 ms", "mean ms", "share");
+		for(size_t stage = 0; stage < TOTAL; ++stage) {
+			const double mean = Mean(all.ms[stage]);
+			printf("%-10s %9.2f %9.2f %9.2f %6.1f%%\n", string(STAGE_NAMES[stage]).c_str(), Percentile(all.ms[stage], 0.5),
+					 Percentile(all.ms[stage], 0.99), mean, total_mean > 0 ? 100.0 * mean / total_mean : 0.0);
+		}
+		printf("outcomes approved %zu, declined %zu, queued offline %zu, failed %zu\n",
+				 all.outcomes[static_cast<size_t>(core::PaymentOutcome::APPROVED)],
+				 all.outcomes[static_cast<size_t>(core::PaymentOutcome::DECLINED)],
+				 all.outcomes[static_cast<size_t>(core::PaymentOutcome::QUEUED_OFFLINE)],
+				 all.outcomes[static_cast<size_t>(core::PaymentOutcome::FAILED)]);
+		printf("offline  %.1f%% of the run (probe window %.0f ms), %zu payments queued without a request\n",
+				 ticks ? 100.0 * static_cast<double>(offline_ticks) / static_cast<double>(ticks) : 0.0, options.probe_ms, all.skipped);
+		if(still_pending == 0) {
+			printf("forward  queue drained %.2f s after the last payment: ", drain_seconds);
+		} else {
+			printf("forward  %zu payments still queued after %.0f s: ", still_pending, drain_seconds);
+		}
+		printf("%llu delivered, %llu rejected, %llu batches, %llu retries\n", static_cast<unsigned long long>(forwarder_stats.delivered),
+				 static_cast<unsigned long long>(forwarder_stats.rejected), static_cast<unsigned long long>(forwarder_stats.batches),
+				 static_cast<unsigned long long>(forwarder_stats.retries));
+
+		const database::StorageStats storage_stats = storage.GetStats();
+		const network::EndpointStats endpoint_stats = client.GetStats("paygo"s);
+		printf("storage  %llu commits, %.1f operations/commit\n", static_cast<unsigned long long>(storage_stats.commits),
+				 storage_stats.commits ? static_cast<double>(storage_stats.operations) / static_cast<double>(storage_stats.commits) : 0.0);
+		printf("network  %llu requests, %llu failures, %llu connections opened, %llu served by acquirer\n",
+				 static_cast<unsigned long long>(endpoint_stats.requests), static_cast<unsigned long long>(endpoint_stats.failures),
+				 static_cast<unsigned long long>(endpoint_stats.connections), static_cast<unsigned long long>(acquirer.Requests()));
+	} catch(const exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+/*
+ * ИНДЕКС ЭМБЕДДИНГОВ ЛИЦ ДЛЯ ИДЕНТИФИКАЦИИ 1:N
+ *
+ * Оплата по лицу ищет покупателя среди всех зарегистрированных
+ * пользователей: эмбеддинг с камеры сравнивается с каждым сохранённым.
+ * На Raspberry Pi это должно занимать миллисекунды.
+ *
+ * КВАНТОВАНИЕ:
+ * Эмбеддинг нормируется (сходство - косинус) и хранится в int8:
+ * q[i] = round(x[i] / max|x| * 127), плюс масштаб max|x| / 127.
+ * Сходство = dot(q_a, q_b) * scale_a * scale_b. Вектор занимает в 4 раза
+ * меньше памяти, чем float, а скалярное произведение int8 считается
+ * векторными инструкциями: NEON (vmull_s8, на ARMv8.2 - sdot), AVX2 или
+ * SSE2 на x86, иначе обычным циклом.
+ *
+ * ПОИСК:
+ * Векторы лежат в памяти подряд (строки выровнены на 32 байта), поиск -
+ * последовательный проход с предвыборкой. Лучшие k совпадений хранятся
+ * в куче; кандидат со сходством не выше k-го (или min_score) отбрасывается
+ * одним сравнением, без операций с кучей.
+ *
+ * ФАЙЛ (отображается в память через mmap, MAP_SHARED):
+ *   заголовок (64 байта) | векторы int8 [capacity][stride] |
+ *   масштабы float [capacity] | идентификаторы u64 [capacity]
+ * При заполнении ёмкость удваивается: данные переписываются в новый файл,
+ * который заменяет старый переименованием. Индекс - производные данные:
+ * после сбоя питания (или при несовпадении размерности) он строится заново
+ * из шаблонов на сервере; Sync() сбрасывает изменения на диск.
+ *
+ * ЦЕЛОСТНОСТЬ: перед первым изменением после Sync в заголовке ставится
+ * флаг dirty и сбрасывается на диск; Sync (и деструктор) снимает его
+ * после msync данных. Файл с флагом - изменения, не дошедшие до диска
+ * целиком, - не открывается (FaceIndexError): его нужно удалить и
+ * построить индекс заново.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace paygo::biometry {
+
+/** Ошибка файла индекса или неверный эмбеддинг */
+class FaceIndexError : public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+struct FaceIndexSettings {
+	std::string path = "/var/lib/paygo/face_index.bin";
+	size_t dimension = 512;            // размерность эмбеддинга модели распознавания
+	size_t initial_capacity = 1024;
+};
+
+struct FaceMatch {
+	uint64_t user_id = 0;
+	float score = 0;                   // косинусное сходство, [-1, 1]
+};
+
+/** Скалярное произведение int8 векторов (size кратен 32) */
+int32_t DotInt8(const int8_t *a, const int8_t *b, size_t size);
+
+/**
+ * Нормирует и квантует эмбеддинг в out (padded_size байт, хвост - нули).
+ * @return масштаб; нулевой или неконечный вектор - FaceIndexError
+ */
+float QuantizeEmbedding(const float *embedding, size_t dimension, int8_t *out, size_t padded_size);
+
+/**
+ * Индекс в файле. Поиск из нескольких потоков выполняется одновременно;
+ * регистрация и удаление - исключительно (std::shared_mutex).
+ */
+class FaceIndex {
+public:
+	/**
+	 * Открывает файл или создаёт пустой индекс; ошибка - FaceIndexError,
+	 * в том числе для файла, изменённого без последующего Sync
+	 */
+	explicit FaceIndex(const FaceIndexSettings &settings);
+	~FaceIndex();
+
+	FaceIndex(const FaceIndex &) = delete;
+	FaceIndex &operator=(const FaceIndex &) = delete;
+
+	/** Регистрирует эмбеддинг пользователя (dimension чисел); повторная регистрация заменяет прежний */
+	void Enroll(uint64_t user_id, const float *embedding);
+
+	/** @return false - пользователь не зарегистрирован */
+	bool Remove(uint64_t user_id);
+
+	/**
+	 * До k лучших совпадений со сходством выше min_score,
+	 * по убыванию сходства
+	 */
+	std::vector<FaceMatch> Search(const float *embedding, size_t k, float min_score = -1.0f) const;
+
+	size_t Size() const;
+
+	size_t Dimension() const {
+		return dimension_;
+	}
+
+	/** Сбрасывает отображённые страницы на диск (msync) и снимает флаг изменений */
+	void Sync();
+
+private:
+	/** Отображённый файл индекса */
+	struct Mapping {
+		int fd = -1;
+		uint8_t *data = nullptr;
+		size_t bytes = 0;
+		size_t capacity = 0;
+	};
+
+	/** Отображает файл; capacity == 0 - открыть существующий, иначе создать новый */
+	Mapping Map(const std::string &path, size_t capacity) const;
+	static void Unmap(Mapping &mapping);
+	void Grow();
+
+	/** Ставит флаг изменений в заголовке на диске; под исключительной блокировкой */
+	void MarkDirty();
+
+	size_t Count() const;
+	int8_t *Vector(size_t slot) const;
+	float *Scales() const;
+	uint64_t *Ids() const;
+
+	FaceIndexSettings settings_;
+	size_t dimension_;
+	size_t stride_;                    // dimension, округлённая вверх до 32
+
+	mutable std::shared_mutex mutex_;
+	Mapping mapping_;
+	std::unordered_map<uint64_t, size_t> slots_;   // user_id -> строка
+};
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+/*
+ * ОБЩИЕ ТИПЫ ТЕРМИНАЛА
+ *
+ * Структуры данных, которыми обмениваются модули paygo_core:
+ * - PaymentMethod, TransactionStatus - перечисления, совпадающие
+ *   со значениями в схеме веб-сервиса (web-service/database/init.sql)
+ * - Transaction - платёжная транзакция в локальном хранилище терминала
+ *
+ * ДЕНЕЖНЫЕ СУММЫ:
+ * Суммы хранятся в минимальных единицах валюты (копейках) целым числом -
+ * без ошибок округления двоичной арифметики с плавающей точкой.
+ */
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace paygo::common {
+
+/** Способ оплаты */
+enum class PaymentMethod {
+	NFC,
+	QR_CODE,
+	BIOMETRIC,
+	CARD_INSERT,
+};
+
+/** Состояние транзакции */
+enum class TransactionStatus {
+	PENDING,
+	COMPLETED,
+	FAILED,
+	CANCELLED,
+	REFUNDED,
+};
+
+inline std::string_view ToString(PaymentMethod method) {
+	switch(method) {
+		case PaymentMethod::NFC:
+			return "nfc";
+		case PaymentMethod::QR_CODE:
+			return "qr_code";
+		case PaymentMethod::BIOMETRIC:
+			return "biometric";
+		case PaymentMethod::CARD_INSERT:
+			return "card_insert";
+	}
+	return "nfc";
+}
+
+inline std::string_view ToString(TransactionStatus status) {
+	switch(status) {
+		case TransactionStatus::PENDING:
+			return "pending";
+		case TransactionStatus::COMPLETED:
+			return "completed";
+		case TransactionStatus::FAILED:
+			return "failed";
+		case TransactionStatus::CANCELLED:
+			return "cancelled";
+		case TransactionStatus::REFUNDED:
+			return "refunded";
+	}
+	return "pending";
+}
+
+inline std::optional<PaymentMethod> ParsePaymentMethod(std::string_view text) {
+	for(PaymentMethod method : {PaymentMethod::NFC, PaymentMethod::QR_CODE, PaymentMethod::BIOMETRIC, PaymentMethod::CARD_INSERT}) {
+		if(ToString(method) == text) {
+			return method;
+		}
+	}
+	return std::nullopt;
+}
+
+inline std::optional<TransactionStatus> ParseTransactionStatus(std::string_view text) {
+	for(TransactionStatus status : {TransactionStatus::PENDING, TransactionStatus::COMPLETED, TransactionStatus::FAILED,
+											  TransactionStatus::CANCELLED, TransactionStatus::REFUNDED}) {
+		if(ToString(status) == text) {
+			return status;
+		}
+	}
+	return std::nullopt;
+}
+
+/**
+ * ПЛАТЁЖНАЯ ТРАНЗАКЦИЯ
+ *
+ * reference - уникальный номер, который терминал присваивает транзакции
+ * при создании; по нему повторная запись той же транзакции распознаётся
+ * как дубликат (и в локальной базе, и на сервере).
+ */
+struct Transaction {
+	int64_t id = 0;                      // локальный номер (0 - ещё не сохранена)
+	std::string reference;               // уникальный номер транзакции терминала
+	std::string terminal_id;
+	int64_t amount = 0;                  // сумма в копейках
+	std::string currency = "RUB";
+	PaymentMethod method = PaymentMethod::NFC;
+	TransactionStatus status = TransactionStatus::PENDING;
+	std::string card_token;              // токен карты (не номер!)
+	std::string description;
+	int64_t created_at = 0;              // миллисекунды с начала эпохи Unix
+};
+}
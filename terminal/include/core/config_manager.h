@@ -0,0 +1,216 @@
+#pragma once
+
+/*
+ * КОНФИГУРАЦИЯ ТЕРМИНАЛА С ГОРЯЧЕЙ ПЕРЕЗАГРУЗКОЙ
+ *
+ * config/terminal_config.json разбирается один раз в неизменяемый
+ * типизированный снимок ConfigSnapshot. Платежи читают настройки из
+ * снимка - без разбора JSON и без блокировок.
+ *
+ * ПУБЛИКАЦИЯ СНИМКА:
+ * Текущий снимок хранится в shared_ptr, который заменяется атомарно
+ * (std::atomic_store). Новый снимок собирается полностью и только потом
+ * публикуется: читатель видит либо старую, либо новую конфигурацию
+ * целиком. Транзакция, взявшая снимок, работает с ним до конца, даже если
+ * за это время конфигурация перезагружена - старый снимок освобождается,
+ * когда его отпустит последний читатель.
+ *
+ * ЧТЕНИЕ БЕЗ БЛОКИРОВОК:
+ * std::atomic_load для shared_ptr в libstdc++ берёт спин-блокировку.
+ * Поэтому Current() сначала сравнивает номер поколения (атомарное
+ * чтение) с кэшем потока и, если конфигурация не менялась, возвращает
+ * закэшированный указатель (только атомарное увеличение счётчика ссылок).
+ * atomic_load выполняется один раз на поток после каждой перезагрузки.
+ *
+ * НАБЛЮДЕНИЕ ЗА ФАЙЛОМ:
+ * Поток наблюдения подписан через inotify на каталог файла (редакторы и
+ * системы развёртывания заменяют файл переименованием). После серии
+ * событий и паузы debounce файл читается заново. Ошибка разбора
+ * записывается в журнал, а в работе остаётся прежний снимок.
+ */
+
+#include "common/types.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace paygo::core {
+
+/** Ошибка чтения или проверки конфигурации */
+class ConfigError : public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+// === СНИМОК КОНФИГУРАЦИИ ===
+
+struct DeviceConfig {
+	bool enabled = false;
+	std::string device;               // /dev/ttyUSB0, /dev/video0
+};
+
+struct HardwareConfig {
+	std::string platform;
+	std::string display_resolution;
+	bool touchscreen = false;
+	DeviceConfig nfc_reader;
+	DeviceConfig camera;
+	std::string camera_resolution;
+	DeviceConfig fingerprint_scanner;
+	bool fiscal_registrator = false;
+	std::string fiscal_model;
+	std::string fiscal_connection;
+};
+
+struct BankConfig {
+	std::string name;                 // ключ в payment.banks.acquiring ("vtb") или "sbp"
+	bool enabled = false;
+	std::string merchant_id;
+	std::string api_endpoint;
+};
+
+/** Суммы - в копейках (в файле - в рублях) */
+struct LimitsConfig {
+	int64_t min_amount = 0;
+	int64_t max_amount = 0;
+	int64_t daily_limit = 0;
+};
+
+struct PaymentConfig {
+	std::vector<std::string> supported_methods;     // как в файле: nfc_card, qr_code, biometry_face...
+	std::vector<BankConfig> acquiring;
+	BankConfig sbp;
+	LimitsConfig limits;
+
+	/** Разрешён ли способ оплаты (nfc_card и nfc_phone - NFC, biometry_* - BIOMETRIC) */
+	bool Supports(common::PaymentMethod method) const;
+
+	/** Банк-эквайер по имени; nullptr - нет такого */
+	const BankConfig *FindBank(std::string_view name) const;
+
+	bool WithinLimits(int64_t amount) const {
+		return amount >= limits.min_amount && amount <= limits.max_amount;
+	}
+};
+
+struct SecurityConfig {
+	std::string encryption_algorithm;
+	int key_rotation_days = 0;
+	double face_confidence_threshold = 0;
+	bool liveness_detection = false;
+	int fingerprint_quality_threshold = 0;
+	int fingerprint_matching_threshold = 0;
+	std::chrono::seconds session_timeout{0};
+	int max_attempts = 0;
+};
+
+struct NetworkConfig {
+	std::string api_url;
+	std::chrono::seconds api_timeout{0};
+	int retry_attempts = 0;
+	bool offline_enabled = false;
+	size_t offline_max_transactions = 0;
+	std::chrono::minutes sync_interval{0};
+	std::chrono::seconds heartbeat_interval{0};
+	std::string log_level;
+};
+
+struct UiConfig {
+	std::string language;
+	std::string theme;
+	std::chrono::seconds idle_timeout{0};
+	std::chrono::seconds transaction_timeout{0};
+	bool sounds_enabled = false;
+	double volume = 0;
+};
+
+struct StorageConfig {
+	std::string database_path;
+	std::chrono::hours backup_interval{0};
+	std::string log_level;
+	std::string log_file;
+	size_t log_max_size_mb = 0;
+	int log_backup_count = 0;
+};
+
+struct ConfigSnapshot {
+	uint64_t generation = 0;          // номер загрузки, начиная с 1
+	std::string terminal_id;
+	std::string location;
+	std::string version;
+	HardwareConfig hardware;
+	PaymentConfig payment;
+	SecurityConfig security;
+	NetworkConfig network;
+	UiConfig ui;
+	StorageConfig storage;            // разделы database и logging
+};
+
+/** Разбирает и проверяет JSON конфигурации; ошибка - ConfigError с путём к полю */
+ConfigSnapshot ParseConfig(std::string_view json);
+
+// === МЕНЕДЖЕР ===
+
+struct ConfigManagerSettings {
+	std::string path = "/etc/paygo/terminal_config.json";
+	bool watch = true;                                   // следить за файлом через inotify
+	std::chrono::milliseconds debounce{200};             // тишина после последнего события перед перечитыванием
+};
+
+class ConfigManager {
+public:
+	/** Загружает файл; ошибка чтения или разбора - ConfigError */
+	explicit ConfigManager(const ConfigManagerSettings &settings);
+
+	/** Останавливает поток наблюдения */
+	~ConfigManager();
+
+	ConfigManager(const ConfigManager &) = delete;
+	ConfigManager &operator=(const ConfigManager &) = delete;
+
+	/**
+	 * Текущий снимок. Без блокировок, пока конфигурация не перезагружена;
+	 * снимок остаётся действительным, пока жив возвращённый указатель
+	 */
+	std::shared_ptr<const ConfigSnapshot> Current() const;
+
+	/** Номер поколения текущего снимка */
+	uint64_t Generation() const {
+		return generation_.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * Перечитывает файл и публикует новый снимок, если содержимое изменилось.
+	 * Ошибка записывается в журнал, прежний снимок остаётся.
+	 * @return true - опубликован новый снимок
+	 */
+	bool Reload();
+
+private:
+	/** Читает и разбирает файл; nullptr - содержимое не изменилось */
+	std::shared_ptr<ConfigSnapshot> Load();
+	void Publish(std::shared_ptr<ConfigSnapshot> snapshot);
+	void Watch();
+
+	ConfigManagerSettings settings_;
+	const uint64_t instance_;                     // различает менеджеры в кэше потоков
+
+	std::shared_ptr<const ConfigSnapshot> snapshot_;   // только через std::atomic_load/atomic_store
+	std::atomic<uint64_t> generation_{0};
+
+	std::mutex reload_mutex_;                     // одна перезагрузка одновременно
+	std::string loaded_text_;
+
+	int inotify_fd_ = -1;
+	int wake_fd_ = -1;                            // eventfd остановки потока наблюдения
+	std::thread watcher_;
+};
+}
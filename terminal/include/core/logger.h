@@ -0,0 +1,360 @@
+#pragma once
+
+/*
+ * АСИНХРОННЫЙ ЖУРНАЛ ТЕРМИНАЛА
+ *
+ * Синхронная запись журнала на платёжном пути добавляет миллисекунды
+ * задержки (запись на SD-карту Raspberry Pi). Здесь поток, пишущий журнал,
+ * только копирует двоичную запись в память, а форматирование и запись
+ * в файл выполняет фоновый поток.
+ *
+ * УСТРОЙСТВО:
+ * 1. Каждое место вызова PAYGO_LOG - статический LogSite (уровень, формат,
+ *    файл, строка); в запись попадает только указатель на него
+ * 2. Аргументы кодируются в двоичном виде (числа - как есть, строки -
+ *    длина и байты) прямо в кольцевой буфер потока
+ * 3. У каждого потока свой кольцевой буфер с одним писателем и одним
+ *    читателем (SPSC) - без блокировок и без общих атомарных счётчиков
+ * 4. Фоновый поток обходит буферы, форматирует записи ("{}" заменяются
+ *    аргументами) и пишет их в файл крупными блоками
+ * 5. Если буфер потока полон, запись отбрасывается и учитывается в счётчике;
+ *    в журнал попадает строка о числе потерянных записей
+ * 6. Файл ротируется при достижении max_file_bytes: terminal.log →
+ *    terminal.log.1 → ... → terminal.log.<backup_count>; размер проверяется
+ *    после записи блока, поэтому файл может превысить порог на один блок
+ *
+ * ИСПОЛЬЗОВАНИЕ:
+ *   core::Logger logger(settings);
+ *   core::Logger::SetDefault(&logger);
+ *   PAYGO_LOG(core::LogLevel::INFO, "payment {} approved in {} ms", reference, elapsed);
+ *
+ * Строковые аргументы копируются, указатели на них хранить не нужно.
+ * Строку формата нужно передавать литералом - она не копируется.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace paygo::core {
+
+/** Уровни совпадают с terminal_logs.level на сервере */
+enum class LogLevel : uint8_t {
+	DEBUG,
+	INFO,
+	WARNING,
+	ERROR,
+};
+
+/** Место вызова журнала; создаётся макросом PAYGO_LOG как статический объект */
+struct LogSite {
+	LogLevel level;
+	const char *format;
+	const char *file;
+	int line;
+};
+
+struct LoggerSettings {
+	std::string path = "/var/log/paygo/terminal.log";
+	LogLevel level = LogLevel::INFO;
+	size_t ring_bytes = 64 << 10;                  // буфер на поток (степень двойки)
+	size_t max_file_bytes = 100 << 20;             // logging.max_size_mb
+	size_t backup_count = 5;                       // logging.backup_count
+	std::chrono::milliseconds flush_interval{5};   // пауза фонового потока, если записей нет
+};
+
+struct LoggerStats {
+	uint64_t written = 0;     // записей выведено в файл
+	uint64_t dropped = 0;     // записей потеряно из-за переполнения буферов
+	uint64_t rotations = 0;
+};
+
+namespace detail {
+
+/** Коды типов аргументов в двоичной записи */
+enum class ArgType : uint8_t {
+	INT,
+	UINT,
+	DOUBLE,
+	BOOL,
+	CHAR,
+	STRING,
+	POINTER,
+};
+
+/**
+ * КОЛЬЦЕВОЙ БУФЕР ПОТОКА (SPSC)
+ *
+ * Записи переменной длины лежат в буфере непрерывно; если запись не
+ * помещается до конца буфера, остаток заполняется записью-заглушкой
+ * и запись начинается с начала буфера.
+ *
+ * head_ двигает только фоновый поток, tail_ - только поток-владелец;
+ * счётчики на разных строках кэша, чтобы не мешать друг другу.
+ */
+class Ring {
+public:
+	explicit Ring(size_t capacity);
+
+	/** Место под запись из size байт или nullptr, если буфер полон (вызывает владелец) */
+	char *Reserve(size_t size);
+
+	/** Публикует запись, место под которую получено Reserve (вместе с заглушкой перед ней) */
+	void Commit(size_t size) {
+		tail_.store(tail_.load(std::memory_order_relaxed) + padding_ + size, std::memory_order_release);
+	}
+
+	void CountDrop() {
+		dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	uint64_t Dropped() const {
+		return dropped_.load(std::memory_order_relaxed);
+	}
+
+	/** Вызывает consume(data, size) для каждой опубликованной записи (вызывает фоновый поток) */
+	template <typename Consume>
+	size_t Drain(Consume &&consume);
+
+	/** Служебная запись-заглушка до конца буфера */
+	static constexpr uint32_t PADDING = 0xFFFFFFFFu;
+
+private:
+	size_t Offset(uint64_t position) const {
+		return static_cast<size_t>(position & (capacity_ - 1));
+	}
+
+	size_t capacity_;
+	std::unique_ptr<char[]> data_;
+
+	alignas(64) std::atomic<uint64_t> tail_{0};
+	uint64_t cached_head_ = 0;                      // последнее прочитанное владельцем значение head_
+	size_t padding_ = 0;                            // заглушка перед последней зарезервированной записью
+	std::atomic<uint64_t> dropped_{0};
+
+	alignas(64) std::atomic<uint64_t> head_{0};
+};
+
+/** Заголовок записи в кольцевом буфере */
+struct RecordHeader {
+	uint32_t size;         // полный размер записи с заголовком (кратен 8) или Ring::PADDING
+	uint32_t arg_count;
+	const LogSite *site;
+	int64_t timestamp_ns;  // системное время, нс с начала эпохи Unix
+};
+
+// === КОДИРОВАНИЕ АРГУМЕНТОВ ===
+
+template <typename T>
+size_t EncodedSize(const T &value) {
+	using Type = std::decay_t<T>;
+	if constexpr(std::is_array_v<T>) {
+		return 1 + sizeof(uint32_t) + std::strlen(value);  // строковый литерал
+	} else if constexpr(std::is_same_v<Type, std::string> || std::is_same_v<Type, std::string_view>) {
+		return 1 + sizeof(uint32_t) + value.size();
+	} else if constexpr(std::is_same_v<Type, const char *> || std::is_same_v<Type, char *>) {
+		return 1 + sizeof(uint32_t) + (value ? std::strlen(value) : 0);
+	} else if constexpr(std::is_same_v<Type, bool> || std::is_same_v<Type, char>) {
+		return 2;
+	} else {
+		static_assert(std::is_arithmetic_v<Type> || std::is_pointer_v<Type> || std::is_enum_v<Type>,
+						  "PAYGO_LOG: unsupported argument type");
+		return 1 + 8;
+	}
+}
+
+inline char *Put(char *out, const void *data, size_t size) {
+	std::memcpy(out, data, size);
+	return out + size;
+}
+
+inline char *EncodeString(char *out, std::string_view text) {
+	*out++ = static_cast<char>(ArgType::STRING);
+	const uint32_t size = static_cast<uint32_t>(text.size());
+	out = Put(out, &size, sizeof(size));
+	return Put(out, text.data(), text.size());
+}
+
+template <typename T>
+char *Encode(char *out, const T &value) {
+	using Type = std::decay_t<T>;
+	if constexpr(std::is_array_v<T>) {
+		return EncodeString(out, value);
+	} else if constexpr(std::is_same_v<Type, std::string> || std::is_same_v<Type, std::string_view>) {
+		return EncodeString(out, value);
+	} else if constexpr(std::is_same_v<Type, const char *> || std::is_same_v<Type, char *>) {
+		return EncodeString(out, value ? std::string_view(value) : std::string_view{});
+	} else if constexpr(std::is_same_v<Type, bool>) {
+		*out++ = static_cast<char>(ArgType::BOOL);
+		*out++ = value ? 1 : 0;
+		return out;
+	} else if constexpr(std::is_same_v<Type, char>) {
+		*out++ = static_cast<char>(ArgType::CHAR);
+		*out++ = value;
+		return out;
+	} else if constexpr(std::is_floating_point_v<Type>) {
+		*out++ = static_cast<char>(ArgType::DOUBLE);
+		const double number = static_cast<double>(value);
+		return Put(out, &number, 8);
+	} else if constexpr(std::is_pointer_v<Type>) {
+		*out++ = static_cast<char>(ArgType::POINTER);
+		const uint64_t number = reinterpret_cast<uintptr_t>(value);
+		return Put(out, &number, 8);
+	} else if constexpr(std::is_enum_v<Type>) {
+		*out++ = static_cast<char>(ArgType::INT);
+		const int64_t number = static_cast<int64_t>(value);
+		return Put(out, &number, 8);
+	} else if constexpr(std::is_signed_v<Type>) {
+		*out++ = static_cast<char>(ArgType::INT);
+		const int64_t number = value;
+		return Put(out, &number, 8);
+	} else {
+		*out++ = static_cast<char>(ArgType::UINT);
+		const uint64_t number = value;
+		return Put(out, &number, 8);
+	}
+}
+
+int64_t NowNs();
+}
+
+class Logger {
+public:
+	explicit Logger(const LoggerSettings &settings);
+
+	/** Выводит все накопленные записи и останавливает фоновый поток */
+	~Logger();
+
+	Logger(const Logger &) = delete;
+	Logger &operator=(const Logger &) = delete;
+
+	/** Журнал, в который пишет PAYGO_LOG (nullptr - журнал отключён) */
+	static void SetDefault(Logger *logger);
+	static Logger *Default() {
+		return default_logger_.load(std::memory_order_acquire);
+	}
+
+	bool Enabled(LogLevel level) const {
+		return level >= level_.load(std::memory_order_relaxed);
+	}
+
+	void SetLevel(LogLevel level) {
+		level_.store(level, std::memory_order_relaxed);
+	}
+
+	/** Помещает запись в буфер текущего потока; без блокировок и системных вызовов */
+	template <typename... Args>
+	void Log(const LogSite &site, const Args &...args);
+
+	/** Ждёт, пока все записи, сделанные до вызова, окажутся в файле */
+	void Flush();
+
+	LoggerStats GetStats() const;
+
+private:
+	detail::Ring &ThreadRing();
+	void WriterLoop();
+	bool DrainAll();
+	void Format(const detail::RecordHeader &header, const char *args);
+	void AppendTimestamp(int64_t timestamp_ns);
+	void WriteOut();
+	void Rotate();
+	void OpenFile();
+
+	static std::atomic<Logger *> default_logger_;
+
+	const uint64_t id_;                 // отличает экземпляры в кэше потока
+	LoggerSettings settings_;
+	std::atomic<LogLevel> level_;
+
+	std::mutex rings_mutex_;
+	std::vector<std::shared_ptr<detail::Ring>> rings_;
+	std::vector<uint64_t> reported_drops_;   // сколько потерь уже отражено в журнале, по буферам
+
+	// Состояние фонового потока
+	int fd_ = -1;
+	size_t file_bytes_ = 0;
+	std::string out_;
+	int64_t cached_second_ = -1;
+	std::string cached_prefix_;
+
+	std::mutex wake_mutex_;
+	std::condition_variable wake_;
+	std::condition_variable flushed_;
+	uint64_t flush_requested_ = 0;
+	uint64_t flush_done_ = 0;
+	bool stop_ = false;
+
+	std::atomic<uint64_t> written_{0};
+	std::atomic<uint64_t> dropped_{0};
+	std::atomic<uint64_t> rotations_{0};
+
+	std::thread writer_;
+};
+
+template <typename Consume>
+size_t detail::Ring::Drain(Consume &&consume) {
+	const uint64_t tail = tail_.load(std::memory_order_acquire);
+	uint64_t head = head_.load(std::memory_order_relaxed);
+	size_t count = 0;
+
+	while(head < tail) {
+		const char *record = data_.get() + Offset(head);
+		uint32_t size;
+		std::memcpy(&size, record, sizeof(size));
+		if(size == PADDING) {
+			head += capacity_ - Offset(head);
+			continue;
+		}
+		consume(record, size);
+		head += size;
+		++count;
+	}
+
+	head_.store(head, std::memory_order_release);
+	return count;
+}
+
+template <typename... Args>
+void Logger::Log(const LogSite &site, const Args &...args) {
+	constexpr size_t HEADER = sizeof(detail::RecordHeader);
+	const size_t payload = (size_t{0} + ... + detail::EncodedSize(args));
+	const size_t size = (HEADER + payload + 7) & ~size_t{7};
+
+	detail::Ring &ring = ThreadRing();
+	char *out = ring.Reserve(size);
+	if(!out) {
+		ring.CountDrop();
+		return;
+	}
+
+	detail::RecordHeader header{static_cast<uint32_t>(size), static_cast<uint32_t>(sizeof...(Args)), &site, detail::NowNs()};
+	std::memcpy(out, &header, HEADER);
+	[[maybe_unused]] char *cursor = out + HEADER;  // без аргументов не используется
+	((cursor = detail::Encode(cursor, args)), ...);
+	ring.Commit(size);
+}
+}
+
+/**
+ * Запись в журнал по умолчанию. Аргументы не вычисляются, если уровень отключён.
+ * PAYGO_LOG(paygo::core::LogLevel::INFO, "terminal {} started", terminal_id);
+ */
+#define PAYGO_LOG(level, format, ...)                                                              \
+	do {                                                                                            \
+		static constexpr ::paygo::core::LogSite paygo_log_site{(level), (format), __FILE__, __LINE__}; \
+		::paygo::core::Logger *paygo_logger = ::paygo::core::Logger::Default();                     \
+		if(paygo_logger && paygo_logger->Enabled(level)) {                                           \
+			paygo_logger->Log(paygo_log_site, ##__VA_ARGS__);                                         \
+		}                                                                                           \
+	} while(false)
@@ -0,0 +1,155 @@
+#pragma once
+
+/*
+ * ОЧЕРЕДЬ ПЛАТЕЖЕЙ ДЛЯ РАБОТЫ БЕЗ СЕТИ (STORE-AND-FORWARD)
+ *
+ * Пока нет связи с сервером, принятые терминалом платежи записываются
+ * в локальную очередь и отправляются, когда связь восстановится
+ * (OfflineForwarder в payment_processor.h).
+ *
+ * ФОРМАТ НА ДИСКЕ:
+ * Каталог с файлами-сегментами offline-<номер>.seg, в которые только
+ * дописываются записи:
+ *   u32 size | u32 crc32 | u8 type | u64 sequence | payload[size]
+ * - ENTRY - платёж (payload - транзакция в двоичном виде)
+ * - ACK   - платёж с номером sequence доставлен (payload пуст)
+ * CRC32 считается по type, sequence и payload. При запуске сегменты
+ * читаются по порядку; платежи без ACK снова попадают в очередь.
+ * Запись с неверной CRC пропускается; оборванная запись (сбой питания
+ * во время записи) завершает чтение сегмента. Последний сегмент обрезается
+ * по последней целой записи.
+ *
+ * Если запись пачки не удалась (диск полон, ошибка ввода-вывода), её future
+ * получают ошибку, а недописанный хвост отрезается до записи следующей
+ * пачки; если обрезать нельзя, запись продолжается в новом сегменте.
+ *
+ * ГРУППОВАЯ ЗАПИСЬ (как в TransactionStorage):
+ * Enqueue только кодирует запись в буфер; поток записи дописывает
+ * накопленный буфер в сегмент и делает один fdatasync на всю пачку.
+ * future выполняется после fdatasync - платёж не потеряется при сбое.
+ * ACK не ждут fdatasync: потерянный ACK означает только повторную
+ * отправку, которую сервер распознаёт по ключу идемпотентности.
+ *
+ * Сегмент закрывается при достижении segment_bytes; старые сегменты,
+ * в которых не осталось недоставленных платежей, удаляются с начала
+ * (ACK в новых сегментах ссылаются только на более старые записи).
+ */
+
+#include "common/types.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace paygo::core {
+
+/** Ошибка очереди: ввод-вывод или переполнение */
+class OfflineQueueError : public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+struct OfflineQueueSettings {
+	std::string directory = "/var/lib/paygo/offline";
+	size_t max_pending = 1000;                     // network.offline_mode.max_transactions
+	size_t segment_bytes = 4 << 20;
+	std::chrono::microseconds max_delay{1000};     // ожидание добора пачки под нагрузкой
+};
+
+struct OfflineQueueStats {
+	size_t pending = 0;           // недоставленных платежей (записанных на диск)
+	uint64_t enqueued = 0;
+	uint64_t acknowledged = 0;
+	uint64_t syncs = 0;           // выполнено fdatasync
+	uint64_t recovered = 0;       // платежей, восстановленных при запуске
+	uint64_t corrupted = 0;       // записей с неверной CRC или оборванных при запуске
+	size_t segments = 0;
+};
+
+/** Платёж в очереди */
+struct OfflineEntry {
+	uint64_t sequence = 0;
+	common::Transaction transaction;
+};
+
+class OfflineQueue {
+public:
+	/** Создаёт каталог при необходимости и восстанавливает недоставленные платежи */
+	explicit OfflineQueue(const OfflineQueueSettings &settings);
+
+	/** Дописывает накопленные записи и останавливает поток записи */
+	~OfflineQueue();
+
+	OfflineQueue(const OfflineQueue &) = delete;
+	OfflineQueue &operator=(const OfflineQueue &) = delete;
+
+	/**
+	 * Ставит платёж в очередь; не ждёт диска.
+	 * @return future с номером платежа в очереди; готов после fdatasync.
+	 *         Очередь переполнена - OfflineQueueError сразу
+	 */
+	std::future<uint64_t> Enqueue(common::Transaction transaction);
+
+	/** До limit самых старых недоставленных платежей (записанных на диск) */
+	std::vector<OfflineEntry> Peek(size_t limit) const;
+
+	/** Отмечает платежи доставленными; неизвестные номера пропускаются */
+	void Acknowledge(const std::vector<uint64_t> &sequences);
+
+	/** Ждёт появления недоставленных платежей; false - по таймауту или при остановке */
+	bool WaitPending(std::chrono::milliseconds timeout) const;
+
+	OfflineQueueStats GetStats() const;
+
+private:
+	struct PendingEntry {
+		common::Transaction transaction;
+		uint64_t segment;
+	};
+
+	struct Segment {
+		uint64_t number;
+		size_t live = 0;              // недоставленных платежей в сегменте
+	};
+
+	void Recover();
+	uint64_t ReadSegment(uint64_t number, bool last);
+	void OpenSegment(uint64_t number);
+	void WriterLoop();
+	void WriteBatch(std::string &data);
+	void RepairSegment();
+	std::string SegmentPath(uint64_t number) const;
+
+	OfflineQueueSettings settings_;
+
+	mutable std::mutex mutex_;
+	std::condition_variable has_work_;
+	mutable std::condition_variable has_pending_;
+
+	// Под mutex_
+	std::string buffer_;                                   // закодированные, но не записанные записи
+	std::vector<std::pair<uint64_t, common::Transaction>> buffered_entries_;
+	std::vector<std::promise<uint64_t>> buffered_promises_;
+	std::map<uint64_t, PendingEntry> pending_;             // записанные на диск, по номеру
+	std::deque<Segment> segments_;                         // последний - текущий
+	uint64_t next_sequence_ = 1;
+	bool stop_ = false;
+	OfflineQueueStats stats_;
+
+	// Только поток записи (и конструктор до его запуска)
+	int fd_ = -1;
+	size_t segment_size_ = 0;                              // до конца последней записанной пачки
+	bool torn_ = false;                                    // после segment_size_ остались байты неудачной пачки
+
+	std::thread writer_;
+};
+}
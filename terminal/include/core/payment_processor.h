@@ -0,0 +1,157 @@
+#pragma once
+
+/*
+ * ПРОВЕДЕНИЕ ПЛАТЕЖЕЙ С РАБОТОЙ БЕЗ СЕТИ
+ *
+ * PaymentProcessor отправляет платёж на сервер PayGo (network.api_server),
+ * а если сервер недоступен - принимает платёж в офлайн-очередь
+ * (OfflineQueue), чтобы не задерживать покупателя на кассе.
+ * OfflineForwarder в фоне отправляет накопленные платежи, когда связь
+ * восстановится.
+ *
+ * ИДЕМПОТЕНТНОСТЬ:
+ * Каждый запрос несёт заголовок Idempotency-Key = reference транзакции.
+ * Сервер выполняет платёж с данным ключом один раз; повтор (после
+ * таймаута, потерянного ответа, перезапуска терминала) получает тот же
+ * результат (или 409 Conflict) и не списывает деньги второй раз.
+ *
+ * БЕЗ СЕТИ:
+ * После сетевой ошибки PaymentProcessor на offline_probe_interval считает
+ * сервер недоступным и сразу ставит платежи в очередь, не дожидаясь
+ * таймаута соединения на каждой покупке. Успешная отправка из очереди
+ * возвращает его в обычный режим раньше.
+ */
+
+#include "common/types.h"
+#include "core/offline_queue.h"
+#include "network/api_client.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace paygo::core {
+
+struct PaymentSettings {
+	std::string endpoint = "paygo";                              // EndpointSettings::name сервера PayGo
+	std::string path = "/api/v1/transactions";
+	bool offline_enabled = true;                                 // network.offline_mode.enabled
+	int64_t offline_max_amount = 1000000;                        // предел суммы без сети, копейки
+	std::chrono::milliseconds offline_probe_interval{30000};     // без попыток связи после ошибки
+};
+
+enum class PaymentOutcome {
+	APPROVED,         // сервер подтвердил платёж
+	DECLINED,         // сервер отклонил платёж (4xx)
+	QUEUED_OFFLINE,   // сервер недоступен, платёж записан в офлайн-очередь
+	FAILED,           // сервер недоступен, а в очередь платёж принять нельзя
+};
+
+struct PaymentResult {
+	PaymentOutcome outcome = PaymentOutcome::FAILED;
+	long http_status = 0;
+	std::string response;                // тело ответа сервера или текст ошибки
+};
+
+/** Тело запроса к серверу: транзакция в JSON */
+std::string ToJson(const common::Transaction &transaction);
+
+/** 2xx, а также 409 - платёж с этим ключом идемпотентности уже проведён */
+inline bool IsDelivered(long http_status) {
+	return (http_status >= 200 && http_status < 300) || http_status == 409;
+}
+
+/** 5xx, 408 и 429 - ответ временный, платёж нужно отправить позже */
+inline bool IsRetryable(long http_status) {
+	return http_status >= 500 || http_status == 408 || http_status == 429;
+}
+
+class PaymentProcessor {
+public:
+	/** client и queue должны пережить обработчик */
+	PaymentProcessor(const PaymentSettings &settings, network::ApiClient &client, OfflineQueue &queue);
+
+	/**
+	 * Проводит платёж. Без сети ставит его в офлайн-очередь и ждёт только
+	 * записи на диск (единицы миллисекунд), если это разрешено настройками
+	 */
+	PaymentResult Process(const common::Transaction &transaction);
+
+	/** Сервер снова доступен (вызывает OfflineForwarder после успешной отправки) */
+	void MarkOnline();
+
+	bool Online() const;
+
+private:
+	PaymentResult QueueOffline(const common::Transaction &transaction, std::string reason);
+
+	PaymentSettings settings_;
+	network::ApiClient &client_;
+	OfflineQueue &queue_;
+	std::atomic<int64_t> offline_until_{0};   // steady_clock, мс; до этого момента сервер не опрашивается
+};
+
+struct ForwarderSettings {
+	std::string endpoint = "paygo";
+	std::string path = "/api/v1/transactions";
+	size_t batch_size = 32;                                   // платежей, отправляемых одновременно
+	std::chrono::milliseconds initial_backoff{1000};
+	std::chrono::milliseconds max_backoff{std::chrono::minutes(5)};
+	std::chrono::milliseconds idle_poll{1000};                // проверка остановки, пока очередь пуста
+};
+
+struct ForwarderStats {
+	uint64_t delivered = 0;      // подтверждено сервером (в том числе повторы - 409)
+	uint64_t rejected = 0;       // отклонено сервером окончательно (4xx)
+	uint64_t retries = 0;        // пачек, отложенных из-за ошибки сети или 5xx
+	uint64_t batches = 0;
+};
+
+/**
+ * ОТПРАВКА ОФЛАЙН-ОЧЕРЕДИ
+ *
+ * Фоновый поток берёт из очереди до batch_size самых старых платежей и
+ * отправляет их одновременно (ApiClient держит соединения открытыми).
+ * Доставленные и окончательно отклонённые платежи подтверждаются в очереди.
+ * Если хоть один платёж пачки не доставлен из-за сети или 5xx, следующая
+ * попытка откладывается: пауза удваивается от initial_backoff до
+ * max_backoff со случайным разбросом ±25% (терминалы не идут на сервер
+ * одновременно после сбоя); после успешной пачки пауза сбрасывается.
+ */
+class OfflineForwarder {
+public:
+	/** queue, client и processor (если задан) должны пережить отправителя */
+	OfflineForwarder(const ForwarderSettings &settings, OfflineQueue &queue, network::ApiClient &client,
+						  PaymentProcessor *processor = nullptr);
+
+	/** Дожидается текущей пачки и останавливает поток */
+	~OfflineForwarder();
+
+	OfflineForwarder(const OfflineForwarder &) = delete;
+	OfflineForwarder &operator=(const OfflineForwarder &) = delete;
+
+	ForwarderStats GetStats() const;
+
+private:
+	void Loop();
+
+	/** Отправляет пачку; true - все платежи доставлены или окончательно отклонены */
+	bool ForwardBatch();
+
+	ForwarderSettings settings_;
+	OfflineQueue &queue_;
+	network::ApiClient &client_;
+	PaymentProcessor *processor_;
+
+	mutable std::mutex mutex_;
+	std::condition_variable stop_signal_;
+	bool stop_ = false;
+	ForwarderStats stats_;
+
+	std::thread thread_;
+};
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+/*
+ * КЭШ ТЕРМИНАЛА В ПАМЯТИ
+ *
+ * Хранит часто читаемые при авторизации данные - токены карт, конфигурацию
+ * терминала, данные мерчантов - чтобы горячие чтения не обращались к диску.
+ *
+ * УСТРОЙСТВО:
+ * 1. Кэш разбит на shards частей по хешу ключа; у каждой части свой mutex,
+ *    поэтому потоки, читающие разные ключи, почти не мешают друг другу
+ * 2. Внутри части - хеш-таблица и список LRU: поиск, продвижение в начало
+ *    и вытеснение с конца - O(1)
+ * 3. У записи есть срок жизни (TTL); просроченная запись не возвращается
+ *    и удаляется при обращении или при вытеснении
+ * 4. Объём ограничен в байтах (ключ + значение + служебные расходы);
+ *    бюджет делится между частями поровну
+ * 5. Промах может быть дочитан загрузчиком (read-through) - обычно это
+ *    SqliteCacheStore, постоянное хранилище в локальной базе. Загрузчик
+ *    работает без блокировки; если за это время ключ части записали или
+ *    удалили (Put, Erase, Clear), загруженное значение не кэшируется
+ *
+ * СЧЁТЧИКИ: попадания, промахи, загрузки, вытеснения, истечения срока.
+ */
+
+#include "database/sqlite_manager.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace paygo::database {
+
+struct CacheSettings {
+	size_t shards = 16;
+	size_t max_bytes = 16 << 20;
+	std::chrono::milliseconds default_ttl{std::chrono::minutes(10)};  // 0 - без ограничения срока
+};
+
+struct CacheStats {
+	uint64_t hits = 0;
+	uint64_t misses = 0;         // промахи памяти (в том числе дочитанные загрузчиком)
+	uint64_t loads = 0;          // значений, найденных загрузчиком
+	uint64_t evictions = 0;      // вытеснено ради места
+	uint64_t expirations = 0;    // удалено по истечении срока
+	size_t entries = 0;
+	size_t bytes = 0;
+};
+
+/** Значение, найденное загрузчиком; ttl не задан - используется default_ttl */
+struct LoadedValue {
+	std::string value;
+	std::optional<std::chrono::milliseconds> ttl;
+};
+
+/** Загрузчик для промахов; вызывается без блокировок кэша */
+using CacheLoader = std::function<std::optional<LoadedValue>(std::string_view key)>;
+
+class CacheManager {
+public:
+	explicit CacheManager(const CacheSettings &settings, CacheLoader loader = {});
+
+	/**
+	 * Значение по ключу: из памяти, а при промахе - из загрузчика.
+	 * Одновременные промахи по одному ключу могут вызвать загрузчик несколько раз.
+	 * Значение, записанное Put во время загрузки, не затирается: оно и возвращается.
+	 */
+	std::optional<std::string> Get(std::string_view key);
+
+	/** Значение только из памяти, без загрузчика */
+	std::optional<std::string> Peek(std::string_view key);
+
+	/** Помещает значение в память; ttl не задан - default_ttl */
+	void Put(std::string_view key, std::string value, std::optional<std::chrono::milliseconds> ttl = std::nullopt);
+
+	/** Удаляет ключ из памяти; true - ключ был */
+	bool Erase(std::string_view key);
+
+	void Clear();
+
+	/** Удаляет все просроченные записи (например, по таймеру в простое) */
+	size_t PurgeExpired();
+
+	CacheStats GetStats() const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Entry {
+		std::string key;
+		std::string value;
+		Clock::time_point expires_at;  // time_point::max() - бессрочно
+		size_t bytes;
+	};
+
+	/** Часть кэша на отдельной строке кэша процессора, чтобы mutex соседних частей не делили её */
+	struct alignas(64) Shard {
+		mutable std::mutex mutex;
+		std::list<Entry> lru;  // начало - последняя использованная запись
+		std::unordered_map<std::string_view, std::list<Entry>::iterator> index;  // ключи ссылаются на Entry::key
+		size_t bytes = 0;
+		uint64_t generation = 0;  // растёт при каждом Put, Erase и Clear части
+		CacheStats stats;
+	};
+
+	Shard &ShardFor(std::string_view key);
+	Clock::time_point ExpiresAt(std::optional<std::chrono::milliseconds> ttl) const;
+	/** Непросроченное значение из части с продвижением в LRU; под блокировкой части */
+	std::optional<std::string> Lookup(Shard &shard, std::string_view key);
+	void Insert(Shard &shard, std::string_view key, std::string value, Clock::time_point expires_at);
+	void Remove(Shard &shard, std::list<Entry>::iterator it);
+
+	CacheSettings settings_;
+	size_t shard_budget_;
+	CacheLoader loader_;
+	std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+/**
+ * ПОСТОЯННОЕ ХРАНИЛИЩЕ КЭША В SQLITE
+ *
+ * Таблица cache_entries(key, value, expires_at) в локальной базе.
+ * Срок хранится как время по системным часам (мс с начала эпохи Unix),
+ * чтобы переживать перезапуск; NULL - бессрочно.
+ * Потокобезопасно: одно соединение под mutex.
+ */
+class SqliteCacheStore {
+public:
+	explicit SqliteCacheStore(const SqliteSettings &settings);
+
+	/**
+	 * Значение и оставшийся срок; просроченное значение не возвращается.
+	 * Для бессрочной записи ttl не задан - в памяти она живёт default_ttl
+	 * и затем перечитывается
+	 */
+	std::optional<LoadedValue> Load(std::string_view key);
+
+	/** Сохраняет значение; ttl не задан - бессрочно */
+	void Save(std::string_view key, std::string_view value, std::optional<std::chrono::milliseconds> ttl = std::nullopt);
+	void Erase(std::string_view key);
+
+	/** Удаляет просроченные записи из таблицы */
+	void PurgeExpired();
+
+	/** Загрузчик для CacheManager; хранилище должно пережить кэш */
+	CacheLoader MakeLoader();
+
+private:
+	std::mutex mutex_;
+	SqliteManager db_;
+};
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+/*
+ * ДОСТУП К ЛОКАЛЬНОЙ БАЗЕ SQLITE
+ *
+ * Тонкая обёртка над C API SQLite:
+ * - SqliteManager - одно соединение с базой и кэш подготовленных запросов
+ * - Statement - подготовленный запрос (RAII над sqlite3_stmt)
+ * - DatabaseError - исключение с кодом ошибки SQLite
+ *
+ * ПРИНЦИПЫ РАБОТЫ:
+ * 1. База открывается в режиме WAL: читатели не блокируют писателя,
+ *    а фиксация транзакции - это дозапись в журнал и один fsync
+ * 2. Подготовленные запросы кэшируются по тексту SQL: разбор и планирование
+ *    запроса выполняются один раз, а не на каждую вставку
+ * 3. Соединение не потокобезопасно - у каждого потока своё соединение
+ *    (SQLite сам согласует доступ к файлу между соединениями)
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace paygo::database {
+
+/** Ошибка SQLite: текст сообщения и код результата (SQLITE_*) */
+class DatabaseError : public std::runtime_error {
+public:
+	DatabaseError(const std::string &message, int code) : std::runtime_error(message), code_(code) {}
+
+	int Code() const {
+		return code_;
+	}
+
+private:
+	int code_;
+};
+
+/**
+ * ПОДГОТОВЛЕННЫЙ ЗАПРОС
+ *
+ * Параметры нумеруются с 1, столбцы результата - с 0 (как в SQLite).
+ * После выполнения запрос нужно сбросить (Reset), чтобы использовать снова;
+ * StatementScope делает это автоматически.
+ */
+class Statement {
+public:
+	Statement(sqlite3 *db, const std::string &sql);
+	~Statement();
+
+	Statement(const Statement &) = delete;
+	Statement &operator=(const Statement &) = delete;
+
+	Statement &Bind(int index, int64_t value);
+	Statement &Bind(int index, double value);
+	Statement &Bind(int index, std::string_view value);
+	Statement &BindBlob(int index, std::string_view value);
+	Statement &BindNull(int index);
+
+	/** Выполняет шаг запроса; true - получена строка результата, false - запрос завершён */
+	bool Step();
+
+	/** Сбрасывает запрос и привязанные параметры для повторного использования */
+	void Reset();
+
+	int64_t ColumnInt64(int column) const;
+	double ColumnDouble(int column) const;
+	std::string ColumnText(int column) const;
+	std::string ColumnBlob(int column) const;
+	bool ColumnIsNull(int column) const;
+
+private:
+	sqlite3 *db_;
+	sqlite3_stmt *stmt_ = nullptr;
+};
+
+/** Сбрасывает запрос при выходе из области видимости - в том числе по исключению */
+class StatementScope {
+public:
+	explicit StatementScope(Statement &statement) : statement_(statement) {}
+
+	~StatementScope() {
+		statement_.Reset();
+	}
+
+	Statement *operator->() {
+		return &statement_;
+	}
+
+	Statement &operator*() {
+		return statement_;
+	}
+
+private:
+	Statement &statement_;
+};
+
+/** Режим синхронизации с диском (PRAGMA synchronous) */
+enum class Synchronous {
+	OFF,      // без fsync - только для тестов и временных баз
+	NORMAL,   // в WAL: fsync только при контрольной точке, последние фиксации могут потеряться
+	FULL,     // fsync журнала при каждой фиксации - подтверждённая транзакция не теряется
+};
+
+struct SqliteSettings {
+	std::string path;
+	bool wal = true;
+	Synchronous synchronous = Synchronous::FULL;
+	int busy_timeout_ms = 5000;        // ожидание блокировки другим соединением
+	size_t statement_cache_size = 64;  // подготовленных запросов на соединение
+};
+
+/**
+ * СОЕДИНЕНИЕ С БАЗОЙ
+ *
+ * Кэш запросов ограничен statement_cache_size; при переполнении закрывается
+ * запрос, который дольше всех не использовался.
+ */
+class SqliteManager {
+public:
+	explicit SqliteManager(const SqliteSettings &settings);
+	~SqliteManager();
+
+	SqliteManager(const SqliteManager &) = delete;
+	SqliteManager &operator=(const SqliteManager &) = delete;
+
+	/** Выполняет один или несколько SQL-запросов без параметров */
+	void Execute(const std::string &sql);
+
+	/** Подготовленный запрос из кэша (подготавливается при первом обращении) */
+	Statement &Prepare(const std::string &sql);
+
+	/** BEGIN IMMEDIATE: блокировка записи берётся сразу, а не при первой записи */
+	void Begin();
+	void Commit();
+	void Rollback();
+
+	/** true, если открыта транзакция (после ошибки SQLite может откатить её сам) */
+	bool InTransaction() const;
+
+	int64_t LastInsertRowId() const;
+	int Changes() const;
+
+	sqlite3 *Handle() const {
+		return db_;
+	}
+
+private:
+	struct CachedStatement {
+		std::unique_ptr<Statement> statement;
+		std::list<std::string>::iterator lru;
+	};
+
+	sqlite3 *db_ = nullptr;
+	size_t cache_size_;
+	std::list<std::string> lru_;  // начало - последний использованный запрос
+	std::unordered_map<std::string, CachedStatement> statements_;
+};
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+/*
+ * ЛОКАЛЬНОЕ ХРАНИЛИЩЕ ТРАНЗАКЦИЙ С ГРУППОВОЙ ФИКСАЦИЕЙ
+ *
+ * Каждая платёжная транзакция должна оказаться на диске до того, как
+ * терминал сообщит покупателю об успехе. Фиксация в SQLite - это fsync,
+ * и при фиксации каждой вставки отдельно пропускная способность
+ * ограничена числом fsync в секунду (на SD-карте - десятки-сотни).
+ *
+ * ПРИНЦИП ГРУППОВОЙ ФИКСАЦИИ:
+ * 1. Вызывающие потоки только ставят операцию в очередь и получают std::future
+ * 2. Отдельный поток-писатель забирает из очереди всё накопившееся
+ *    (не больше max_batch) и записывает одной транзакцией SQLite - один fsync
+ *    на всю пачку
+ * 3. Пока идёт fsync одной пачки, в очереди копится следующая - чем выше
+ *    нагрузка, тем крупнее пачки
+ * 4. Если предыдущая пачка была групповой (больше одной операции), писатель
+ *    ждёт, пока новая дорастёт до того же размера, но не дольше max_delay -
+ *    это граница добавочной задержки. Одиночная операция в простое не ждёт
+ * 5. future выполняется только после успешного COMMIT: значение future -
+ *    подтверждение долговечности (при synchronous = FULL)
+ *
+ * ОШИБКИ:
+ * - Ошибка одной операции (например, повтор reference) передаётся только
+ *   в её future, остальные операции пачки фиксируются
+ * - Ошибка фиксации (диск полон, ошибка ввода-вывода) передаётся всем
+ *   операциям пачки
+ *
+ * ЧТЕНИЕ идёт через отдельное соединение: в режиме WAL читатели
+ * не ждут писателя.
+ */
+
+#include "common/types.h"
+#include "database/sqlite_manager.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
+
+namespace paygo::database {
+
+struct StorageSettings {
+	SqliteSettings database;
+	size_t max_batch = 256;                       // операций в одной фиксации
+	std::chrono::microseconds max_delay{1000};    // ожидание добора пачки под нагрузкой
+	size_t queue_limit = 16384;                   // при переполнении Store блокируется
+};
+
+/** Счётчики работы писателя */
+struct StorageStats {
+	uint64_t commits = 0;        // выполнено фиксаций (fsync)
+	uint64_t operations = 0;     // операций в них
+	uint64_t failed = 0;         // операций, завершившихся ошибкой
+	uint64_t max_batch = 0;      // самая крупная пачка
+};
+
+class TransactionStorage {
+public:
+	explicit TransactionStorage(const StorageSettings &settings);
+
+	/** Дожидается записи всех поставленных операций и останавливает писателя */
+	~TransactionStorage();
+
+	TransactionStorage(const TransactionStorage &) = delete;
+	TransactionStorage &operator=(const TransactionStorage &) = delete;
+
+	/**
+	 * Ставит транзакцию в очередь на запись.
+	 * @return future с локальным номером транзакции; готов после фиксации на диске.
+	 *         Повтор reference - DatabaseError (SQLITE_CONSTRAINT) в future
+	 */
+	std::future<int64_t> Store(common::Transaction transaction);
+
+	/** Ставит в очередь смену состояния транзакции; неизвестный id - DatabaseError в future */
+	std::future<void> UpdateStatus(int64_t id, common::TransactionStatus status);
+
+	std::optional<common::Transaction> Find(int64_t id) const;
+	std::optional<common::Transaction> FindByReference(std::string_view reference) const;
+
+	/** Транзакции в заданном состоянии в порядке создания (например, неотправленные) */
+	std::vector<common::Transaction> FindByStatus(common::TransactionStatus status, size_t limit) const;
+
+	StorageStats GetStats() const;
+
+private:
+	struct StoreOperation {
+		common::Transaction transaction;
+		std::promise<int64_t> done;
+	};
+
+	struct StatusOperation {
+		int64_t id;
+		common::TransactionStatus status;
+		std::promise<void> done;
+	};
+
+	using Operation = std::variant<StoreOperation, StatusOperation>;
+
+	void Enqueue(Operation operation);
+	void WriterLoop();
+	void CommitBatch(std::vector<Operation> &batch);
+	void Apply(StoreOperation &operation, int64_t &id);
+	void Apply(StatusOperation &operation);
+
+	StorageSettings settings_;
+
+	SqliteManager writer_;              // используется только потоком-писателем
+	mutable SqliteManager reader_;
+	mutable std::mutex reader_mutex_;
+
+	std::mutex mutex_;
+	std::condition_variable has_work_;
+	std::condition_variable has_space_;
+	std::deque<Operation> queue_;
+	bool stop_ = false;
+
+	std::atomic<uint64_t> commits_{0};
+	std::atomic<uint64_t> operations_{0};
+	std::atomic<uint64_t> failed_{0};
+	std::atomic<uint64_t> max_batch_{0};
+
+	std::thread writer_thread_;         // последним: запускается, когда всё остальное готово
+};
+}
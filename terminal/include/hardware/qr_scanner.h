@@ -0,0 +1,156 @@
+#pragma once
+
+/*
+ * КОНВЕЙЕРНОЕ РАСПОЗНАВАНИЕ QR-КОДОВ
+ *
+ * Камера терминала (terminal.hardware.peripherals.camera) даёт кадры
+ * 1280x720. Полный поиск и декодирование QR-кода в каждом кадре занимают
+ * процессор Raspberry Pi целиком, поэтому работа разделена на три потока:
+ *
+ * 1. Захват - читает кадры в буферы из пула и передаёт их на поиск.
+ *    Если поиск не успевает, ждущий кадр заменяется свежим (устаревший
+ *    кадр только увеличил бы задержку), буфер возвращается в пул
+ * 2. Поиск - ищет код (cv::QRCodeDetector::detect) в уменьшенной копии
+ *    области интереса (ROI): после находки ищет только вокруг последнего
+ *    положения кода, с запасом roi_margin; после roi_lost_frames кадров
+ *    без кода - снова во всём кадре
+ * 3. Декодирование - читает код по найденным углам в полном разрешении,
+ *    только в окрестности кода; повтор того же кода в течение
+ *    duplicate_window не сообщается
+ *
+ * Буферы кадров выделяются один раз (pool_size штук) и переиспользуются:
+ * кадр переходит между потоками по номеру буфера, без копирования.
+ * Пока буфер на поиске или декодировании, захват пишет в другие.
+ *
+ * Источник - устройство камеры или видеофайл (для измерений без камеры:
+ * bench_qr_scanner). Для файла pace_to_fps воспроизводит темп камеры.
+ */
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace paygo::hardware {
+
+/** Ошибка открытия источника кадров */
+class QrScannerError : public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+struct QrScannerSettings {
+	std::string source = "/dev/video0";        // устройство камеры или видеофайл
+	int width = 1280;                           // terminal.hardware.peripherals.camera.resolution
+	int height = 720;
+	bool pace_to_fps = false;                   // видеофайл: выдавать кадры в темпе записи
+	double detect_scale = 0.5;                  // масштаб копии для поиска кода
+	double roi_margin = 0.5;                    // запас вокруг найденного кода, доля его размера
+	int roi_lost_frames = 5;                    // кадров без кода до возврата к поиску во всём кадре
+	size_t pool_size = 4;                       // буферов кадров
+	std::chrono::milliseconds duplicate_window{2000};
+};
+
+struct QrResult {
+	std::string payload;
+	std::vector<cv::Point2f> corners;           // углы кода в координатах кадра
+	uint64_t frame = 0;                         // номер кадра источника
+	std::chrono::steady_clock::time_point captured_at;
+	std::chrono::steady_clock::time_point detected_at;
+	std::chrono::steady_clock::time_point decoded_at;
+};
+
+struct QrScannerStats {
+	uint64_t captured = 0;
+	uint64_t dropped = 0;          // кадров, заменённых более свежими или без свободного буфера
+	uint64_t detected = 0;         // кадров, прошедших поиск
+	uint64_t roi_scans = 0;        // из них поиск только в области интереса
+	uint64_t found = 0;            // кадров с найденным кодом
+	uint64_t decoded = 0;          // успешно декодировано
+	uint64_t decode_failures = 0;
+	uint64_t duplicates = 0;       // повторы того же кода, не переданные обработчику
+};
+
+class QrScanner {
+public:
+	/** Вызывается из потока декодирования для каждого нового кода */
+	using Handler = std::function<void(const QrResult &result)>;
+
+	/** Открывает источник и запускает потоки; ошибка - QrScannerError */
+	QrScanner(const QrScannerSettings &settings, Handler handler);
+
+	/** Останавливает потоки */
+	~QrScanner();
+
+	QrScanner(const QrScanner &) = delete;
+	QrScanner &operator=(const QrScanner &) = delete;
+
+	/** Видеофайл прочитан до конца и все кадры обработаны */
+	bool Finished() const;
+
+	/** Ждёт Finished() не дольше timeout */
+	bool WaitFinished(std::chrono::milliseconds timeout) const;
+
+	QrScannerStats GetStats() const;
+
+private:
+	/** Кадр в пути между потоками: номер буфера в пуле и метки времени */
+	struct FrameTicket {
+		size_t slot = 0;
+		uint64_t frame = 0;
+		std::chrono::steady_clock::time_point captured_at;
+		std::chrono::steady_clock::time_point detected_at;
+		std::vector<cv::Point2f> corners;
+	};
+
+	/**
+	 * Передача между потоками: одно место, новый кадр вытесняет ждущий
+	 * (его буфер возвращается в пул)
+	 */
+	struct Handoff {
+		std::optional<FrameTicket> ticket;
+		bool closed = false;
+		std::condition_variable ready;
+	};
+
+	void CaptureLoop();
+	void DetectLoop();
+	void DecodeLoop();
+	void ThreadDone();
+
+	std::optional<size_t> AcquireSlot();
+	void ReleaseSlot(size_t slot);
+	void Put(Handoff &handoff, FrameTicket ticket);
+	std::optional<FrameTicket> Take(Handoff &handoff);
+	void Close(Handoff &handoff);
+
+	QrScannerSettings settings_;
+	Handler handler_;
+	cv::VideoCapture source_;
+	double source_fps_ = 0;
+
+	mutable std::mutex mutex_;                  // пул, передачи, статистика
+	mutable std::condition_variable finished_signal_;
+	std::vector<cv::Mat> pool_;
+	std::vector<size_t> free_slots_;
+	Handoff to_detect_;
+	Handoff to_decode_;
+	QrScannerStats stats_;
+	size_t threads_done_ = 0;
+	std::atomic<bool> stop_{false};
+
+	std::thread capture_;
+	std::thread detect_;
+	std::thread decode_;
+};
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+/*
+ * КЛИЕНТ HTTP API БАНКОВ-ЭКВАЙЕРОВ
+ *
+ * Авторизация платежа - запрос к API банка (vtb, alfa, center_invest из
+ * payment.banks.acquiring). Если каждый запрос открывает новое соединение,
+ * к ответу банка добавляются TCP- и TLS-рукопожатия.
+ *
+ * УСТРОЙСТВО:
+ * 1. Все запросы выполняет один поток на curl multi: запросы идут
+ *    параллельно, без потока на запрос
+ * 2. Соединения после ответа остаются открытыми (keep-alive) в пуле multi
+ *    и используются следующими запросами к тому же банку
+ * 3. Новые соединения возобновляют TLS-сессию из общего кэша SslManager
+ * 4. У каждого банка свои таймауты и предел одновременных запросов
+ *    (= соединений); лишние запросы ждут в очереди банка
+ * 5. Вызывающий поток получает std::future; ответ с любым HTTP-статусом -
+ *    значение future, сетевая ошибка или таймаут - NetworkError в future
+ *
+ * СЧЁТЧИКИ по банку: запросы, ошибки, новые соединения (остальные
+ * запросы выполнены на уже открытых).
+ */
+
+#include "network/ssl_manager.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace paygo::network {
+
+struct EndpointSettings {
+	std::string name;                                 // ключ банка: "vtb", "alfa", "center_invest"
+	std::string base_url;                             // api_endpoint
+	std::chrono::milliseconds connect_timeout{5000};  // TCP + TLS
+	std::chrono::milliseconds request_timeout{30000}; // весь запрос, без ожидания в очереди
+	size_t max_connections = 4;                       // одновременных запросов к банку
+	bool keep_alive = true;                           // false - новое соединение на каждый запрос
+};
+
+struct ApiClientSettings {
+	std::vector<EndpointSettings> endpoints;
+	std::chrono::seconds idle_timeout{60};           // закрывать соединения, простаивающие дольше
+	std::string user_agent = "PayGoTerminal/1.0";
+};
+
+struct HttpRequest {
+	std::string endpoint;                    // EndpointSettings::name
+	std::string method = "POST";
+	std::string path;                        // добавляется к base_url
+	std::string body;
+	std::vector<std::string> headers;        // "Имя: значение"
+};
+
+struct HttpResponse {
+	long status = 0;
+	std::string body;
+	std::chrono::microseconds elapsed{0};    // от постановки в очередь до ответа
+	bool new_connection = false;             // false - соединение взято из пула
+};
+
+struct EndpointStats {
+	uint64_t requests = 0;
+	uint64_t failures = 0;       // сетевые ошибки и таймауты
+	uint64_t connections = 0;    // открыто новых соединений
+	size_t in_flight = 0;
+	size_t queued = 0;
+};
+
+class ApiClient {
+public:
+	/** ssl должен пережить клиент */
+	ApiClient(const ApiClientSettings &settings, const SslManager &ssl);
+
+	/** Прерывает невыполненные запросы (NetworkError в future) и закрывает соединения */
+	~ApiClient();
+
+	ApiClient(const ApiClient &) = delete;
+	ApiClient &operator=(const ApiClient &) = delete;
+
+	/** Ставит запрос в очередь банка; неизвестный банк - std::invalid_argument */
+	std::future<HttpResponse> Send(HttpRequest request);
+
+	/** Send и ожидание ответа */
+	HttpResponse Execute(HttpRequest request) {
+		return Send(std::move(request)).get();
+	}
+
+	/** Счётчики банка; неизвестный банк - std::invalid_argument */
+	EndpointStats GetStats(const std::string &endpoint) const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Endpoint;
+
+	/** Запрос в очереди или в работе; владеет буферами, на которые ссылается CURL */
+	struct Transfer {
+		Endpoint *endpoint = nullptr;
+		HttpRequest request;
+		std::promise<HttpResponse> done;
+		Clock::time_point queued_at;
+		std::string url;
+		std::string response_body;
+		curl_slist *headers = nullptr;
+		char error[CURL_ERROR_SIZE] = {};
+	};
+
+	struct Endpoint {
+		EndpointSettings settings;
+		std::deque<std::unique_ptr<Transfer>> queue;
+		size_t in_flight = 0;
+		EndpointStats stats;
+	};
+
+	void EventLoop();
+	void StartQueued();
+	void Start(std::unique_ptr<Transfer> transfer);
+	void Finish(CURL *easy, CURLcode code);
+	void Release(CURL *easy, Transfer &transfer);
+	void FailAll();
+
+	static size_t WriteBody(char *data, size_t size, size_t count, void *user);
+
+	ApiClientSettings settings_;
+	const SslManager &ssl_;
+	CURLM *multi_ = nullptr;
+
+	mutable std::mutex mutex_;  // очереди, in_flight и счётчики банков
+	std::unordered_map<std::string, std::unique_ptr<Endpoint>> endpoints_;
+	bool stop_ = false;
+
+	// Только поток клиента
+	std::unordered_map<CURL *, std::unique_ptr<Transfer>> active_;
+	std::vector<CURL *> idle_handles_;   // сброшенные CURL для повторного использования
+
+	std::thread thread_;
+};
+}
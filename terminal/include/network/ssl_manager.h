@@ -0,0 +1,75 @@
+#pragma once
+
+/*
+ * НАСТРОЙКИ TLS ДЛЯ ЗАПРОСОВ К БАНКАМ
+ *
+ * Полное TLS-рукопожатие - два обхода сети и асимметричная криптография;
+ * на Raspberry Pi через мобильную сеть это сотни миллисекунд к каждой
+ * авторизации. SslManager:
+ * 1. Задаёт проверку сертификата сервера, CA и клиентский сертификат
+ *    (если банк требует взаимной аутентификации)
+ * 2. Держит общий для всех запросов кэш TLS-сессий и DNS (CURLSH):
+ *    новое соединение с тем же банком возобновляет сессию
+ *    (сокращённое рукопожатие без обмена сертификатами)
+ *
+ * Один SslManager на процесс; он должен пережить все ApiClient,
+ * которые его используют. Потокобезопасен.
+ */
+
+#include <curl/curl.h>
+
+#include <array>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace paygo::network {
+
+/** Ошибка сети: текст сообщения и код libcurl (CURLcode) */
+class NetworkError : public std::runtime_error {
+public:
+	NetworkError(const std::string &message, int code) : std::runtime_error(message), code_(code) {}
+
+	int Code() const {
+		return code_;
+	}
+
+private:
+	int code_;
+};
+
+struct TlsSettings {
+	std::string ca_file;             // пусто - системное хранилище CA
+	std::string client_cert;         // PEM; пусто - без клиентского сертификата
+	std::string client_key;
+	bool verify_peer = true;         // false - только для тестовых стендов
+	bool session_cache = true;       // возобновление TLS-сессий между соединениями
+};
+
+class SslManager {
+public:
+	explicit SslManager(const TlsSettings &settings);
+	~SslManager();
+
+	SslManager(const SslManager &) = delete;
+	SslManager &operator=(const SslManager &) = delete;
+
+	/** Применяет настройки TLS и общий кэш к запросу */
+	void Apply(CURL *easy) const;
+
+	const TlsSettings &Settings() const {
+		return settings_;
+	}
+
+private:
+	static void Lock(CURL *easy, curl_lock_data data, curl_lock_access access, void *user);
+	static void Unlock(CURL *easy, curl_lock_data data, void *user);
+
+	TlsSettings settings_;
+	CURLSH *share_ = nullptr;
+	std::array<std::mutex, CURL_LOCK_DATA_LAST> locks_;
+};
+
+/** Инициализация libcurl для процесса (потокобезопасно, повторные вызовы ничего не делают) */
+void InitCurl();
+}
@@ -0,0 +1,335 @@
+#pragma once
+
+/*
+ * WEBSOCKET (RFC 6455) ДЛЯ КОМАНД И СТАТУСОВ ТЕРМИНАЛА
+ *
+ * Сервер PayGo присылает терминалу команды (terminal_commands) и принимает
+ * от него статусы по WebSocket. Здесь кодек кадров и клиент поверх сокета.
+ *
+ * ПРИЁМ БЕЗ КОПИРОВАНИЯ:
+ * 1. Данные из сокета читаются прямо в кольцевой буфер ReceiveRing.
+ *    Одни и те же страницы отображены в память дважды подряд, поэтому
+ *    любой непрочитанный участок - непрерывный, даже если переходит через
+ *    конец буфера
+ * 2. FrameReader разбирает кадры на месте; полезная нагрузка передаётся
+ *    обработчику как string_view на буфер (маска снимается на месте,
+ *    векторными инструкциями)
+ * 3. Сообщение из одного кадра (обычный случай) не копируется; фрагменты
+ *    либо передаются по одному (deliver_fragments), либо собираются
+ *    в отдельную строку
+ *
+ * ОТПРАВКА: FrameWriter копит кадры и отправляет их одним вызовом sendmsg
+ * (writev с MSG_NOSIGNAL).
+ * Клиент обязан маскировать кадры, поэтому его данные копируются с маской;
+ * сервер (например, тестовый эхо-сервер) ссылается на данные без копии.
+ *
+ * TLS (wss://) здесь не реализован: соединение с сервером идёт через
+ * локальный TLS-туннель или по защищённой сети.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace paygo::network {
+
+/** Ошибка протокола или соединения; код закрытия - из RFC 6455, раздел 7.4 */
+class WebSocketError : public std::runtime_error {
+public:
+	WebSocketError(const std::string &message, uint16_t close_code) : std::runtime_error(message), close_code_(close_code) {}
+
+	uint16_t CloseCode() const {
+		return close_code_;
+	}
+
+private:
+	uint16_t close_code_;
+};
+
+namespace close_code {
+constexpr uint16_t NORMAL = 1000;
+constexpr uint16_t GOING_AWAY = 1001;
+constexpr uint16_t PROTOCOL_ERROR = 1002;
+constexpr uint16_t INVALID_PAYLOAD = 1007;    // текст не в UTF-8
+constexpr uint16_t MESSAGE_TOO_BIG = 1009;
+constexpr uint16_t INTERNAL_ERROR = 1011;
+}
+
+enum class Opcode : uint8_t {
+	CONTINUATION = 0x0,
+	TEXT = 0x1,
+	BINARY = 0x2,
+	CLOSE = 0x8,
+	PING = 0x9,
+	PONG = 0xA,
+};
+
+/** Сторона соединения: клиент маскирует отправляемые кадры, сервер - принимаемые */
+enum class Role {
+	CLIENT,
+	SERVER,
+};
+
+// === КОДЕК ЗАГОЛОВКА КАДРА ===
+
+struct FrameHeader {
+	bool fin = true;
+	Opcode opcode = Opcode::TEXT;
+	bool masked = false;
+	uint32_t mask = 0;            // байты ключа маски в порядке передачи
+	uint64_t payload_size = 0;
+	size_t header_size = 0;       // 2..14 байт
+};
+
+enum class ParseStatus {
+	COMPLETE,
+	INCOMPLETE,                   // заголовок ещё не получен целиком
+};
+
+constexpr size_t MAX_HEADER_SIZE = 14;
+
+/** Разбирает заголовок кадра; нарушение протокола - WebSocketError */
+ParseStatus ParseFrameHeader(const uint8_t *data, size_t size, FrameHeader &header);
+
+/** Записывает заголовок в out (не меньше MAX_HEADER_SIZE байт); mask - nullptr без маски */
+size_t EncodeFrameHeader(uint8_t *out, Opcode opcode, bool fin, uint64_t payload_size, const uint32_t *mask);
+
+/**
+ * Накладывает (снимает) маску на месте. offset - позиция data[0] в полезной
+ * нагрузке кадра (по модулю 4), если кадр обрабатывается по частям
+ */
+void Unmask(uint8_t *data, size_t size, uint32_t mask, size_t offset = 0);
+
+/** Sec-WebSocket-Accept для Sec-WebSocket-Key (base64(SHA-1(key + GUID))) */
+std::string ComputeAcceptKey(std::string_view key);
+
+/**
+ * Проверка UTF-8 (RFC 3629) по частям: символ может разрываться между
+ * фрагментами сообщения. Отвергаются избыточные формы, суррогаты
+ * и значения больше U+10FFFF
+ */
+class Utf8Validator {
+public:
+	/** Продолжает проверку; false - данные не UTF-8 */
+	bool Feed(std::string_view data);
+
+	/** Данные закончились на границе символа */
+	bool Complete() const {
+		return needed_ == 0;
+	}
+
+	void Reset() {
+		needed_ = 0;
+		lower_ = 0x80;
+		upper_ = 0xBF;
+	}
+
+private:
+	uint8_t needed_ = 0;          // продолжающих байтов до конца символа
+	uint8_t lower_ = 0x80;        // допустимые значения следующего продолжающего байта
+	uint8_t upper_ = 0xBF;
+};
+
+// === КОЛЬЦЕВОЙ БУФЕР ПРИЁМА ===
+
+/**
+ * Буфер с двойным отображением страниц (memfd + два mmap подряд):
+ * байт по адресу data + capacity совпадает с байтом data. Непрочитанные
+ * данные и свободное место всегда непрерывны - их можно передать в read()
+ * и разбирать на месте без переноса в начало буфера.
+ */
+class ReceiveRing {
+public:
+	/** Ёмкость округляется вверх до размера страницы */
+	explicit ReceiveRing(size_t capacity);
+	~ReceiveRing();
+
+	ReceiveRing(const ReceiveRing &) = delete;
+	ReceiveRing &operator=(const ReceiveRing &) = delete;
+
+	uint8_t *WriteData() {
+		return base_ + (tail_ % capacity_);
+	}
+
+	size_t Writable() const {
+		return capacity_ - Readable();
+	}
+
+	void Produce(size_t size) {
+		tail_ += size;
+	}
+
+	uint8_t *ReadData() {
+		return base_ + (head_ % capacity_);
+	}
+
+	size_t Readable() const {
+		return static_cast<size_t>(tail_ - head_);
+	}
+
+	void Consume(size_t size) {
+		head_ += size;
+	}
+
+	size_t Capacity() const {
+		return capacity_;
+	}
+
+private:
+	uint8_t *base_ = nullptr;
+	size_t capacity_ = 0;
+	uint64_t head_ = 0;
+	uint64_t tail_ = 0;
+};
+
+// === РАЗБОР ПОТОКА КАДРОВ ===
+
+/**
+ * Сообщение или его фрагмент. data указывает в буфер приёма
+ * и действительно только во время вызова обработчика
+ */
+struct Message {
+	Opcode opcode;                // для фрагментов - тип всего сообщения
+	std::string_view data;
+	bool final = true;            // false - будут ещё фрагменты (только при deliver_fragments)
+};
+
+using MessageHandler = std::function<void(const Message &message)>;
+
+struct FrameReaderSettings {
+	Role role = Role::CLIENT;
+	size_t max_message_bytes = 1 << 20;    // предел сообщения (при deliver_fragments - кадра с fin)
+	bool deliver_fragments = false;        // true - фрагменты передаются по мере прихода, без сборки
+};
+
+class FrameReader {
+public:
+	explicit FrameReader(const FrameReaderSettings &settings);
+
+	/**
+	 * Разбирает все полностью полученные кадры из ring и передаёт их
+	 * обработчику (управляющие кадры тоже); разобранные байты освобождаются.
+	 * Кадр больше буфера или нарушение протокола - WebSocketError.
+	 * Текстовое сообщение проверяется на UTF-8 до передачи каждого
+	 * фрагмента (RFC 6455, раздел 8.1); ошибка - код INVALID_PAYLOAD.
+	 * @return число переданных обработчику сообщений и фрагментов
+	 */
+	size_t Parse(ReceiveRing &ring, const MessageHandler &handler);
+
+private:
+	/** Продолжает проверку UTF-8 текстового сообщения; fin - его последний кадр */
+	void CheckText(std::string_view data, bool fin);
+
+	FrameReaderSettings settings_;
+	bool in_message_ = false;
+	Opcode message_opcode_ = Opcode::TEXT;
+	std::string assembly_;         // сборка фрагментированного сообщения
+	Utf8Validator utf8_;           // состояние проверки текущего текстового сообщения
+};
+
+// === ОТПРАВКА КАДРОВ ===
+
+class FrameWriter {
+public:
+	explicit FrameWriter(Role role);
+
+	/**
+	 * Добавляет кадр в очередь отправки. Роль CLIENT: данные копируются
+	 * с маской. Роль SERVER: данные не копируются и должны оставаться
+	 * доступными до окончания Flush
+	 */
+	void Add(Opcode opcode, std::string_view payload, bool fin = true);
+
+	/** Байт в очереди */
+	size_t Pending() const {
+		return pending_;
+	}
+
+	/**
+	 * Отправляет очередь через sendmsg (сокет). Для неблокирующего сокета возвращает
+	 * false, если отправлена не вся очередь (остаток - при следующем вызове).
+	 * Ошибка сокета - WebSocketError
+	 */
+	bool Flush(int fd);
+
+private:
+	/** Участок очереди: в arena_ (заголовки, маскированные данные) или внешние данные */
+	struct Part {
+		const char *external;      // nullptr - участок в arena_
+		size_t offset;
+		size_t size;
+	};
+
+	void AddArena(const uint8_t *data, size_t size);
+
+	Role role_;
+	std::string arena_;
+	std::vector<Part> parts_;
+	size_t first_part_ = 0;        // отправлено целиком частей
+	size_t first_offset_ = 0;      // отправлено байт первой неотправленной части
+	size_t pending_ = 0;
+	std::mt19937 random_;          // ключи маски
+};
+
+// === КЛИЕНТ ===
+
+struct WebSocketSettings {
+	std::string host = "127.0.0.1";
+	uint16_t port = 80;
+	std::string path = "/";
+	std::vector<std::string> headers;                   // дополнительные заголовки рукопожатия
+	std::chrono::milliseconds connect_timeout{5000};
+	size_t ring_bytes = 256 << 10;                      // предел размера кадра
+	FrameReaderSettings reader;
+};
+
+/**
+ * Клиентское соединение. Не потокобезопасно: Send, Flush и Poll вызываются
+ * из одного потока (цикла событий терминала).
+ */
+class WebSocketClient {
+public:
+	/** Соединяется и выполняет рукопожатие; ошибка - WebSocketError */
+	explicit WebSocketClient(const WebSocketSettings &settings);
+	~WebSocketClient();
+
+	WebSocketClient(const WebSocketClient &) = delete;
+	WebSocketClient &operator=(const WebSocketClient &) = delete;
+
+	/** Ставит сообщение в очередь отправки (отправляется в Flush или Poll) */
+	void Send(Opcode opcode, std::string_view payload);
+
+	/** Отправляет очередь целиком */
+	void Flush();
+
+	/**
+	 * Отправляет очередь, ждёт данные до timeout и передаёт полученные
+	 * сообщения обработчику. На PING отвечает PONG, на CLOSE - CLOSE.
+	 * @return false - соединение закрыто
+	 */
+	bool Poll(const MessageHandler &handler, std::chrono::milliseconds timeout);
+
+	/** Отправляет CLOSE с кодом (ответ сервера принимает Poll) */
+	void Close(uint16_t code = close_code::NORMAL);
+
+	bool IsOpen() const {
+		return fd_ >= 0;
+	}
+
+private:
+	void Handshake(const WebSocketSettings &settings);
+	void Disconnect();
+
+	int fd_ = -1;
+	ReceiveRing ring_;
+	FrameReader reader_;
+	FrameWriter writer_;
+	bool close_sent_ = false;
+};
+}
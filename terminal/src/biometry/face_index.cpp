@@ -0,0 +1,439 @@
+#include "biometry/face_index.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+using namespace std::literals;
+
+namespace paygo::biometry {
+
+namespace {
+
+constexpr char MAGIC[8] = {'P', 'G', 'F', 'A', 'C', 'E', '0', '1'};
+constexpr size_t HEADER_BYTES = 64;
+constexpr size_t ROW_ALIGN = 32;
+constexpr size_t PREFETCH_ROWS = 4;
+
+struct FileHeader {
+	char magic[8];
+	uint32_t dimension;
+	uint32_t stride;
+	uint64_t count;
+	uint64_t capacity;
+	uint64_t dirty;      // не 0 - есть изменения после последнего Sync; в старых файлах 0
+};
+
+static_assert(sizeof(FileHeader) <= HEADER_BYTES);
+
+FileHeader &Header(uint8_t *data) {
+	return *reinterpret_cast<FileHeader *>(data);
+}
+
+size_t ScalesOffset(size_t capacity, size_t stride) {
+	return HEADER_BYTES + capacity * stride;
+}
+
+size_t IdsOffset(size_t capacity, size_t stride) {
+	return ScalesOffset(capacity, stride) + (capacity * sizeof(float) + 7) / 8 * 8;
+}
+
+size_t FileBytes(size_t capacity, size_t stride) {
+	return IdsOffset(capacity, stride) + capacity * sizeof(uint64_t);
+}
+
+FaceIndexError SystemError(const std::string &what, const std::string &path) {
+	return FaceIndexError("face index: "s + what + " "s + path + ": "s + std::strerror(errno));
+}
+
+/** Кандидат в куче лучших: меньшее сходство - в вершине */
+struct Candidate {
+	float score;
+	size_t slot;
+};
+
+bool WorseFirst(const Candidate &a, const Candidate &b) {
+	return a.score > b.score;
+}
+}
+
+// === СКАЛЯРНОЕ ПРОИЗВЕДЕНИЕ ===
+
+/**
+ * int8 * int8 без переполнения: произведения складываются попарно
+ * в int16 (|q| <= 127, поэтому 2 * 127 * 127 < 32767), затем в int32
+ */
+int32_t DotInt8(const int8_t *a, const int8_t *b, size_t size) {
+	size_t i = 0;
+	int32_t sum = 0;
+#if defined(__AVX2__)
+	__m256i acc = _mm256_setzero_si256();
+	for(; i + 16 <= size; i += 16) {
+		const __m256i wide_a = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)));
+		const __m256i wide_b = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+		acc = _mm256_add_epi32(acc, _mm256_madd_epi16(wide_a, wide_b));
+	}
+	__m128i half = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+	sum = _mm_cvtsi128_si32(half);
+#elif defined(__SSE2__)
+	__m128i acc = _mm_setzero_si128();
+	for(; i + 16 <= size; i += 16) {
+		const __m128i chunk_a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+		const __m128i chunk_b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+		// Расширение знака int8 -> int16: байт в старшую половину и арифметический сдвиг
+		const __m128i low_a = _mm_srai_epi16(_mm_unpacklo_epi8(chunk_a, chunk_a), 8);
+		const __m128i high_a = _mm_srai_epi16(_mm_unpackhi_epi8(chunk_a, chunk_a), 8);
+		const __m128i low_b = _mm_srai_epi16(_mm_unpacklo_epi8(chunk_b, chunk_b), 8);
+		const __m128i high_b = _mm_srai_epi16(_mm_unpackhi_epi8(chunk_b, chunk_b), 8);
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(low_a, low_b));
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(high_a, high_b));
+	}
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+	sum = _mm_cvtsi128_si32(acc);
+#elif defined(__ARM_NEON)
+	int32x4_t acc = vdupq_n_s32(0);
+	for(; i + 16 <= size; i += 16) {
+		const int8x16_t chunk_a = vld1q_s8(a + i);
+		const int8x16_t chunk_b = vld1q_s8(b + i);
+#if defined(__ARM_FEATURE_DOTPROD)
+		acc = vdotq_s32(acc, chunk_a, chunk_b);
+#else
+		int16x8_t products = vmull_s8(vget_low_s8(chunk_a), vget_low_s8(chunk_b));
+		products = vmlal_s8(products, vget_high_s8(chunk_a), vget_high_s8(chunk_b));
+		acc = vpadalq_s16(acc, products);
+#endif
+	}
+	sum = vgetq_lane_s32(acc, 0) + vgetq_lane_s32(acc, 1) + vgetq_lane_s32(acc, 2) + vgetq_lane_s32(acc, 3);
+#endif
+	for(; i < size; ++i) {
+		sum += int32_t{a[i]} * int32_t{b[i]};
+	}
+	return sum;
+}
+
+float QuantizeEmbedding(const float *embedding, size_t dimension, int8_t *out, size_t padded_size) {
+	double squares = 0;
+	for(size_t i = 0; i < dimension; ++i) {
+		squares += static_cast<double>(embedding[i]) * embedding[i];
+	}
+	const double norm = std::sqrt(squares);
+	if(!(norm > 0) || !std::isfinite(norm)) {
+		throw FaceIndexError("face index: embedding is zero or not finite"s);
+	}
+
+	double max_abs = 0;
+	for(size_t i = 0; i < dimension; ++i) {
+		max_abs = std::max(max_abs, std::fabs(embedding[i] / norm));
+	}
+	const double scale = max_abs / 127.0;
+	for(size_t i = 0; i < dimension; ++i) {
+		const long value = std::lround(embedding[i] / norm / scale);
+		out[i] = static_cast<int8_t>(std::clamp(value, -127L, 127L));
+	}
+	std::fill(out + dimension, out + padded_size, int8_t{0});
+	return static_cast<float>(scale);
+}
+
+// === ФАЙЛ ===
+
+FaceIndex::FaceIndex(const FaceIndexSettings &settings)
+	: settings_(settings), dimension_(settings.dimension), stride_((settings.dimension + ROW_ALIGN - 1) / ROW_ALIGN * ROW_ALIGN) {
+	if(dimension_ == 0) {
+		throw FaceIndexError("face index: dimension must be positive"s);
+	}
+
+	struct stat status;
+	if(::stat(settings_.path.c_str(), &status) == 0) {
+		mapping_ = Map(settings_.path, 0);
+	} else if(errno == ENOENT) {
+		mapping_ = Map(settings_.path, std::max<size_t>(1, settings_.initial_capacity));
+	} else {
+		throw SystemError("cannot stat"s, settings_.path);
+	}
+
+	const size_t count = Count();
+	slots_.reserve(count);
+	const uint64_t *ids = Ids();
+	for(size_t slot = 0; slot < count; ++slot) {
+		if(!slots_.emplace(ids[slot], slot).second) {
+			const uint64_t duplicate = ids[slot];
+			Unmap(mapping_);
+			throw FaceIndexError("face index: "s + settings_.path + " is corrupted: user "s + std::to_string(duplicate) +
+										" enrolled twice"s);
+		}
+	}
+}
+
+/** Изменения сбрасываются на диск; если это не удалось, файл остаётся помеченным и не откроется */
+FaceIndex::~FaceIndex() {
+	if(Header(mapping_.data).dirty != 0 && ::msync(mapping_.data, mapping_.bytes, MS_SYNC) == 0) {
+		Header(mapping_.data).dirty = 0;
+		::msync(mapping_.data, HEADER_BYTES, MS_SYNC);
+	}
+	Unmap(mapping_);
+}
+
+FaceIndex::Mapping FaceIndex::Map(const std::string &path, size_t capacity) const {
+	Mapping mapping;
+	const bool create = capacity > 0;
+	mapping.fd = ::open(path.c_str(), create ? O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC : O_RDWR | O_CLOEXEC, 0600);
+	if(mapping.fd < 0) {
+		throw SystemError("cannot open"s, path);
+	}
+
+	FileHeader header{};
+	try {
+		if(create) {
+			std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+			header.dimension = static_cast<uint32_t>(dimension_);
+			header.stride = static_cast<uint32_t>(stride_);
+			header.capacity = capacity;
+			if(::ftruncate(mapping.fd, static_cast<off_t>(FileBytes(capacity, stride_))) != 0) {
+				throw SystemError("cannot resize"s, path);
+			}
+		} else {
+			struct stat status;
+			if(::pread(mapping.fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+				std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+				throw FaceIndexError("face index: "s + path + " is not a face index"s);
+			}
+			if(header.dimension != dimension_ || header.stride != stride_) {
+				throw FaceIndexError("face index: "s + path + " has dimension "s + std::to_string(header.dimension) + ", expected "s +
+											std::to_string(dimension_));
+			}
+			if(::fstat(mapping.fd, &status) != 0 || header.count > header.capacity ||
+				static_cast<uint64_t>(status.st_size) < FileBytes(header.capacity, stride_)) {
+				throw FaceIndexError("face index: "s + path + " is truncated"s);
+			}
+			if(header.dirty != 0) {
+				throw FaceIndexError("face index: "s + path + " was modified and not synced (crash?), rebuild it"s);
+			}
+			capacity = header.capacity;
+		}
+
+		mapping.capacity = capacity;
+		mapping.bytes = FileBytes(capacity, stride_);
+		void *data = ::mmap(nullptr, mapping.bytes, PROT_READ | PROT_WRITE, MAP_SHARED, mapping.fd, 0);
+		if(data == MAP_FAILED) {
+			throw SystemError("cannot map"s, path);
+		}
+		mapping.data = static_cast<uint8_t *>(data);
+	} catch(...) {
+		::close(mapping.fd);
+		throw;
+	}
+
+	if(create) {
+		std::memcpy(mapping.data, &header, sizeof(header));
+	}
+	return mapping;
+}
+
+void FaceIndex::Unmap(Mapping &mapping) {
+	if(mapping.data) {
+		::munmap(mapping.data, mapping.bytes);
+		mapping.data = nullptr;
+	}
+	if(mapping.fd >= 0) {
+		::close(mapping.fd);
+		mapping.fd = -1;
+	}
+}
+
+/**
+ * УДВОЕНИЕ ЁМКОСТИ
+ *
+ * Размеры разделов зависят от ёмкости, поэтому данные копируются в новый
+ * файл, который затем атомарно заменяет старый. Вызывается под
+ * исключительной блокировкой; при ошибке остаётся прежний файл.
+ */
+void FaceIndex::Grow() {
+	const std::string temporary = settings_.path + ".tmp"s;
+	Mapping grown = Map(temporary, mapping_.capacity * 2);
+	const size_t count = Count();
+
+	std::memcpy(grown.data + HEADER_BYTES, Vector(0), count * stride_);
+	std::memcpy(grown.data + ScalesOffset(grown.capacity, stride_), Scales(), count * sizeof(float));
+	std::memcpy(grown.data + IdsOffset(grown.capacity, stride_), Ids(), count * sizeof(uint64_t));
+	Header(grown.data).count = count;
+
+	if(::msync(grown.data, grown.bytes, MS_SYNC) != 0 || ::rename(temporary.c_str(), settings_.path.c_str()) != 0) {
+		const FaceIndexError error = SystemError("cannot replace"s, settings_.path);
+		Unmap(grown);
+		::unlink(temporary.c_str());
+		throw error;
+	}
+	Unmap(mapping_);
+	mapping_ = grown;
+}
+
+/**
+ * ПОМЕТКА ОБ ИЗМЕНЕНИИ
+ *
+ * Флаг попадает на диск (msync страницы заголовка) раньше первого
+ * изменённого байта данных: ядро может записать страницы MAP_SHARED
+ * в любой момент и в любом порядке, и без флага файл после сбоя
+ * выглядел бы целым. Снимает флаг Sync.
+ */
+void FaceIndex::MarkDirty() {
+	if(Header(mapping_.data).dirty != 0) {
+		return;
+	}
+	Header(mapping_.data).dirty = 1;
+	if(::msync(mapping_.data, HEADER_BYTES, MS_SYNC) != 0) {
+		Header(mapping_.data).dirty = 0;
+		throw SystemError("cannot sync"s, settings_.path);
+	}
+}
+
+size_t FaceIndex::Count() const {
+	return static_cast<size_t>(Header(mapping_.data).count);
+}
+
+int8_t *FaceIndex::Vector(size_t slot) const {
+	return reinterpret_cast<int8_t *>(mapping_.data + HEADER_BYTES + slot * stride_);
+}
+
+float *FaceIndex::Scales() const {
+	return reinterpret_cast<float *>(mapping_.data + ScalesOffset(mapping_.capacity, stride_));
+}
+
+uint64_t *FaceIndex::Ids() const {
+	return reinterpret_cast<uint64_t *>(mapping_.data + IdsOffset(mapping_.capacity, stride_));
+}
+
+// === ОПЕРАЦИИ ===
+
+void FaceIndex::Enroll(uint64_t user_id, const float *embedding) {
+	std::vector<int8_t> quantized(stride_);
+	const float scale = QuantizeEmbedding(embedding, dimension_, quantized.data(), stride_);
+
+	std::unique_lock lock(mutex_);
+	auto it = slots_.find(user_id);
+	size_t slot;
+	if(it != slots_.end()) {
+		slot = it->second;
+	} else {
+		if(Count() == mapping_.capacity) {
+			Grow();
+		}
+		slot = Count();
+	}
+
+	MarkDirty();
+	std::memcpy(Vector(slot), quantized.data(), stride_);
+	Scales()[slot] = scale;
+	Ids()[slot] = user_id;
+	if(it == slots_.end()) {
+		Header(mapping_.data).count = slot + 1;
+		slots_.emplace(user_id, slot);
+	}
+}
+
+/** Последняя строка переносится на место удалённой - векторы остаются подряд */
+bool FaceIndex::Remove(uint64_t user_id) {
+	std::unique_lock lock(mutex_);
+	auto it = slots_.find(user_id);
+	if(it == slots_.end()) {
+		return false;
+	}
+	const size_t slot = it->second;
+	const size_t last = Count() - 1;
+	MarkDirty();
+	slots_.erase(it);
+	if(slot != last) {
+		std::memcpy(Vector(slot), Vector(last), stride_);
+		Scales()[slot] = Scales()[last];
+		Ids()[slot] = Ids()[last];
+		slots_[Ids()[slot]] = slot;
+	}
+	Header(mapping_.data).count = last;
+	return true;
+}
+
+/**
+ * ПОИСК
+ *
+ * Полный проход по всем строкам. Порог отбора - наибольшее из min_score
+ * и k-го лучшего сходства; строки не выше порога не трогают кучу.
+ */
+std::vector<FaceMatch> FaceIndex::Search(const float *embedding, size_t k, float min_score) const {
+	std::vector<FaceMatch> matches;
+	if(k == 0) {
+		return matches;
+	}
+	std::vector<int8_t> query(stride_);
+	const float query_scale = QuantizeEmbedding(embedding, dimension_, query.data(), stride_);
+
+	std::shared_lock lock(mutex_);
+	const size_t count = Count();
+	const float *scales = Scales();
+	std::vector<Candidate> best;
+	best.reserve(k + 1);
+	float threshold = min_score;
+
+	for(size_t slot = 0; slot < count; ++slot) {
+		if(slot + PREFETCH_ROWS < count) {
+			__builtin_prefetch(Vector(slot + PREFETCH_ROWS));
+		}
+		const float score = static_cast<float>(DotInt8(query.data(), Vector(slot), stride_)) * query_scale * scales[slot];
+		if(score <= threshold) {
+			continue;
+		}
+		best.push_back(Candidate{score, slot});
+		std::push_heap(best.begin(), best.end(), WorseFirst);
+		if(best.size() > k) {
+			std::pop_heap(best.begin(), best.end(), WorseFirst);
+			best.pop_back();
+		}
+		if(best.size() == k) {
+			threshold = std::max(min_score, best.front().score);
+		}
+	}
+
+	std::sort_heap(best.begin(), best.end(), WorseFirst);
+	const uint64_t *ids = Ids();
+	matches.reserve(best.size());
+	for(const Candidate &candidate : best) {
+		matches.push_back(FaceMatch{ids[candidate.slot], candidate.score});
+	}
+	return matches;
+}
+
+size_t FaceIndex::Size() const {
+	std::shared_lock lock(mutex_);
+	return slots_.size();
+}
+
+/** Сначала данные, затем снятый флаг: чистый заголовок на диске - только поверх сохранённых данных */
+void FaceIndex::Sync() {
+	std::unique_lock lock(mutex_);
+	if(Header(mapping_.data).dirty == 0) {
+		return;
+	}
+	if(::msync(mapping_.data, mapping_.bytes, MS_SYNC) != 0) {
+		throw SystemError("cannot sync"s, settings_.path);
+	}
+	Header(mapping_.data).dirty = 0;
+	if(::msync(mapping_.data, HEADER_BYTES, MS_SYNC) != 0) {
+		throw SystemError("cannot sync"s, settings_.path);
+	}
+}
+}
@@ -0,0 +1,399 @@
+#include "core/config_manager.h"
+
+#include "core/logger.h"
+
+#include <nlohmann/json.hpp>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace std::literals;
+
+namespace paygo::core {
+
+namespace {
+
+using Json = nlohmann::json;
+
+std::atomic<uint64_t> next_instance{1};
+
+/** Последний снимок, прочитанный потоком (один менеджер на поток - обычный случай) */
+struct ReaderCache {
+	uint64_t instance = 0;
+	uint64_t generation = 0;
+	std::shared_ptr<const ConfigSnapshot> snapshot;
+};
+
+thread_local ReaderCache reader_cache;
+
+const Json &At(const Json &node, std::string_view key, const std::string &path) {
+	if(!node.is_object()) {
+		throw ConfigError("config: "s + path + " is not an object"s);
+	}
+	const auto it = node.find(key);
+	if(it == node.end()) {
+		throw ConfigError("config: missing "s + path + "."s + std::string(key));
+	}
+	return *it;
+}
+
+template <typename Type>
+Type Value(const Json &node, std::string_view key, const std::string &path) {
+	const Json &value = At(node, key, path);
+	const bool valid = std::is_same_v<Type, bool> ? value.is_boolean()
+							 : std::is_arithmetic_v<Type> ? value.is_number()
+															 : value.is_string();
+	if(!valid) {
+		throw ConfigError("config: invalid type of "s + path + "."s + std::string(key));
+	}
+	return value.get<Type>();
+}
+
+/** Рубли из файла в копейки */
+int64_t Money(const Json &node, std::string_view key, const std::string &path) {
+	return std::llround(Value<double>(node, key, path) * 100.0);
+}
+
+DeviceConfig ParseDevice(const Json &node, const std::string &path) {
+	DeviceConfig device;
+	device.enabled = Value<bool>(node, "enabled"sv, path);
+	device.device = Value<std::string>(node, "device"sv, path);
+	return device;
+}
+
+BankConfig ParseBank(const Json &node, std::string name, const std::string &path) {
+	BankConfig bank;
+	bank.name = std::move(name);
+	bank.enabled = Value<bool>(node, "enabled"sv, path);
+	bank.merchant_id = Value<std::string>(node, "merchant_id"sv, path);
+	bank.api_endpoint = Value<std::string>(node, "api_endpoint"sv, path);
+	return bank;
+}
+
+void Require(bool condition, const char *message) {
+	if(!condition) {
+		throw ConfigError("config: "s + message);
+	}
+}
+
+std::string ReadFile(const std::string &path) {
+	std::ifstream file(path, std::ios::binary);
+	if(!file) {
+		throw ConfigError("config: cannot open "s + path);
+	}
+	std::ostringstream text;
+	text << file.rdbuf();
+	if(file.bad()) {
+		throw ConfigError("config: cannot read "s + path);
+	}
+	return text.str();
+}
+}
+
+// === СНИМОК ===
+
+bool PaymentConfig::Supports(common::PaymentMethod method) const {
+	for(const std::string &name : supported_methods) {
+		switch(method) {
+			case common::PaymentMethod::NFC:
+				if(name == "nfc_card"sv || name == "nfc_phone"sv) {
+					return true;
+				}
+				break;
+			case common::PaymentMethod::QR_CODE:
+				if(name == "qr_code"sv) {
+					return true;
+				}
+				break;
+			case common::PaymentMethod::BIOMETRIC:
+				if(name == "biometry_face"sv || name == "biometry_fingerprint"sv) {
+					return true;
+				}
+				break;
+			case common::PaymentMethod::CARD_INSERT:
+				if(name == "card_insert"sv) {
+					return true;
+				}
+				break;
+		}
+	}
+	return false;
+}
+
+const BankConfig *PaymentConfig::FindBank(std::string_view name) const {
+	for(const BankConfig &bank : acquiring) {
+		if(bank.name == name) {
+			return &bank;
+		}
+	}
+	return nullptr;
+}
+
+ConfigSnapshot ParseConfig(std::string_view json) {
+	Json root;
+	try {
+		root = Json::parse(json.begin(), json.end());
+	} catch(const Json::parse_error &e) {
+		throw ConfigError("config: "s + e.what());
+	}
+
+	ConfigSnapshot config;
+
+	const Json &terminal = At(root, "terminal"sv, "$"s);
+	config.terminal_id = Value<std::string>(terminal, "id"sv, "terminal"s);
+	config.location = Value<std::string>(terminal, "location"sv, "terminal"s);
+	config.version = Value<std::string>(terminal, "version"sv, "terminal"s);
+
+	const Json &hardware = At(terminal, "hardware"sv, "terminal"s);
+	config.hardware.platform = Value<std::string>(hardware, "platform"sv, "terminal.hardware"s);
+	const Json &display = At(hardware, "display"sv, "terminal.hardware"s);
+	config.hardware.display_resolution = Value<std::string>(display, "resolution"sv, "terminal.hardware.display"s);
+	config.hardware.touchscreen = Value<bool>(display, "touchscreen"sv, "terminal.hardware.display"s);
+	const Json &peripherals = At(hardware, "peripherals"sv, "terminal.hardware"s);
+	config.hardware.nfc_reader = ParseDevice(At(peripherals, "nfc_reader"sv, "peripherals"s), "peripherals.nfc_reader"s);
+	const Json &camera = At(peripherals, "camera"sv, "peripherals"s);
+	config.hardware.camera = ParseDevice(camera, "peripherals.camera"s);
+	config.hardware.camera_resolution = Value<std::string>(camera, "resolution"sv, "peripherals.camera"s);
+	config.hardware.fingerprint_scanner =
+		ParseDevice(At(peripherals, "fingerprint_scanner"sv, "peripherals"s), "peripherals.fingerprint_scanner"s);
+	const Json &fiscal = At(peripherals, "fiscal_registrator"sv, "peripherals"s);
+	config.hardware.fiscal_registrator = Value<bool>(fiscal, "enabled"sv, "peripherals.fiscal_registrator"s);
+	config.hardware.fiscal_model = Value<std::string>(fiscal, "model"sv, "peripherals.fiscal_registrator"s);
+	config.hardware.fiscal_connection = Value<std::string>(fiscal, "connection"sv, "peripherals.fiscal_registrator"s);
+
+	const Json &payment = At(root, "payment"sv, "$"s);
+	const Json &methods = At(payment, "supported_methods"sv, "payment"s);
+	Require(methods.is_array(), "payment.supported_methods is not an array");
+	for(const Json &method : methods) {
+		Require(method.is_string(), "payment.supported_methods must contain strings");
+		config.payment.supported_methods.push_back(method.get<std::string>());
+	}
+	const Json &banks = At(payment, "banks"sv, "payment"s);
+	const Json &acquiring = At(banks, "acquiring"sv, "payment.banks"s);
+	Require(acquiring.is_object(), "payment.banks.acquiring is not an object");
+	for(const auto &[name, bank] : acquiring.items()) {
+		config.payment.acquiring.push_back(ParseBank(bank, name, "payment.banks.acquiring."s + name));
+	}
+	config.payment.sbp = ParseBank(At(banks, "sbp"sv, "payment.banks"s), "sbp"s, "payment.banks.sbp"s);
+	const Json &limits = At(payment, "limits"sv, "payment"s);
+	config.payment.limits.min_amount = Money(limits, "min_amount"sv, "payment.limits"s);
+	config.payment.limits.max_amount = Money(limits, "max_amount"sv, "payment.limits"s);
+	config.payment.limits.daily_limit = Money(limits, "daily_limit"sv, "payment.limits"s);
+
+	const Json &security = At(root, "security"sv, "$"s);
+	const Json &encryption = At(security, "encryption"sv, "security"s);
+	config.security.encryption_algorithm = Value<std::string>(encryption, "algorithm"sv, "security.encryption"s);
+	config.security.key_rotation_days = Value<int>(encryption, "key_rotation_days"sv, "security.encryption"s);
+	const Json &biometry = At(security, "biometry"sv, "security"s);
+	const Json &face = At(biometry, "face_recognition"sv, "security.biometry"s);
+	config.security.face_confidence_threshold = Value<double>(face, "confidence_threshold"sv, "security.biometry.face_recognition"s);
+	config.security.liveness_detection = Value<bool>(face, "liveness_detection"sv, "security.biometry.face_recognition"s);
+	const Json &fingerprint = At(biometry, "fingerprint"sv, "security.biometry"s);
+	config.security.fingerprint_quality_threshold = Value<int>(fingerprint, "quality_threshold"sv, "security.biometry.fingerprint"s);
+	config.security.fingerprint_matching_threshold = Value<int>(fingerprint, "matching_threshold"sv, "security.biometry.fingerprint"s);
+	const Json &session = At(security, "session"sv, "security"s);
+	config.security.session_timeout = std::chrono::seconds(Value<int64_t>(session, "timeout_seconds"sv, "security.session"s));
+	config.security.max_attempts = Value<int>(session, "max_attempts"sv, "security.session"s);
+
+	const Json &network = At(root, "network"sv, "$"s);
+	const Json &api_server = At(network, "api_server"sv, "network"s);
+	config.network.api_url = Value<std::string>(api_server, "url"sv, "network.api_server"s);
+	config.network.api_timeout = std::chrono::seconds(Value<int64_t>(api_server, "timeout_seconds"sv, "network.api_server"s));
+	config.network.retry_attempts = Value<int>(api_server, "retry_attempts"sv, "network.api_server"s);
+	const Json &offline = At(network, "offline_mode"sv, "network"s);
+	config.network.offline_enabled = Value<bool>(offline, "enabled"sv, "network.offline_mode"s);
+	config.network.offline_max_transactions = Value<size_t>(offline, "max_transactions"sv, "network.offline_mode"s);
+	config.network.sync_interval = std::chrono::minutes(Value<int64_t>(offline, "sync_interval_minutes"sv, "network.offline_mode"s));
+	const Json &monitoring = At(network, "monitoring"sv, "network"s);
+	config.network.heartbeat_interval =
+		std::chrono::seconds(Value<int64_t>(monitoring, "heartbeat_interval_seconds"sv, "network.monitoring"s));
+	config.network.log_level = Value<std::string>(monitoring, "log_level"sv, "network.monitoring"s);
+
+	const Json &ui = At(root, "ui"sv, "$"s);
+	config.ui.language = Value<std::string>(ui, "language"sv, "ui"s);
+	config.ui.theme = Value<std::string>(ui, "theme"sv, "ui"s);
+	const Json &timeout = At(ui, "timeout"sv, "ui"s);
+	config.ui.idle_timeout = std::chrono::seconds(Value<int64_t>(timeout, "idle_seconds"sv, "ui.timeout"s));
+	config.ui.transaction_timeout = std::chrono::seconds(Value<int64_t>(timeout, "transaction_seconds"sv, "ui.timeout"s));
+	const Json &sounds = At(ui, "sounds"sv, "ui"s);
+	config.ui.sounds_enabled = Value<bool>(sounds, "enabled"sv, "ui.sounds"s);
+	config.ui.volume = Value<double>(sounds, "volume"sv, "ui.sounds"s);
+
+	const Json &local = At(At(root, "database"sv, "$"s), "local"sv, "database"s);
+	config.storage.database_path = Value<std::string>(local, "path"sv, "database.local"s);
+	config.storage.backup_interval = std::chrono::hours(Value<int64_t>(local, "backup_interval_hours"sv, "database.local"s));
+	const Json &logging = At(root, "logging"sv, "$"s);
+	config.storage.log_level = Value<std::string>(logging, "level"sv, "logging"s);
+	config.storage.log_file = Value<std::string>(logging, "file"sv, "logging"s);
+	config.storage.log_max_size_mb = Value<size_t>(logging, "max_size_mb"sv, "logging"s);
+	config.storage.log_backup_count = Value<int>(logging, "backup_count"sv, "logging"s);
+
+	// Проверки: ошибочный файл не должен заменить рабочую конфигурацию
+	Require(!config.terminal_id.empty(), "terminal.id is empty");
+	Require(!config.payment.supported_methods.empty(), "payment.supported_methods is empty");
+	Require(config.payment.limits.min_amount > 0 && config.payment.limits.min_amount <= config.payment.limits.max_amount &&
+				  config.payment.limits.max_amount <= config.payment.limits.daily_limit,
+			  "payment.limits must satisfy 0 < min_amount <= max_amount <= daily_limit");
+	Require(config.security.face_confidence_threshold >= 0 && config.security.face_confidence_threshold <= 1,
+			  "security.biometry.face_recognition.confidence_threshold must be within [0, 1]");
+	Require(config.security.session_timeout.count() > 0 && config.security.max_attempts > 0,
+			  "security.session values must be positive");
+	Require(config.network.api_timeout.count() > 0, "network.api_server.timeout_seconds must be positive");
+	Require(config.ui.volume >= 0 && config.ui.volume <= 1, "ui.sounds.volume must be within [0, 1]");
+	return config;
+}
+
+// === МЕНЕДЖЕР ===
+
+ConfigManager::ConfigManager(const ConfigManagerSettings &settings) : settings_(settings), instance_(next_instance++) {
+	std::shared_ptr<ConfigSnapshot> snapshot = Load();
+	Publish(std::move(snapshot));
+
+	if(!settings_.watch) {
+		return;
+	}
+
+	std::filesystem::path path = std::filesystem::absolute(settings_.path);
+	inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(inotify_fd_ < 0 ||
+		::inotify_add_watch(inotify_fd_, path.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+		const std::string reason = std::strerror(errno);
+		if(inotify_fd_ >= 0) {
+			::close(inotify_fd_);
+		}
+		throw ConfigError("config: cannot watch "s + path.parent_path().string() + ": "s + reason);
+	}
+	wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(wake_fd_ < 0) {
+		::close(inotify_fd_);
+		throw ConfigError("config: eventfd: "s + std::strerror(errno));
+	}
+	watcher_ = std::thread([this] {
+		Watch();
+	});
+}
+
+ConfigManager::~ConfigManager() {
+	if(watcher_.joinable()) {
+		const uint64_t one = 1;
+		[[maybe_unused]] const ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+		watcher_.join();
+	}
+	if(inotify_fd_ >= 0) {
+		::close(inotify_fd_);
+	}
+	if(wake_fd_ >= 0) {
+		::close(wake_fd_);
+	}
+}
+
+/**
+ * ЧТЕНИЕ СНИМКА
+ *
+ * Поколение публикуется после указателя: если поток видит поколение N,
+ * снимок N уже опубликован. Пока поколение совпадает с кэшем потока,
+ * общий указатель не читается вовсе.
+ */
+std::shared_ptr<const ConfigSnapshot> ConfigManager::Current() const {
+	ReaderCache &cache = reader_cache;
+	if(cache.instance != instance_ || cache.generation != generation_.load(std::memory_order_acquire)) {
+		cache.snapshot = std::atomic_load(&snapshot_);
+		cache.instance = instance_;
+		cache.generation = cache.snapshot->generation;
+	}
+	return cache.snapshot;
+}
+
+bool ConfigManager::Reload() {
+	std::lock_guard lock(reload_mutex_);
+	try {
+		std::shared_ptr<ConfigSnapshot> snapshot = Load();
+		if(!snapshot) {
+			return false;
+		}
+		Publish(std::move(snapshot));
+	} catch(const ConfigError &e) {
+		PAYGO_LOG(LogLevel::ERROR, "config {} not reloaded, keeping generation {}: {}", settings_.path, Generation(), e.what());
+		return false;
+	}
+	PAYGO_LOG(LogLevel::INFO, "config {} reloaded, generation {}", settings_.path, Generation());
+	return true;
+}
+
+std::shared_ptr<ConfigSnapshot> ConfigManager::Load() {
+	std::string text = ReadFile(settings_.path);
+	if(generation_.load() > 0 && text == loaded_text_) {
+		return nullptr;  // файл перезаписан тем же содержимым
+	}
+	auto snapshot = std::make_shared<ConfigSnapshot>(ParseConfig(text));
+	loaded_text_ = std::move(text);
+	return snapshot;
+}
+
+void ConfigManager::Publish(std::shared_ptr<ConfigSnapshot> snapshot) {
+	const uint64_t generation = generation_.load() + 1;
+	snapshot->generation = generation;
+	std::atomic_store(&snapshot_, std::shared_ptr<const ConfigSnapshot>(std::move(snapshot)));
+	generation_.store(generation, std::memory_order_release);
+}
+
+/**
+ * ПОТОК НАБЛЮДЕНИЯ
+ *
+ * Запись файла порождает несколько событий (создание, запись, закрытие,
+ * переименование); перечитывание откладывается, пока события не
+ * прекратятся на debounce. Переполнение очереди inotify - тоже повод
+ * перечитать файл.
+ */
+void ConfigManager::Watch() {
+	const std::string file_name = std::filesystem::path(settings_.path).filename().string();
+	bool changed = false;
+	auto deadline = std::chrono::steady_clock::now();
+
+	alignas(inotify_event) char buffer[4096];
+	while(true) {
+		int timeout_ms = -1;
+		if(changed) {
+			timeout_ms = static_cast<int>(std::max<int64_t>(
+				0, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count()));
+		}
+
+		pollfd descriptors[2] = {{wake_fd_, POLLIN, 0}, {inotify_fd_, POLLIN, 0}};
+		if(::poll(descriptors, 2, timeout_ms) < 0 && errno != EINTR) {
+			PAYGO_LOG(LogLevel::ERROR, "config watcher stopped: poll: {}", std::strerror(errno));
+			return;
+		}
+		if(descriptors[0].revents & POLLIN) {
+			return;
+		}
+
+		if(descriptors[1].revents & POLLIN) {
+			ssize_t size;
+			while((size = ::read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+				for(ssize_t offset = 0; offset < size;) {
+					const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+					if((event->mask & IN_Q_OVERFLOW) || (event->len > 0 && file_name == event->name)) {
+						changed = true;
+						deadline = std::chrono::steady_clock::now() + settings_.debounce;
+					}
+					offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+				}
+			}
+		}
+
+		if(changed && std::chrono::steady_clock::now() >= deadline) {
+			changed = false;
+			Reload();
+		}
+	}
+}
+}
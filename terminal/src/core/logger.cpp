@@ -0,0 +1,398 @@
+#include "core/logger.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <ctime>
+#include <utility>
+
+using namespace std::literals;
+
+namespace paygo::core {
+
+namespace detail {
+
+int64_t NowNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+Ring::Ring(size_t capacity) {
+	// Ёмкость - степень двойки: позиция в буфере вычисляется маской
+	capacity_ = 1024;
+	while(capacity_ < capacity) {
+		capacity_ <<= 1;
+	}
+	data_ = std::make_unique<char[]>(capacity_);
+}
+
+/**
+ * РЕЗЕРВИРОВАНИЕ МЕСТА (поток-владелец)
+ *
+ * head_ читается только тогда, когда по ранее прочитанному значению места
+ * не хватает: в обычном случае запись не касается строки кэша фонового потока.
+ */
+char *Ring::Reserve(size_t size) {
+	const uint64_t tail = tail_.load(std::memory_order_relaxed);
+	const size_t to_end = capacity_ - Offset(tail);
+	const size_t padding = size > to_end ? to_end : 0;
+	const size_t need = padding + size;
+	if(need > capacity_) {
+		return nullptr;
+	}
+
+	if(tail + need - cached_head_ > capacity_) {
+		cached_head_ = head_.load(std::memory_order_acquire);
+		if(tail + need - cached_head_ > capacity_) {
+			return nullptr;
+		}
+	}
+
+	if(padding > 0) {
+		const uint32_t marker = PADDING;
+		std::memcpy(data_.get() + Offset(tail), &marker, sizeof(marker));
+	}
+	padding_ = padding;
+	return data_.get() + Offset(tail + padding);
+}
+}
+
+namespace {
+
+// Буфер потока кэшируется вместе с id журнала: поиск буфера - одно сравнение
+struct ThreadRingCache {
+	uint64_t logger_id = 0;
+	std::shared_ptr<detail::Ring> ring;
+};
+
+thread_local ThreadRingCache thread_ring;
+
+std::atomic<uint64_t> next_logger_id{1};
+
+constexpr size_t WRITE_THRESHOLD = 256 << 10;  // размер блока записи в файл
+
+std::string_view LevelName(LogLevel level) {
+	switch(level) {
+		case LogLevel::DEBUG:
+			return "DEBUG"sv;
+		case LogLevel::INFO:
+			return "INFO"sv;
+		case LogLevel::WARNING:
+			return "WARNING"sv;
+		case LogLevel::ERROR:
+			return "ERROR"sv;
+	}
+	return "INFO"sv;
+}
+
+template <typename T>
+T Read(const char *&in) {
+	T value;
+	std::memcpy(&value, in, sizeof(value));
+	in += sizeof(value);
+	return value;
+}
+
+template <typename T>
+void AppendNumber(std::string &out, T value) {
+	char chars[32];
+	auto result = std::to_chars(chars, chars + sizeof(chars), value);
+	out.append(chars, result.ptr - chars);
+}
+
+/** Выводит один аргумент и возвращает указатель на следующий */
+const char *AppendArgument(std::string &out, const char *in) {
+	const auto type = static_cast<detail::ArgType>(*in++);
+	switch(type) {
+		case detail::ArgType::INT:
+			AppendNumber(out, Read<int64_t>(in));
+			break;
+		case detail::ArgType::UINT:
+			AppendNumber(out, Read<uint64_t>(in));
+			break;
+		case detail::ArgType::DOUBLE: {
+			char chars[32];
+			const int length = std::snprintf(chars, sizeof(chars), "%g", Read<double>(in));
+			out.append(chars, static_cast<size_t>(std::clamp(length, 0, static_cast<int>(sizeof(chars)) - 1)));
+			break;
+		}
+		case detail::ArgType::BOOL:
+			out += *in++ ? "true"sv : "false"sv;
+			break;
+		case detail::ArgType::CHAR:
+			out += *in++;
+			break;
+		case detail::ArgType::STRING: {
+			const uint32_t size = Read<uint32_t>(in);
+			out.append(in, size);
+			in += size;
+			break;
+		}
+		case detail::ArgType::POINTER: {
+			char chars[32];
+			const int length = std::snprintf(chars, sizeof(chars), "0x%llx", static_cast<unsigned long long>(Read<uint64_t>(in)));
+			out.append(chars, static_cast<size_t>(std::clamp(length, 0, static_cast<int>(sizeof(chars)) - 1)));
+			break;
+		}
+	}
+	return in;
+}
+}
+
+std::atomic<Logger *> Logger::default_logger_{nullptr};
+
+Logger::Logger(const LoggerSettings &settings)
+	: id_(next_logger_id.fetch_add(1)), settings_(settings), level_(settings.level) {
+	OpenFile();
+	out_.reserve(WRITE_THRESHOLD * 2);
+	writer_ = std::thread([this] {
+		WriterLoop();
+	});
+}
+
+Logger::~Logger() {
+	Logger *self = this;
+	default_logger_.compare_exchange_strong(self, nullptr);
+	{
+		std::lock_guard lock(wake_mutex_);
+		stop_ = true;
+	}
+	wake_.notify_all();
+	writer_.join();
+	if(fd_ >= 0) {
+		::close(fd_);
+	}
+}
+
+void Logger::SetDefault(Logger *logger) {
+	default_logger_.store(logger, std::memory_order_release);
+}
+
+/** Буфер текущего потока; при первом обращении потока создаётся и регистрируется */
+detail::Ring &Logger::ThreadRing() {
+	if(thread_ring.logger_id != id_) {
+		auto ring = std::make_shared<detail::Ring>(settings_.ring_bytes);
+		{
+			std::lock_guard lock(rings_mutex_);
+			rings_.push_back(ring);
+			reported_drops_.push_back(0);
+		}
+		thread_ring.logger_id = id_;
+		thread_ring.ring = std::move(ring);
+	}
+	return *thread_ring.ring;
+}
+
+void Logger::Flush() {
+	std::unique_lock lock(wake_mutex_);
+	const uint64_t ticket = ++flush_requested_;
+	wake_.notify_all();
+	flushed_.wait(lock, [this, ticket] {
+		return flush_done_ >= ticket || stop_;
+	});
+}
+
+LoggerStats Logger::GetStats() const {
+	LoggerStats stats;
+	stats.written = written_.load();
+	stats.dropped = dropped_.load();
+	stats.rotations = rotations_.load();
+	return stats;
+}
+
+/**
+ * ЦИКЛ ФОНОВОГО ПОТОКА
+ *
+ * Проход по всем буферам; если записей не было - ожидание flush_interval
+ * (или пробуждение от Flush/деструктора). Запрос Flush считается
+ * выполненным после прохода, начатого после запроса.
+ */
+void Logger::WriterLoop() {
+	while(true) {
+		uint64_t flush_ticket;
+		bool stopping;
+		{
+			std::lock_guard lock(wake_mutex_);
+			flush_ticket = flush_requested_;
+			stopping = stop_;
+		}
+
+		const bool had_records = DrainAll();
+		WriteOut();
+
+		std::unique_lock lock(wake_mutex_);
+		if(flush_ticket > flush_done_) {
+			flush_done_ = flush_ticket;
+			flushed_.notify_all();
+		}
+		if(stopping) {
+			return;  // последний проход сделан уже после установки stop_
+		}
+		if(!had_records) {
+			wake_.wait_for(lock, settings_.flush_interval, [this, flush_ticket] {
+				return stop_ || flush_requested_ > flush_ticket;
+			});
+		}
+	}
+}
+
+bool Logger::DrainAll() {
+	std::vector<std::shared_ptr<detail::Ring>> rings;
+	{
+		std::lock_guard lock(rings_mutex_);
+		rings = rings_;
+	}
+
+	auto consume = [this](const char *record, size_t) {
+		detail::RecordHeader header;
+		std::memcpy(&header, record, sizeof(header));
+		Format(header, record + sizeof(header));
+		if(out_.size() >= WRITE_THRESHOLD) {
+			WriteOut();
+		}
+	};
+
+	size_t count = 0;
+	for(size_t i = 0; i < rings.size(); ++i) {
+		count += rings[i]->Drain(consume);
+
+		// reported_drops_ меняет только этот поток; владельцы лишь добавляют элементы
+		const uint64_t dropped = rings[i]->Dropped();
+		uint64_t reported;
+		{
+			std::lock_guard lock(rings_mutex_);
+			reported = std::exchange(reported_drops_[i], dropped);
+		}
+		if(dropped > reported) {
+			dropped_ += dropped - reported;
+			AppendTimestamp(detail::NowNs());
+			out_ += "WARNING logger: "sv;
+			AppendNumber(out_, dropped - reported);
+			out_ += " records dropped (ring buffer full)\n"sv;
+		}
+	}
+	rings.clear();
+
+	// Буфер завершившегося потока (ссылка осталась только в rings_) дочитывается и удаляется
+	std::lock_guard lock(rings_mutex_);
+	for(size_t i = 0; i < rings_.size();) {
+		if(rings_[i].use_count() == 1) {
+			count += rings_[i]->Drain(consume);
+			rings_[i] = std::move(rings_.back());
+			rings_.pop_back();
+			reported_drops_[i] = reported_drops_.back();
+			reported_drops_.pop_back();
+			continue;
+		}
+		++i;
+	}
+	return count > 0;
+}
+
+/** Форматирует запись: "ГГГГ-ММ-ДД ЧЧ:ММ:СС.мкс УРОВЕНЬ сообщение [файл:строка]" */
+void Logger::Format(const detail::RecordHeader &header, const char *args) {
+	const LogSite &site = *header.site;
+	AppendTimestamp(header.timestamp_ns);
+	out_ += LevelName(site.level);
+	out_ += ' ';
+
+	std::string_view format = site.format;
+	uint32_t remaining = header.arg_count;
+	while(!format.empty()) {
+		const size_t placeholder = format.find("{}"sv);
+		if(placeholder == std::string_view::npos || remaining == 0) {
+			out_ += format;
+			break;
+		}
+		out_ += format.substr(0, placeholder);
+		args = AppendArgument(out_, args);
+		--remaining;
+		format.remove_prefix(placeholder + 2);
+	}
+	// Аргументы сверх числа "{}" выводятся через пробел
+	for(; remaining > 0; --remaining) {
+		out_ += ' ';
+		args = AppendArgument(out_, args);
+	}
+
+	std::string_view file = site.file;
+	if(size_t slash = file.rfind('/'); slash != std::string_view::npos) {
+		file.remove_prefix(slash + 1);
+	}
+	out_ += " ["sv;
+	out_ += file;
+	out_ += ':';
+	AppendNumber(out_, site.line);
+	out_ += "]\n"sv;
+	++written_;
+}
+
+/** Дата и время с точностью до микросекунды; локальное время пересчитывается раз в секунду */
+void Logger::AppendTimestamp(int64_t timestamp_ns) {
+	const int64_t second = timestamp_ns / 1'000'000'000;
+	if(second != cached_second_) {
+		const std::time_t time = static_cast<std::time_t>(second);
+		std::tm local{};
+		localtime_r(&time, &local);
+		char chars[32];
+		const size_t length = std::strftime(chars, sizeof(chars), "%Y-%m-%d %H:%M:%S", &local);
+		cached_prefix_.assign(chars, length);
+		cached_second_ = second;
+	}
+	out_ += cached_prefix_;
+
+	char micros[16];
+	std::snprintf(micros, sizeof(micros), ".%06d", static_cast<int>(timestamp_ns / 1000 % 1'000'000));
+	out_ += micros;
+	out_ += ' ';
+}
+
+void Logger::WriteOut() {
+	size_t offset = 0;
+	while(offset < out_.size() && fd_ >= 0) {
+		const ssize_t written = ::write(fd_, out_.data() + offset, out_.size() - offset);
+		if(written < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			break;  // журналу некуда сообщить об ошибке записи - данные теряются
+		}
+		offset += static_cast<size_t>(written);
+	}
+	file_bytes_ += offset;
+	out_.clear();
+
+	if(settings_.max_file_bytes > 0 && file_bytes_ >= settings_.max_file_bytes) {
+		Rotate();
+	}
+}
+
+/** terminal.log.(N-1) → terminal.log.N, ..., terminal.log → terminal.log.1 */
+void Logger::Rotate() {
+	if(fd_ >= 0) {
+		::close(fd_);
+		fd_ = -1;
+	}
+	if(settings_.backup_count == 0) {
+		std::remove(settings_.path.c_str());
+	} else {
+		for(size_t i = settings_.backup_count; i > 1; --i) {
+			std::rename((settings_.path + "." + std::to_string(i - 1)).c_str(), (settings_.path + "." + std::to_string(i)).c_str());
+		}
+		std::rename(settings_.path.c_str(), (settings_.path + ".1").c_str());
+	}
+	++rotations_;
+	OpenFile();
+}
+
+void Logger::OpenFile() {
+	fd_ = ::open(settings_.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	file_bytes_ = 0;
+	if(fd_ >= 0) {
+		const off_t size = ::lseek(fd_, 0, SEEK_END);
+		file_bytes_ = size > 0 ? static_cast<size_t>(size) : 0;
+	}
+}
+}
@@ -0,0 +1,522 @@
+#include "core/offline_queue.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+
+using namespace std::literals;
+
+namespace paygo::core {
+
+namespace {
+
+enum class RecordType : uint8_t {
+	ENTRY = 1,
+	ACK = 2,
+};
+
+constexpr size_t HEADER_SIZE = 4 + 4 + 1 + 8;    // size, crc32, type, sequence
+constexpr uint32_t MAX_PAYLOAD = 1 << 20;
+
+/** CRC-32 (IEEE 802.3, как в zlib), табличный вариант */
+uint32_t Crc32(uint32_t crc, std::string_view data) {
+	static const std::array<uint32_t, 256> TABLE = [] {
+		std::array<uint32_t, 256> table{};
+		for(uint32_t i = 0; i < 256; ++i) {
+			uint32_t value = i;
+			for(int bit = 0; bit < 8; ++bit) {
+				value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+			}
+			table[i] = value;
+		}
+		return table;
+	}();
+
+	crc = ~crc;
+	for(unsigned char byte : data) {
+		crc = TABLE[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+// === ДВОИЧНОЕ КОДИРОВАНИЕ (little-endian, как в памяти терминала) ===
+
+template <typename T>
+void Append(std::string &out, T value) {
+	out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void AppendString(std::string &out, std::string_view text) {
+	Append(out, static_cast<uint32_t>(text.size()));
+	out.append(text);
+}
+
+/** Чтение с проверкой границ: при выходе за конец данных ok становится false */
+class Reader {
+public:
+	explicit Reader(std::string_view data) : data_(data) {}
+
+	template <typename T>
+	T Read() {
+		T value{};
+		if(data_.size() < sizeof(value)) {
+			ok_ = false;
+			return value;
+		}
+		std::memcpy(&value, data_.data(), sizeof(value));
+		data_.remove_prefix(sizeof(value));
+		return value;
+	}
+
+	std::string ReadString() {
+		const uint32_t size = Read<uint32_t>();
+		if(!ok_ || data_.size() < size) {
+			ok_ = false;
+			return {};
+		}
+		std::string text(data_.substr(0, size));
+		data_.remove_prefix(size);
+		return text;
+	}
+
+	bool Ok() const {
+		return ok_;
+	}
+
+private:
+	std::string_view data_;
+	bool ok_ = true;
+};
+
+void EncodeTransaction(std::string &out, const common::Transaction &transaction) {
+	Append(out, transaction.id);
+	AppendString(out, transaction.reference);
+	AppendString(out, transaction.terminal_id);
+	Append(out, transaction.amount);
+	AppendString(out, transaction.currency);
+	Append(out, static_cast<uint8_t>(transaction.method));
+	Append(out, static_cast<uint8_t>(transaction.status));
+	AppendString(out, transaction.card_token);
+	AppendString(out, transaction.description);
+	Append(out, transaction.created_at);
+}
+
+bool DecodeTransaction(std::string_view data, common::Transaction &transaction) {
+	Reader reader(data);
+	transaction.id = reader.Read<int64_t>();
+	transaction.reference = reader.ReadString();
+	transaction.terminal_id = reader.ReadString();
+	transaction.amount = reader.Read<int64_t>();
+	transaction.currency = reader.ReadString();
+	transaction.method = static_cast<common::PaymentMethod>(reader.Read<uint8_t>());
+	transaction.status = static_cast<common::TransactionStatus>(reader.Read<uint8_t>());
+	transaction.card_token = reader.ReadString();
+	transaction.description = reader.ReadString();
+	transaction.created_at = reader.Read<int64_t>();
+	return reader.Ok();
+}
+
+/** Дописывает в out запись сегмента */
+void AppendRecord(std::string &out, RecordType type, uint64_t sequence, std::string_view payload) {
+	std::string body;
+	body.reserve(1 + 8 + payload.size());
+	Append(body, static_cast<uint8_t>(type));
+	Append(body, sequence);
+	body.append(payload);
+
+	Append(out, static_cast<uint32_t>(payload.size()));
+	Append(out, Crc32(0, body));
+	out += body;
+}
+
+void SyncDirectory(const std::string &directory) {
+	const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(fd >= 0) {
+		::fsync(fd);
+		::close(fd);
+	}
+}
+
+OfflineQueueError IoError(const std::string &what, const std::string &path) {
+	return OfflineQueueError(what + " "s + path + ": "s + std::strerror(errno));
+}
+}
+
+OfflineQueue::OfflineQueue(const OfflineQueueSettings &settings) : settings_(settings) {
+	settings_.max_pending = std::max<size_t>(1, settings_.max_pending);
+	std::filesystem::create_directories(settings_.directory);
+	Recover();
+	writer_ = std::thread([this] {
+		WriterLoop();
+	});
+}
+
+OfflineQueue::~OfflineQueue() {
+	{
+		std::lock_guard lock(mutex_);
+		stop_ = true;
+	}
+	has_work_.notify_all();
+	has_pending_.notify_all();
+	writer_.join();
+	if(fd_ >= 0) {
+		::close(fd_);
+	}
+}
+
+std::string OfflineQueue::SegmentPath(uint64_t number) const {
+	char name[32];
+	std::snprintf(name, sizeof(name), "offline-%08llu.seg", static_cast<unsigned long long>(number));
+	return settings_.directory + "/"s + name;
+}
+
+/**
+ * ВОССТАНОВЛЕНИЕ ПРИ ЗАПУСКЕ
+ *
+ * Сегменты читаются по возрастанию номера; ENTRY добавляет платёж,
+ * ACK удаляет. Пустые сегменты в начале удаляются, запись продолжается
+ * в новом сегменте.
+ */
+void OfflineQueue::Recover() {
+	std::vector<uint64_t> numbers;
+	for(const auto &file : std::filesystem::directory_iterator(settings_.directory)) {
+		const std::string name = file.path().filename().string();
+		constexpr std::string_view PREFIX = "offline-"sv;
+		constexpr std::string_view SUFFIX = ".seg"sv;
+		if(name.size() <= PREFIX.size() + SUFFIX.size() || name.compare(0, PREFIX.size(), PREFIX) != 0 ||
+			name.compare(name.size() - SUFFIX.size(), SUFFIX.size(), SUFFIX) != 0) {
+			continue;
+		}
+		uint64_t number = 0;
+		const char *first = name.data() + PREFIX.size();
+		const char *last = name.data() + name.size() - SUFFIX.size();
+		if(auto [end, error] = std::from_chars(first, last, number); error == std::errc() && end == last) {
+			numbers.push_back(number);
+		}
+	}
+	std::sort(numbers.begin(), numbers.end());
+
+	uint64_t max_sequence = 0;
+	for(size_t i = 0; i < numbers.size(); ++i) {
+		max_sequence = std::max(max_sequence, ReadSegment(numbers[i], i + 1 == numbers.size()));
+	}
+	next_sequence_ = max_sequence + 1;
+	stats_.recovered = pending_.size();
+
+	while(!segments_.empty() && segments_.front().live == 0) {
+		std::filesystem::remove(SegmentPath(segments_.front().number));
+		segments_.pop_front();
+	}
+	OpenSegment(numbers.empty() ? 1 : numbers.back() + 1);
+}
+
+/** Читает сегмент; возвращает наибольший номер платежа, упомянутый в нём */
+uint64_t OfflineQueue::ReadSegment(uint64_t number, bool last) {
+	const std::string path = SegmentPath(number);
+	std::ifstream file(path, std::ios::binary);
+	const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	segments_.push_back(Segment{number, 0});
+
+	uint64_t max_sequence = 0;
+	size_t offset = 0;
+	size_t valid_end = 0;   // конец последней целой записи
+	while(offset < data.size()) {
+		uint32_t size;
+		uint32_t crc;
+		if(data.size() - offset < HEADER_SIZE) {
+			break;
+		}
+		std::memcpy(&size, data.data() + offset, 4);
+		std::memcpy(&crc, data.data() + offset + 4, 4);
+		if(size > MAX_PAYLOAD || data.size() - offset - HEADER_SIZE < size) {
+			break;
+		}
+		const std::string_view body(data.data() + offset + 8, 1 + 8 + size);
+		offset += HEADER_SIZE + size;
+		if(Crc32(0, body) != crc) {
+			// Границы записи целы - повреждено только её содержимое, следующие записи читаются
+			++stats_.corrupted;
+			continue;
+		}
+
+		const auto type = static_cast<RecordType>(body[0]);
+		uint64_t sequence;
+		std::memcpy(&sequence, body.data() + 1, 8);
+		if(type == RecordType::ENTRY) {
+			common::Transaction transaction;
+			if(!DecodeTransaction(body.substr(9), transaction)) {
+				++stats_.corrupted;
+				continue;
+			}
+			pending_[sequence] = PendingEntry{std::move(transaction), number};
+			++segments_.back().live;
+		} else if(type == RecordType::ACK) {
+			if(auto it = pending_.find(sequence); it != pending_.end()) {
+				for(Segment &segment : segments_) {
+					if(segment.number == it->second.segment) {
+						--segment.live;
+						break;
+					}
+				}
+				pending_.erase(it);
+			}
+		}
+		max_sequence = std::max(max_sequence, sequence);
+		valid_end = offset;
+	}
+
+	if(offset < data.size()) {
+		++stats_.corrupted;   // оборванная запись; что за ней - не разобрать
+	}
+	if(last && valid_end < data.size()) {
+		// Оборванная при сбое запись: следующий запуск не должен натыкаться на неё снова
+		std::filesystem::resize_file(path, valid_end);
+	}
+	return max_sequence;
+}
+
+void OfflineQueue::OpenSegment(uint64_t number) {
+	const std::string path = SegmentPath(number);
+	fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if(fd_ < 0) {
+		throw IoError("cannot open"s, path);
+	}
+	SyncDirectory(settings_.directory);
+	segment_size_ = 0;
+
+	std::lock_guard lock(mutex_);
+	segments_.push_back(Segment{number, 0});
+}
+
+std::future<uint64_t> OfflineQueue::Enqueue(common::Transaction transaction) {
+	std::string payload;
+	EncodeTransaction(payload, transaction);
+
+	std::future<uint64_t> result;
+	{
+		std::lock_guard lock(mutex_);
+		if(pending_.size() + buffered_entries_.size() >= settings_.max_pending) {
+			throw OfflineQueueError("offline queue is full ("s + std::to_string(settings_.max_pending) + " payments)"s);
+		}
+		const uint64_t sequence = next_sequence_++;
+		AppendRecord(buffer_, RecordType::ENTRY, sequence, payload);
+		buffered_entries_.emplace_back(sequence, std::move(transaction));
+		result = buffered_promises_.emplace_back().get_future();
+		++stats_.enqueued;
+	}
+	has_work_.notify_one();
+	return result;
+}
+
+std::vector<OfflineEntry> OfflineQueue::Peek(size_t limit) const {
+	std::vector<OfflineEntry> entries;
+	std::lock_guard lock(mutex_);
+	for(auto it = pending_.begin(); it != pending_.end() && entries.size() < limit; ++it) {
+		entries.push_back(OfflineEntry{it->first, it->second.transaction});
+	}
+	return entries;
+}
+
+void OfflineQueue::Acknowledge(const std::vector<uint64_t> &sequences) {
+	{
+		std::lock_guard lock(mutex_);
+		for(uint64_t sequence : sequences) {
+			auto it = pending_.find(sequence);
+			if(it == pending_.end()) {
+				continue;
+			}
+			for(Segment &segment : segments_) {
+				if(segment.number == it->second.segment) {
+					--segment.live;
+					break;
+				}
+			}
+			pending_.erase(it);
+			AppendRecord(buffer_, RecordType::ACK, sequence, {});
+			++stats_.acknowledged;
+		}
+	}
+	has_work_.notify_one();
+}
+
+bool OfflineQueue::WaitPending(std::chrono::milliseconds timeout) const {
+	std::unique_lock lock(mutex_);
+	has_pending_.wait_for(lock, timeout, [this] {
+		return stop_ || !pending_.empty();
+	});
+	return !stop_ && !pending_.empty();
+}
+
+OfflineQueueStats OfflineQueue::GetStats() const {
+	std::lock_guard lock(mutex_);
+	OfflineQueueStats stats = stats_;
+	stats.pending = pending_.size();
+	stats.segments = segments_.size();
+	return stats;
+}
+
+/**
+ * ЦИКЛ ПОТОКА ЗАПИСИ
+ *
+ * 1. Забирает весь накопленный буфер (под нагрузкой - дождавшись, пока
+ *    пачка дорастёт до размера предыдущей, но не дольше max_delay)
+ * 2. Дописывает его в текущий сегмент и делает fdatasync
+ * 3. Публикует платежи для отправки и выполняет их future
+ * 4. Переходит к новому сегменту при достижении segment_bytes и удаляет
+ *    опустевшие сегменты с начала
+ * Завершается, когда установлен stop_ и буфер пуст.
+ */
+void OfflineQueue::WriterLoop() {
+	size_t last_batch = 0;
+	std::string data;
+	std::vector<std::pair<uint64_t, common::Transaction>> entries;
+	std::vector<std::promise<uint64_t>> promises;
+
+	while(true) {
+		{
+			std::unique_lock lock(mutex_);
+			has_work_.wait(lock, [this] {
+				return stop_ || !buffer_.empty();
+			});
+			if(buffer_.empty()) {
+				return;
+			}
+
+			const size_t target = last_batch;
+			if(target > 1 && settings_.max_delay.count() > 0 && !buffered_promises_.empty() && buffered_promises_.size() < target) {
+				has_work_.wait_until(lock, std::chrono::steady_clock::now() + settings_.max_delay, [this, target] {
+					return stop_ || buffered_promises_.size() >= target;
+				});
+			}
+			data.swap(buffer_);
+			entries.swap(buffered_entries_);
+			promises.swap(buffered_promises_);
+		}
+		last_batch = promises.size();
+
+		try {
+			WriteBatch(data);
+		} catch(const OfflineQueueError &) {
+			// Часть пачки могла попасть на диск: до следующей записи она отрезается
+			// (RepairSegment), иначе при запуске чтение сегмента остановилось бы на ней
+			// и потеряло все платежи, записанные после
+			try {
+				RepairSegment();
+			} catch(const OfflineQueueError &) {
+				// Повторная попытка - перед записью следующей пачки
+			}
+			for(auto &promise : promises) {
+				promise.set_exception(std::current_exception());
+			}
+			data.clear();
+			entries.clear();
+			promises.clear();
+			continue;
+		}
+
+		std::vector<uint64_t> dead_segments;
+		{
+			std::lock_guard lock(mutex_);
+			++stats_.syncs;
+			Segment &current = segments_.back();
+			for(auto &[sequence, transaction] : entries) {
+				pending_.emplace(sequence, PendingEntry{std::move(transaction), current.number});
+				++current.live;
+			}
+			while(segments_.size() > 1 && segments_.front().live == 0) {
+				dead_segments.push_back(segments_.front().number);
+				segments_.pop_front();
+			}
+		}
+		if(!entries.empty()) {
+			has_pending_.notify_all();
+		}
+		for(size_t i = 0; i < promises.size(); ++i) {
+			promises[i].set_value(entries[i].first);
+		}
+
+		for(uint64_t number : dead_segments) {
+			::unlink(SegmentPath(number).c_str());
+		}
+		if(segment_size_ >= settings_.segment_bytes) {
+			uint64_t number;
+			{
+				std::lock_guard lock(mutex_);
+				number = segments_.back().number + 1;
+			}
+			const int old_fd = fd_;
+			try {
+				OpenSegment(number);
+				::close(old_fd);
+			} catch(const OfflineQueueError &) {
+				fd_ = old_fd;  // новый сегмент не создан - продолжаем дописывать текущий
+			}
+		}
+
+		data.clear();
+		entries.clear();
+		promises.clear();
+	}
+}
+
+void OfflineQueue::WriteBatch(std::string &data) {
+	if(torn_) {
+		RepairSegment();
+	}
+	size_t offset = 0;
+	while(offset < data.size()) {
+		const ssize_t written = ::write(fd_, data.data() + offset, data.size() - offset);
+		if(written < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			torn_ = true;
+			throw IoError("cannot write"s, SegmentPath(segments_.back().number));
+		}
+		offset += static_cast<size_t>(written);
+	}
+	if(::fdatasync(fd_) != 0) {
+		torn_ = true;
+		throw IoError("cannot sync"s, SegmentPath(segments_.back().number));
+	}
+	segment_size_ += data.size();
+}
+
+/**
+ * После ошибки записи в конце сегмента могут остаться байты неудачной пачки.
+ * Сегмент обрезается до последней записанной пачки (segment_size_); если
+ * обрезать нельзя - запись продолжается в новом сегменте, а оборванный хвост
+ * старого остаётся последним, что в нём есть
+ */
+void OfflineQueue::RepairSegment() {
+	if(::ftruncate(fd_, static_cast<off_t>(segment_size_)) == 0 && ::fdatasync(fd_) == 0) {
+		torn_ = false;
+		return;
+	}
+	uint64_t number;
+	{
+		std::lock_guard lock(mutex_);
+		number = segments_.back().number + 1;
+	}
+	const int old_fd = fd_;
+	try {
+		OpenSegment(number);
+	} catch(const OfflineQueueError &) {
+		fd_ = old_fd;  // сегмент остаётся оборванным - следующая пачка не будет записана
+		throw;
+	}
+	::close(old_fd);
+	torn_ = false;
+}
+}
@@ -0,0 +1,254 @@
+#include "core/payment_processor.h"
+
+#include "core/logger.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <future>
+#include <random>
+#include <vector>
+
+using namespace std::literals;
+
+namespace paygo::core {
+
+namespace {
+
+int64_t SteadyNowMs() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void AppendJsonString(std::string &out, std::string_view text) {
+	out += '"';
+	for(char c : text) {
+		switch(c) {
+			case '"':
+				out += "\\\""sv;
+				break;
+			case '\\':
+				out += "\\\\"sv;
+				break;
+			case '\n':
+				out += "\\n"sv;
+				break;
+			case '\r':
+				out += "\\r"sv;
+				break;
+			case '\t':
+				out += "\\t"sv;
+				break;
+			default:
+				if(static_cast<unsigned char>(c) < 0x20) {
+					char escaped[8];
+					std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+					out += escaped;
+				} else {
+					out += c;
+				}
+		}
+	}
+	out += '"';
+}
+
+network::HttpRequest MakeRequest(const std::string &endpoint, const std::string &path, const common::Transaction &transaction) {
+	network::HttpRequest request;
+	request.endpoint = endpoint;
+	request.method = "POST"s;
+	request.path = path;
+	request.body = ToJson(transaction);
+	request.headers = {"Content-Type: application/json"s, "Idempotency-Key: "s + transaction.reference};
+	return request;
+}
+}
+
+std::string ToJson(const common::Transaction &transaction) {
+	std::string json;
+	json.reserve(256);
+	json += "{\"reference\":"sv;
+	AppendJsonString(json, transaction.reference);
+	json += ",\"terminal_id\":"sv;
+	AppendJsonString(json, transaction.terminal_id);
+	json += ",\"amount\":"sv;
+	json += std::to_string(transaction.amount);
+	json += ",\"currency\":"sv;
+	AppendJsonString(json, transaction.currency);
+	json += ",\"payment_method\":"sv;
+	AppendJsonString(json, common::ToString(transaction.method));
+	json += ",\"card_token\":"sv;
+	AppendJsonString(json, transaction.card_token);
+	json += ",\"description\":"sv;
+	AppendJsonString(json, transaction.description);
+	json += ",\"created_at\":"sv;
+	json += std::to_string(transaction.created_at);
+	json += '}';
+	return json;
+}
+
+// === ПРОВЕДЕНИЕ ПЛАТЕЖА ===
+
+PaymentProcessor::PaymentProcessor(const PaymentSettings &settings, network::ApiClient &client, OfflineQueue &queue)
+	: settings_(settings), client_(client), queue_(queue) {
+	client_.GetStats(settings_.endpoint);  // неизвестный сервер - std::invalid_argument сразу
+}
+
+/**
+ * ПРОВЕДЕНИЕ
+ *
+ * 1. Если сервер недавно был недоступен - сразу в офлайн-очередь
+ * 2. Иначе запрос к серверу: 2xx и 409 - одобрен, прочие 4xx - отклонён
+ * 3. Сетевая ошибка, 5xx, 408, 429 - сервер считается недоступным
+ *    на offline_probe_interval, платёж уходит в офлайн-очередь
+ */
+PaymentResult PaymentProcessor::Process(const common::Transaction &transaction) {
+	if(!Online()) {
+		return QueueOffline(transaction, "payment server marked unavailable"s);
+	}
+
+	try {
+		network::HttpResponse response = client_.Execute(MakeRequest(settings_.endpoint, settings_.path, transaction));
+		if(IsDelivered(response.status)) {
+			return PaymentResult{PaymentOutcome::APPROVED, response.status, std::move(response.body)};
+		}
+		if(!IsRetryable(response.status)) {
+			return PaymentResult{PaymentOutcome::DECLINED, response.status, std::move(response.body)};
+		}
+		offline_until_ = SteadyNowMs() + settings_.offline_probe_interval.count();
+		return QueueOffline(transaction, "HTTP "s + std::to_string(response.status));
+	} catch(const network::NetworkError &e) {
+		offline_until_ = SteadyNowMs() + settings_.offline_probe_interval.count();
+		return QueueOffline(transaction, e.what());
+	}
+}
+
+PaymentResult PaymentProcessor::QueueOffline(const common::Transaction &transaction, std::string reason) {
+	if(!settings_.offline_enabled) {
+		return PaymentResult{PaymentOutcome::FAILED, 0, std::move(reason)};
+	}
+	if(transaction.amount > settings_.offline_max_amount) {
+		return PaymentResult{PaymentOutcome::FAILED, 0, reason + " (amount exceeds offline limit)"s};
+	}
+
+	try {
+		queue_.Enqueue(transaction).get();  // только запись на диск
+	} catch(const OfflineQueueError &e) {
+		PAYGO_LOG(LogLevel::ERROR, "payment {} not queued offline: {}", transaction.reference, e.what());
+		return PaymentResult{PaymentOutcome::FAILED, 0, e.what()};
+	}
+	PAYGO_LOG(LogLevel::WARNING, "payment {} queued offline: {}", transaction.reference, reason);
+	return PaymentResult{PaymentOutcome::QUEUED_OFFLINE, 0, std::move(reason)};
+}
+
+void PaymentProcessor::MarkOnline() {
+	offline_until_ = 0;
+}
+
+bool PaymentProcessor::Online() const {
+	return SteadyNowMs() >= offline_until_.load();
+}
+
+// === ОТПРАВКА ОФЛАЙН-ОЧЕРЕДИ ===
+
+OfflineForwarder::OfflineForwarder(const ForwarderSettings &settings, OfflineQueue &queue, network::ApiClient &client,
+											  PaymentProcessor *processor)
+	: settings_(settings), queue_(queue), client_(client), processor_(processor) {
+	settings_.batch_size = std::max<size_t>(1, settings_.batch_size);
+	client_.GetStats(settings_.endpoint);  // неизвестный сервер - std::invalid_argument сразу
+	thread_ = std::thread([this] {
+		Loop();
+	});
+}
+
+OfflineForwarder::~OfflineForwarder() {
+	{
+		std::lock_guard lock(mutex_);
+		stop_ = true;
+	}
+	stop_signal_.notify_all();
+	thread_.join();
+}
+
+ForwarderStats OfflineForwarder::GetStats() const {
+	std::lock_guard lock(mutex_);
+	return stats_;
+}
+
+void OfflineForwarder::Loop() {
+	std::mt19937_64 random(std::random_device{}());
+	std::uniform_real_distribution<double> jitter(0.75, 1.25);
+	std::chrono::milliseconds backoff = settings_.initial_backoff;
+
+	while(true) {
+		{
+			std::lock_guard lock(mutex_);
+			if(stop_) {
+				return;
+			}
+		}
+		if(!queue_.WaitPending(settings_.idle_poll)) {
+			continue;
+		}
+
+		if(ForwardBatch()) {
+			backoff = settings_.initial_backoff;
+			continue;
+		}
+
+		const auto delay = std::chrono::milliseconds(static_cast<int64_t>(static_cast<double>(backoff.count()) * jitter(random)));
+		backoff = std::min(backoff * 2, settings_.max_backoff);
+
+		std::unique_lock lock(mutex_);
+		++stats_.retries;
+		stop_signal_.wait_for(lock, delay, [this] {
+			return stop_;
+		});
+	}
+}
+
+bool OfflineForwarder::ForwardBatch() {
+	const std::vector<OfflineEntry> entries = queue_.Peek(settings_.batch_size);
+	if(entries.empty()) {
+		return true;
+	}
+
+	std::vector<std::future<network::HttpResponse>> responses;
+	responses.reserve(entries.size());
+	for(const OfflineEntry &entry : entries) {
+		responses.push_back(client_.Send(MakeRequest(settings_.endpoint, settings_.path, entry.transaction)));
+	}
+
+	std::vector<uint64_t> done;
+	uint64_t delivered = 0;
+	uint64_t rejected = 0;
+	bool complete = true;
+	for(size_t i = 0; i < entries.size(); ++i) {
+		try {
+			const network::HttpResponse response = responses[i].get();
+			if(IsDelivered(response.status)) {
+				done.push_back(entries[i].sequence);
+				++delivered;
+			} else if(IsRetryable(response.status)) {
+				complete = false;
+			} else {
+				// Повтор не изменит ответ: платёж снимается с очереди, расхождение разбирается по журналу
+				PAYGO_LOG(LogLevel::ERROR, "offline payment {} rejected by server: HTTP {} {}", entries[i].transaction.reference,
+							 response.status, response.body);
+				done.push_back(entries[i].sequence);
+				++rejected;
+			}
+		} catch(const network::NetworkError &) {
+			complete = false;
+		}
+	}
+
+	queue_.Acknowledge(done);
+	if(delivered > 0 && processor_) {
+		processor_->MarkOnline();
+	}
+
+	std::lock_guard lock(mutex_);
+	++stats_.batches;
+	stats_.delivered += delivered;
+	stats_.rejected += rejected;
+	return complete;
+}
+}
@@ -0,0 +1,274 @@
+#include "database/cache_manager.h"
+
+#include <algorithm>
+
+using namespace std::literals;
+
+namespace paygo::database {
+
+namespace {
+
+// Служебные расходы на запись: узел списка, узел хеш-таблицы, две строки, поля Entry
+constexpr size_t ENTRY_OVERHEAD = 160;
+
+int64_t NowUnixMs() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+}
+
+// === КЭШ В ПАМЯТИ ===
+
+CacheManager::CacheManager(const CacheSettings &settings, CacheLoader loader)
+	: settings_(settings), loader_(std::move(loader)) {
+	settings_.shards = std::max<size_t>(1, settings_.shards);
+	shard_budget_ = settings_.max_bytes / settings_.shards;
+	shards_.reserve(settings_.shards);
+	for(size_t i = 0; i < settings_.shards; ++i) {
+		shards_.push_back(std::make_unique<Shard>());
+	}
+}
+
+CacheManager::Shard &CacheManager::ShardFor(std::string_view key) {
+	return *shards_[std::hash<std::string_view>{}(key) % shards_.size()];
+}
+
+CacheManager::Clock::time_point CacheManager::ExpiresAt(std::optional<std::chrono::milliseconds> ttl) const {
+	const std::chrono::milliseconds duration = ttl.value_or(settings_.default_ttl);
+	if(duration.count() <= 0) {
+		return Clock::time_point::max();
+	}
+	return Clock::now() + duration;
+}
+
+std::optional<std::string> CacheManager::Peek(std::string_view key) {
+	Shard &shard = ShardFor(key);
+	std::lock_guard lock(shard.mutex);
+	return Lookup(shard, key);
+}
+
+std::optional<std::string> CacheManager::Lookup(Shard &shard, std::string_view key) {
+	auto it = shard.index.find(key);
+	if(it == shard.index.end()) {
+		++shard.stats.misses;
+		return std::nullopt;
+	}
+	if(it->second->expires_at <= Clock::now()) {
+		Remove(shard, it->second);
+		++shard.stats.expirations;
+		++shard.stats.misses;
+		return std::nullopt;
+	}
+
+	shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+	++shard.stats.hits;
+	return it->second->value;
+}
+
+/**
+ * ЧТЕНИЕ С ДОЧИТЫВАНИЕМ
+ *
+ * Загрузчик вызывается без блокировки: обращение к диску не держит часть
+ * кэша. За это время ключ могут записать или удалить, поэтому после
+ * загрузки под блокировкой:
+ * - ключ уже в памяти (Put или соседний Get) - возвращается он, а не загруженное
+ * - поколение части изменилось (Put, Erase, Clear) - загруженное значение
+ *   могло устареть: оно возвращается, но не кэшируется
+ * - иначе значение заносится в кэш
+ */
+std::optional<std::string> CacheManager::Get(std::string_view key) {
+	Shard &shard = ShardFor(key);
+	uint64_t generation = 0;
+	{
+		std::lock_guard lock(shard.mutex);
+		if(std::optional<std::string> value = Lookup(shard, key)) {
+			return value;
+		}
+		generation = shard.generation;
+	}
+	if(!loader_) {
+		return std::nullopt;
+	}
+
+	std::optional<LoadedValue> loaded = loader_(key);
+	if(!loaded) {
+		return std::nullopt;
+	}
+
+	std::lock_guard lock(shard.mutex);
+	++shard.stats.loads;
+	if(auto it = shard.index.find(key); it != shard.index.end() && it->second->expires_at > Clock::now()) {
+		shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+		return it->second->value;
+	}
+	if(shard.generation == generation) {
+		Insert(shard, key, loaded->value, ExpiresAt(loaded->ttl));
+	}
+	return std::move(loaded->value);
+}
+
+void CacheManager::Put(std::string_view key, std::string value, std::optional<std::chrono::milliseconds> ttl) {
+	const Clock::time_point expires_at = ExpiresAt(ttl);
+	Shard &shard = ShardFor(key);
+	std::lock_guard lock(shard.mutex);
+	++shard.generation;
+	Insert(shard, key, std::move(value), expires_at);
+}
+
+bool CacheManager::Erase(std::string_view key) {
+	Shard &shard = ShardFor(key);
+	std::lock_guard lock(shard.mutex);
+	++shard.generation;
+	auto it = shard.index.find(key);
+	if(it == shard.index.end()) {
+		return false;
+	}
+	Remove(shard, it->second);
+	return true;
+}
+
+void CacheManager::Clear() {
+	for(const auto &shard : shards_) {
+		std::lock_guard lock(shard->mutex);
+		++shard->generation;
+		shard->index.clear();
+		shard->lru.clear();
+		shard->bytes = 0;
+	}
+}
+
+size_t CacheManager::PurgeExpired() {
+	size_t removed = 0;
+	const Clock::time_point now = Clock::now();
+	for(const auto &shard : shards_) {
+		std::lock_guard lock(shard->mutex);
+		for(auto it = shard->lru.begin(); it != shard->lru.end();) {
+			auto next = std::next(it);
+			if(it->expires_at <= now) {
+				Remove(*shard, it);
+				++shard->stats.expirations;
+				++removed;
+			}
+			it = next;
+		}
+	}
+	return removed;
+}
+
+CacheStats CacheManager::GetStats() const {
+	CacheStats total;
+	for(const auto &shard : shards_) {
+		std::lock_guard lock(shard->mutex);
+		total.hits += shard->stats.hits;
+		total.misses += shard->stats.misses;
+		total.loads += shard->stats.loads;
+		total.evictions += shard->stats.evictions;
+		total.expirations += shard->stats.expirations;
+		total.entries += shard->index.size();
+		total.bytes += shard->bytes;
+	}
+	return total;
+}
+
+/**
+ * ВСТАВКА ПОД БЛОКИРОВКОЙ ЧАСТИ
+ *
+ * Существующая запись заменяется. Затем с конца LRU удаляются записи,
+ * пока часть не уложится в бюджет: сначала в хвосте оказываются давно
+ * не читавшиеся, в том числе просроченные. Запись больше бюджета части
+ * не кэшируется вовсе.
+ */
+void CacheManager::Insert(Shard &shard, std::string_view key, std::string value, Clock::time_point expires_at) {
+	if(auto it = shard.index.find(key); it != shard.index.end()) {
+		Remove(shard, it->second);
+	}
+
+	const size_t bytes = key.size() + value.size() + ENTRY_OVERHEAD;
+	if(bytes > shard_budget_) {
+		return;
+	}
+
+	shard.lru.push_front(Entry{std::string(key), std::move(value), expires_at, bytes});
+	shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+	shard.bytes += bytes;
+
+	const Clock::time_point now = Clock::now();
+	while(shard.bytes > shard_budget_) {
+		auto victim = std::prev(shard.lru.end());
+		if(victim->expires_at <= now) {
+			++shard.stats.expirations;
+		} else {
+			++shard.stats.evictions;
+		}
+		Remove(shard, victim);
+	}
+}
+
+void CacheManager::Remove(Shard &shard, std::list<Entry>::iterator it) {
+	shard.bytes -= it->bytes;
+	shard.index.erase(it->key);
+	shard.lru.erase(it);
+}
+
+// === ПОСТОЯННОЕ ХРАНИЛИЩЕ ===
+
+SqliteCacheStore::SqliteCacheStore(const SqliteSettings &settings) : db_(settings) {
+	db_.Execute(R"(
+CREATE TABLE IF NOT EXISTS cache_entries (
+	key TEXT PRIMARY KEY,
+	value BLOB NOT NULL,
+	expires_at INTEGER
+) WITHOUT ROWID;
+)"s);
+}
+
+std::optional<LoadedValue> SqliteCacheStore::Load(std::string_view key) {
+	std::lock_guard lock(mutex_);
+	StatementScope select(db_.Prepare("SELECT value, expires_at FROM cache_entries WHERE key = ?"s));
+	select->Bind(1, key);
+	if(!select->Step()) {
+		return std::nullopt;
+	}
+
+	LoadedValue loaded{select->ColumnBlob(0), std::nullopt};
+	if(!select->ColumnIsNull(1)) {
+		const int64_t left = select->ColumnInt64(1) - NowUnixMs();
+		if(left <= 0) {
+			return std::nullopt;
+		}
+		loaded.ttl = std::chrono::milliseconds(left);
+	}
+	return loaded;
+}
+
+void SqliteCacheStore::Save(std::string_view key, std::string_view value, std::optional<std::chrono::milliseconds> ttl) {
+	std::lock_guard lock(mutex_);
+	StatementScope upsert(db_.Prepare("INSERT OR REPLACE INTO cache_entries(key, value, expires_at) VALUES(?, ?, ?)"s));
+	upsert->Bind(1, key).BindBlob(2, value);
+	if(ttl && ttl->count() > 0) {
+		upsert->Bind(3, NowUnixMs() + static_cast<int64_t>(ttl->count()));
+	} else {
+		upsert->BindNull(3);
+	}
+	upsert->Step();
+}
+
+void SqliteCacheStore::Erase(std::string_view key) {
+	std::lock_guard lock(mutex_);
+	StatementScope erase(db_.Prepare("DELETE FROM cache_entries WHERE key = ?"s));
+	erase->Bind(1, key);
+	erase->Step();
+}
+
+void SqliteCacheStore::PurgeExpired() {
+	std::lock_guard lock(mutex_);
+	StatementScope purge(db_.Prepare("DELETE FROM cache_entries WHERE expires_at IS NOT NULL AND expires_at <= ?"s));
+	purge->Bind(1, NowUnixMs());
+	purge->Step();
+}
+
+CacheLoader SqliteCacheStore::MakeLoader() {
+	return [this](std::string_view key) {
+		return Load(key);
+	};
+}
+}
@@ -0,0 +1,199 @@
+#include "database/sqlite_manager.h"
+
+#include <sqlite3.h>
+
+#include <algorithm>
+
+using namespace std::literals;
+
+namespace paygo::database {
+
+namespace {
+
+[[noreturn]] void Throw(sqlite3 *db, int code, std::string_view context) {
+	std::string message(context);
+	message += ": "sv;
+	message += db ? sqlite3_errmsg(db) : sqlite3_errstr(code);
+	throw DatabaseError(message, code);
+}
+
+void Check(sqlite3 *db, int code, std::string_view context) {
+	if(code != SQLITE_OK) {
+		Throw(db, code, context);
+	}
+}
+
+std::string_view SynchronousPragma(Synchronous synchronous) {
+	switch(synchronous) {
+		case Synchronous::OFF:
+			return "PRAGMA synchronous=OFF"sv;
+		case Synchronous::NORMAL:
+			return "PRAGMA synchronous=NORMAL"sv;
+		case Synchronous::FULL:
+			return "PRAGMA synchronous=FULL"sv;
+	}
+	return "PRAGMA synchronous=FULL"sv;
+}
+}
+
+// === ПОДГОТОВЛЕННЫЙ ЗАПРОС ===
+
+Statement::Statement(sqlite3 *db, const std::string &sql) : db_(db) {
+	// SQLITE_PREPARE_PERSISTENT: запрос будет жить долго, SQLite размещает его вне lookaside-памяти
+	Check(db_, sqlite3_prepare_v3(db_, sql.c_str(), static_cast<int>(sql.size()), SQLITE_PREPARE_PERSISTENT, &stmt_, nullptr),
+			"prepare"sv);
+}
+
+Statement::~Statement() {
+	sqlite3_finalize(stmt_);
+}
+
+Statement &Statement::Bind(int index, int64_t value) {
+	Check(db_, sqlite3_bind_int64(stmt_, index, value), "bind"sv);
+	return *this;
+}
+
+Statement &Statement::Bind(int index, double value) {
+	Check(db_, sqlite3_bind_double(stmt_, index, value), "bind"sv);
+	return *this;
+}
+
+Statement &Statement::Bind(int index, std::string_view value) {
+	// SQLITE_TRANSIENT: SQLite копирует строку, string_view может не пережить Step
+	Check(db_, sqlite3_bind_text(stmt_, index, value.data(), static_cast<int>(value.size()), SQLITE_TRANSIENT), "bind"sv);
+	return *this;
+}
+
+Statement &Statement::BindBlob(int index, std::string_view value) {
+	Check(db_, sqlite3_bind_blob(stmt_, index, value.data(), static_cast<int>(value.size()), SQLITE_TRANSIENT), "bind"sv);
+	return *this;
+}
+
+Statement &Statement::BindNull(int index) {
+	Check(db_, sqlite3_bind_null(stmt_, index), "bind"sv);
+	return *this;
+}
+
+bool Statement::Step() {
+	int code = sqlite3_step(stmt_);
+	if(code == SQLITE_ROW) {
+		return true;
+	}
+	if(code == SQLITE_DONE) {
+		return false;
+	}
+	Throw(db_, code, "step"sv);
+}
+
+void Statement::Reset() {
+	sqlite3_reset(stmt_);
+	sqlite3_clear_bindings(stmt_);
+}
+
+int64_t Statement::ColumnInt64(int column) const {
+	return sqlite3_column_int64(stmt_, column);
+}
+
+double Statement::ColumnDouble(int column) const {
+	return sqlite3_column_double(stmt_, column);
+}
+
+std::string Statement::ColumnText(int column) const {
+	const unsigned char *text = sqlite3_column_text(stmt_, column);
+	return text ? std::string(reinterpret_cast<const char *>(text), sqlite3_column_bytes(stmt_, column)) : std::string{};
+}
+
+std::string Statement::ColumnBlob(int column) const {
+	const void *data = sqlite3_column_blob(stmt_, column);
+	return data ? std::string(static_cast<const char *>(data), sqlite3_column_bytes(stmt_, column)) : std::string{};
+}
+
+bool Statement::ColumnIsNull(int column) const {
+	return sqlite3_column_type(stmt_, column) == SQLITE_NULL;
+}
+
+// === СОЕДИНЕНИЕ ===
+
+SqliteManager::SqliteManager(const SqliteSettings &settings) : cache_size_(std::max<size_t>(1, settings.statement_cache_size)) {
+	const int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX;
+	int code = sqlite3_open_v2(settings.path.c_str(), &db_, flags, nullptr);
+	if(code != SQLITE_OK) {
+		std::string message = "open "s + settings.path + ": "s + (db_ ? sqlite3_errmsg(db_) : sqlite3_errstr(code));
+		sqlite3_close(db_);
+		db_ = nullptr;
+		throw DatabaseError(message, code);
+	}
+
+	try {
+		Check(db_, sqlite3_busy_timeout(db_, settings.busy_timeout_ms), "busy_timeout"sv);
+		if(settings.wal) {
+			Execute("PRAGMA journal_mode=WAL"s);
+		}
+		Execute(std::string(SynchronousPragma(settings.synchronous)));
+	} catch(...) {
+		sqlite3_close(db_);
+		throw;
+	}
+}
+
+SqliteManager::~SqliteManager() {
+	// Запросы должны быть закрыты до соединения
+	statements_.clear();
+	sqlite3_close(db_);
+}
+
+void SqliteManager::Execute(const std::string &sql) {
+	char *error = nullptr;
+	int code = sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &error);
+	if(code != SQLITE_OK) {
+		std::string message = "exec: "s + (error ? error : sqlite3_errstr(code));
+		sqlite3_free(error);
+		throw DatabaseError(message, code);
+	}
+}
+
+Statement &SqliteManager::Prepare(const std::string &sql) {
+	if(auto it = statements_.find(sql); it != statements_.end()) {
+		lru_.splice(lru_.begin(), lru_, it->second.lru);
+		return *it->second.statement;
+	}
+
+	if(statements_.size() >= cache_size_) {
+		statements_.erase(lru_.back());
+		lru_.pop_back();
+	}
+
+	auto statement = std::make_unique<Statement>(db_, sql);
+	lru_.push_front(sql);
+	Statement &result = *statement;
+	statements_.emplace(sql, CachedStatement{std::move(statement), lru_.begin()});
+	return result;
+}
+
+void SqliteManager::Begin() {
+	StatementScope(Prepare("BEGIN IMMEDIATE"s))->Step();
+}
+
+void SqliteManager::Commit() {
+	StatementScope(Prepare("COMMIT"s))->Step();
+}
+
+void SqliteManager::Rollback() {
+	// Откат после ошибки не должен бросать: транзакция могла уже завершиться
+	if(InTransaction()) {
+		sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
+	}
+}
+
+bool SqliteManager::InTransaction() const {
+	return sqlite3_get_autocommit(db_) == 0;
+}
+
+int64_t SqliteManager::LastInsertRowId() const {
+	return sqlite3_last_insert_rowid(db_);
+}
+
+int SqliteManager::Changes() const {
+	return sqlite3_changes(db_);
+}
+}
@@ -0,0 +1,284 @@
+#include "database/transaction_storage.h"
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <exception>
+#include <string>
+
+using namespace std::literals;
+
+namespace paygo::database {
+
+namespace {
+
+const std::string SCHEMA = R"(
+CREATE TABLE IF NOT EXISTS transactions (
+	id INTEGER PRIMARY KEY,
+	reference TEXT NOT NULL UNIQUE,
+	terminal_id TEXT NOT NULL,
+	amount INTEGER NOT NULL CHECK (amount > 0),
+	currency TEXT NOT NULL DEFAULT 'RUB',
+	payment_method TEXT NOT NULL,
+	status TEXT NOT NULL,
+	card_token TEXT,
+	description TEXT,
+	created_at INTEGER NOT NULL
+);
+CREATE INDEX IF NOT EXISTS idx_transactions_status ON transactions(status, id);
+)";
+
+const std::string INSERT_SQL =
+	"INSERT INTO transactions(reference, terminal_id, amount, currency, payment_method, status, card_token, description, created_at) "
+	"VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?)";
+
+const std::string UPDATE_STATUS_SQL = "UPDATE transactions SET status = ? WHERE id = ?";
+
+const std::string SELECT_COLUMNS =
+	"SELECT id, reference, terminal_id, amount, currency, payment_method, status, card_token, description, created_at "
+	"FROM transactions ";
+
+/** Строка результата SELECT_COLUMNS → Transaction */
+common::Transaction ReadTransaction(const Statement &row) {
+	common::Transaction transaction;
+	transaction.id = row.ColumnInt64(0);
+	transaction.reference = row.ColumnText(1);
+	transaction.terminal_id = row.ColumnText(2);
+	transaction.amount = row.ColumnInt64(3);
+	transaction.currency = row.ColumnText(4);
+	transaction.method = common::ParsePaymentMethod(row.ColumnText(5)).value_or(common::PaymentMethod::NFC);
+	transaction.status = common::ParseTransactionStatus(row.ColumnText(6)).value_or(common::TransactionStatus::PENDING);
+	transaction.card_token = row.ColumnText(7);
+	transaction.description = row.ColumnText(8);
+	transaction.created_at = row.ColumnInt64(9);
+	return transaction;
+}
+}
+
+TransactionStorage::TransactionStorage(const StorageSettings &settings)
+	: settings_(settings), writer_(settings.database), reader_(settings.database) {
+	settings_.max_batch = std::max<size_t>(1, settings_.max_batch);
+	settings_.queue_limit = std::max(settings_.queue_limit, settings_.max_batch);
+
+	writer_.Execute(SCHEMA);
+	writer_thread_ = std::thread([this] {
+		WriterLoop();
+	});
+}
+
+TransactionStorage::~TransactionStorage() {
+	{
+		std::lock_guard lock(mutex_);
+		stop_ = true;
+	}
+	has_work_.notify_all();
+	writer_thread_.join();
+}
+
+std::future<int64_t> TransactionStorage::Store(common::Transaction transaction) {
+	StoreOperation operation{std::move(transaction), {}};
+	std::future<int64_t> result = operation.done.get_future();
+	Enqueue(std::move(operation));
+	return result;
+}
+
+std::future<void> TransactionStorage::UpdateStatus(int64_t id, common::TransactionStatus status) {
+	StatusOperation operation{id, status, {}};
+	std::future<void> result = operation.done.get_future();
+	Enqueue(std::move(operation));
+	return result;
+}
+
+void TransactionStorage::Enqueue(Operation operation) {
+	{
+		std::unique_lock lock(mutex_);
+		has_space_.wait(lock, [this] {
+			return queue_.size() < settings_.queue_limit;
+		});
+		queue_.push_back(std::move(operation));
+	}
+	has_work_.notify_one();
+}
+
+/**
+ * ЦИКЛ ПОТОКА-ПИСАТЕЛЯ
+ *
+ * Забирает из очереди пачку операций и фиксирует её. Завершается, когда
+ * установлен stop_ и очередь пуста - поставленные операции не теряются.
+ */
+void TransactionStorage::WriterLoop() {
+	std::vector<Operation> batch;
+	batch.reserve(settings_.max_batch);
+	size_t last_batch = 0;
+
+	while(true) {
+		{
+			std::unique_lock lock(mutex_);
+			has_work_.wait(lock, [this] {
+				return stop_ || !queue_.empty();
+			});
+			if(queue_.empty()) {
+				return;  // stop_ и всё записано
+			}
+
+			// Под нагрузкой ждём, пока пачка дорастёт до размера предыдущей
+			// (примерно столько касс ждут подтверждения), но не дольше max_delay
+			const size_t target = std::min(last_batch, settings_.max_batch);
+			if(target > 1 && settings_.max_delay.count() > 0 && queue_.size() < target) {
+				const auto deadline = std::chrono::steady_clock::now() + settings_.max_delay;
+				has_work_.wait_until(lock, deadline, [this, target] {
+					return stop_ || queue_.size() >= target;
+				});
+			}
+
+			const size_t count = std::min(queue_.size(), settings_.max_batch);
+			for(size_t i = 0; i < count; ++i) {
+				batch.push_back(std::move(queue_.front()));
+				queue_.pop_front();
+			}
+		}
+		has_space_.notify_all();
+
+		last_batch = batch.size();
+		CommitBatch(batch);
+		batch.clear();
+	}
+}
+
+void TransactionStorage::Apply(StoreOperation &operation, int64_t &id) {
+	const common::Transaction &transaction = operation.transaction;
+	StatementScope insert(writer_.Prepare(INSERT_SQL));
+	insert->Bind(1, transaction.reference)
+		 .Bind(2, transaction.terminal_id)
+		 .Bind(3, transaction.amount)
+		 .Bind(4, transaction.currency)
+		 .Bind(5, common::ToString(transaction.method))
+		 .Bind(6, common::ToString(transaction.status))
+		 .Bind(7, transaction.card_token)
+		 .Bind(8, transaction.description)
+		 .Bind(9, transaction.created_at);
+	insert->Step();
+	id = writer_.LastInsertRowId();
+}
+
+void TransactionStorage::Apply(StatusOperation &operation) {
+	StatementScope update(writer_.Prepare(UPDATE_STATUS_SQL));
+	update->Bind(1, common::ToString(operation.status)).Bind(2, operation.id);
+	update->Step();
+	if(writer_.Changes() == 0) {
+		throw DatabaseError("transaction not found: "s + std::to_string(operation.id), SQLITE_NOTFOUND);
+	}
+}
+
+/**
+ * ФИКСАЦИЯ ПАЧКИ
+ *
+ * АЛГОРИТМ:
+ * 1. BEGIN IMMEDIATE
+ * 2. Каждая операция выполняется отдельно; её ошибка запоминается,
+ *    а остальные операции продолжаются (ошибка ограничения откатывает
+ *    только свой запрос)
+ * 3. Если SQLite откатил всю транзакцию сам (ошибка ввода-вывода,
+ *    нехватка памяти), ошибку получают все операции пачки
+ * 4. COMMIT - единственный fsync пачки; только после него выполняются future
+ */
+void TransactionStorage::CommitBatch(std::vector<Operation> &batch) {
+	std::vector<int64_t> ids(batch.size(), 0);
+	std::vector<std::exception_ptr> errors(batch.size());
+
+	auto fail_all = [&](std::exception_ptr error) {
+		for(Operation &operation : batch) {
+			std::visit([&error](auto &op) {
+				op.done.set_exception(error);
+			}, operation);
+		}
+		failed_ += batch.size();
+	};
+
+	try {
+		writer_.Begin();
+		for(size_t i = 0; i < batch.size(); ++i) {
+			try {
+				if(auto *store = std::get_if<StoreOperation>(&batch[i])) {
+					Apply(*store, ids[i]);
+				} else {
+					Apply(std::get<StatusOperation>(batch[i]));
+				}
+			} catch(const DatabaseError &) {
+				if(!writer_.InTransaction()) {
+					throw;
+				}
+				errors[i] = std::current_exception();
+			}
+		}
+		writer_.Commit();
+	} catch(...) {
+		writer_.Rollback();
+		fail_all(std::current_exception());
+		return;
+	}
+
+	uint64_t failed = 0;
+	for(size_t i = 0; i < batch.size(); ++i) {
+		if(errors[i]) {
+			++failed;
+			std::visit([&](auto &op) {
+				op.done.set_exception(errors[i]);
+			}, batch[i]);
+		} else if(auto *store = std::get_if<StoreOperation>(&batch[i])) {
+			store->done.set_value(ids[i]);
+		} else {
+			std::get<StatusOperation>(batch[i]).done.set_value();
+		}
+	}
+
+	++commits_;
+	operations_ += batch.size();
+	failed_ += failed;
+	if(batch.size() > max_batch_.load()) {
+		max_batch_ = batch.size();  // пишет только поток-писатель
+	}
+}
+
+// === ЧТЕНИЕ ===
+
+std::optional<common::Transaction> TransactionStorage::Find(int64_t id) const {
+	std::lock_guard lock(reader_mutex_);
+	StatementScope select(reader_.Prepare(SELECT_COLUMNS + "WHERE id = ?"s));
+	select->Bind(1, id);
+	if(!select->Step()) {
+		return std::nullopt;
+	}
+	return ReadTransaction(*select);
+}
+
+std::optional<common::Transaction> TransactionStorage::FindByReference(std::string_view reference) const {
+	std::lock_guard lock(reader_mutex_);
+	StatementScope select(reader_.Prepare(SELECT_COLUMNS + "WHERE reference = ?"s));
+	select->Bind(1, reference);
+	if(!select->Step()) {
+		return std::nullopt;
+	}
+	return ReadTransaction(*select);
+}
+
+std::vector<common::Transaction> TransactionStorage::FindByStatus(common::TransactionStatus status, size_t limit) const {
+	std::vector<common::Transaction> result;
+	std::lock_guard lock(reader_mutex_);
+	StatementScope select(reader_.Prepare(SELECT_COLUMNS + "WHERE status = ? ORDER BY id LIMIT ?"s));
+	select->Bind(1, common::ToString(status)).Bind(2, static_cast<int64_t>(limit));
+	while(select->Step()) {
+		result.push_back(ReadTransaction(*select));
+	}
+	return result;
+}
+
+StorageStats TransactionStorage::GetStats() const {
+	StorageStats stats;
+	stats.commits = commits_.load();
+	stats.operations = operations_.load();
+	stats.failed = failed_.load();
+	stats.max_batch = max_batch_.load();
+	return stats;
+}
+}
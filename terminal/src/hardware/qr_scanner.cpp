@@ -0,0 +1,306 @@
+#include "hardware/qr_scanner.h"
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/objdetect.hpp>
+
+#include <algorithm>
+#include <cctype>
+
+using namespace std::literals;
+
+namespace paygo::hardware {
+
+namespace {
+
+constexpr size_t MIN_POOL_SIZE = 3;      // по буферу на каждый поток конвейера
+constexpr double DECODE_MARGIN = 0.1;    // запас вокруг углов при декодировании
+
+bool IsDeviceIndex(const std::string &source) {
+	return !source.empty() && std::all_of(source.begin(), source.end(), [](unsigned char c) {
+		return std::isdigit(c);
+	});
+}
+
+/** Прямоугольник углов с запасом margin (доля большей стороны), в пределах кадра */
+cv::Rect Surround(const std::vector<cv::Point2f> &corners, double margin, const cv::Rect &bounds) {
+	const cv::Rect box = cv::boundingRect(corners);
+	const int pad = static_cast<int>(std::max(box.width, box.height) * margin);
+	return cv::Rect(box.x - pad, box.y - pad, box.width + 2 * pad, box.height + 2 * pad) & bounds;
+}
+
+void ToGray(const cv::Mat &image, cv::Mat &gray) {
+	if(image.channels() == 1) {
+		image.copyTo(gray);
+	} else {
+		cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+	}
+}
+}
+
+QrScanner::QrScanner(const QrScannerSettings &settings, Handler handler) : settings_(settings), handler_(std::move(handler)) {
+	const bool opened = IsDeviceIndex(settings_.source) ? source_.open(std::stoi(settings_.source)) : source_.open(settings_.source);
+	if(!opened || !source_.isOpened()) {
+		throw QrScannerError("qr scanner: cannot open "s + settings_.source);
+	}
+	source_.set(cv::CAP_PROP_FRAME_WIDTH, settings_.width);
+	source_.set(cv::CAP_PROP_FRAME_HEIGHT, settings_.height);
+	source_fps_ = source_.get(cv::CAP_PROP_FPS);
+
+	const size_t pool_size = std::max(settings_.pool_size, MIN_POOL_SIZE);
+	pool_.reserve(pool_size);
+	for(size_t slot = 0; slot < pool_size; ++slot) {
+		pool_.emplace_back(settings_.height, settings_.width, CV_8UC3);
+		free_slots_.push_back(slot);
+	}
+
+	capture_ = std::thread([this] {
+		CaptureLoop();
+	});
+	detect_ = std::thread([this] {
+		DetectLoop();
+	});
+	decode_ = std::thread([this] {
+		DecodeLoop();
+	});
+}
+
+QrScanner::~QrScanner() {
+	stop_ = true;
+	capture_.join();
+	Close(to_detect_);
+	detect_.join();
+	Close(to_decode_);
+	decode_.join();
+}
+
+bool QrScanner::Finished() const {
+	std::lock_guard lock(mutex_);
+	return threads_done_ == 3;
+}
+
+bool QrScanner::WaitFinished(std::chrono::milliseconds timeout) const {
+	std::unique_lock lock(mutex_);
+	return finished_signal_.wait_for(lock, timeout, [this] {
+		return threads_done_ == 3;
+	});
+}
+
+QrScannerStats QrScanner::GetStats() const {
+	std::lock_guard lock(mutex_);
+	return stats_;
+}
+
+// === ПУЛ И ПЕРЕДАЧА КАДРОВ ===
+
+std::optional<size_t> QrScanner::AcquireSlot() {
+	std::lock_guard lock(mutex_);
+	if(free_slots_.empty()) {
+		return std::nullopt;
+	}
+	const size_t slot = free_slots_.back();
+	free_slots_.pop_back();
+	return slot;
+}
+
+void QrScanner::ReleaseSlot(size_t slot) {
+	std::lock_guard lock(mutex_);
+	free_slots_.push_back(slot);
+}
+
+void QrScanner::Put(Handoff &handoff, FrameTicket ticket) {
+	{
+		std::lock_guard lock(mutex_);
+		if(handoff.ticket) {
+			free_slots_.push_back(handoff.ticket->slot);
+			++stats_.dropped;
+		}
+		handoff.ticket = std::move(ticket);
+	}
+	handoff.ready.notify_one();
+}
+
+/** Следующий кадр; nullopt - передача закрыта и пуста */
+std::optional<QrScanner::FrameTicket> QrScanner::Take(Handoff &handoff) {
+	std::unique_lock lock(mutex_);
+	handoff.ready.wait(lock, [&handoff] {
+		return handoff.ticket.has_value() || handoff.closed;
+	});
+	std::optional<FrameTicket> ticket = std::move(handoff.ticket);
+	handoff.ticket.reset();
+	return ticket;
+}
+
+void QrScanner::Close(Handoff &handoff) {
+	{
+		std::lock_guard lock(mutex_);
+		handoff.closed = true;
+	}
+	handoff.ready.notify_all();
+}
+
+void QrScanner::ThreadDone() {
+	{
+		std::lock_guard lock(mutex_);
+		++threads_done_;
+	}
+	finished_signal_.notify_all();
+}
+
+// === ПОТОКИ КОНВЕЙЕРА ===
+
+/**
+ * ЗАХВАТ
+ *
+ * Без свободного буфера кадр всё равно читается (во временный буфер),
+ * чтобы камера не копила устаревшие кадры, и отбрасывается.
+ */
+void QrScanner::CaptureLoop() {
+	cv::Mat scratch;
+	uint64_t frame = 0;
+	const bool paced = settings_.pace_to_fps && source_fps_ > 0;
+	auto period = std::chrono::steady_clock::duration::zero();
+	if(paced) {
+		period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / source_fps_));
+	}
+	auto next = std::chrono::steady_clock::now();
+
+	while(!stop_) {
+		const std::optional<size_t> slot = AcquireSlot();
+		cv::Mat &target = slot ? pool_[*slot] : scratch;
+		if(!source_.read(target) || target.empty()) {
+			if(slot) {
+				ReleaseSlot(*slot);
+			}
+			break;
+		}
+		const auto captured_at = std::chrono::steady_clock::now();
+		++frame;
+		{
+			std::lock_guard lock(mutex_);
+			++stats_.captured;
+			if(!slot) {
+				++stats_.dropped;
+			}
+		}
+		if(slot) {
+			FrameTicket ticket;
+			ticket.slot = *slot;
+			ticket.frame = frame;
+			ticket.captured_at = captured_at;
+			Put(to_detect_, std::move(ticket));
+		}
+
+		if(paced) {
+			next += period;
+			std::this_thread::sleep_until(next);
+		}
+	}
+	Close(to_detect_);
+	ThreadDone();
+}
+
+/**
+ * ПОИСК
+ *
+ * Кадр сначала уменьшается, потом переводится в оттенки серого (так
+ * дешевле). Область интереса просматривается с вдвое большим масштабом,
+ * чем весь кадр (но не больше 1): она меньше, а код в ней мельче.
+ */
+void QrScanner::DetectLoop() {
+	cv::QRCodeDetector detector;
+	cv::Mat small;
+	cv::Mat gray;
+	std::optional<cv::Rect> roi;
+	int misses = 0;
+
+	while(std::optional<FrameTicket> ticket = Take(to_detect_)) {
+		const cv::Mat &frame = pool_[ticket->slot];
+		const cv::Rect bounds(0, 0, frame.cols, frame.rows);
+		const cv::Rect area = roi ? (*roi & bounds) : bounds;
+		const double scale = roi ? std::min(1.0, settings_.detect_scale * 2) : settings_.detect_scale;
+
+		cv::resize(frame(area), small, cv::Size(), scale, scale, cv::INTER_AREA);
+		ToGray(small, gray);
+		std::vector<cv::Point2f> corners;
+		const bool found = detector.detect(gray, corners) && corners.size() == 4;
+		{
+			std::lock_guard lock(mutex_);
+			++stats_.detected;
+			stats_.roi_scans += roi ? 1 : 0;
+			stats_.found += found ? 1 : 0;
+		}
+
+		if(!found) {
+			if(roi && ++misses >= settings_.roi_lost_frames) {
+				roi.reset();
+				misses = 0;
+			}
+			ReleaseSlot(ticket->slot);
+			continue;
+		}
+
+		for(cv::Point2f &corner : corners) {
+			corner.x = static_cast<float>(corner.x / scale + area.x);
+			corner.y = static_cast<float>(corner.y / scale + area.y);
+		}
+		roi = Surround(corners, settings_.roi_margin, bounds);
+		misses = 0;
+
+		ticket->corners = std::move(corners);
+		ticket->detected_at = std::chrono::steady_clock::now();
+		Put(to_decode_, std::move(*ticket));
+	}
+	Close(to_decode_);
+	ThreadDone();
+}
+
+void QrScanner::DecodeLoop() {
+	cv::QRCodeDetector detector;
+	cv::Mat gray;
+	std::string last_payload;
+	std::chrono::steady_clock::time_point last_seen;
+
+	while(std::optional<FrameTicket> ticket = Take(to_decode_)) {
+		const cv::Mat &frame = pool_[ticket->slot];
+		const cv::Rect area = Surround(ticket->corners, DECODE_MARGIN, cv::Rect(0, 0, frame.cols, frame.rows));
+		ToGray(frame(area), gray);
+		ReleaseSlot(ticket->slot);  // дальше нужна только серая копия окрестности кода
+
+		std::vector<cv::Point2f> local = ticket->corners;
+		for(cv::Point2f &corner : local) {
+			corner.x -= static_cast<float>(area.x);
+			corner.y -= static_cast<float>(area.y);
+		}
+		std::string payload = detector.decode(gray, local);
+		const auto decoded_at = std::chrono::steady_clock::now();
+
+		if(payload.empty()) {
+			std::lock_guard lock(mutex_);
+			++stats_.decode_failures;
+			continue;
+		}
+		if(payload == last_payload && decoded_at - last_seen < settings_.duplicate_window) {
+			last_seen = decoded_at;  // код всё ещё перед камерой
+			std::lock_guard lock(mutex_);
+			++stats_.duplicates;
+			continue;
+		}
+		last_payload = payload;
+		last_seen = decoded_at;
+		{
+			std::lock_guard lock(mutex_);
+			++stats_.decoded;
+		}
+
+		QrResult result;
+		result.payload = std::move(payload);
+		result.corners = std::move(ticket->corners);
+		result.frame = ticket->frame;
+		result.captured_at = ticket->captured_at;
+		result.detected_at = ticket->detected_at;
+		result.decoded_at = decoded_at;
+		handler_(result);
+	}
+	ThreadDone();
+}
+}
@@ -0,0 +1,280 @@
+#include "network/api_client.h"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+using namespace std::literals;
+
+namespace paygo::network {
+
+namespace {
+
+// Ожидание событий сокетов, если ни один запрос не завершился
+constexpr int POLL_TIMEOUT_MS = 1000;
+}
+
+ApiClient::ApiClient(const ApiClientSettings &settings, const SslManager &ssl) : settings_(settings), ssl_(ssl) {
+	InitCurl();
+
+	size_t total_connections = 0;
+	for(const EndpointSettings &endpoint : settings_.endpoints) {
+		auto [it, inserted] = endpoints_.emplace(endpoint.name, std::make_unique<Endpoint>());
+		if(!inserted) {
+			throw std::invalid_argument("duplicate endpoint: "s + endpoint.name);
+		}
+		it->second->settings = endpoint;
+		it->second->settings.max_connections = std::max<size_t>(1, endpoint.max_connections);
+		total_connections += it->second->settings.max_connections;
+	}
+
+	multi_ = curl_multi_init();
+	if(!multi_) {
+		throw NetworkError("curl_multi_init failed"s, CURLE_OUT_OF_MEMORY);
+	}
+	// Пул соединений multi вмещает все соединения всех банков - простаивающие не закрываются из-за размера пула
+	curl_multi_setopt(multi_, CURLMOPT_MAXCONNECTS, static_cast<long>(total_connections));
+	curl_multi_setopt(multi_, CURLMOPT_PIPELINING, static_cast<long>(CURLPIPE_MULTIPLEX));
+
+	thread_ = std::thread([this] {
+		EventLoop();
+	});
+}
+
+ApiClient::~ApiClient() {
+	{
+		std::lock_guard lock(mutex_);
+		stop_ = true;
+	}
+	curl_multi_wakeup(multi_);
+	thread_.join();
+
+	for(CURL *easy : idle_handles_) {
+		curl_easy_cleanup(easy);
+	}
+	curl_multi_cleanup(multi_);
+}
+
+std::future<HttpResponse> ApiClient::Send(HttpRequest request) {
+	auto transfer = std::make_unique<Transfer>();
+	transfer->request = std::move(request);
+	transfer->queued_at = Clock::now();
+	std::future<HttpResponse> result = transfer->done.get_future();
+
+	{
+		std::lock_guard lock(mutex_);
+		auto it = endpoints_.find(transfer->request.endpoint);
+		if(it == endpoints_.end()) {
+			throw std::invalid_argument("unknown endpoint: "s + transfer->request.endpoint);
+		}
+		transfer->endpoint = it->second.get();
+		it->second->queue.push_back(std::move(transfer));
+	}
+	curl_multi_wakeup(multi_);
+	return result;
+}
+
+EndpointStats ApiClient::GetStats(const std::string &endpoint) const {
+	std::lock_guard lock(mutex_);
+	auto it = endpoints_.find(endpoint);
+	if(it == endpoints_.end()) {
+		throw std::invalid_argument("unknown endpoint: "s + endpoint);
+	}
+	EndpointStats stats = it->second->stats;
+	stats.in_flight = it->second->in_flight;
+	stats.queued = it->second->queue.size();
+	return stats;
+}
+
+/**
+ * ЦИКЛ ПОТОКА КЛИЕНТА
+ *
+ * 1. Запросы из очередей банков запускаются, пока у банка есть свободные места
+ * 2. curl_multi_perform продвигает все запросы (соединение, TLS, отправка, приём)
+ * 3. Завершённые запросы выполняют свои future и освобождают места
+ * 4. Если ничего не завершилось - ожидание событий сокетов;
+ *    Send и деструктор прерывают ожидание через curl_multi_wakeup
+ */
+void ApiClient::EventLoop() {
+	while(true) {
+		{
+			std::lock_guard lock(mutex_);
+			if(stop_) {
+				break;
+			}
+		}
+
+		StartQueued();
+
+		int running = 0;
+		curl_multi_perform(multi_, &running);
+
+		bool finished = false;
+		int left = 0;
+		while(CURLMsg *message = curl_multi_info_read(multi_, &left)) {
+			if(message->msg == CURLMSG_DONE) {
+				Finish(message->easy_handle, message->data.result);
+				finished = true;
+			}
+		}
+
+		if(!finished) {
+			curl_multi_poll(multi_, nullptr, 0, POLL_TIMEOUT_MS, nullptr);
+		}
+	}
+	FailAll();
+}
+
+void ApiClient::StartQueued() {
+	std::vector<std::unique_ptr<Transfer>> ready;
+	{
+		std::lock_guard lock(mutex_);
+		for(auto &[name, endpoint] : endpoints_) {
+			while(!endpoint->queue.empty() && endpoint->in_flight < endpoint->settings.max_connections) {
+				ready.push_back(std::move(endpoint->queue.front()));
+				endpoint->queue.pop_front();
+				++endpoint->in_flight;
+			}
+		}
+	}
+	for(auto &transfer : ready) {
+		Start(std::move(transfer));
+	}
+}
+
+/** Настраивает CURL (из пула сброшенных или новый) под запрос и добавляет его в multi */
+void ApiClient::Start(std::unique_ptr<Transfer> transfer) {
+	CURL *easy = nullptr;
+	if(!idle_handles_.empty()) {
+		easy = idle_handles_.back();
+		idle_handles_.pop_back();
+	} else {
+		easy = curl_easy_init();
+	}
+
+	const EndpointSettings &endpoint = transfer->endpoint->settings;
+	const HttpRequest &request = transfer->request;
+	transfer->url = endpoint.base_url + request.path;
+	for(const std::string &header : request.headers) {
+		transfer->headers = curl_slist_append(transfer->headers, header.c_str());
+	}
+
+	ssl_.Apply(easy);
+	curl_easy_setopt(easy, CURLOPT_URL, transfer->url.c_str());
+	curl_easy_setopt(easy, CURLOPT_HTTPHEADER, transfer->headers);
+	curl_easy_setopt(easy, CURLOPT_USERAGENT, settings_.user_agent.c_str());
+	curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, &ApiClient::WriteBody);
+	curl_easy_setopt(easy, CURLOPT_WRITEDATA, transfer.get());
+	curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, transfer->error);
+	curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+
+	if(request.method == "GET"sv) {
+		curl_easy_setopt(easy, CURLOPT_HTTPGET, 1L);
+	} else {
+		if(request.method != "POST"sv) {
+			curl_easy_setopt(easy, CURLOPT_CUSTOMREQUEST, request.method.c_str());
+		}
+		curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE, static_cast<long>(request.body.size()));
+		curl_easy_setopt(easy, CURLOPT_POSTFIELDS, request.body.data());
+	}
+
+	curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(endpoint.connect_timeout.count()));
+	curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, static_cast<long>(endpoint.request_timeout.count()));
+	curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+	curl_easy_setopt(easy, CURLOPT_MAXAGE_CONN, static_cast<long>(settings_.idle_timeout.count()));
+	if(!endpoint.keep_alive) {
+		curl_easy_setopt(easy, CURLOPT_FRESH_CONNECT, 1L);
+		curl_easy_setopt(easy, CURLOPT_FORBID_REUSE, 1L);
+	}
+
+	const CURLMcode code = curl_multi_add_handle(multi_, easy);
+	if(code != CURLM_OK) {
+		Release(easy, *transfer);
+		{
+			std::lock_guard lock(mutex_);
+			--transfer->endpoint->in_flight;
+			++transfer->endpoint->stats.failures;
+		}
+		transfer->done.set_exception(std::make_exception_ptr(
+			NetworkError(endpoint.name + ": "s + curl_multi_strerror(code), CURLE_FAILED_INIT)));
+		return;
+	}
+	active_.emplace(easy, std::move(transfer));
+}
+
+void ApiClient::Finish(CURL *easy, CURLcode code) {
+	auto it = active_.find(easy);
+	if(it == active_.end()) {
+		return;
+	}
+	std::unique_ptr<Transfer> transfer = std::move(it->second);
+	active_.erase(it);
+	curl_multi_remove_handle(multi_, easy);
+
+	long status = 0;
+	long connects = 0;
+	curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &status);
+	curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &connects);
+
+	{
+		std::lock_guard lock(mutex_);
+		Endpoint &endpoint = *transfer->endpoint;
+		--endpoint.in_flight;
+		++endpoint.stats.requests;
+		endpoint.stats.connections += static_cast<uint64_t>(connects);
+		if(code != CURLE_OK) {
+			++endpoint.stats.failures;
+		}
+	}
+
+	if(code != CURLE_OK) {
+		const std::string detail = transfer->error[0] ? std::string(transfer->error) : std::string(curl_easy_strerror(code));
+		transfer->done.set_exception(std::make_exception_ptr(NetworkError(transfer->endpoint->settings.name + ": "s + detail, code)));
+	} else {
+		HttpResponse response;
+		response.status = status;
+		response.body = std::move(transfer->response_body);
+		response.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - transfer->queued_at);
+		response.new_connection = connects > 0;
+		transfer->done.set_value(std::move(response));
+	}
+	Release(easy, *transfer);
+}
+
+/** Освобождает заголовки запроса и возвращает сброшенный CURL в пул */
+void ApiClient::Release(CURL *easy, Transfer &transfer) {
+	curl_slist_free_all(transfer.headers);
+	transfer.headers = nullptr;
+	curl_easy_reset(easy);
+	idle_handles_.push_back(easy);
+}
+
+/** При остановке: запросы в работе и в очередях завершаются ошибкой */
+void ApiClient::FailAll() {
+	auto stopped = [](const Transfer &transfer) {
+		return std::make_exception_ptr(NetworkError(transfer.endpoint->settings.name + ": client stopped"s, CURLE_ABORTED_BY_CALLBACK));
+	};
+
+	for(auto &[easy, transfer] : active_) {
+		curl_multi_remove_handle(multi_, easy);
+		transfer->done.set_exception(stopped(*transfer));
+		Release(easy, *transfer);
+	}
+	active_.clear();
+
+	std::lock_guard lock(mutex_);
+	for(auto &[name, endpoint] : endpoints_) {
+		for(auto &transfer : endpoint->queue) {
+			transfer->done.set_exception(stopped(*transfer));
+		}
+		endpoint->queue.clear();
+		endpoint->in_flight = 0;
+	}
+}
+
+size_t ApiClient::WriteBody(char *data, size_t size, size_t count, void *user) {
+	static_cast<Transfer *>(user)->response_body.append(data, size * count);
+	return size * count;
+}
+}
@@ -0,0 +1,60 @@
+#include "network/ssl_manager.h"
+
+using namespace std::literals;
+
+namespace paygo::network {
+
+void InitCurl() {
+	static std::once_flag once;
+	std::call_once(once, [] {
+		const CURLcode code = curl_global_init(CURL_GLOBAL_DEFAULT);
+		if(code != CURLE_OK) {
+			throw NetworkError("curl_global_init failed: "s + curl_easy_strerror(code), code);
+		}
+	});
+}
+
+SslManager::SslManager(const TlsSettings &settings) : settings_(settings) {
+	InitCurl();
+	share_ = curl_share_init();
+	if(!share_) {
+		throw NetworkError("curl_share_init failed"s, CURLE_OUT_OF_MEMORY);
+	}
+
+	curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, &SslManager::Lock);
+	curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, &SslManager::Unlock);
+	curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+	curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	if(settings_.session_cache) {
+		curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+	}
+}
+
+SslManager::~SslManager() {
+	curl_share_cleanup(share_);
+}
+
+void SslManager::Apply(CURL *easy) const {
+	curl_easy_setopt(easy, CURLOPT_SHARE, share_);
+	curl_easy_setopt(easy, CURLOPT_SSLVERSION, static_cast<long>(CURL_SSLVERSION_TLSv1_2));
+	curl_easy_setopt(easy, CURLOPT_SSL_SESSIONID_CACHE, settings_.session_cache ? 1L : 0L);
+	curl_easy_setopt(easy, CURLOPT_SSL_VERIFYPEER, settings_.verify_peer ? 1L : 0L);
+	curl_easy_setopt(easy, CURLOPT_SSL_VERIFYHOST, settings_.verify_peer ? 2L : 0L);
+
+	if(!settings_.ca_file.empty()) {
+		curl_easy_setopt(easy, CURLOPT_CAINFO, settings_.ca_file.c_str());
+	}
+	if(!settings_.client_cert.empty()) {
+		curl_easy_setopt(easy, CURLOPT_SSLCERT, settings_.client_cert.c_str());
+		curl_easy_setopt(easy, CURLOPT_SSLKEY, settings_.client_key.c_str());
+	}
+}
+
+void SslManager::Lock(CURL *, curl_lock_data data, curl_lock_access, void *user) {
+	static_cast<SslManager *>(user)->locks_[data].lock();
+}
+
+void SslManager::Unlock(CURL *, curl_lock_data data, void *user) {
+	static_cast<SslManager *>(user)->locks_[data].unlock();
+}
+}
@@ -0,0 +1,831 @@
+#include "network/websocket_client.h"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+
+using namespace std::literals;
+
+namespace paygo::network {
+
+namespace {
+
+constexpr std::string_view WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"sv;
+constexpr size_t IOV_BATCH = 64;   // частей очереди в одном writev
+
+bool IsControl(Opcode opcode) {
+	return (static_cast<uint8_t>(opcode) & 0x8) != 0;
+}
+
+[[noreturn]] void ProtocolError(const std::string &message) {
+	throw WebSocketError("websocket: "s + message, close_code::PROTOCOL_ERROR);
+}
+
+WebSocketError SystemError(const std::string &what) {
+	return WebSocketError("websocket: "s + what + ": "s + std::strerror(errno), close_code::GOING_AWAY);
+}
+
+/** SHA-1 (FIPS 180-4) - только для Sec-WebSocket-Accept */
+std::array<uint8_t, 20> Sha1(std::string_view data) {
+	uint32_t h[5] = {0x67452301u, 0xEFCDAB89u, 0x98BADCFEu, 0x10325476u, 0xC3D2E1F0u};
+	auto rotl = [](uint32_t x, int n) {
+		return (x << n) | (x >> (32 - n));
+	};
+
+	std::string message(data);
+	const uint64_t bit_length = static_cast<uint64_t>(data.size()) * 8;
+	message += static_cast<char>(0x80);
+	while(message.size() % 64 != 56) {
+		message += '\0';
+	}
+	for(int i = 7; i >= 0; --i) {
+		message += static_cast<char>((bit_length >> (i * 8)) & 0xFF);
+	}
+
+	for(size_t block = 0; block < message.size(); block += 64) {
+		uint32_t w[80];
+		for(int i = 0; i < 16; ++i) {
+			const auto *p = reinterpret_cast<const uint8_t *>(message.data() + block + i * 4);
+			w[i] = (uint32_t{p[0]} << 24) | (uint32_t{p[1]} << 16) | (uint32_t{p[2]} << 8) | p[3];
+		}
+		for(int i = 16; i < 80; ++i) {
+			w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+		}
+
+		uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+		for(int i = 0; i < 80; ++i) {
+			uint32_t f, k;
+			if(i < 20) {
+				f = (b & c) | (~b & d);
+				k = 0x5A827999u;
+			} else if(i < 40) {
+				f = b ^ c ^ d;
+				k = 0x6ED9EBA1u;
+			} else if(i < 60) {
+				f = (b & c) | (b & d) | (c & d);
+				k = 0x8F1BBCDCu;
+			} else {
+				f = b ^ c ^ d;
+				k = 0xCA62C1D6u;
+			}
+			const uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+			e = d;
+			d = c;
+			c = rotl(b, 30);
+			b = a;
+			a = temp;
+		}
+		h[0] += a;
+		h[1] += b;
+		h[2] += c;
+		h[3] += d;
+		h[4] += e;
+	}
+
+	std::array<uint8_t, 20> digest;
+	for(int i = 0; i < 5; ++i) {
+		digest[i * 4] = static_cast<uint8_t>(h[i] >> 24);
+		digest[i * 4 + 1] = static_cast<uint8_t>(h[i] >> 16);
+		digest[i * 4 + 2] = static_cast<uint8_t>(h[i] >> 8);
+		digest[i * 4 + 3] = static_cast<uint8_t>(h[i]);
+	}
+	return digest;
+}
+
+std::string Base64(const uint8_t *data, size_t size) {
+	static constexpr char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	std::string out;
+	out.reserve((size + 2) / 3 * 4);
+	for(size_t i = 0; i < size; i += 3) {
+		const uint32_t chunk = (uint32_t{data[i]} << 16) | (i + 1 < size ? uint32_t{data[i + 1]} << 8 : 0) |
+									  (i + 2 < size ? uint32_t{data[i + 2]} : 0);
+		out += ALPHABET[(chunk >> 18) & 0x3F];
+		out += ALPHABET[(chunk >> 12) & 0x3F];
+		out += i + 1 < size ? ALPHABET[(chunk >> 6) & 0x3F] : '=';
+		out += i + 2 < size ? ALPHABET[chunk & 0x3F] : '=';
+	}
+	return out;
+}
+
+std::string ToLower(std::string_view text) {
+	std::string lower(text);
+	std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) {
+		return static_cast<char>(std::tolower(c));
+	});
+	return lower;
+}
+
+/** Значение заголовка HTTP-ответа (имя - в нижнем регистре) */
+std::string_view HeaderValue(std::string_view headers, std::string_view lower_headers, std::string_view name) {
+	size_t position = 0;
+	while((position = lower_headers.find(name, position)) != std::string_view::npos) {
+		if(position >= 2 && lower_headers.substr(position - 2, 2) == "\r\n"sv &&
+			lower_headers.substr(position + name.size(), 1) == ":"sv) {
+			size_t begin = position + name.size() + 1;
+			size_t end = headers.find("\r\n"sv, begin);
+			std::string_view value = headers.substr(begin, end - begin);
+			while(!value.empty() && value.front() == ' ') {
+				value.remove_prefix(1);
+			}
+			while(!value.empty() && value.back() == ' ') {
+				value.remove_suffix(1);
+			}
+			return value;
+		}
+		position += name.size();
+	}
+	return {};
+}
+
+/** Ждёт готовности сокета; false - таймаут */
+bool WaitSocket(int fd, short events, int timeout_ms) {
+	pollfd descriptor{fd, events, 0};
+	while(true) {
+		const int ready = ::poll(&descriptor, 1, timeout_ms);
+		if(ready < 0 && errno == EINTR) {
+			continue;
+		}
+		if(ready < 0) {
+			throw SystemError("poll"s);
+		}
+		return ready > 0;
+	}
+}
+}
+
+// === КОДЕК ===
+
+ParseStatus ParseFrameHeader(const uint8_t *data, size_t size, FrameHeader &header) {
+	if(size < 2) {
+		return ParseStatus::INCOMPLETE;
+	}
+	if(data[0] & 0x70) {
+		ProtocolError("reserved bits set without negotiated extension"s);
+	}
+	const uint8_t opcode = data[0] & 0x0F;
+	if(opcode > 0xA || (opcode > 0x2 && opcode < 0x8)) {
+		ProtocolError("unknown opcode "s + std::to_string(opcode));
+	}
+	header.fin = (data[0] & 0x80) != 0;
+	header.opcode = static_cast<Opcode>(opcode);
+	header.masked = (data[1] & 0x80) != 0;
+
+	size_t position = 2;
+	uint64_t length = data[1] & 0x7F;
+	if(length == 126) {
+		if(size < 4) {
+			return ParseStatus::INCOMPLETE;
+		}
+		length = (uint64_t{data[2]} << 8) | data[3];
+		if(length < 126) {
+			ProtocolError("non-minimal payload length"s);
+		}
+		position = 4;
+	} else if(length == 127) {
+		if(size < 10) {
+			return ParseStatus::INCOMPLETE;
+		}
+		length = 0;
+		for(size_t i = 2; i < 10; ++i) {
+			length = (length << 8) | data[i];
+		}
+		if((length >> 63) != 0 || length < 65536) {
+			ProtocolError("invalid 64-bit payload length"s);
+		}
+		position = 10;
+	}
+
+	if(header.masked) {
+		if(size < position + 4) {
+			return ParseStatus::INCOMPLETE;
+		}
+		std::memcpy(&header.mask, data + position, 4);
+		position += 4;
+	}
+	if(IsControl(header.opcode) && (!header.fin || length > 125)) {
+		ProtocolError("fragmented or oversized control frame"s);
+	}
+
+	header.payload_size = length;
+	header.header_size = position;
+	return ParseStatus::COMPLETE;
+}
+
+size_t EncodeFrameHeader(uint8_t *out, Opcode opcode, bool fin, uint64_t payload_size, const uint32_t *mask) {
+	out[0] = static_cast<uint8_t>((fin ? 0x80 : 0x00) | static_cast<uint8_t>(opcode));
+	const uint8_t mask_bit = mask ? 0x80 : 0x00;
+	size_t position;
+	if(payload_size < 126) {
+		out[1] = static_cast<uint8_t>(mask_bit | payload_size);
+		position = 2;
+	} else if(payload_size <= 0xFFFF) {
+		out[1] = mask_bit | 126;
+		out[2] = static_cast<uint8_t>(payload_size >> 8);
+		out[3] = static_cast<uint8_t>(payload_size);
+		position = 4;
+	} else {
+		out[1] = mask_bit | 127;
+		for(int i = 0; i < 8; ++i) {
+			out[2 + i] = static_cast<uint8_t>(payload_size >> (56 - i * 8));
+		}
+		position = 10;
+	}
+	if(mask) {
+		std::memcpy(out + position, mask, 4);
+		position += 4;
+	}
+	return position;
+}
+
+/**
+ * СНЯТИЕ МАСКИ
+ *
+ * Маска повторяется каждые 4 байта, поэтому её можно размножить на 16/32
+ * байта и обрабатывать данные векторами: AVX2/SSE2 на x86, NEON на ARM
+ * (Raspberry Pi), иначе словами по 8 байт. Остаток - побайтно.
+ */
+void Unmask(uint8_t *data, size_t size, uint32_t mask, size_t offset) {
+	uint8_t key[4];
+	std::memcpy(key, &mask, 4);
+	alignas(32) uint8_t pattern[32];
+	for(size_t i = 0; i < sizeof(pattern); ++i) {
+		pattern[i] = key[(i + offset) & 3];
+	}
+
+	size_t i = 0;
+#if defined(__AVX2__)
+	const __m256i wide = _mm256_load_si256(reinterpret_cast<const __m256i *>(pattern));
+	for(; i + 32 <= size; i += 32) {
+		__m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(data + i), _mm256_xor_si256(chunk, wide));
+	}
+#endif
+#if defined(__SSE2__)
+	const __m128i vector = _mm_load_si128(reinterpret_cast<const __m128i *>(pattern));
+	for(; i + 16 <= size; i += 16) {
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(data + i), _mm_xor_si128(chunk, vector));
+	}
+#elif defined(__ARM_NEON)
+	const uint8x16_t vector = vld1q_u8(pattern);
+	for(; i + 16 <= size; i += 16) {
+		vst1q_u8(data + i, veorq_u8(vld1q_u8(data + i), vector));
+	}
+#endif
+	uint64_t word_mask;
+	std::memcpy(&word_mask, pattern, 8);
+	for(; i + 8 <= size; i += 8) {
+		uint64_t word;
+		std::memcpy(&word, data + i, 8);
+		word ^= word_mask;
+		std::memcpy(data + i, &word, 8);
+	}
+	for(; i < size; ++i) {
+		data[i] ^= pattern[i & 3];
+	}
+}
+
+std::string ComputeAcceptKey(std::string_view key) {
+	std::string input(key);
+	input += WEBSOCKET_GUID;
+	const std::array<uint8_t, 20> digest = Sha1(input);
+	return Base64(digest.data(), digest.size());
+}
+
+/**
+ * ПРОВЕРКА UTF-8
+ *
+ * Вне символа ASCII пропускается по 8 байт за шаг. Ведущий байт задаёт
+ * число продолжающих байтов и диапазон первого из них: E0 - от A0
+ * (избыточная форма), ED - до 9F (суррогаты), F0 - от 90, F4 - до 8F
+ * (больше U+10FFFF). C0, C1 и F5..FF не встречаются никогда.
+ */
+bool Utf8Validator::Feed(std::string_view data) {
+	const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data.data());
+	const size_t size = data.size();
+	size_t i = 0;
+	while(i < size) {
+		if(needed_ == 0) {
+			uint64_t word;
+			while(i + 8 <= size) {
+				std::memcpy(&word, bytes + i, 8);
+				if((word & 0x8080808080808080ull) != 0) {
+					break;
+				}
+				i += 8;
+			}
+			if(i == size) {
+				break;
+			}
+
+			const uint8_t lead = bytes[i++];
+			if(lead < 0x80) {
+				continue;
+			}
+			if(lead >= 0xC2 && lead <= 0xDF) {
+				needed_ = 1;
+			} else if(lead >= 0xE0 && lead <= 0xEF) {
+				needed_ = 2;
+				lower_ = lead == 0xE0 ? 0xA0 : 0x80;
+				upper_ = lead == 0xED ? 0x9F : 0xBF;
+			} else if(lead >= 0xF0 && lead <= 0xF4) {
+				needed_ = 3;
+				lower_ = lead == 0xF0 ? 0x90 : 0x80;
+				upper_ = lead == 0xF4 ? 0x8F : 0xBF;
+			} else {
+				return false;
+			}
+		} else {
+			const uint8_t next = bytes[i++];
+			if(next < lower_ || next > upper_) {
+				return false;
+			}
+			lower_ = 0x80;
+			upper_ = 0xBF;
+			--needed_;
+		}
+	}
+	return true;
+}
+
+// === КОЛЬЦЕВОЙ БУФЕР ===
+
+ReceiveRing::ReceiveRing(size_t capacity) {
+	const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+	capacity_ = std::max(page, (capacity + page - 1) / page * page);
+
+	const int fd = ::memfd_create("paygo-ws-ring", MFD_CLOEXEC);
+	if(fd < 0) {
+		throw SystemError("memfd_create"s);
+	}
+	if(::ftruncate(fd, static_cast<off_t>(capacity_)) != 0) {
+		const WebSocketError error = SystemError("ftruncate"s);
+		::close(fd);
+		throw error;
+	}
+
+	// Резервируем 2 * capacity адресов, затем отображаем в обе половины один и тот же файл
+	void *region = ::mmap(nullptr, capacity_ * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(region == MAP_FAILED) {
+		const WebSocketError error = SystemError("mmap"s);
+		::close(fd);
+		throw error;
+	}
+	base_ = static_cast<uint8_t *>(region);
+	if(::mmap(base_, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+		::mmap(base_ + capacity_, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		const WebSocketError error = SystemError("mmap"s);
+		::munmap(base_, capacity_ * 2);
+		::close(fd);
+		throw error;
+	}
+	::close(fd);  // отображения держат файл
+}
+
+ReceiveRing::~ReceiveRing() {
+	::munmap(base_, capacity_ * 2);
+}
+
+// === РАЗБОР ===
+
+FrameReader::FrameReader(const FrameReaderSettings &settings) : settings_(settings) {}
+
+void FrameReader::CheckText(std::string_view data, bool fin) {
+	if(!utf8_.Feed(data) || (fin && !utf8_.Complete())) {
+		throw WebSocketError("websocket: text message is not valid UTF-8"s, close_code::INVALID_PAYLOAD);
+	}
+}
+
+/**
+ * РАЗБОР КАДРОВ НА МЕСТЕ
+ *
+ * Кадр обрабатывается, только когда он получен целиком. Маска снимается
+ * прямо в буфере. Управляющие кадры могут приходить между фрагментами
+ * сообщения и передаются сразу. Байты кадра освобождаются после
+ * возврата из обработчика.
+ *
+ * Предел max_message_bytes проверяется до копирования: у первого фрагмента
+ * при сборке - сразу, у следующих - по сумме с уже собранным.
+ * Текст проверяется на UTF-8 по кадрам, с состоянием между фрагментами.
+ */
+size_t FrameReader::Parse(ReceiveRing &ring, const MessageHandler &handler) {
+	size_t delivered = 0;
+	while(true) {
+		uint8_t *data = ring.ReadData();
+		const size_t available = ring.Readable();
+
+		FrameHeader header;
+		if(ParseFrameHeader(data, available, header) == ParseStatus::INCOMPLETE) {
+			break;
+		}
+		if(header.payload_size > ring.Capacity() - header.header_size) {
+			throw WebSocketError("websocket: frame of "s + std::to_string(header.payload_size) + " bytes exceeds receive buffer"s,
+										close_code::MESSAGE_TOO_BIG);
+		}
+		const size_t frame_size = header.header_size + static_cast<size_t>(header.payload_size);
+		if(available < frame_size) {
+			break;
+		}
+		if(header.masked != (settings_.role == Role::SERVER)) {
+			ProtocolError(header.masked ? "masked frame from server"s : "unmasked frame from client"s);
+		}
+
+		uint8_t *payload = data + header.header_size;
+		const size_t size = static_cast<size_t>(header.payload_size);
+		if(header.masked) {
+			Unmask(payload, size, header.mask);
+		}
+		const std::string_view view(reinterpret_cast<const char *>(payload), size);
+
+		if(IsControl(header.opcode)) {
+			handler(Message{header.opcode, view, true});
+			++delivered;
+		} else if(header.opcode == Opcode::CONTINUATION) {
+			if(!in_message_) {
+				ProtocolError("continuation frame outside of a message"s);
+			}
+			if(!settings_.deliver_fragments && assembly_.size() + size > settings_.max_message_bytes) {
+				throw WebSocketError("websocket: message exceeds max_message_bytes"s, close_code::MESSAGE_TOO_BIG);
+			}
+			if(message_opcode_ == Opcode::TEXT) {
+				CheckText(view, header.fin);
+			}
+			if(settings_.deliver_fragments) {
+				handler(Message{message_opcode_, view, header.fin});
+				++delivered;
+			} else {
+				assembly_.append(view);
+				if(header.fin) {
+					handler(Message{message_opcode_, assembly_, true});
+					++delivered;
+					assembly_.clear();
+				}
+			}
+			in_message_ = !header.fin;
+		} else {
+			if(in_message_) {
+				ProtocolError("new data frame inside a fragmented message"s);
+			}
+			if((header.fin || !settings_.deliver_fragments) && size > settings_.max_message_bytes) {
+				throw WebSocketError("websocket: message exceeds max_message_bytes"s, close_code::MESSAGE_TOO_BIG);
+			}
+			if(header.opcode == Opcode::TEXT) {
+				utf8_.Reset();
+				CheckText(view, header.fin);
+			}
+			if(header.fin || settings_.deliver_fragments) {
+				handler(Message{header.opcode, view, header.fin});
+				++delivered;
+			} else {
+				assembly_.assign(view);
+			}
+			if(!header.fin) {
+				in_message_ = true;
+				message_opcode_ = header.opcode;
+			}
+		}
+		ring.Consume(frame_size);
+	}
+	return delivered;
+}
+
+// === ОТПРАВКА ===
+
+FrameWriter::FrameWriter(Role role) : role_(role), random_(std::random_device{}()) {}
+
+void FrameWriter::AddArena(const uint8_t *data, size_t size) {
+	const size_t offset = arena_.size();
+	arena_.append(reinterpret_cast<const char *>(data), size);
+	if(!parts_.empty() && !parts_.back().external && parts_.back().offset + parts_.back().size == offset) {
+		parts_.back().size += size;
+	} else {
+		parts_.push_back(Part{nullptr, offset, size});
+	}
+}
+
+void FrameWriter::Add(Opcode opcode, std::string_view payload, bool fin) {
+	uint8_t header[MAX_HEADER_SIZE];
+	if(role_ == Role::CLIENT) {
+		const uint32_t mask = random_();
+		AddArena(header, EncodeFrameHeader(header, opcode, fin, payload.size(), &mask));
+		AddArena(reinterpret_cast<const uint8_t *>(payload.data()), payload.size());
+		Unmask(reinterpret_cast<uint8_t *>(arena_.data()) + arena_.size() - payload.size(), payload.size(), mask);
+	} else {
+		AddArena(header, EncodeFrameHeader(header, opcode, fin, payload.size(), nullptr));
+		if(!payload.empty()) {
+			parts_.push_back(Part{payload.data(), 0, payload.size()});
+		}
+	}
+	pending_ = 0;
+	for(size_t i = first_part_; i < parts_.size(); ++i) {
+		pending_ += parts_[i].size;
+	}
+	pending_ -= first_offset_;
+}
+
+bool FrameWriter::Flush(int fd) {
+	while(first_part_ < parts_.size()) {
+		iovec vectors[IOV_BATCH];
+		size_t count = 0;
+		for(size_t i = first_part_; i < parts_.size() && count < IOV_BATCH; ++i, ++count) {
+			const Part &part = parts_[i];
+			const char *base = part.external ? part.external : arena_.data() + part.offset;
+			const size_t skip = i == first_part_ ? first_offset_ : 0;
+			vectors[count].iov_base = const_cast<char *>(base + skip);
+			vectors[count].iov_len = part.size - skip;
+		}
+
+		msghdr message{};
+		message.msg_iov = vectors;
+		message.msg_iovlen = count;
+		ssize_t sent = ::sendmsg(fd, &message, MSG_NOSIGNAL);
+		if(sent < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			if(errno == EAGAIN || errno == EWOULDBLOCK) {
+				return false;
+			}
+			throw SystemError("send"s);
+		}
+
+		pending_ -= static_cast<size_t>(sent);
+		while(sent > 0) {
+			const size_t left = parts_[first_part_].size - first_offset_;
+			if(static_cast<size_t>(sent) >= left) {
+				sent -= static_cast<ssize_t>(left);
+				++first_part_;
+				first_offset_ = 0;
+			} else {
+				first_offset_ += static_cast<size_t>(sent);
+				sent = 0;
+			}
+		}
+	}
+
+	arena_.clear();
+	parts_.clear();
+	first_part_ = 0;
+	first_offset_ = 0;
+	pending_ = 0;
+	return true;
+}
+
+// === КЛИЕНТ ===
+
+WebSocketClient::WebSocketClient(const WebSocketSettings &settings)
+	: ring_(settings.ring_bytes), reader_([&settings] {
+		  FrameReaderSettings reader = settings.reader;
+		  reader.role = Role::CLIENT;
+		  return reader;
+	  }()),
+	  writer_(Role::CLIENT) {
+	addrinfo hints{};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	addrinfo *addresses = nullptr;
+	if(const int code = ::getaddrinfo(settings.host.c_str(), std::to_string(settings.port).c_str(), &hints, &addresses); code != 0) {
+		throw WebSocketError("websocket: cannot resolve "s + settings.host + ": "s + ::gai_strerror(code), close_code::GOING_AWAY);
+	}
+
+	const int timeout_ms = static_cast<int>(settings.connect_timeout.count());
+	for(addrinfo *address = addresses; address && fd_ < 0; address = address->ai_next) {
+		const int fd = ::socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, address->ai_protocol);
+		if(fd < 0) {
+			continue;
+		}
+		if(::connect(fd, address->ai_addr, address->ai_addrlen) == 0 ||
+			(errno == EINPROGRESS && WaitSocket(fd, POLLOUT, timeout_ms))) {
+			int error = 0;
+			socklen_t length = sizeof(error);
+			::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length);
+			if(error == 0) {
+				fd_ = fd;
+				break;
+			}
+		}
+		::close(fd);
+	}
+	::freeaddrinfo(addresses);
+	if(fd_ < 0) {
+		throw WebSocketError("websocket: cannot connect to "s + settings.host + ":"s + std::to_string(settings.port), close_code::GOING_AWAY);
+	}
+
+	int nodelay = 1;
+	::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+	try {
+		Handshake(settings);
+	} catch(...) {
+		Disconnect();
+		throw;
+	}
+}
+
+WebSocketClient::~WebSocketClient() {
+	Disconnect();
+}
+
+/**
+ * РУКОПОЖАТИЕ (RFC 6455, раздел 4)
+ *
+ * Запрос GET с Upgrade: websocket и случайным Sec-WebSocket-Key; сервер
+ * обязан ответить 101 и Sec-WebSocket-Accept от этого ключа. Байты после
+ * заголовков ответа (первые кадры сервера) остаются в буфере приёма.
+ */
+void WebSocketClient::Handshake(const WebSocketSettings &settings) {
+	std::random_device random;
+	uint8_t nonce[16];
+	for(uint8_t &byte : nonce) {
+		byte = static_cast<uint8_t>(random());
+	}
+	const std::string key = Base64(nonce, sizeof(nonce));
+
+	std::string request = "GET "s + settings.path + " HTTP/1.1\r\nHost: "s + settings.host + ":"s + std::to_string(settings.port) +
+								 "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: "s + key +
+								 "\r\nSec-WebSocket-Version: 13\r\n"s;
+	for(const std::string &header : settings.headers) {
+		request += header;
+		request += "\r\n"sv;
+	}
+	request += "\r\n"sv;
+
+	const auto deadline = std::chrono::steady_clock::now() + settings.connect_timeout;
+	auto remaining_ms = [&deadline] {
+		return static_cast<int>(std::max<int64_t>(
+			0, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count()));
+	};
+
+	size_t sent = 0;
+	while(sent < request.size()) {
+		const ssize_t count = ::send(fd_, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+		if(count > 0) {
+			sent += static_cast<size_t>(count);
+		} else if(count < 0 && errno != EAGAIN && errno != EINTR) {
+			throw SystemError("handshake send"s);
+		} else if(!WaitSocket(fd_, POLLOUT, remaining_ms())) {
+			throw WebSocketError("websocket: handshake timeout"s, close_code::GOING_AWAY);
+		}
+	}
+
+	size_t header_end = std::string_view::npos;
+	while(header_end == std::string_view::npos) {
+		if(ring_.Writable() == 0) {
+			ProtocolError("handshake response too large"s);
+		}
+		const ssize_t count = ::recv(fd_, ring_.WriteData(), ring_.Writable(), 0);
+		if(count > 0) {
+			ring_.Produce(static_cast<size_t>(count));
+			header_end = std::string_view(reinterpret_cast<const char *>(ring_.ReadData()), ring_.Readable()).find("\r\n\r\n"sv);
+		} else if(count == 0) {
+			throw WebSocketError("websocket: connection closed during handshake"s, close_code::GOING_AWAY);
+		} else if(errno != EAGAIN && errno != EINTR) {
+			throw SystemError("handshake recv"s);
+		} else if(!WaitSocket(fd_, POLLIN, remaining_ms())) {
+			throw WebSocketError("websocket: handshake timeout"s, close_code::GOING_AWAY);
+		}
+	}
+
+	const std::string_view headers(reinterpret_cast<const char *>(ring_.ReadData()), header_end + 2);
+	const std::string lower = ToLower(headers);
+	if(headers.substr(0, 12) != "HTTP/1.1 101"sv) {
+		ProtocolError("handshake rejected: "s + std::string(headers.substr(0, headers.find("\r\n"sv))));
+	}
+	if(HeaderValue(headers, lower, "sec-websocket-accept"sv) != ComputeAcceptKey(key)) {
+		ProtocolError("invalid Sec-WebSocket-Accept"s);
+	}
+	ring_.Consume(header_end + 4);
+}
+
+void WebSocketClient::Send(Opcode opcode, std::string_view payload) {
+	writer_.Add(opcode, payload);
+}
+
+void WebSocketClient::Flush() {
+	while(fd_ >= 0 && !writer_.Flush(fd_)) {
+		WaitSocket(fd_, POLLOUT, -1);
+	}
+}
+
+/**
+ * ОДИН ШАГ ЦИКЛА СОБЫТИЙ
+ *
+ * 1. Отправка очереди (сколько примет сокет)
+ * 2. Ожидание данных до timeout
+ * 3. Чтение в буфер приёма, пока есть данные и место, и разбор кадров;
+ *    если буфер был заполнен, после разбора чтение продолжается
+ * 4. Ответы на PING и CLOSE ставятся в очередь и отправляются сразу
+ * Нарушение протокола: серверу отправляется CLOSE с кодом ошибки,
+ * соединение закрывается, WebSocketError передаётся вызывающему.
+ */
+bool WebSocketClient::Poll(const MessageHandler &handler, std::chrono::milliseconds timeout) {
+	if(fd_ < 0) {
+		return false;
+	}
+
+	bool closed = false;
+	auto dispatch = [&](const Message &message) {
+		if(message.opcode == Opcode::PING) {
+			writer_.Add(Opcode::PONG, message.data);
+		} else if(message.opcode == Opcode::CLOSE) {
+			if(!close_sent_) {
+				writer_.Add(Opcode::CLOSE, message.data.substr(0, 2));
+				close_sent_ = true;
+			}
+			closed = true;
+		}
+		handler(message);
+	};
+
+	try {
+		writer_.Flush(fd_);
+		short events = POLLIN;
+		if(writer_.Pending() > 0) {
+			events |= POLLOUT;
+		}
+		if(!WaitSocket(fd_, events, static_cast<int>(timeout.count()))) {
+			return true;
+		}
+
+		bool peer_closed = false;
+		while(true) {
+			bool full = false;
+			while(true) {
+				if(ring_.Writable() == 0) {
+					full = true;
+					break;
+				}
+				const ssize_t count = ::recv(fd_, ring_.WriteData(), ring_.Writable(), 0);
+				if(count > 0) {
+					ring_.Produce(static_cast<size_t>(count));
+				} else if(count == 0) {
+					peer_closed = true;
+					break;
+				} else if(errno == EINTR) {
+					continue;
+				} else if(errno == EAGAIN || errno == EWOULDBLOCK) {
+					break;
+				} else {
+					throw SystemError("recv"s);
+				}
+			}
+			reader_.Parse(ring_, dispatch);
+			if(!full || closed) {
+				break;
+			}
+		}
+
+		writer_.Flush(fd_);
+		if(closed || peer_closed) {
+			Disconnect();
+			return false;
+		}
+	} catch(const WebSocketError &e) {
+		if(!close_sent_ && e.CloseCode() != close_code::GOING_AWAY) {
+			const uint8_t code[2] = {static_cast<uint8_t>(e.CloseCode() >> 8), static_cast<uint8_t>(e.CloseCode())};
+			writer_.Add(Opcode::CLOSE, std::string_view(reinterpret_cast<const char *>(code), 2));
+			close_sent_ = true;
+			try {
+				writer_.Flush(fd_);
+			} catch(const WebSocketError &) {
+			}
+		}
+		Disconnect();
+		throw;
+	}
+	return true;
+}
+
+void WebSocketClient::Close(uint16_t code) {
+	if(fd_ < 0 || close_sent_) {
+		return;
+	}
+	const uint8_t payload[2] = {static_cast<uint8_t>(code >> 8), static_cast<uint8_t>(code)};
+	writer_.Add(Opcode::CLOSE, std::string_view(reinterpret_cast<const char *>(payload), 2));
+	close_sent_ = true;
+	Flush();
+}
+
+void WebSocketClient::Disconnect() {
+	if(fd_ >= 0) {
+		::close(fd_);
+		fd_ = -1;
+	}
+}
+}
@@ -0,0 +1,337 @@
+#pragma once
+
+/*
+ * ИМИТАЦИЯ HTTP-СЕРВЕРА ДЛЯ ТЕСТОВ
+ *
+ * HTTP/1.1 на 127.0.0.1 (порт выбирает система), по желанию поверх TLS
+ * с самоподписанным сертификатом. Поток на соединение, соединения
+ * keep-alive. Ответ на каждый запрос даёт обработчик теста; сервер
+ * считает соединения, возобновлённые TLS-сессии и одновременные запросы.
+ *
+ * Для нагрузочных тестов поверх обработчика задаются задержка всех ответов
+ * (SetLatency) и ошибки: на время сбоя (FailFor) или на долю запросов
+ * (FailRate). Запрос с внесённой ошибкой обработчик не видит.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace paygo::test {
+
+struct MockRequest {
+	std::string method;
+	std::string path;
+	std::string headers;     // строки заголовков как пришли
+	std::string body;
+
+	/** Значение заголовка по точному имени; нет заголовка - пустая строка */
+	std::string Header(std::string_view name) const {
+		const std::string prefix = "\r\n" + std::string(name) + ": ";
+		const size_t position = headers.find(prefix);
+		if(position == std::string::npos) {
+			return {};
+		}
+		const size_t begin = position + prefix.size();
+		return headers.substr(begin, headers.find("\r\n", begin) - begin);
+	}
+};
+
+struct MockResponse {
+	long status = 200;
+	std::string body = R"({"status":"approved"})";
+	std::chrono::microseconds delay{0};   // задержка перед ответом
+};
+
+class MockServer {
+public:
+	using Handler = std::function<MockResponse(const MockRequest &)>;
+
+	MockServer(bool tls, Handler handler) : handler_(std::move(handler)) {
+		if(tls) {
+			InitTls();
+		}
+
+		listener_ = ::socket(AF_INET, SOCK_STREAM, 0);
+		int yes = 1;
+		::setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		if(::bind(listener_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || ::listen(listener_, 64) != 0) {
+			throw std::runtime_error("mock server: cannot listen");
+		}
+		socklen_t length = sizeof(address);
+		::getsockname(listener_, reinterpret_cast<sockaddr *>(&address), &length);
+		port_ = ntohs(address.sin_port);
+
+		acceptor_ = std::thread([this] {
+			AcceptLoop();
+		});
+	}
+
+	~MockServer() {
+		stop_ = true;
+		::shutdown(listener_, SHUT_RDWR);
+		::close(listener_);
+		acceptor_.join();
+		{
+			std::lock_guard lock(mutex_);
+			for(int fd : open_fds_) {
+				::shutdown(fd, SHUT_RDWR);
+			}
+		}
+		for(std::thread &connection : connections_) {
+			connection.join();
+		}
+		if(context_) {
+			SSL_CTX_free(context_);
+		}
+	}
+
+	MockServer(const MockServer &) = delete;
+	MockServer &operator=(const MockServer &) = delete;
+
+	/** Адрес для EndpointSettings::base_url */
+	std::string BaseUrl() const {
+		return std::string(context_ ? "https" : "http") + "://127.0.0.1:" + std::to_string(port_);
+	}
+
+	uint64_t Connections() const {
+		return connections_count_;
+	}
+
+	/** TLS-соединений с сокращённым рукопожатием (сессия из кэша клиента) */
+	uint64_t ResumedSessions() const {
+		return resumed_;
+	}
+
+	uint64_t Requests() const {
+		return requests_;
+	}
+
+	/** Наибольшее число запросов, которые сервер обрабатывал одновременно */
+	uint64_t MaxConcurrent() const {
+		return max_concurrent_;
+	}
+
+	/** Ответов с ошибкой от FailFor и FailRate */
+	uint64_t InjectedFailures() const {
+		return injected_;
+	}
+
+	/** Задержка каждого ответа сверх MockResponse::delay: latency, умноженная на случайное из [1 - jitter, 1 + jitter] */
+	void SetLatency(std::chrono::microseconds latency, double jitter = 0) {
+		std::lock_guard lock(mutex_);
+		latency_ = latency;
+		jitter_ = jitter;
+	}
+
+	/** Сбой: duration, начиная с вызова, на все запросы отвечать status */
+	void FailFor(std::chrono::milliseconds duration, long status = 503) {
+		std::lock_guard lock(mutex_);
+		fail_until_ = std::chrono::steady_clock::now() + duration;
+		outage_status_ = status;
+	}
+
+	/** На случайную долю rate запросов отвечать status */
+	void FailRate(double rate, long status = 503) {
+		std::lock_guard lock(mutex_);
+		fail_rate_ = rate;
+		failure_status_ = status;
+	}
+
+private:
+	void InitTls() {
+		context_ = SSL_CTX_new(TLS_server_method());
+		EVP_PKEY *key = EVP_EC_gen("P-256");
+		X509 *certificate = X509_new();
+		ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+		X509_gmtime_adj(X509_getm_notBefore(certificate), 0);
+		X509_gmtime_adj(X509_getm_notAfter(certificate), 24 * 3600);
+		X509_set_pubkey(certificate, key);
+		X509_NAME *name = X509_get_subject_name(certificate);
+		X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>("127.0.0.1"), -1, -1, 0);
+		X509_set_issuer_name(certificate, name);
+		X509_sign(certificate, key, EVP_sha256());
+		SSL_CTX_use_certificate(context_, certificate);
+		SSL_CTX_use_PrivateKey(context_, key);
+		X509_free(certificate);
+		EVP_PKEY_free(key);
+
+		const unsigned char session_context[] = "paygo-test";
+		SSL_CTX_set_session_id_context(context_, session_context, sizeof(session_context) - 1);
+	}
+
+	void AcceptLoop() {
+		while(!stop_) {
+			const int fd = ::accept(listener_, nullptr, nullptr);
+			if(fd < 0) {
+				continue;
+			}
+			int yes = 1;
+			::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+			++connections_count_;
+			std::lock_guard lock(mutex_);
+			open_fds_.push_back(fd);
+			connections_.emplace_back([this, fd] {
+				Serve(fd);
+			});
+		}
+	}
+
+	void Serve(int fd) {
+		SSL *ssl = nullptr;
+		if(context_) {
+			ssl = SSL_new(context_);
+			SSL_set_fd(ssl, fd);
+			if(SSL_accept(ssl) != 1) {
+				Close(fd, ssl);
+				return;
+			}
+			if(SSL_session_reused(ssl)) {
+				++resumed_;
+			}
+		}
+
+		auto receive = [&](std::string &buffer) {
+			char chunk[4096];
+			const long read = ssl ? SSL_read(ssl, chunk, sizeof(chunk)) : ::recv(fd, chunk, sizeof(chunk), 0);
+			if(read <= 0) {
+				return false;
+			}
+			buffer.append(chunk, static_cast<size_t>(read));
+			return true;
+		};
+
+		std::mt19937_64 random(std::random_device{}());
+		std::string buffer;
+		while(!stop_) {
+			// Заголовки, затем тело длиной Content-Length
+			size_t header_end;
+			while((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+				if(!receive(buffer)) {
+					Close(fd, ssl);
+					return;
+				}
+			}
+			MockRequest request;
+			const size_t line_end = buffer.find("\r\n");
+			const std::string_view line(buffer.data(), line_end);
+			request.method = std::string(line.substr(0, line.find(' ')));
+			request.path = std::string(line.substr(request.method.size() + 1, line.rfind(' ') - request.method.size() - 1));
+			request.headers = buffer.substr(line_end, header_end + 2 - line_end);
+			const std::string length = request.Header("Content-Length");
+			const size_t body_size = length.empty() ? 0 : std::stoul(length);
+			while(buffer.size() < header_end + 4 + body_size) {
+				if(!receive(buffer)) {
+					Close(fd, ssl);
+					return;
+				}
+			}
+			request.body = buffer.substr(header_end + 4, body_size);
+			buffer.erase(0, header_end + 4 + body_size);
+
+			++requests_;
+			const uint64_t concurrent = ++concurrent_;
+			uint64_t seen = max_concurrent_;
+			while(concurrent > seen && !max_concurrent_.compare_exchange_weak(seen, concurrent)) {
+			}
+			const MockResponse response = Respond(request, random);
+			std::this_thread::sleep_for(response.delay);
+			--concurrent_;
+
+			const std::string reply = "HTTP/1.1 " + std::to_string(response.status) +
+											  " Mock\r\nContent-Type: application/json\r\nContent-Length: " +
+											  std::to_string(response.body.size()) + "\r\n\r\n" + response.body;
+			const long written = ssl ? SSL_write(ssl, reply.data(), static_cast<int>(reply.size()))
+											 : ::send(fd, reply.data(), reply.size(), MSG_NOSIGNAL);
+			if(written <= 0) {
+				break;
+			}
+		}
+		Close(fd, ssl);
+	}
+
+	/** Ответ обработчика или внесённая ошибка; задержка SetLatency добавляется к delay */
+	MockResponse Respond(const MockRequest &request, std::mt19937_64 &random) {
+		std::chrono::microseconds latency;
+		double jitter;
+		long status = 0;
+		{
+			std::lock_guard lock(mutex_);
+			latency = latency_;
+			jitter = jitter_;
+			if(std::chrono::steady_clock::now() < fail_until_) {
+				status = outage_status_;
+			} else if(fail_rate_ > 0 && std::uniform_real_distribution<double>(0, 1)(random) < fail_rate_) {
+				status = failure_status_;
+			}
+		}
+
+		MockResponse response;
+		if(status != 0) {
+			++injected_;
+			response.status = status;
+			response.body = "{}";
+		} else {
+			response = handler_(request);
+		}
+		if(latency.count() > 0) {
+			const double scale = jitter > 0 ? std::uniform_real_distribution<double>(1 - jitter, 1 + jitter)(random) : 1;
+			response.delay += std::chrono::duration_cast<std::chrono::microseconds>(latency * scale);
+		}
+		return response;
+	}
+
+	void Close(int fd, SSL *ssl) {
+		if(ssl) {
+			SSL_free(ssl);
+		}
+		std::lock_guard lock(mutex_);
+		open_fds_.erase(std::find(open_fds_.begin(), open_fds_.end(), fd));
+		::close(fd);
+	}
+
+	Handler handler_;
+	SSL_CTX *context_ = nullptr;
+	int listener_ = -1;
+	uint16_t port_ = 0;
+	std::atomic<bool> stop_{false};
+	std::atomic<uint64_t> connections_count_{0};
+	std::atomic<uint64_t> resumed_{0};
+	std::atomic<uint64_t> requests_{0};
+	std::atomic<uint64_t> concurrent_{0};
+	std::atomic<uint64_t> max_concurrent_{0};
+	std::atomic<uint64_t> injected_{0};
+
+	std::mutex mutex_;
+	std::chrono::microseconds latency_{0};   // SetLatency, FailFor и FailRate - под mutex_
+	double jitter_ = 0;
+	std::chrono::steady_clock::time_point fail_until_;
+	long outage_status_ = 503;
+	double fail_rate_ = 0;
+	long failure_status_ = 503;
+	std::vector<int> open_fds_;              // для остановки: прерывает чтение в потоках соединений
+	std::vector<std::thread> connections_;   // пополняет только поток acceptor_ до остановки
+	std::thread acceptor_;
+};
+}
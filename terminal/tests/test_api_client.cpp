@@ -0,0 +1,306 @@
+/*
+ * ТЕСТЫ КЛИЕНТА API БАНКОВ
+ *
+ * Банк имитирует MockServer (mock_server.h) в том же процессе:
+ * HTTP или HTTPS с самоподписанным сертификатом на 127.0.0.1.
+ */
+
+#include "network/api_client.h"
+
+#include "mock_server.h"
+
+#include <gtest/gtest.h>
+
+#include <sys/socket.h>
+
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+using namespace paygo;
+using test::MockResponse;
+
+namespace {
+
+network::EndpointSettings MakeEndpoint(const std::string &base_url) {
+	network::EndpointSettings endpoint;
+	endpoint.name = "vtb"s;
+	endpoint.base_url = base_url;
+	endpoint.connect_timeout = 2s;
+	endpoint.request_timeout = 5s;
+	return endpoint;
+}
+
+network::TlsSettings TestTls() {
+	network::TlsSettings tls;
+	tls.verify_peer = false;  // самоподписанный сертификат имитации
+	return tls;
+}
+
+network::HttpRequest MakeRequest(const std::string &body = R"({"amount":15000})"s) {
+	network::HttpRequest request;
+	request.endpoint = "vtb"s;
+	request.path = "/authorize"s;
+	request.body = body;
+	request.headers = {"Content-Type: application/json"s};
+	return request;
+}
+
+/** Порт, на котором никто не слушает: соединение будет отвергнуто */
+uint16_t ClosedPort() {
+	const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	::bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+	socklen_t length = sizeof(address);
+	::getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length);
+	::close(fd);
+	return ntohs(address.sin_port);
+}
+
+MockResponse Approve(const test::MockRequest &) {
+	return {};
+}
+}
+
+TEST(ApiClientTest, SendsRequestAndReturnsResponse) {
+	test::MockRequest received;
+	std::mutex mutex;
+	test::MockServer server(false, [&](const test::MockRequest &request) {
+		std::lock_guard lock(mutex);
+		received = request;
+		return MockResponse{201, R"({"authorization_code":"123456"})"s};
+	});
+	network::SslManager ssl(TestTls());
+	network::ApiClientSettings settings;
+	settings.endpoints = {MakeEndpoint(server.BaseUrl() + "/api"s)};
+	network::ApiClient client(settings, ssl);
+
+	network::HttpRequest request = MakeRequest(R"({"amount":42})"s);
+	request.headers.push_back("Idempotency-Key: PAY-1"s);
+	const network::HttpResponse response = client.Execute(request);
+
+	EXPECT_EQ(response.status, 201);
+	EXPECT_EQ(response.body, R"({"authorization_code":"123456"})");
+	EXPECT_TRUE(response.new_connection);
+	std::lock_guard lock(mutex);
+	EXPECT_EQ(received.method, "POST");
+	EXPECT_EQ(received.path, "/api/authorize");
+	EXPECT_EQ(received.body, R"({"amount":42})");
+	EXPECT_EQ(received.Header("Idempotency-Key"), "PAY-1");
+}
+
+TEST(ApiClientTest, KeepAliveReusesConnection) {
+	test::MockServer server(false, Approve);
+	network::SslManager ssl(TestTls());
+	network::ApiClientSettings settings;
+	settings.endpoints = {MakeEndpoint(server.BaseUrl())};
+	network::ApiClient client(settings, ssl);
+
+	std::vector<bool> fresh;
+	for(int i = 0; i < 5; ++i) {
+		fresh.push_back(client.Execute(MakeRequest()).new_connection);
+	}
+
+	EXPECT_EQ(fresh, (std::vector<bool>{true, false, false, false, false}));
+	EXPECT_EQ(server.Connections(), 1u);
+	EXPECT_EQ(client.GetStats("vtb"s).connections, 1u);
+	EXPECT_EQ(client.GetStats("vtb"s).requests, 5u);
+}
+
+TEST(ApiClientTest, WithoutKeepAliveOpensConnectionPerRequest) {
+	test::MockServer server(false, Approve);
+	network::SslManager ssl(TestTls());
+	network::ApiClientSettings settings;
+	settings.endpoints = {MakeEndpoint(server.BaseUrl())};
+	settings.endpoints[0].keep_alive = false;
+	network::ApiClient client(settings, ssl);
+
+	for(int i = 0; i < 3; ++i) {
+		EXPECT_TRUE(client.Execute(MakeRequest()).new_connection);
+	}
+	EXPECT_EQ(server.Connections(), 3u);
+	EXPECT_EQ(client.GetStats("vtb"s).connections, 3u);
+}
+
+TEST(ApiClientTest, TlsConnectionIsReused) {
+	test::MockServer server(true, Approve);
+	network::SslManager ssl(TestTls());
+	network::ApiClientSettings settings;
+	settings.endpoints = {MakeEndpoint(server.BaseUrl())};
+	network::ApiClient client(settings, ssl);
+
+	for(int i = 0; i < 4; ++i) {
+		EXPECT_EQ(client.Execute(MakeRequest()).status, 200);
+	}
+	EXPECT_EQ(server.Connections(), 1u);   // одно рукопожатие на все запросы
+}
+
+TEST(ApiClientTest, NewTlsConnectionsResumeSession) {
+	test::MockServer server(true, Approve);
+	network::SslManager ssl(TestTls());
+	network::ApiClientSettings settings;
+	settings.endpoints = {MakeEndpoint(server.BaseUrl())};
+	settings.endpoints[0].keep_alive = false;
+	network::ApiClient client(settings, ssl);
+
+	for(int i = 0; i < 4; ++i) {
+		EXPECT_EQ(client.Execute(MakeRequest()).status, 200);
+	}
+	EXPECT_EQ(server.Connections(), 4u);
+	EXPECT_EQ(server.ResumedSessions(), 3u);   // полное рукопожатие только у первого
+}
+
+TEST(ApiClientTest, SessionCacheCanBeDisabled) {
+	test::MockServer server(true, Approve);
+	network::TlsSettings tls = TestTls();
+	tls.session_cache = false;
+	network::SslManager ssl(tls);
+	network::ApiClientSettings settings;
+	settings.endpoints = {MakeEndpoint(server.BaseUrl())};
+	settings.endpoints[0].keep_alive = false;
+	network::ApiClient client(settings, ssl);
+
+	for(int i = 0; i < 3; ++i) {
+		EXPECT_EQ(client.Execute(MakeRequest()).status, 200);
+	}
+	EXPECT_EQ(server.ResumedSessions(), 0u);
+}
+
+TEST(ApiClientTest, LimitsConcurrentRequestsPerEndpoint) {
+	test::MockServer server(false, [](const test::MockRequest &) {
+		return MockResponse{200, "{}"s, 30ms};
+	});
+	network::SslManager ssl(TestTls());
+	network::ApiClientSettings settings;
+	settings.endpoints = {MakeEndpoint(server.BaseUrl())};
+	settings.endpoints[0].max_connections = 2;
+	network::ApiClient client(settings, ssl);
+
+	std::vector<std::future<network::HttpResponse>> responses;
+	for(int i = 0; i < 8; ++i) {
+		responses.push_back(client.Send(MakeRequest()));
+	}
+	for(auto &response : responses) {
+		EXPECT_EQ(response.get().status, 200);
+	}
+	EXPECT_EQ(server.Requests(), 8u);
+	EXPECT_LE(server.MaxConcurrent(), 2u);
+	EXPECT_LE(server.Connections(), 2u);
+}
+
+// === ОТОБРАЖЕНИЕ ОШИБОК ===
+
+TEST(ApiClientTest, HttpErrorStatusIsResponseNotException) {
+	test::MockServer server(false, [](const test::MockRequest &) {
+		return MockResponse{503, R"({"error":"maintenance"})"s};
+	});
+	network::SslManager ssl(TestTls());
+	network::ApiClientSettings settings;
+	settings.endpoints = {MakeEndpoint(server.BaseUrl())};
+	network::ApiClient client(settings, ssl);
+
+	const network::HttpResponse response = client.Execute(MakeRequest());
+	EXPECT_EQ(response.status, 503);
+	EXPECT_EQ(response.body, R"({"error":"maintenance"})");
+	EXPECT_EQ(client.GetStats("vtb"s).failures, 0u);
+}
+
+TEST(ApiClientTest, RequestTimeoutIsNetworkError) {
+	test::MockServer server(false, [](const test::MockRequest &) {
+		return MockResponse{200, "{}"s, 1s};
+	});
+	network::SslManager ssl(TestTls());
+	network::ApiClientSettings settings;
+	settings.endpoints = {MakeEndpoint(server.BaseUrl())};
+	settings.endpoints[0].request_timeout = 200ms;
+	network::ApiClient client(settings, ssl);
+
+	const auto start = std::chrono::steady_clock::now();
+	try {
+		client.Execute(MakeRequest());
+		FAIL() << "timeout expected";
+	} catch(const network::NetworkError &e) {
+		EXPECT_EQ(e.Code(), CURLE_OPERATION_TIMEDOUT);
+		EXPECT_NE(std::string(e.what()).find("vtb"), std::string::npos);
+	}
+	EXPECT_LT(std::chrono::steady_clock::now() - start, 900ms);
+	EXPECT_EQ(client.GetStats("vtb"s).failures, 1u);
+}
+
+TEST(ApiClientTest, RefusedConnectionIsNetworkError) {
+	network::SslManager ssl(TestTls());
+	network::ApiClientSettings settings;
+	settings.endpoints = {MakeEndpoint("http://127.0.0.1:"s + std::to_string(ClosedPort()))};
+	network::ApiClient client(settings, ssl);
+
+	try {
+		client.Execute(MakeRequest());
+		FAIL() << "connection error expected";
+	} catch(const network::NetworkError &e) {
+		EXPECT_EQ(e.Code(), CURLE_COULDNT_CONNECT);
+	}
+	EXPECT_EQ(client.GetStats("vtb"s).failures, 1u);
+}
+
+TEST(ApiClientTest, UntrustedCertificateIsNetworkError) {
+	test::MockServer server(true, Approve);
+	network::TlsSettings tls;
+	tls.verify_peer = true;
+	network::SslManager ssl(tls);
+	network::ApiClientSettings settings;
+	settings.endpoints = {MakeEndpoint(server.BaseUrl())};
+	network::ApiClient client(settings, ssl);
+
+	try {
+		client.Execute(MakeRequest());
+		FAIL() << "certificate error expected";
+	} catch(const network::NetworkError &e) {
+		EXPECT_EQ(e.Code(), CURLE_PEER_FAILED_VERIFICATION);
+	}
+}
+
+TEST(ApiClientTest, UnknownEndpointIsInvalidArgument) {
+	network::SslManager ssl(TestTls());
+	network::ApiClientSettings settings;
+	settings.endpoints = {MakeEndpoint("http://127.0.0.1:1"s)};
+	network::ApiClient client(settings, ssl);
+
+	network::HttpRequest request = MakeRequest();
+	request.endpoint = "sber"s;
+	EXPECT_THROW(client.Send(request), std::invalid_argument);
+	EXPECT_THROW(client.GetStats("sber"s), std::invalid_argument);
+
+	settings.endpoints.push_back(settings.endpoints[0]);
+	EXPECT_THROW(network::ApiClient(settings, ssl), std::invalid_argument);
+}
+
+TEST(ApiClientTest, PendingRequestsFailWhenClientStops) {
+	test::MockServer server(false, [](const test::MockRequest &) {
+		return MockResponse{200, "{}"s, 300ms};
+	});
+	network::SslManager ssl(TestTls());
+	std::future<network::HttpResponse> in_flight;
+	std::future<network::HttpResponse> queued;
+	{
+		network::ApiClientSettings settings;
+		settings.endpoints = {MakeEndpoint(server.BaseUrl())};
+		settings.endpoints[0].max_connections = 1;
+		network::ApiClient client(settings, ssl);
+		in_flight = client.Send(MakeRequest());
+		queued = client.Send(MakeRequest());
+		std::this_thread::sleep_for(50ms);
+	}
+	for(auto *result : {&in_flight, &queued}) {
+		try {
+			result->get();
+			FAIL() << "client stop error expected";
+		} catch(const network::NetworkError &e) {
+			EXPECT_EQ(e.Code(), CURLE_ABORTED_BY_CALLBACK);
+		}
+	}
+}
@@ -0,0 +1,301 @@
+/*
+ * ТЕСТЫ КОНФИГУРАЦИИ ТЕРМИНАЛА
+ *
+ * Файл конфигурации пишется во временный каталог; его содержимое -
+ * минимальная корректная конфигурация, в которой тест меняет отдельные
+ * поля. Замена файла - через временный файл и rename, как при развёртывании.
+ */
+
+#include "core/config_manager.h"
+
+#include <gtest/gtest.h>
+
+#include <nlohmann/json.hpp>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+using namespace paygo;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::string_view BASE_CONFIG = R"({
+	"terminal": {
+		"id": "T-0001", "location": "test", "version": "1.0.0",
+		"hardware": {
+			"platform": "test",
+			"display": {"resolution": "800x480", "touchscreen": true},
+			"peripherals": {
+				"nfc_reader": {"enabled": true, "device": "/dev/null"},
+				"camera": {"enabled": false, "device": "/dev/null", "resolution": "640x480"},
+				"fingerprint_scanner": {"enabled": false, "device": "/dev/null"},
+				"fiscal_registrator": {"enabled": false, "model": "none", "connection": "USB"}
+			}
+		}
+	},
+	"payment": {
+		"supported_methods": ["nfc_card", "qr_code"],
+		"banks": {
+			"acquiring": {"vtb": {"enabled": true, "merchant_id": "M1", "api_endpoint": "https://vtb.test"}},
+			"sbp": {"enabled": true, "merchant_id": "S1", "api_endpoint": "https://sbp.test"}
+		},
+		"limits": {"min_amount": 1.00, "max_amount": 1000.50, "daily_limit": 10005.00}
+	},
+	"security": {
+		"encryption": {"algorithm": "AES-256-GCM", "key_rotation_days": 30},
+		"biometry": {
+			"face_recognition": {"confidence_threshold": 0.85, "liveness_detection": true},
+			"fingerprint": {"quality_threshold": 60, "matching_threshold": 40}
+		},
+		"session": {"timeout_seconds": 300, "max_attempts": 3}
+	},
+	"network": {
+		"api_server": {"url": "https://api.test", "timeout_seconds": 30, "retry_attempts": 3},
+		"offline_mode": {"enabled": true, "max_transactions": 100, "sync_interval_minutes": 5},
+		"monitoring": {"heartbeat_interval_seconds": 60, "log_level": "INFO"}
+	},
+	"ui": {
+		"language": "ru", "theme": "light",
+		"timeout": {"idle_seconds": 60, "transaction_seconds": 180},
+		"sounds": {"enabled": true, "volume": 0.5}
+	},
+	"database": {"local": {"path": "/tmp/terminal.db", "backup_interval_hours": 6}},
+	"logging": {"level": "INFO", "file": "/tmp/terminal.log", "max_size_mb": 10, "backup_count": 2}
+})";
+
+/** Ждёт условия не дольше timeout */
+bool WaitFor(const std::function<bool()> &condition, std::chrono::milliseconds timeout = 5s) {
+	const Clock::time_point deadline = Clock::now() + timeout;
+	while(!condition()) {
+		if(Clock::now() > deadline) {
+			return false;
+		}
+		std::this_thread::sleep_for(5ms);
+	}
+	return true;
+}
+
+class ConfigManagerTest : public ::testing::Test {
+protected:
+	void SetUp() override {
+		const auto *info = ::testing::UnitTest::GetInstance()->current_test_info();
+		directory_ = std::filesystem::temp_directory_path() /
+						 ("paygo_config_"s + info->name() + "_"s + std::to_string(::getpid()));
+		std::filesystem::remove_all(directory_);
+		std::filesystem::create_directories(directory_);
+		settings_.path = (directory_ / "terminal_config.json").string();
+		settings_.watch = false;
+		settings_.debounce = 10ms;
+		base_ = nlohmann::json::parse(BASE_CONFIG);
+		WriteText(base_.dump());
+	}
+
+	void TearDown() override {
+		std::filesystem::remove_all(directory_);
+	}
+
+	/** Заменяет файл атомарно: временный файл + rename */
+	void WriteText(const std::string &text) const {
+		const std::filesystem::path temporary = settings_.path + ".tmp"s;
+		{
+			std::ofstream file(temporary, std::ios::binary);
+			file << text;
+		}
+		std::filesystem::rename(temporary, settings_.path);
+	}
+
+	/** Базовая конфигурация с max_amount = rubles и daily_limit = rubles * 10 */
+	void WriteLimits(double rubles) const {
+		nlohmann::json config = base_;
+		config["payment"]["limits"]["max_amount"] = rubles;
+		config["payment"]["limits"]["daily_limit"] = rubles * 10;
+		WriteText(config.dump());
+	}
+
+	std::filesystem::path directory_;
+	core::ConfigManagerSettings settings_;
+	nlohmann::json base_;
+};
+}
+
+TEST(ConfigParseTest, ConvertsAndValidatesFields) {
+	const core::ConfigSnapshot config = core::ParseConfig(BASE_CONFIG);
+	EXPECT_EQ(config.terminal_id, "T-0001"s);
+	EXPECT_EQ(config.payment.limits.min_amount, 100);
+	EXPECT_EQ(config.payment.limits.max_amount, 100050);
+	EXPECT_TRUE(config.payment.Supports(common::PaymentMethod::NFC));
+	EXPECT_TRUE(config.payment.Supports(common::PaymentMethod::QR_CODE));
+	EXPECT_FALSE(config.payment.Supports(common::PaymentMethod::BIOMETRIC));
+	ASSERT_NE(config.payment.FindBank("vtb"sv), nullptr);
+	EXPECT_EQ(config.payment.FindBank("vtb"sv)->merchant_id, "M1"s);
+	EXPECT_EQ(config.payment.FindBank("alfa"sv), nullptr);
+	EXPECT_EQ(config.security.session_timeout, 300s);
+	EXPECT_EQ(config.storage.log_max_size_mb, 10u);
+}
+
+TEST(ConfigParseTest, ErrorNamesTheField) {
+	nlohmann::json config = nlohmann::json::parse(BASE_CONFIG);
+	config["network"]["api_server"].erase("timeout_seconds");
+	try {
+		core::ParseConfig(config.dump());
+		FAIL() << "missing field accepted";
+	} catch(const core::ConfigError &e) {
+		EXPECT_NE(std::string(e.what()).find("network.api_server.timeout_seconds"), std::string::npos) << e.what();
+	}
+
+	config = nlohmann::json::parse(BASE_CONFIG);
+	config["ui"]["sounds"]["volume"] = "loud";
+	EXPECT_THROW(core::ParseConfig(config.dump()), core::ConfigError);
+	EXPECT_THROW(core::ParseConfig("{\"terminal\": "sv), core::ConfigError);
+}
+
+TEST_F(ConfigManagerTest, CurrentReusesSnapshotUntilGenerationChanges) {
+	core::ConfigManager manager(settings_);
+	EXPECT_EQ(manager.Generation(), 1u);
+
+	const std::shared_ptr<const core::ConfigSnapshot> first = manager.Current();
+	EXPECT_EQ(first->generation, 1u);
+	EXPECT_EQ(manager.Current().get(), first.get());
+
+	// Тот же текст - не новая конфигурация: поколение и снимок прежние
+	WriteText(base_.dump());
+	EXPECT_FALSE(manager.Reload());
+	EXPECT_EQ(manager.Generation(), 1u);
+	EXPECT_EQ(manager.Current().get(), first.get());
+
+	WriteLimits(2000);
+	EXPECT_TRUE(manager.Reload());
+	EXPECT_EQ(manager.Generation(), 2u);
+	const std::shared_ptr<const core::ConfigSnapshot> second = manager.Current();
+	EXPECT_NE(second.get(), first.get());
+	EXPECT_EQ(second->generation, 2u);
+	EXPECT_EQ(second->payment.limits.max_amount, 200000);
+
+	// Взятый раньше снимок остаётся прежним до конца транзакции
+	EXPECT_EQ(first->payment.limits.max_amount, 100050);
+}
+
+TEST_F(ConfigManagerTest, ManagersInOneThreadDoNotShareCachedSnapshot) {
+	core::ConfigManager first(settings_);
+	const std::shared_ptr<const core::ConfigSnapshot> from_first = first.Current();
+
+	WriteLimits(3000);
+	core::ConfigManager second(settings_);
+	// Поколение у обоих 1 - кэш потока различает менеджеры, а не только поколения
+	EXPECT_EQ(second.Generation(), first.Generation());
+	EXPECT_EQ(second.Current()->payment.limits.max_amount, 300000);
+	EXPECT_EQ(first.Current()->payment.limits.max_amount, 100050);
+	EXPECT_EQ(first.Current().get(), from_first.get());
+}
+
+TEST_F(ConfigManagerTest, InvalidFileKeepsCurrentSnapshot) {
+	core::ConfigManager manager(settings_);
+	const std::shared_ptr<const core::ConfigSnapshot> before = manager.Current();
+
+	WriteText("{\"terminal\": "s);
+	EXPECT_FALSE(manager.Reload());
+
+	nlohmann::json config = base_;
+	config["payment"]["limits"]["min_amount"] = 5000;  // больше max_amount
+	WriteText(config.dump());
+	EXPECT_FALSE(manager.Reload());
+
+	std::filesystem::remove(settings_.path);
+	EXPECT_FALSE(manager.Reload());
+
+	EXPECT_EQ(manager.Generation(), 1u);
+	EXPECT_EQ(manager.Current().get(), before.get());
+
+	// Исправленный файл принимается; одинаковый с последним отклонённым текст не мешает
+	WriteLimits(4000);
+	EXPECT_TRUE(manager.Reload());
+	EXPECT_EQ(manager.Generation(), 2u);
+	EXPECT_EQ(manager.Current()->payment.limits.max_amount, 400000);
+}
+
+TEST_F(ConfigManagerTest, InvalidFileAtStartupIsError) {
+	WriteText("[]"s);
+	EXPECT_THROW(core::ConfigManager{settings_}, core::ConfigError);
+
+	std::filesystem::remove(settings_.path);
+	EXPECT_THROW(core::ConfigManager{settings_}, core::ConfigError);
+}
+
+TEST_F(ConfigManagerTest, WatcherRebuildsSnapshotAfterFileIsReplaced) {
+	settings_.watch = true;
+	core::ConfigManager manager(settings_);
+
+	WriteLimits(5000);
+	ASSERT_TRUE(WaitFor([&] {
+		return manager.Generation() == 2;
+	}));
+	EXPECT_EQ(manager.Current()->payment.limits.max_amount, 500000);
+
+	// Запись другого файла в том же каталоге конфигурацию не перечитывает
+	std::ofstream(directory_ / "other.json") << "{}";
+	WriteText("not json"s);
+	std::this_thread::sleep_for(200ms);
+	EXPECT_EQ(manager.Generation(), 2u);
+
+	WriteLimits(6000);
+	ASSERT_TRUE(WaitFor([&] {
+		return manager.Generation() == 3;
+	}));
+	EXPECT_EQ(manager.Current()->payment.limits.max_amount, 600000);
+}
+
+TEST_F(ConfigManagerTest, ReadersSeeWholeSnapshotsDuringPublish) {
+	core::ConfigManager manager(settings_);
+	WriteLimits(1000);
+	ASSERT_TRUE(manager.Reload());
+
+	constexpr size_t READERS = 4;
+	constexpr int RELOADS = 200;
+	std::atomic<bool> stop{false};
+	std::atomic<size_t> torn{0};
+	std::atomic<size_t> backwards{0};
+	std::vector<std::thread> readers;
+	for(size_t t = 0; t < READERS; ++t) {
+		readers.emplace_back([&] {
+			uint64_t last_generation = 0;
+			while(!stop.load(std::memory_order_relaxed)) {
+				const std::shared_ptr<const core::ConfigSnapshot> config = manager.Current();
+				if(config->payment.limits.daily_limit != config->payment.limits.max_amount * 10) {
+					++torn;
+				}
+				if(config->generation < last_generation) {
+					++backwards;
+				}
+				last_generation = config->generation;
+			}
+		});
+	}
+
+	size_t published = 0;
+	for(int i = 1; i <= RELOADS; ++i) {
+		WriteLimits(1000 + i);
+		published += manager.Reload() ? 1 : 0;
+	}
+	stop = true;
+	for(std::thread &reader : readers) {
+		reader.join();
+	}
+
+	EXPECT_EQ(published, static_cast<size_t>(RELOADS));
+	EXPECT_EQ(torn.load(), 0u);
+	EXPECT_EQ(backwards.load(), 0u);
+	EXPECT_EQ(manager.Generation(), static_cast<uint64_t>(RELOADS + 2));
+	EXPECT_EQ(manager.Current()->payment.limits.max_amount, (1000 + RELOADS) * 100);
+}
@@ -0,0 +1,253 @@
+/*
+ * ТЕСТЫ КЭША ТЕРМИНАЛА
+ *
+ * Размер записи в байтах тест не угадывает: он измеряется на отдельном
+ * кэше (GetStats().bytes после одной записи), и бюджет задаётся в записях.
+ * Постоянное хранилище - база SQLite во временном каталоге.
+ */
+
+#include "database/cache_manager.h"
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <optional>
+#include <string>
+#include <thread>
+
+using namespace std::literals;
+using namespace paygo;
+
+namespace {
+
+/** Байт на запись с ключом и значением таких размеров */
+size_t EntryBytes(size_t key_size, size_t value_size) {
+	database::CacheManager probe(database::CacheSettings{1, 1 << 20, 0ms});
+	probe.Put(std::string(key_size, 'k'), std::string(value_size, 'v'));
+	return probe.GetStats().bytes;
+}
+
+/** Одна часть на entries записей с ключом из 2 символов и значением из 8 */
+database::CacheSettings SmallCache(size_t entries) {
+	return database::CacheSettings{1, entries * EntryBytes(2, 8), 0ms};
+}
+
+/**
+ * Загрузчик, который останавливается внутри вызова, пока тест не разрешит
+ * продолжить: так тест делает Put или Erase ровно во время загрузки
+ */
+class BlockingLoader {
+public:
+	database::CacheLoader Loader() {
+		return [this](std::string_view) -> std::optional<database::LoadedValue> {
+			++calls_;
+			entered_.set_value();
+			release_future_.wait();
+			return database::LoadedValue{"loaded"s, std::nullopt};
+		};
+	}
+
+	void WaitEntered() {
+		entered_future_.wait();
+	}
+
+	void Release() {
+		release_.set_value();
+	}
+
+	int Calls() const {
+		return calls_;
+	}
+
+private:
+	std::promise<void> entered_;
+	std::future<void> entered_future_ = entered_.get_future();
+	std::promise<void> release_;
+	std::shared_future<void> release_future_ = release_.get_future().share();
+	std::atomic<int> calls_{0};
+};
+
+class CacheStoreTest : public ::testing::Test {
+protected:
+	void SetUp() override {
+		const auto *info = ::testing::UnitTest::GetInstance()->current_test_info();
+		directory_ = std::filesystem::temp_directory_path() /
+						 ("paygo_cache_"s + info->name() + "_"s + std::to_string(::getpid()));
+		std::filesystem::remove_all(directory_);
+		std::filesystem::create_directories(directory_);
+		settings_.path = (directory_ / "cache.db").string();
+	}
+
+	void TearDown() override {
+		std::filesystem::remove_all(directory_);
+	}
+
+	std::filesystem::path directory_;
+	database::SqliteSettings settings_;
+};
+}
+
+TEST(CacheManagerTest, EvictsLeastRecentlyUsed) {
+	database::CacheManager cache(SmallCache(3));
+	cache.Put("k1"sv, "value--1"s);
+	cache.Put("k2"sv, "value--2"s);
+	cache.Put("k3"sv, "value--3"s);
+	ASSERT_EQ(cache.Get("k1"sv), "value--1"s);  // k1 теперь последний использованный
+
+	cache.Put("k4"sv, "value--4"s);
+	EXPECT_EQ(cache.Peek("k2"sv), std::nullopt);
+	EXPECT_EQ(cache.Peek("k1"sv), "value--1"s);
+	EXPECT_EQ(cache.Peek("k3"sv), "value--3"s);
+	EXPECT_EQ(cache.Peek("k4"sv), "value--4"s);
+
+	const database::CacheStats stats = cache.GetStats();
+	EXPECT_EQ(stats.entries, 3u);
+	EXPECT_EQ(stats.evictions, 1u);
+}
+
+TEST(CacheManagerTest, ReplacingKeyDoesNotEvictOthers) {
+	database::CacheManager cache(SmallCache(2));
+	cache.Put("k1"sv, "value--1"s);
+	cache.Put("k2"sv, "value--2"s);
+	cache.Put("k1"sv, "value-1b"s);
+
+	EXPECT_EQ(cache.Peek("k1"sv), "value-1b"s);
+	EXPECT_EQ(cache.Peek("k2"sv), "value--2"s);
+	EXPECT_EQ(cache.GetStats().evictions, 0u);
+	EXPECT_EQ(cache.GetStats().bytes, 2 * EntryBytes(2, 8));
+}
+
+TEST(CacheManagerTest, ExpiredEntriesAreNotReturned) {
+	database::CacheManager cache(database::CacheSettings{4, 1 << 20, 0ms});
+	cache.Put("short"sv, "a"s, 20ms);
+	cache.Put("purged"sv, "b"s, 20ms);
+	cache.Put("forever"sv, "c"s);  // default_ttl 0 - бессрочно
+	cache.Put("long"sv, "d"s, 1h);
+
+	std::this_thread::sleep_for(50ms);
+	EXPECT_EQ(cache.Get("short"sv), std::nullopt);
+	EXPECT_EQ(cache.GetStats().expirations, 1u);
+
+	EXPECT_EQ(cache.PurgeExpired(), 1u);
+	EXPECT_EQ(cache.GetStats().expirations, 2u);
+	EXPECT_EQ(cache.Peek("forever"sv), "c"s);
+	EXPECT_EQ(cache.Peek("long"sv), "d"s);
+	EXPECT_EQ(cache.GetStats().entries, 2u);
+}
+
+TEST(CacheManagerTest, StaysWithinByteBudget) {
+	constexpr size_t MAX_BYTES = 64 << 10;
+	database::CacheManager cache(database::CacheSettings{8, MAX_BYTES, 0ms});
+	for(int i = 0; i < 10000; ++i) {
+		cache.Put("key-"s + std::to_string(i), std::string(100, 'x'));
+	}
+	const database::CacheStats stats = cache.GetStats();
+	EXPECT_LE(stats.bytes, MAX_BYTES);
+	EXPECT_GT(stats.entries, 0u);
+	EXPECT_EQ(stats.entries + stats.evictions, 10000u);
+
+	// Запись больше бюджета части не кэшируется и ничего не вытесняет
+	cache.Put("huge"sv, std::string(MAX_BYTES, 'x'));
+	EXPECT_EQ(cache.Peek("huge"sv), std::nullopt);
+	EXPECT_EQ(cache.GetStats().entries, stats.entries);
+}
+
+TEST(CacheManagerTest, PutDuringLoadIsNotOverwritten) {
+	BlockingLoader loader;
+	database::CacheManager cache(database::CacheSettings{1, 1 << 20, 0ms}, loader.Loader());
+
+	std::future<std::optional<std::string>> read = std::async(std::launch::async, [&] {
+		return cache.Get("card"sv);
+	});
+	loader.WaitEntered();
+	cache.Put("card"sv, "fresh"s);
+	loader.Release();
+
+	EXPECT_EQ(read.get(), "fresh"s);
+	EXPECT_EQ(cache.Peek("card"sv), "fresh"s);
+	EXPECT_EQ(loader.Calls(), 1);
+}
+
+TEST(CacheManagerTest, EraseDuringLoadIsNotUndone) {
+	BlockingLoader loader;
+	database::CacheManager cache(database::CacheSettings{1, 1 << 20, 0ms}, loader.Loader());
+
+	std::future<std::optional<std::string>> read = std::async(std::launch::async, [&] {
+		return cache.Get("card"sv);
+	});
+	loader.WaitEntered();
+	cache.Erase("card"sv);
+	loader.Release();
+
+	// Загруженное значение возвращается читателю, но в кэш не попадает
+	EXPECT_EQ(read.get(), "loaded"s);
+	EXPECT_EQ(cache.Peek("card"sv), std::nullopt);
+}
+
+TEST(CacheManagerTest, LoadWithoutConcurrentWritesIsCached) {
+	int calls = 0;
+	database::CacheManager cache(database::CacheSettings{1, 1 << 20, 0ms}, [&](std::string_view key) {
+		++calls;
+		return std::optional<database::LoadedValue>(database::LoadedValue{"v:"s + std::string(key), std::nullopt});
+	});
+	EXPECT_EQ(cache.Get("a"sv), "v:a"s);
+	EXPECT_EQ(cache.Get("a"sv), "v:a"s);
+	EXPECT_EQ(calls, 1);
+
+	const database::CacheStats stats = cache.GetStats();
+	EXPECT_EQ(stats.loads, 1u);
+	EXPECT_EQ(stats.hits, 1u);
+	EXPECT_EQ(stats.misses, 1u);
+}
+
+TEST_F(CacheStoreTest, ReadsThroughToSqlite) {
+	database::SqliteCacheStore store(settings_);
+	store.Save("merchant"sv, "M-1"sv);
+	store.Save("token"sv, "tok"sv, 1h);
+	store.Save("stale"sv, "old"sv, 1ms);
+	std::this_thread::sleep_for(10ms);
+
+	database::CacheManager cache(database::CacheSettings{4, 1 << 20, 0ms}, store.MakeLoader());
+	EXPECT_EQ(cache.Get("merchant"sv), "M-1"s);
+	EXPECT_EQ(cache.Get("token"sv), "tok"s);
+	EXPECT_EQ(cache.Get("stale"sv), std::nullopt);
+	EXPECT_EQ(cache.Get("missing"sv), std::nullopt);
+	EXPECT_EQ(cache.GetStats().loads, 2u);
+
+	// Второе чтение - из памяти, даже если в базе ключа уже нет
+	store.Erase("merchant"sv);
+	EXPECT_EQ(cache.Get("merchant"sv), "M-1"s);
+	EXPECT_EQ(cache.GetStats().loads, 2u);
+}
+
+TEST_F(CacheStoreTest, StoredTtlLimitsLifetimeInMemory) {
+	database::SqliteCacheStore store(settings_);
+	store.Save("session"sv, "s-1"sv, 100ms);
+
+	database::CacheManager cache(database::CacheSettings{1, 1 << 20, 1h}, store.MakeLoader());
+	EXPECT_EQ(cache.Get("session"sv), "s-1"s);
+	std::this_thread::sleep_for(150ms);
+	EXPECT_EQ(cache.Peek("session"sv), std::nullopt);
+	EXPECT_EQ(cache.Get("session"sv), std::nullopt);
+}
+
+TEST_F(CacheStoreTest, SurvivesRestart) {
+	{
+		database::SqliteCacheStore store(settings_);
+		store.Save("merchant"sv, "M-1"sv);
+		store.Save("expired"sv, "x"sv, 1ms);
+	}
+	std::this_thread::sleep_for(10ms);
+
+	database::SqliteCacheStore store(settings_);
+	store.PurgeExpired();
+	ASSERT_TRUE(store.Load("merchant"sv).has_value());
+	EXPECT_EQ(store.Load("merchant"sv)->value, "M-1"s);
+	EXPECT_FALSE(store.Load("merchant"sv)->ttl.has_value());
+	EXPECT_FALSE(store.Load("expired"sv).has_value());
+}
@@ -0,0 +1,302 @@
+/*
+ * ТЕСТЫ АСИНХРОННОГО ЖУРНАЛА
+ *
+ * Кольцевой буфер проверяется напрямую, журнал целиком - через файл во
+ * временном каталоге: после Flush в файле должно быть всё, что записано
+ * до вызова.
+ */
+
+#include "core/logger.h"
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+using namespace paygo;
+
+namespace {
+
+/** Запись для Ring: размер в первых 4 байтах, остальное заполнено меткой */
+bool Push(core::detail::Ring &ring, uint32_t size, char tag) {
+	char *out = ring.Reserve(size);
+	if(!out) {
+		return false;
+	}
+	std::memcpy(out, &size, sizeof(size));
+	std::memset(out + sizeof(size), tag, size - sizeof(size));
+	ring.Commit(size);
+	return true;
+}
+
+/** Размер и метка каждой вычитанной записи; метка проверяется по всей записи */
+std::vector<std::pair<size_t, char>> DrainRecords(core::detail::Ring &ring) {
+	std::vector<std::pair<size_t, char>> records;
+	ring.Drain([&](const char *record, size_t size) {
+		const char tag = record[sizeof(uint32_t)];
+		for(size_t i = sizeof(uint32_t); i < size; ++i) {
+			if(record[i] != tag) {
+				ADD_FAILURE() << "record " << tag << " corrupted at byte " << i;
+				break;
+			}
+		}
+		records.emplace_back(size, tag);
+	});
+	return records;
+}
+
+std::vector<std::string> ReadLines(const std::filesystem::path &path) {
+	std::vector<std::string> lines;
+	std::ifstream file(path);
+	for(std::string line; std::getline(file, line);) {
+		lines.push_back(line);
+	}
+	return lines;
+}
+
+/** Число строк, содержащих text */
+size_t CountLines(const std::vector<std::string> &lines, std::string_view text) {
+	return static_cast<size_t>(std::count_if(lines.begin(), lines.end(), [text](const std::string &line) {
+		return line.find(text) != std::string::npos;
+	}));
+}
+
+/** Номера из строк "... record N ..." по порядку */
+std::vector<int> RecordNumbers(const std::vector<std::string> &lines) {
+	std::vector<int> numbers;
+	for(const std::string &line : lines) {
+		if(const size_t at = line.find(" record "sv); at != std::string::npos) {
+			numbers.push_back(std::stoi(line.substr(at + 8)));
+		}
+	}
+	return numbers;
+}
+
+class LoggerTest : public ::testing::Test {
+protected:
+	void SetUp() override {
+		const auto *info = ::testing::UnitTest::GetInstance()->current_test_info();
+		directory_ = std::filesystem::temp_directory_path() /
+						 ("paygo_logger_"s + info->name() + "_"s + std::to_string(::getpid()));
+		std::filesystem::remove_all(directory_);
+		std::filesystem::create_directories(directory_);
+		path_ = directory_ / "terminal.log";
+		settings_.path = path_.string();
+		settings_.level = core::LogLevel::DEBUG;
+	}
+
+	void TearDown() override {
+		std::filesystem::remove_all(directory_);
+	}
+
+	std::filesystem::path directory_;
+	std::filesystem::path path_;
+	core::LoggerSettings settings_;
+};
+}
+
+TEST(LoggerRingTest, WrapsWithPaddingRecord) {
+	core::detail::Ring ring(1024);
+	ASSERT_TRUE(Push(ring, 384, 'a'));
+	ASSERT_TRUE(Push(ring, 384, 'b'));
+	EXPECT_EQ(DrainRecords(ring), (std::vector<std::pair<size_t, char>>{{384, 'a'}, {384, 'b'}}));
+
+	// До конца буфера 256 байт: они уходят на заглушку, запись начинается с начала
+	ASSERT_TRUE(Push(ring, 384, 'c'));
+	ASSERT_TRUE(Push(ring, 256, 'd'));
+	EXPECT_EQ(DrainRecords(ring), (std::vector<std::pair<size_t, char>>{{384, 'c'}, {256, 'd'}}));
+
+	// Заглушка занимает место до вычитки: 256 + 384 + 256 + 384 - не помещается
+	ASSERT_TRUE(Push(ring, 384, 'e'));
+	EXPECT_FALSE(Push(ring, 768, 'f'));
+	EXPECT_EQ(DrainRecords(ring), (std::vector<std::pair<size_t, char>>{{384, 'e'}}));
+	ASSERT_TRUE(Push(ring, 768, 'f'));
+	EXPECT_EQ(DrainRecords(ring), (std::vector<std::pair<size_t, char>>{{768, 'f'}}));
+}
+
+TEST(LoggerRingTest, FullRingRejectsUntilDrained) {
+	core::detail::Ring ring(1024);
+	for(char tag = 'a'; tag < 'a' + 8; ++tag) {
+		ASSERT_TRUE(Push(ring, 128, tag));
+	}
+	EXPECT_FALSE(Push(ring, 8, 'x'));
+	EXPECT_FALSE(Push(ring, 2048, 'y'));  // больше всего буфера - никогда не поместится
+	EXPECT_EQ(DrainRecords(ring).size(), 8u);
+	EXPECT_TRUE(Push(ring, 128, 'z'));
+}
+
+TEST_F(LoggerTest, FormatsArguments) {
+	core::Logger logger(settings_);
+	core::Logger::SetDefault(&logger);
+	PAYGO_LOG(core::LogLevel::INFO, "payment {} approved in {} ms", "P-1"s, 12);
+	PAYGO_LOG(core::LogLevel::DEBUG, "extra", 1.5, true);
+	logger.SetLevel(core::LogLevel::WARNING);
+	PAYGO_LOG(core::LogLevel::INFO, "hidden");
+	logger.Flush();
+
+	const std::vector<std::string> lines = ReadLines(path_);
+	ASSERT_EQ(lines.size(), 2u);
+	EXPECT_NE(lines[0].find(" INFO payment P-1 approved in 12 ms [test_logger.cpp:"sv), std::string::npos) << lines[0];
+	EXPECT_NE(lines[1].find(" DEBUG extra 1.5 true [test_logger.cpp:"sv), std::string::npos) << lines[1];
+	EXPECT_EQ(logger.GetStats().written, 2u);
+}
+
+TEST_F(LoggerTest, DroppedRecordsAreCountedAndReported) {
+	settings_.ring_bytes = 1024;
+	core::Logger logger(settings_);
+	core::Logger::SetDefault(&logger);
+
+	// Запись больше буфера потока не помещается никогда - отбрасывается при любом темпе фонового потока
+	const std::string huge(2000, 'x');
+	for(int i = 0; i < 3; ++i) {
+		PAYGO_LOG(core::LogLevel::INFO, "huge {}", huge);
+	}
+	PAYGO_LOG(core::LogLevel::INFO, "record {}", 1);
+	logger.Flush();
+
+	// Предупреждение выводится после записей того же прохода фонового потока
+	std::vector<std::string> lines = ReadLines(path_);
+	ASSERT_EQ(lines.size(), 2u);
+	EXPECT_EQ(CountLines(lines, " WARNING logger: 3 records dropped (ring buffer full)"sv), 1u);
+	EXPECT_EQ(RecordNumbers(lines), std::vector<int>{1});
+	EXPECT_EQ(logger.GetStats().dropped, 3u);
+	EXPECT_EQ(logger.GetStats().written, 1u);
+
+	// В следующем предупреждении - только новые потери
+	PAYGO_LOG(core::LogLevel::INFO, "huge {}", huge);
+	logger.Flush();
+	lines = ReadLines(path_);
+	ASSERT_EQ(lines.size(), 3u);
+	EXPECT_EQ(CountLines(lines, " WARNING logger: 1 records dropped (ring buffer full)"sv), 1u);
+	EXPECT_EQ(logger.GetStats().dropped, 4u);
+}
+
+TEST_F(LoggerTest, RingsOfExitedThreadsAreDrained) {
+	core::Logger logger(settings_);
+	core::Logger::SetDefault(&logger);
+
+	constexpr int THREADS = 8;
+	constexpr int RECORDS = 100;
+	constexpr int WAVES = 3;
+	for(int wave = 0; wave < WAVES; ++wave) {
+		std::vector<std::thread> threads;
+		for(int t = 0; t < THREADS; ++t) {
+			threads.emplace_back([first = (wave * THREADS + t) * RECORDS] {
+				for(int i = 0; i < RECORDS; ++i) {
+					PAYGO_LOG(core::LogLevel::INFO, "record {}", first + i);
+				}
+			});
+		}
+		for(std::thread &thread : threads) {
+			thread.join();
+		}
+	}
+	logger.Flush();
+
+	std::vector<int> numbers = RecordNumbers(ReadLines(path_));
+	std::sort(numbers.begin(), numbers.end());
+	std::vector<int> expected(WAVES * THREADS * RECORDS);
+	for(size_t i = 0; i < expected.size(); ++i) {
+		expected[i] = static_cast<int>(i);
+	}
+	EXPECT_EQ(numbers, expected);
+	EXPECT_EQ(logger.GetStats().written, expected.size());
+	EXPECT_EQ(logger.GetStats().dropped, 0u);
+}
+
+TEST_F(LoggerTest, FlushWritesEverythingLoggedBefore) {
+	core::Logger logger(settings_);
+	core::Logger::SetDefault(&logger);
+
+	for(int i = 0; i < 1000; ++i) {
+		PAYGO_LOG(core::LogLevel::INFO, "record {}", i);
+	}
+	logger.Flush();
+	std::vector<int> numbers = RecordNumbers(ReadLines(path_));
+	ASSERT_EQ(numbers.size(), 1000u);
+	for(int i = 0; i < 1000; ++i) {
+		ASSERT_EQ(numbers[i], i);  // записи одного потока выходят в порядке записи
+	}
+
+	// Flush из нескольких потоков: каждый видит в файле свою последнюю запись
+	std::atomic<int> missing{0};
+	std::vector<std::thread> threads;
+	for(int t = 0; t < 4; ++t) {
+		threads.emplace_back([&, t] {
+			for(int i = 0; i < 20; ++i) {
+				const int number = 10000 + t * 100 + i;
+				PAYGO_LOG(core::LogLevel::INFO, "record {}", number);
+				logger.Flush();
+				const std::vector<int> written = RecordNumbers(ReadLines(path_));
+				if(std::find(written.begin(), written.end(), number) == written.end()) {
+					++missing;
+				}
+			}
+		});
+	}
+	for(std::thread &thread : threads) {
+		thread.join();
+	}
+	EXPECT_EQ(missing.load(), 0);
+}
+
+TEST_F(LoggerTest, RotatesAndKeepsBackupCount) {
+	settings_.max_file_bytes = 2000;
+	settings_.backup_count = 2;
+	core::Logger logger(settings_);
+	core::Logger::SetDefault(&logger);
+
+	int number = 0;
+	for(int batch = 0; batch < 10; ++batch) {
+		for(int i = 0; i < 50; ++i) {
+			PAYGO_LOG(core::LogLevel::INFO, "record {}", number++);
+		}
+		logger.Flush();
+	}
+
+	EXPECT_GE(logger.GetStats().rotations, 5u);
+	ASSERT_TRUE(std::filesystem::exists(path_.string() + ".1"s));
+	ASSERT_TRUE(std::filesystem::exists(path_.string() + ".2"s));
+	EXPECT_FALSE(std::filesystem::exists(path_.string() + ".3"s));
+	// Файл ротируется после блока, дошедшего до порога: резервные копии не меньше порога
+	EXPECT_GE(std::filesystem::file_size(path_.string() + ".1"s), settings_.max_file_bytes);
+
+	// Старшая копия, младшая и текущий файл - непрерывный хвост записей
+	std::vector<int> tail = RecordNumbers(ReadLines(path_.string() + ".2"s));
+	for(const std::string &file : {path_.string() + ".1"s, path_.string()}) {
+		const std::vector<int> numbers = RecordNumbers(ReadLines(file));
+		tail.insert(tail.end(), numbers.begin(), numbers.end());
+	}
+	ASSERT_FALSE(tail.empty());
+	EXPECT_EQ(tail.back(), number - 1);
+	for(size_t i = 1; i < tail.size(); ++i) {
+		ASSERT_EQ(tail[i], tail[i - 1] + 1);
+	}
+}
+
+TEST_F(LoggerTest, RotationWithoutBackupsStartsNewFile) {
+	settings_.max_file_bytes = 2000;
+	settings_.backup_count = 0;
+	core::Logger logger(settings_);
+	core::Logger::SetDefault(&logger);
+
+	for(int i = 0; i < 100; ++i) {
+		PAYGO_LOG(core::LogLevel::INFO, "record {}", i);
+	}
+	logger.Flush();
+
+	EXPECT_GE(logger.GetStats().rotations, 1u);
+	EXPECT_FALSE(std::filesystem::exists(path_.string() + ".1"s));
+	EXPECT_LT(std::filesystem::file_size(path_), 2000u);
+}
@@ -0,0 +1,164 @@
+/*
+ * ТЕСТЫ ОФЛАЙН-ОЧЕРЕДИ
+ *
+ * Очередь работает в отдельном временном каталоге; перезапуск терминала -
+ * это уничтожение OfflineQueue и создание новой над тем же каталогом.
+ */
+
+#include "core/offline_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+using namespace paygo;
+
+namespace {
+
+common::Transaction MakePayment(const std::string &reference, size_t description_size = 16) {
+	common::Transaction transaction;
+	transaction.reference = reference;
+	transaction.terminal_id = "T-0001"s;
+	transaction.amount = 15000;
+	transaction.card_token = "tok_"s + reference;
+	transaction.description = std::string(description_size, 'x');
+	transaction.created_at = 1700000000000;
+	return transaction;
+}
+
+std::vector<std::string> PendingReferences(const core::OfflineQueue &queue) {
+	std::vector<std::string> references;
+	for(const core::OfflineEntry &entry : queue.Peek(100)) {
+		references.push_back(entry.transaction.reference);
+	}
+	return references;
+}
+
+class OfflineQueueTest : public ::testing::Test {
+protected:
+	void SetUp() override {
+		const auto *info = ::testing::UnitTest::GetInstance()->current_test_info();
+		directory_ = std::filesystem::temp_directory_path() /
+						 ("paygo_offline_"s + info->name() + "_"s + std::to_string(::getpid()));
+		std::filesystem::remove_all(directory_);
+		settings_.directory = directory_.string();
+	}
+
+	void TearDown() override {
+		std::filesystem::remove_all(directory_);
+	}
+
+	std::filesystem::path SegmentPath(int number) const {
+		char name[32];
+		std::snprintf(name, sizeof(name), "offline-%08d.seg", number);
+		return directory_ / name;
+	}
+
+	std::filesystem::path directory_;
+	core::OfflineQueueSettings settings_;
+};
+}
+
+TEST_F(OfflineQueueTest, RecoversPendingAfterRestart) {
+	{
+		core::OfflineQueue queue(settings_);
+		const uint64_t first = queue.Enqueue(MakePayment("PAY-1"s)).get();
+		queue.Enqueue(MakePayment("PAY-2"s)).get();
+		queue.Enqueue(MakePayment("PAY-3"s)).get();
+		queue.Acknowledge({first});
+	}
+
+	core::OfflineQueue queue(settings_);
+	EXPECT_EQ(PendingReferences(queue), (std::vector<std::string>{"PAY-2"s, "PAY-3"s}));
+	EXPECT_EQ(queue.GetStats().recovered, 2u);
+	EXPECT_EQ(queue.GetStats().corrupted, 0u);
+}
+
+TEST_F(OfflineQueueTest, TornTailIsTruncatedOnRecovery) {
+	{
+		core::OfflineQueue queue(settings_);
+		queue.Enqueue(MakePayment("PAY-1"s)).get();
+		queue.Enqueue(MakePayment("PAY-2"s)).get();
+	}
+	const uintmax_t intact_size = std::filesystem::file_size(SegmentPath(1));
+	{
+		// Сбой питания посреди записи: заголовок следующей записи без тела
+		std::ofstream segment(SegmentPath(1), std::ios::binary | std::ios::app);
+		segment.write("\x40\x00\x00\x00\x12\x34", 6);
+	}
+
+	{
+		core::OfflineQueue queue(settings_);
+		EXPECT_EQ(PendingReferences(queue), (std::vector<std::string>{"PAY-1"s, "PAY-2"s}));
+		EXPECT_EQ(queue.GetStats().corrupted, 1u);
+		EXPECT_EQ(std::filesystem::file_size(SegmentPath(1)), intact_size);
+		queue.Enqueue(MakePayment("PAY-3"s)).get();
+	}
+
+	core::OfflineQueue queue(settings_);
+	EXPECT_EQ(PendingReferences(queue), (std::vector<std::string>{"PAY-1"s, "PAY-2"s, "PAY-3"s}));
+	EXPECT_EQ(queue.GetStats().corrupted, 0u);
+}
+
+TEST_F(OfflineQueueTest, CorruptedRecordIsSkippedAndCounted) {
+	{
+		core::OfflineQueue queue(settings_);
+		queue.Enqueue(MakePayment("PAY-1"s)).get();
+		queue.Enqueue(MakePayment("PAY-2"s)).get();
+		queue.Enqueue(MakePayment("PAY-3"s)).get();
+	}
+	{
+		// Порча байта в середине первой записи: её CRC не сходится, границы целы
+		std::fstream segment(SegmentPath(1), std::ios::binary | std::ios::in | std::ios::out);
+		segment.seekp(24);
+		segment.put('\xFF');
+	}
+
+	core::OfflineQueue queue(settings_);
+	EXPECT_EQ(PendingReferences(queue), (std::vector<std::string>{"PAY-2"s, "PAY-3"s}));
+	EXPECT_EQ(queue.GetStats().corrupted, 1u);
+}
+
+TEST_F(OfflineQueueTest, ShortWriteDoesNotLoseLaterPayments) {
+	{
+		core::OfflineQueue queue(settings_);
+		queue.Enqueue(MakePayment("PAY-1"s)).get();
+
+		// Файл не может вырасти больше чем на 10 байт: следующая пачка запишется частично
+		const uintmax_t size = std::filesystem::file_size(SegmentPath(1));
+		rlimit saved{};
+		ASSERT_EQ(::getrlimit(RLIMIT_FSIZE, &saved), 0);
+		const auto previous_handler = std::signal(SIGXFSZ, SIG_IGN);
+		rlimit limited = saved;
+		limited.rlim_cur = static_cast<rlim_t>(size + 10);
+		ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &limited), 0);
+
+		EXPECT_THROW(queue.Enqueue(MakePayment("PAY-2"s, 200)).get(), core::OfflineQueueError);
+
+		ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &saved), 0);
+		std::signal(SIGXFSZ, previous_handler);
+
+		queue.Enqueue(MakePayment("PAY-3"s)).get();
+		EXPECT_EQ(PendingReferences(queue), (std::vector<std::string>{"PAY-1"s, "PAY-3"s}));
+	}
+
+	core::OfflineQueue queue(settings_);
+	EXPECT_EQ(PendingReferences(queue), (std::vector<std::string>{"PAY-1"s, "PAY-3"s}));
+	EXPECT_EQ(queue.GetStats().corrupted, 0u);
+}
+
+TEST_F(OfflineQueueTest, RejectsWhenFull) {
+	settings_.max_pending = 2;
+	core::OfflineQueue queue(settings_);
+	queue.Enqueue(MakePayment("PAY-1"s)).get();
+	queue.Enqueue(MakePayment("PAY-2"s)).get();
+	EXPECT_THROW(queue.Enqueue(MakePayment("PAY-3"s)), core::OfflineQueueError);
+}
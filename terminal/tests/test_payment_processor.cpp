@@ -0,0 +1,398 @@
+/*
+ * ТЕСТЫ ПРОВЕДЕНИЯ ПЛАТЕЖЕЙ И ОТПРАВКИ ОФЛАЙН-ОЧЕРЕДИ
+ *
+ * Сервер PayGo имитирует MockServer (mock_server.h) в том же процессе;
+ * ответ на каждый запрос задаёт тест через SetHandler. Офлайн-очередь
+ * работает во временном каталоге.
+ */
+
+#include "core/payment_processor.h"
+
+#include "mock_server.h"
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+using namespace paygo;
+using test::MockRequest;
+using test::MockResponse;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+common::Transaction MakePayment(const std::string &reference, int64_t amount = 15000) {
+	common::Transaction transaction;
+	transaction.reference = reference;
+	transaction.terminal_id = "T-0001"s;
+	transaction.amount = amount;
+	transaction.card_token = "tok_"s + reference;
+	transaction.created_at = 1700000000000;
+	return transaction;
+}
+
+/** Ждёт условия не дольше timeout */
+bool WaitFor(const std::function<bool()> &condition, std::chrono::milliseconds timeout = 5s) {
+	const Clock::time_point deadline = Clock::now() + timeout;
+	while(!condition()) {
+		if(Clock::now() > deadline) {
+			return false;
+		}
+		std::this_thread::sleep_for(5ms);
+	}
+	return true;
+}
+
+class PaymentTest : public ::testing::Test {
+protected:
+	void SetUp() override {
+		const auto *info = ::testing::UnitTest::GetInstance()->current_test_info();
+		directory_ = std::filesystem::temp_directory_path() /
+						 ("paygo_payment_"s + info->name() + "_"s + std::to_string(::getpid()));
+		std::filesystem::remove_all(directory_);
+
+		server_ = std::make_unique<test::MockServer>(false, [this](const MockRequest &request) {
+			std::lock_guard lock(mutex_);
+			requests_.push_back(request);
+			request_times_.push_back(Clock::now());
+			return handler_(request);
+		});
+
+		network::ApiClientSettings settings;
+		network::EndpointSettings endpoint;
+		endpoint.name = "paygo"s;
+		endpoint.base_url = server_->BaseUrl();
+		endpoint.connect_timeout = 1s;
+		endpoint.request_timeout = 2s;
+		settings.endpoints = {endpoint};
+		client_ = std::make_unique<network::ApiClient>(settings, ssl_);
+
+		core::OfflineQueueSettings queue_settings;
+		queue_settings.directory = directory_.string();
+		queue_ = std::make_unique<core::OfflineQueue>(queue_settings);
+	}
+
+	void TearDown() override {
+		queue_.reset();
+		client_.reset();
+		server_.reset();
+		std::filesystem::remove_all(directory_);
+	}
+
+	void SetHandler(std::function<MockResponse(const MockRequest &)> handler) {
+		std::lock_guard lock(mutex_);
+		handler_ = std::move(handler);
+	}
+
+	/** Сервер отвечает status на первые failures запросов, затем 200 */
+	void FailFirst(size_t failures, long status) {
+		SetHandler([this, failures, status](const MockRequest &) {
+			return requests_.size() <= failures ? MockResponse{status, R"({"error":"unavailable"})"s} : MockResponse{};
+		});
+	}
+
+	std::vector<MockRequest> Requests() {
+		std::lock_guard lock(mutex_);
+		return requests_;
+	}
+
+	std::vector<Clock::time_point> RequestTimes() {
+		std::lock_guard lock(mutex_);
+		return request_times_;
+	}
+
+	std::filesystem::path directory_;
+	network::SslManager ssl_{network::TlsSettings{}};
+	std::unique_ptr<test::MockServer> server_;
+	std::unique_ptr<network::ApiClient> client_;
+	std::unique_ptr<core::OfflineQueue> queue_;
+
+	std::mutex mutex_;
+	std::function<MockResponse(const MockRequest &)> handler_ = [](const MockRequest &) {
+		return MockResponse{};
+	};
+	std::vector<MockRequest> requests_;
+	std::vector<Clock::time_point> request_times_;
+};
+}
+
+// === ОТПРАВКА ОФЛАЙН-ОЧЕРЕДИ: ПОВТОРЫ И ПАУЗЫ ===
+
+TEST_F(PaymentTest, ForwarderRetriesWithGrowingBackoff) {
+	FailFirst(5, 503);
+	queue_->Enqueue(MakePayment("PAY-1"s)).get();
+
+	core::ForwarderSettings settings;
+	settings.initial_backoff = 20ms;
+	settings.max_backoff = 80ms;
+	settings.idle_poll = 10ms;
+	core::OfflineForwarder forwarder(settings, *queue_, *client_);
+	ASSERT_TRUE(WaitFor([&] {
+		return queue_->GetStats().pending == 0;
+	}));
+
+	const core::ForwarderStats stats = forwarder.GetStats();
+	EXPECT_EQ(stats.retries, 5u);
+	EXPECT_EQ(stats.delivered, 1u);
+	EXPECT_EQ(stats.batches, 6u);
+
+	// Паузы 20, 40, 80, 80, 80 мс с разбросом ±25%
+	const std::vector<Clock::time_point> times = RequestTimes();
+	ASSERT_EQ(times.size(), 6u);
+	const std::vector<std::chrono::milliseconds> backoff = {20ms, 40ms, 80ms, 80ms, 80ms};
+	for(size_t i = 0; i < backoff.size(); ++i) {
+		const auto gap = times[i + 1] - times[i];
+		EXPECT_GE(gap, backoff[i] * 3 / 4) << "retry " << i + 1;
+		EXPECT_LT(gap, backoff[i] * 5 / 4 + 100ms) << "retry " << i + 1;
+	}
+
+	// Все повторы - один и тот же платёж с одним ключом идемпотентности
+	for(const MockRequest &request : Requests()) {
+		EXPECT_EQ(request.Header("Idempotency-Key"), "PAY-1");
+	}
+}
+
+TEST_F(PaymentTest, ForwarderResetsBackoffAfterDelivery) {
+	FailFirst(3, 503);
+	queue_->Enqueue(MakePayment("PAY-1"s)).get();
+
+	core::ForwarderSettings settings;
+	settings.initial_backoff = 20ms;
+	settings.max_backoff = 1s;
+	settings.idle_poll = 10ms;
+	core::OfflineForwarder forwarder(settings, *queue_, *client_);
+	ASSERT_TRUE(WaitFor([&] {
+		return queue_->GetStats().pending == 0;
+	}));
+
+	// Следующий сбой снова начинается с initial_backoff, а не с 160 мс
+	SetHandler([this](const MockRequest &) {
+		return requests_.size() == 5 ? MockResponse{503, "{}"s} : MockResponse{};
+	});
+	queue_->Enqueue(MakePayment("PAY-2"s)).get();
+	ASSERT_TRUE(WaitFor([&] {
+		return queue_->GetStats().pending == 0;
+	}));
+
+	const std::vector<Clock::time_point> times = RequestTimes();
+	ASSERT_EQ(times.size(), 6u);
+	EXPECT_LT(times[5] - times[4], 20ms * 5 / 4 + 60ms);
+	EXPECT_EQ(forwarder.GetStats().retries, 4u);
+}
+
+TEST_F(PaymentTest, ForwarderRetriesNetworkErrors) {
+	// Сервер не отвечает дольше таймаута запроса - как обрыв связи
+	SetHandler([this](const MockRequest &) {
+		return requests_.size() <= 2 ? MockResponse{200, "{}"s, 300ms} : MockResponse{};
+	});
+	network::ApiClientSettings settings;
+	network::EndpointSettings endpoint;
+	endpoint.name = "paygo"s;
+	endpoint.base_url = server_->BaseUrl();
+	endpoint.request_timeout = 100ms;
+	settings.endpoints = {endpoint};
+	network::ApiClient client(settings, ssl_);
+
+	queue_->Enqueue(MakePayment("PAY-1"s)).get();
+	core::ForwarderSettings forwarder_settings;
+	forwarder_settings.initial_backoff = 10ms;
+	forwarder_settings.idle_poll = 10ms;
+	core::OfflineForwarder forwarder(forwarder_settings, *queue_, client);
+	ASSERT_TRUE(WaitFor([&] {
+		return queue_->GetStats().pending == 0;
+	}));
+	EXPECT_EQ(forwarder.GetStats().retries, 2u);
+	EXPECT_EQ(forwarder.GetStats().delivered, 1u);
+}
+
+// === ПРОВЕДЕНИЕ ПЛАТЕЖА ===
+
+TEST_F(PaymentTest, ApprovedPaymentCarriesIdempotencyKey) {
+	SetHandler([](const MockRequest &) {
+		return MockResponse{201, R"({"status":"approved"})"s};
+	});
+	core::PaymentProcessor processor(core::PaymentSettings{}, *client_, *queue_);
+
+	const core::PaymentResult result = processor.Process(MakePayment("PAY-1"s));
+	EXPECT_EQ(result.outcome, core::PaymentOutcome::APPROVED);
+	EXPECT_EQ(result.http_status, 201);
+	EXPECT_EQ(result.response, R"({"status":"approved"})");
+
+	const std::vector<MockRequest> requests = Requests();
+	ASSERT_EQ(requests.size(), 1u);
+	EXPECT_EQ(requests[0].path, "/api/v1/transactions");
+	EXPECT_EQ(requests[0].Header("Idempotency-Key"), "PAY-1");
+	EXPECT_NE(requests[0].body.find(R"("reference":"PAY-1")"), std::string::npos);
+	EXPECT_EQ(queue_->GetStats().pending, 0u);
+}
+
+TEST_F(PaymentTest, ConflictOnReplayIsApproved) {
+	// Платёж с этим ключом уже проведён (ответ на первую попытку потерялся)
+	SetHandler([](const MockRequest &) {
+		return MockResponse{409, R"({"error":"duplicate idempotency key"})"s};
+	});
+	core::PaymentProcessor processor(core::PaymentSettings{}, *client_, *queue_);
+
+	const core::PaymentResult result = processor.Process(MakePayment("PAY-1"s));
+	EXPECT_EQ(result.outcome, core::PaymentOutcome::APPROVED);
+	EXPECT_EQ(result.http_status, 409);
+	EXPECT_EQ(queue_->GetStats().pending, 0u);
+	EXPECT_TRUE(processor.Online());
+}
+
+TEST_F(PaymentTest, ClientErrorIsDeclined) {
+	SetHandler([](const MockRequest &) {
+		return MockResponse{402, R"({"error":"insufficient funds"})"s};
+	});
+	core::PaymentProcessor processor(core::PaymentSettings{}, *client_, *queue_);
+
+	const core::PaymentResult result = processor.Process(MakePayment("PAY-1"s));
+	EXPECT_EQ(result.outcome, core::PaymentOutcome::DECLINED);
+	EXPECT_EQ(result.http_status, 402);
+	EXPECT_EQ(result.response, R"({"error":"insufficient funds"})");
+	EXPECT_EQ(queue_->GetStats().pending, 0u);   // отказ не повторяется из очереди
+	EXPECT_TRUE(processor.Online());
+}
+
+TEST_F(PaymentTest, ServerErrorQueuesOfflineAndSkipsServer) {
+	SetHandler([](const MockRequest &) {
+		return MockResponse{503, "{}"s};
+	});
+	core::PaymentSettings settings;
+	settings.offline_probe_interval = 1min;
+	core::PaymentProcessor processor(settings, *client_, *queue_);
+
+	EXPECT_EQ(processor.Process(MakePayment("PAY-1"s)).outcome, core::PaymentOutcome::QUEUED_OFFLINE);
+	EXPECT_FALSE(processor.Online());
+
+	// Пока сервер считается недоступным, платёж сразу уходит в очередь
+	EXPECT_EQ(processor.Process(MakePayment("PAY-2"s)).outcome, core::PaymentOutcome::QUEUED_OFFLINE);
+	EXPECT_EQ(Requests().size(), 1u);
+	EXPECT_EQ(queue_->GetStats().pending, 2u);
+}
+
+TEST_F(PaymentTest, OfflineLimitRejectsLargePayments) {
+	SetHandler([](const MockRequest &) {
+		return MockResponse{503, "{}"s};
+	});
+	core::PaymentSettings settings;
+	settings.offline_max_amount = 50000;
+	core::PaymentProcessor processor(settings, *client_, *queue_);
+
+	const core::PaymentResult over = processor.Process(MakePayment("PAY-1"s, 50001));
+	EXPECT_EQ(over.outcome, core::PaymentOutcome::FAILED);
+	EXPECT_NE(over.response.find("offline limit"), std::string::npos);
+
+	EXPECT_EQ(processor.Process(MakePayment("PAY-2"s, 50000)).outcome, core::PaymentOutcome::QUEUED_OFFLINE);
+	const std::vector<core::OfflineEntry> pending = queue_->Peek(10);
+	ASSERT_EQ(pending.size(), 1u);
+	EXPECT_EQ(pending[0].transaction.reference, "PAY-2");
+}
+
+TEST_F(PaymentTest, OfflineModeDisabledFails) {
+	SetHandler([](const MockRequest &) {
+		return MockResponse{503, "{}"s};
+	});
+	core::PaymentSettings settings;
+	settings.offline_enabled = false;
+	core::PaymentProcessor processor(settings, *client_, *queue_);
+
+	EXPECT_EQ(processor.Process(MakePayment("PAY-1"s)).outcome, core::PaymentOutcome::FAILED);
+	EXPECT_EQ(queue_->GetStats().pending, 0u);
+}
+
+// === ОТПРАВКА ОФЛАЙН-ОЧЕРЕДИ: ОТВЕТЫ СЕРВЕРА ===
+
+TEST_F(PaymentTest, ForwarderAcknowledgesReplaysAndRejections) {
+	SetHandler([](const MockRequest &request) {
+		const std::string key = request.Header("Idempotency-Key");
+		if(key == "PAY-1") {
+			return MockResponse{409, "{}"s};   // уже проведён при прошлой попытке
+		}
+		if(key == "PAY-2") {
+			return MockResponse{400, R"({"error":"card expired"})"s};
+		}
+		return MockResponse{};
+	});
+	queue_->Enqueue(MakePayment("PAY-1"s)).get();
+	queue_->Enqueue(MakePayment("PAY-2"s)).get();
+	queue_->Enqueue(MakePayment("PAY-3"s)).get();
+
+	core::ForwarderSettings settings;
+	settings.idle_poll = 10ms;
+	core::OfflineForwarder forwarder(settings, *queue_, *client_);
+	ASSERT_TRUE(WaitFor([&] {
+		return queue_->GetStats().pending == 0;
+	}));
+
+	const core::ForwarderStats stats = forwarder.GetStats();
+	EXPECT_EQ(stats.delivered, 2u);
+	EXPECT_EQ(stats.rejected, 1u);
+	EXPECT_EQ(stats.retries, 0u);
+	EXPECT_EQ(Requests().size(), 3u);
+}
+
+TEST_F(PaymentTest, ForwarderDeliveryBringsProcessorOnline) {
+	FailFirst(1, 503);
+	core::PaymentSettings payment_settings;
+	payment_settings.offline_probe_interval = 1min;
+	core::PaymentProcessor processor(payment_settings, *client_, *queue_);
+	ASSERT_EQ(processor.Process(MakePayment("PAY-1"s)).outcome, core::PaymentOutcome::QUEUED_OFFLINE);
+	ASSERT_FALSE(processor.Online());
+
+	core::ForwarderSettings settings;
+	settings.idle_poll = 10ms;
+	core::OfflineForwarder forwarder(settings, *queue_, *client_, &processor);
+	ASSERT_TRUE(WaitFor([&] {
+		return queue_->GetStats().pending == 0;
+	}));
+	EXPECT_TRUE(processor.Online());
+}
+
+TEST_F(PaymentTest, PaymentsRecoveredAfterTornTailAreForwarded) {
+	queue_->Enqueue(MakePayment("PAY-1"s)).get();
+	queue_->Enqueue(MakePayment("PAY-2"s)).get();
+	queue_.reset();
+
+	// Сбой питания посреди записи третьего платежа
+	std::filesystem::path segment;
+	for(const auto &file : std::filesystem::directory_iterator(directory_)) {
+		segment = std::max(segment, file.path());
+	}
+	{
+		std::ofstream tail(segment, std::ios::binary | std::ios::app);
+		tail.write("\x80\x00\x00\x00\x01\x02\x03", 7);
+	}
+
+	core::OfflineQueueSettings queue_settings;
+	queue_settings.directory = directory_.string();
+	queue_ = std::make_unique<core::OfflineQueue>(queue_settings);
+	EXPECT_EQ(queue_->GetStats().recovered, 2u);
+	EXPECT_EQ(queue_->GetStats().corrupted, 1u);
+
+	core::ForwarderSettings settings;
+	settings.idle_poll = 10ms;
+	core::OfflineForwarder forwarder(settings, *queue_, *client_);
+	ASSERT_TRUE(WaitFor([&] {
+		return queue_->GetStats().pending == 0;
+	}));
+	std::vector<std::string> keys;
+	for(const MockRequest &request : Requests()) {
+		keys.push_back(request.Header("Idempotency-Key"));
+	}
+	std::sort(keys.begin(), keys.end());
+	EXPECT_EQ(keys, (std::vector<std::string>{"PAY-1"s, "PAY-2"s}));
+}
@@ -0,0 +1,661 @@
+/*
+ * ТЕСТЫ WEBSOCKET
+ *
+ * Кодек и разбор кадров проверяются без сети: очередь FrameWriter
+ * передаётся через socketpair в буфер приёма, как после recv. Клиент -
+ * через эхо-сервер на том же кодеке в том же процессе (127.0.0.1).
+ */
+
+#include "network/websocket_client.h"
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+using namespace paygo;
+using network::Opcode;
+
+namespace {
+
+struct Received {
+	Opcode opcode;
+	std::string data;
+	bool final;
+};
+
+/** Обработчик, который копирует сообщения (Message::data живёт только во время вызова) */
+network::MessageHandler Collect(std::vector<Received> &received) {
+	return [&received](const network::Message &message) {
+		received.push_back({message.opcode, std::string(message.data), message.final});
+	};
+}
+
+/** Очередь writer в буфере приёма целиком */
+void Deliver(network::FrameWriter &writer, network::ReceiveRing &ring) {
+	int fds[2];
+	ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+	writer.Flush(fds[1]);
+	::close(fds[1]);
+	ssize_t count;
+	while((count = ::read(fds[0], ring.WriteData(), ring.Writable())) > 0) {
+		ring.Produce(static_cast<size_t>(count));
+	}
+	::close(fds[0]);
+}
+
+/** Код закрытия, с которым Parse отверг поток; 0 - поток принят */
+uint16_t ParseCloseCode(network::FrameReader &reader, network::ReceiveRing &ring, std::vector<Received> &received) {
+	try {
+		reader.Parse(ring, Collect(received));
+	} catch(const network::WebSocketError &e) {
+		return e.CloseCode();
+	}
+	return 0;
+}
+
+network::FrameReaderSettings ServerReader(bool deliver_fragments = false, size_t max_message_bytes = 1 << 20) {
+	network::FrameReaderSettings settings;
+	settings.role = network::Role::SERVER;
+	settings.deliver_fragments = deliver_fragments;
+	settings.max_message_bytes = max_message_bytes;
+	return settings;
+}
+
+const std::vector<std::string> VALID_UTF8 = {
+	""s,
+	"status"s,
+	"Оплата прошла"s,
+	"€ 150"s,
+	"\xF0\x9F\x92\xB3 card"s,                               // U+1F4B3, четыре байта
+	"\xED\x9F\xBF\xEE\x80\x80"s,                            // U+D7FF и U+E000 вокруг суррогатов
+	"\xF4\x8F\xBF\xBF"s,                                    // U+10FFFF
+	std::string(37, 'a') + "ж"s + std::string(21, 'b'),    // символ посреди длинного ASCII
+};
+
+const std::vector<std::string> INVALID_UTF8 = {
+	"\xC3\x28"s,              // нет продолжающего байта
+	"\xC0\xAF"s,              // избыточная форма '/'
+	"\xE0\x80\xAF"s,          // избыточная форма в трёх байтах
+	"\xED\xA0\x80"s,          // суррогат U+D800
+	"\xF4\x90\x80\x80"s,      // больше U+10FFFF
+	"\xF5\x80\x80\x80"s,
+	"\x80"s,                  // продолжающий байт без ведущего
+	"ok\xFF"s,
+	std::string(40, 'a') + "\xE2\x82"s + "x"s,
+};
+
+/**
+ * ЭХО-СЕРВЕР
+ *
+ * Одно соединение за раз: рукопожатие, затем каждое сообщение
+ * возвращается как пришло (фрагменты - фрагментами). Нарушение протокола
+ * клиентом - CLOSE с кодом ошибки.
+ */
+class EchoServer {
+public:
+	EchoServer() {
+		listener_ = ::socket(AF_INET, SOCK_STREAM, 0);
+		int yes = 1;
+		::setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		if(::bind(listener_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || ::listen(listener_, 16) != 0) {
+			throw std::runtime_error("echo server: cannot listen");
+		}
+		socklen_t length = sizeof(address);
+		::getsockname(listener_, reinterpret_cast<sockaddr *>(&address), &length);
+		port_ = ntohs(address.sin_port);
+
+		thread_ = std::thread([this] {
+			while(!stop_) {
+				const int fd = ::accept(listener_, nullptr, nullptr);
+				if(fd < 0) {
+					continue;
+				}
+				int nodelay = 1;
+				::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+				Serve(fd);
+				::close(fd);
+			}
+		});
+	}
+
+	~EchoServer() {
+		stop_ = true;
+		::shutdown(listener_, SHUT_RDWR);
+		::close(listener_);
+		thread_.join();
+	}
+
+	EchoServer(const EchoServer &) = delete;
+	EchoServer &operator=(const EchoServer &) = delete;
+
+	network::WebSocketSettings ClientSettings() const {
+		network::WebSocketSettings settings;
+		settings.port = port_;
+		settings.path = "/ws/terminal"s;
+		settings.ring_bytes = 1 << 20;
+		return settings;
+	}
+
+private:
+	void Serve(int fd) {
+		network::ReceiveRing ring(1 << 20);
+		if(!Upgrade(fd, ring)) {
+			return;
+		}
+
+		network::FrameReader reader(ServerReader(true));
+		network::FrameWriter writer(network::Role::SERVER);
+		bool continuation = false;
+		bool closed = false;
+		while(!closed) {
+			const ssize_t count = ::read(fd, ring.WriteData(), ring.Writable());
+			if(count <= 0) {
+				return;
+			}
+			ring.Produce(static_cast<size_t>(count));
+			try {
+				reader.Parse(ring, [&](const network::Message &message) {
+					if(message.opcode == Opcode::PING) {
+						writer.Add(Opcode::PONG, message.data);
+					} else if(message.opcode == Opcode::CLOSE) {
+						writer.Add(Opcode::CLOSE, message.data);
+						closed = true;
+					} else if(message.opcode != Opcode::PONG) {
+						writer.Add(continuation ? Opcode::CONTINUATION : message.opcode, message.data, message.final);
+						continuation = !message.final;
+					}
+				});
+			} catch(const network::WebSocketError &e) {
+				code_[0] = static_cast<char>(e.CloseCode() >> 8);
+				code_[1] = static_cast<char>(e.CloseCode());
+				writer.Add(Opcode::CLOSE, std::string_view(code_, 2));
+				closed = true;
+			}
+			// Ответы ссылаются на разобранные байты буфера: отправить до следующего read
+			while(!writer.Flush(fd)) {
+				pollfd descriptor{fd, POLLOUT, 0};
+				::poll(&descriptor, 1, -1);
+			}
+		}
+	}
+
+	bool Upgrade(int fd, network::ReceiveRing &ring) {
+		size_t header_end;
+		while(true) {
+			const std::string_view received(reinterpret_cast<const char *>(ring.ReadData()), ring.Readable());
+			if((header_end = received.find("\r\n\r\n")) != std::string_view::npos) {
+				break;
+			}
+			const ssize_t count = ::read(fd, ring.WriteData(), ring.Writable());
+			if(count <= 0) {
+				return false;
+			}
+			ring.Produce(static_cast<size_t>(count));
+		}
+
+		const std::string_view request(reinterpret_cast<const char *>(ring.ReadData()), header_end);
+		const size_t position = request.find("Sec-WebSocket-Key: ");
+		if(position == std::string_view::npos) {
+			return false;
+		}
+		const size_t end = request.find("\r\n", position);
+		const std::string key(request.substr(position + 19, end == std::string_view::npos ? std::string_view::npos : end - position - 19));
+		ring.Consume(header_end + 4);
+
+		const std::string response = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: "s +
+											  network::ComputeAcceptKey(key) + "\r\n\r\n"s;
+		return ::write(fd, response.data(), response.size()) == static_cast<ssize_t>(response.size());
+	}
+
+	int listener_ = -1;
+	uint16_t port_ = 0;
+	char code_[2] = {};   // тело CLOSE с кодом ошибки
+	std::atomic<bool> stop_{false};
+	std::thread thread_;
+};
+
+/** Опрашивает клиента, пока сервер не закроет соединение */
+std::vector<Received> PollUntilClosed(network::WebSocketClient &client) {
+	std::vector<Received> received;
+	for(int i = 0; i < 100 && client.Poll(Collect(received), 100ms); ++i) {
+	}
+	return received;
+}
+}
+
+// === КОДЕК ===
+
+TEST(WebSocketCodecTest, FrameHeaderRoundTrip) {
+	const uint32_t mask = 0x11223344u;
+	for(uint64_t size : {uint64_t{0}, uint64_t{125}, uint64_t{126}, uint64_t{65535}, uint64_t{65536}, uint64_t{1} << 33}) {
+		for(const uint32_t *key : {static_cast<const uint32_t *>(nullptr), &mask}) {
+			uint8_t out[network::MAX_HEADER_SIZE];
+			const size_t header_size = network::EncodeFrameHeader(out, Opcode::BINARY, false, size, key);
+
+			network::FrameHeader header;
+			EXPECT_EQ(network::ParseFrameHeader(out, header_size - 1, header), network::ParseStatus::INCOMPLETE);
+			ASSERT_EQ(network::ParseFrameHeader(out, header_size, header), network::ParseStatus::COMPLETE);
+			EXPECT_FALSE(header.fin);
+			EXPECT_EQ(header.opcode, Opcode::BINARY);
+			EXPECT_EQ(header.payload_size, size);
+			EXPECT_EQ(header.header_size, header_size);
+			EXPECT_EQ(header.masked, key != nullptr);
+			if(key) {
+				EXPECT_EQ(header.mask, mask);
+			}
+		}
+	}
+}
+
+TEST(WebSocketCodecTest, RejectsMalformedHeaders) {
+	network::FrameHeader header;
+	const std::vector<std::vector<uint8_t>> malformed = {
+		{0xC1, 0x00},                      // RSV1 без расширения
+		{0x83, 0x00},                      // неизвестный код
+		{0x09, 0x00},                      // фрагментированный PING
+		{0x89, 0x7E, 0x00, 0x80},          // PING длиннее 125 байт
+		{0x82, 0x7E, 0x00, 0x10},          // длина 16 в 16-битном поле
+	};
+	for(const std::vector<uint8_t> &bytes : malformed) {
+		try {
+			network::ParseFrameHeader(bytes.data(), bytes.size(), header);
+			ADD_FAILURE() << "accepted header starting with " << static_cast<int>(bytes[0]);
+		} catch(const network::WebSocketError &e) {
+			EXPECT_EQ(e.CloseCode(), network::close_code::PROTOCOL_ERROR);
+		}
+	}
+}
+
+TEST(WebSocketCodecTest, UnmaskMatchesBytewise) {
+	const uint32_t mask = 0x5A3C96E1u;
+	uint8_t key[4];
+	std::memcpy(key, &mask, 4);
+	for(size_t size : {size_t{0}, size_t{3}, size_t{15}, size_t{16}, size_t{33}, size_t{100}, size_t{1000}}) {
+		for(size_t offset = 0; offset < 4; ++offset) {
+			std::vector<uint8_t> data(size);
+			for(size_t i = 0; i < size; ++i) {
+				data[i] = static_cast<uint8_t>(i * 31 + 7);
+			}
+			std::vector<uint8_t> expected = data;
+			for(size_t i = 0; i < size; ++i) {
+				expected[i] ^= key[(i + offset) & 3];
+			}
+			network::Unmask(data.data(), data.size(), mask, offset);
+			EXPECT_EQ(data, expected) << "size " << size << " offset " << offset;
+		}
+	}
+}
+
+TEST(WebSocketCodecTest, AcceptKeyMatchesRfcExample) {
+	// RFC 6455, раздел 1.3
+	EXPECT_EQ(network::ComputeAcceptKey("dGhlIHNhbXBsZSBub25jZQ=="sv), "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+TEST(WebSocketCodecTest, Utf8ValidatorAcceptsSequencesSplitAnywhere) {
+	for(const std::string &text : VALID_UTF8) {
+		for(size_t split = 0; split <= text.size(); ++split) {
+			network::Utf8Validator validator;
+			EXPECT_TRUE(validator.Feed(std::string_view(text).substr(0, split)));
+			EXPECT_TRUE(validator.Feed(std::string_view(text).substr(split)));
+			EXPECT_TRUE(validator.Complete()) << text << " split at " << split;
+		}
+	}
+}
+
+TEST(WebSocketCodecTest, Utf8ValidatorRejectsInvalidSequences) {
+	for(const std::string &text : INVALID_UTF8) {
+		network::Utf8Validator validator;
+		EXPECT_FALSE(validator.Feed(text) && validator.Complete()) << "accepted byte string of size " << text.size();
+	}
+
+	network::Utf8Validator validator;
+	EXPECT_TRUE(validator.Feed("\xE2\x82"sv));
+	EXPECT_FALSE(validator.Complete());   // символ оборван
+	validator.Reset();
+	EXPECT_TRUE(validator.Complete());
+}
+
+TEST(WebSocketCodecTest, RingKeepsUnreadDataContiguous) {
+	network::ReceiveRing ring(4096);
+	const size_t capacity = ring.Capacity();
+	ring.Produce(capacity - 3);
+	ring.Consume(capacity - 3);
+
+	// Запись через конец буфера - одним куском
+	ASSERT_EQ(ring.Writable(), capacity);
+	std::memcpy(ring.WriteData(), "payment", 7);
+	ring.Produce(7);
+	EXPECT_EQ(std::string_view(reinterpret_cast<const char *>(ring.ReadData()), ring.Readable()), "payment");
+	ring.Consume(7);
+	EXPECT_EQ(ring.Readable(), 0u);
+}
+
+// === РАЗБОР КАДРОВ ===
+
+TEST(WebSocketReaderTest, AssemblesFragmentsWithInterleavedPing) {
+	network::ReceiveRing ring(4096);
+	network::FrameWriter writer(network::Role::CLIENT);
+	writer.Add(Opcode::TEXT, "pay"sv, false);
+	writer.Add(Opcode::PING, ""sv);
+	writer.Add(Opcode::CONTINUATION, "ment "sv, false);
+	writer.Add(Opcode::CONTINUATION, "approved"sv, true);
+	Deliver(writer, ring);
+
+	network::FrameReader reader(ServerReader());
+	std::vector<Received> received;
+	EXPECT_EQ(reader.Parse(ring, Collect(received)), 2u);
+	ASSERT_EQ(received.size(), 2u);
+	EXPECT_EQ(received[0].opcode, Opcode::PING);
+	EXPECT_EQ(received[1].opcode, Opcode::TEXT);
+	EXPECT_EQ(received[1].data, "payment approved");
+	EXPECT_EQ(ring.Readable(), 0u);
+}
+
+TEST(WebSocketReaderTest, DeliversFragmentsWithoutAssembly) {
+	network::ReceiveRing ring(4096);
+	network::FrameWriter writer(network::Role::CLIENT);
+	writer.Add(Opcode::BINARY, "ab"sv, false);
+	writer.Add(Opcode::CONTINUATION, "cd"sv, true);
+	Deliver(writer, ring);
+
+	network::FrameReader reader(ServerReader(true));
+	std::vector<Received> received;
+	reader.Parse(ring, Collect(received));
+	ASSERT_EQ(received.size(), 2u);
+	EXPECT_EQ(received[0].opcode, Opcode::BINARY);
+	EXPECT_EQ(received[0].data, "ab");
+	EXPECT_FALSE(received[0].final);
+	EXPECT_EQ(received[1].opcode, Opcode::BINARY);
+	EXPECT_EQ(received[1].data, "cd");
+	EXPECT_TRUE(received[1].final);
+}
+
+TEST(WebSocketReaderTest, IncompleteFrameWaitsForRest) {
+	network::ReceiveRing ring(4096);
+	network::FrameWriter writer(network::Role::CLIENT);
+	writer.Add(Opcode::TEXT, "terminal status"sv);
+	Deliver(writer, ring);
+
+	// Половина кадра: разбирать нечего, байты остаются в буфере
+	network::ReceiveRing partial(4096);
+	const size_t half = ring.Readable() / 2;
+	std::memcpy(partial.WriteData(), ring.ReadData(), half);
+	partial.Produce(half);
+	network::FrameReader reader(ServerReader());
+	std::vector<Received> received;
+	EXPECT_EQ(reader.Parse(partial, Collect(received)), 0u);
+	EXPECT_EQ(partial.Readable(), half);
+
+	std::memcpy(partial.WriteData(), ring.ReadData() + half, ring.Readable() - half);
+	partial.Produce(ring.Readable() - half);
+	EXPECT_EQ(reader.Parse(partial, Collect(received)), 1u);
+	ASSERT_EQ(received.size(), 1u);
+	EXPECT_EQ(received[0].data, "terminal status");
+}
+
+TEST(WebSocketReaderTest, RejectsUnmaskedFrameFromClient) {
+	network::ReceiveRing ring(4096);
+	network::FrameWriter writer(network::Role::SERVER);   // сервер не маскирует
+	writer.Add(Opcode::TEXT, "status"sv);
+	Deliver(writer, ring);
+
+	network::FrameReader reader(ServerReader());
+	std::vector<Received> received;
+	EXPECT_EQ(ParseCloseCode(reader, ring, received), network::close_code::PROTOCOL_ERROR);
+	EXPECT_TRUE(received.empty());
+}
+
+TEST(WebSocketReaderTest, RejectsContinuationOutsideMessage) {
+	network::ReceiveRing ring(4096);
+	network::FrameWriter writer(network::Role::CLIENT);
+	writer.Add(Opcode::CONTINUATION, "tail"sv, true);
+	Deliver(writer, ring);
+
+	network::FrameReader reader(ServerReader());
+	std::vector<Received> received;
+	EXPECT_EQ(ParseCloseCode(reader, ring, received), network::close_code::PROTOCOL_ERROR);
+}
+
+TEST(WebSocketReaderTest, RejectsNewMessageInsideFragmentedOne) {
+	network::ReceiveRing ring(4096);
+	network::FrameWriter writer(network::Role::CLIENT);
+	writer.Add(Opcode::TEXT, "pay"sv, false);
+	writer.Add(Opcode::TEXT, "ment"sv, true);
+	Deliver(writer, ring);
+
+	network::FrameReader reader(ServerReader());
+	std::vector<Received> received;
+	EXPECT_EQ(ParseCloseCode(reader, ring, received), network::close_code::PROTOCOL_ERROR);
+}
+
+// === ПРЕДЕЛ РАЗМЕРА СООБЩЕНИЯ ===
+
+TEST(WebSocketReaderTest, RejectsSingleFrameOverLimit) {
+	network::ReceiveRing ring(4096);
+	network::FrameWriter writer(network::Role::CLIENT);
+	writer.Add(Opcode::BINARY, std::string(17, 'x'));
+	Deliver(writer, ring);
+
+	network::FrameReader reader(ServerReader(false, 16));
+	std::vector<Received> received;
+	EXPECT_EQ(ParseCloseCode(reader, ring, received), network::close_code::MESSAGE_TOO_BIG);
+	EXPECT_TRUE(received.empty());
+}
+
+TEST(WebSocketReaderTest, RejectsFirstFragmentOverLimitWhenAssembling) {
+	network::ReceiveRing ring(4096);
+	network::FrameWriter writer(network::Role::CLIENT);
+	writer.Add(Opcode::BINARY, std::string(17, 'x'), false);
+	Deliver(writer, ring);
+
+	// Отказ по первому фрагменту, не дожидаясь остальных
+	network::FrameReader reader(ServerReader(false, 16));
+	std::vector<Received> received;
+	EXPECT_EQ(ParseCloseCode(reader, ring, received), network::close_code::MESSAGE_TOO_BIG);
+}
+
+TEST(WebSocketReaderTest, RejectsAssembledMessageOverLimit) {
+	network::ReceiveRing ring(4096);
+	network::FrameWriter writer(network::Role::CLIENT);
+	writer.Add(Opcode::BINARY, std::string(10, 'x'), false);
+	writer.Add(Opcode::CONTINUATION, std::string(7, 'y'), true);
+	Deliver(writer, ring);
+
+	network::FrameReader reader(ServerReader(false, 16));
+	std::vector<Received> received;
+	EXPECT_EQ(ParseCloseCode(reader, ring, received), network::close_code::MESSAGE_TOO_BIG);
+	EXPECT_TRUE(received.empty());
+}
+
+TEST(WebSocketReaderTest, DeliveredFragmentsAreNotLimitedInTotal) {
+	network::ReceiveRing ring(4096);
+	network::FrameWriter writer(network::Role::CLIENT);
+	writer.Add(Opcode::BINARY, std::string(20, 'x'), false);
+	writer.Add(Opcode::CONTINUATION, std::string(10, 'y'), true);
+	Deliver(writer, ring);
+
+	network::FrameReader reader(ServerReader(true, 16));
+	std::vector<Received> received;
+	EXPECT_EQ(ParseCloseCode(reader, ring, received), 0);
+	EXPECT_EQ(received.size(), 2u);
+}
+
+// === UTF-8 В ТЕКСТОВЫХ СООБЩЕНИЯХ ===
+
+TEST(WebSocketReaderTest, RejectsInvalidUtf8Text) {
+	for(const std::string &text : INVALID_UTF8) {
+		network::ReceiveRing ring(4096);
+		network::FrameWriter writer(network::Role::CLIENT);
+		writer.Add(Opcode::TEXT, text);
+		Deliver(writer, ring);
+
+		network::FrameReader reader(ServerReader());
+		std::vector<Received> received;
+		EXPECT_EQ(ParseCloseCode(reader, ring, received), network::close_code::INVALID_PAYLOAD);
+		EXPECT_TRUE(received.empty());
+	}
+}
+
+TEST(WebSocketReaderTest, AcceptsUtf8SplitAcrossFragments) {
+	const std::string text = "Оплата €150 \xF0\x9F\x92\xB3"s;
+	for(bool deliver_fragments : {false, true}) {
+		for(size_t split = 1; split < text.size(); ++split) {
+			network::ReceiveRing ring(4096);
+			network::FrameWriter writer(network::Role::CLIENT);
+			writer.Add(Opcode::TEXT, std::string_view(text).substr(0, split), false);
+			writer.Add(Opcode::CONTINUATION, std::string_view(text).substr(split), true);
+			Deliver(writer, ring);
+
+			network::FrameReader reader(ServerReader(deliver_fragments));
+			std::vector<Received> received;
+			ASSERT_EQ(ParseCloseCode(reader, ring, received), 0) << "split at " << split;
+			std::string assembled;
+			for(const Received &message : received) {
+				EXPECT_EQ(message.opcode, Opcode::TEXT);
+				assembled += message.data;
+			}
+			EXPECT_EQ(assembled, text);
+		}
+	}
+}
+
+TEST(WebSocketReaderTest, RejectsTextEndingInsideCharacter) {
+	network::ReceiveRing ring(4096);
+	network::FrameWriter writer(network::Role::CLIENT);
+	writer.Add(Opcode::TEXT, "price \xE2"sv, false);
+	writer.Add(Opcode::CONTINUATION, "\x82"sv, true);   // у € не хватает байта
+	Deliver(writer, ring);
+
+	// Первый фрагмент корректен и уже передан, последний - нет
+	network::FrameReader reader(ServerReader(true));
+	std::vector<Received> received;
+	EXPECT_EQ(ParseCloseCode(reader, ring, received), network::close_code::INVALID_PAYLOAD);
+	ASSERT_EQ(received.size(), 1u);
+	EXPECT_EQ(received[0].data, "price \xE2");
+}
+
+TEST(WebSocketReaderTest, ValidationStartsOverForEachMessage) {
+	network::ReceiveRing ring(4096);
+	network::FrameWriter writer(network::Role::CLIENT);
+	writer.Add(Opcode::TEXT, "\xE2\x82"sv, false);
+	writer.Add(Opcode::CONTINUATION, "\xAC"sv, true);
+	writer.Add(Opcode::TEXT, "ok"sv);
+	Deliver(writer, ring);
+
+	network::FrameReader reader(ServerReader());
+	std::vector<Received> received;
+	EXPECT_EQ(ParseCloseCode(reader, ring, received), 0);
+	ASSERT_EQ(received.size(), 2u);
+	EXPECT_EQ(received[0].data, "€");
+	EXPECT_EQ(received[1].data, "ok");
+}
+
+TEST(WebSocketReaderTest, BinaryIsNotCheckedForUtf8) {
+	network::ReceiveRing ring(4096);
+	network::FrameWriter writer(network::Role::CLIENT);
+	writer.Add(Opcode::BINARY, "\xFF\xFE\xC0"sv);
+	Deliver(writer, ring);
+
+	network::FrameReader reader(ServerReader());
+	std::vector<Received> received;
+	EXPECT_EQ(ParseCloseCode(reader, ring, received), 0);
+	EXPECT_EQ(received.size(), 1u);
+}
+
+// === КЛИЕНТ ===
+
+TEST(WebSocketClientTest, EchoesTextAndAnswersPing) {
+	EchoServer server;
+	network::WebSocketClient client(server.ClientSettings());
+
+	client.Send(Opcode::PING, "ping"sv);
+	client.Send(Opcode::TEXT, R"({"command":"status"})"sv);
+
+	bool pong = false;
+	bool text = false;
+	for(int i = 0; i < 100 && !(pong && text); ++i) {
+		client.Poll(
+			[&](const network::Message &message) {
+				pong |= message.opcode == Opcode::PONG && message.data == "ping"sv;
+				text |= message.opcode == Opcode::TEXT && message.data == R"({"command":"status"})"sv;
+			},
+			100ms);
+	}
+	EXPECT_TRUE(pong);
+	EXPECT_TRUE(text);
+
+	client.Close();
+	const std::vector<Received> received = PollUntilClosed(client);
+	ASSERT_FALSE(received.empty());
+	EXPECT_EQ(received.back().opcode, Opcode::CLOSE);
+	EXPECT_FALSE(client.IsOpen());
+}
+
+TEST(WebSocketClientTest, EchoesMessagesOfEveryLengthEncoding) {
+	EchoServer server;
+	network::WebSocketClient client(server.ClientSettings());
+
+	for(size_t size : {size_t{0}, size_t{125}, size_t{126}, size_t{65535}, size_t{65536}, size_t{200000}}) {
+		std::string payload(size, '\0');
+		for(size_t i = 0; i < size; ++i) {
+			payload[i] = static_cast<char>(i * 131);
+		}
+		client.Send(Opcode::BINARY, payload);
+
+		std::vector<Received> received;
+		for(int i = 0; i < 100 && received.empty(); ++i) {
+			ASSERT_TRUE(client.Poll(Collect(received), 100ms));
+		}
+		ASSERT_EQ(received.size(), 1u) << "size " << size;
+		EXPECT_EQ(received[0].opcode, Opcode::BINARY);
+		EXPECT_TRUE(received[0].data == payload) << "size " << size;
+	}
+}
+
+TEST(WebSocketClientTest, ServerClosesWithInvalidPayloadOnBadText) {
+	EchoServer server;
+	network::WebSocketClient client(server.ClientSettings());
+
+	client.Send(Opcode::TEXT, "\xC3\x28"sv);
+	const std::vector<Received> received = PollUntilClosed(client);
+	ASSERT_EQ(received.size(), 1u);
+	EXPECT_EQ(received[0].opcode, Opcode::CLOSE);
+	EXPECT_EQ(received[0].data, "\x03\xEF"s);   // 1007
+	EXPECT_FALSE(client.IsOpen());
+}
+
+TEST(WebSocketClientTest, OversizedMessageFailsPoll) {
+	EchoServer server;
+	network::WebSocketSettings settings = server.ClientSettings();
+	settings.reader.max_message_bytes = 1000;
+	network::WebSocketClient client(settings);
+
+	client.Send(Opcode::BINARY, std::string(2000, 'x'));
+	try {
+		for(int i = 0; i < 100; ++i) {
+			client.Poll([](const network::Message &) {}, 100ms);
+		}
+		FAIL() << "message size error expected";
+	} catch(const network::WebSocketError &e) {
+		EXPECT_EQ(e.CloseCode(), network::close_code::MESSAGE_TOO_BIG);
+	}
+	EXPECT_FALSE(client.IsOpen());
+}